@@ -26,7 +26,7 @@
 # ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 # POSSIBILITY OF SUCH DAMAGE.
 #
-# Last modified 26 May 2005.
+# Last modified 19 October 2026.
 #
 
 BINDIR="@BINDIR@"
@@ -40,4 +40,26 @@ $BINDIR/ppr-index >$VAR_SPOOL_PPR/logs/ppr-index 2>&1
 # Remove various temporary files that PPR may leave behind.
 $BINDIR/ppr-clean >$VAR_SPOOL_PPR/logs/ppr-clean 2>&1
 
+# Total up the spool space saved each day by the automatic resource cache.
+# The log is moved aside first (ppr opens it anew for each job) and its
+# totals are added to those already in rcache-daily, so neither grows
+# without limit.
+if [ -f $VAR_SPOOL_PPR/logs/rcache ]
+	then
+	mv $VAR_SPOOL_PPR/logs/rcache $VAR_SPOOL_PPR/logs/rcache.old
+	touch $VAR_SPOOL_PPR/logs/rcache-daily
+	awk '{
+		if(NF == 3)		# a line from rcache-daily
+			{ split($2, r, "="); split($3, s, "="); }
+		else			# a line from the log
+			{ split($5, r, "="); split($6, s, "="); }
+		replaced[$1] += r[2]; saved[$1] += s[2];
+		}
+	END {
+		for(day in saved)
+			printf("%s replaced=%d saved=%d\n", day, replaced[day], saved[day]);
+		}' $VAR_SPOOL_PPR/logs/rcache-daily $VAR_SPOOL_PPR/logs/rcache.old | sort >$VAR_SPOOL_PPR/logs/rcache-daily.new \
+		&& mv $VAR_SPOOL_PPR/logs/rcache-daily.new $VAR_SPOOL_PPR/logs/rcache-daily
+	fi
+
 exit 0
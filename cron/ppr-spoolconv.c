@@ -0,0 +1,350 @@
+/*
+** mouse:~ppr/src/cron/ppr-spoolconv.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This program converts the jobs in the queue between the traditional
+** spool format, in which the body of each job is in separate -comments,
+** -pages, and -text files, and the single file container format described
+** in libppr/spoolfile.c.  It must be run while pprd is stopped.  Jobs which
+** were split with ppr's -Y switch share their -text file and are left alone.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef INTERNATIONAL
+#include <locale.h>
+#include <libintl.h>
+#endif
+#include "gu.h"
+#include "global_defines.h"
+#include "util_exits.h"
+#include "version.h"
+
+const char myname[] = "ppr-spoolconv";
+
+static const char *sections[] = {"comments", "pages", "text", NULL};
+
+/*
+** Command line options:
+*/
+static const char *option_chars = "v";
+static const struct gu_getopt_opt option_words[] = {
+	{"to-container", 1000, FALSE},
+	{"to-separate", 1001, FALSE},
+	{"verbose", 'v', FALSE},
+	{"help", 9000, FALSE},
+	{"version", 9001, FALSE},
+	{(char*)NULL, 0, FALSE}
+	} ;
+
+/*
+** Print help.
+*/
+static void help_usage(FILE *outfile)
+	{
+	fprintf(outfile, _("Usage: %s [switches]\n"), myname);
+
+	fputc('\n', outfile);
+
+	fputs(_("Valid switches:\n"), outfile);
+
+	fputs(_(	"\t--to-container\n"
+				"\t--to-separate\n"
+				"\t--verbose, -v\n"), outfile);
+
+	fputs(_(	"\t--version\n"
+				"\t--help\n"), outfile);
+	}
+
+/*
+** Return TRUE if pprd seems to be running.
+*/
+static gu_boolean pprd_running(void)
+	{
+	FILE *f;
+	long int pid;
+	int count;
+
+	if(!(f = fopen(PPRD_LOCKFILE, "r")))
+		return FALSE;
+	count = fscanf(f, "%ld", &pid);
+	fclose(f);
+
+	return (count == 1 && kill((pid_t)pid, 0) == 0) ? TRUE : FALSE;
+	}
+
+/*
+** Copy one stream to another.
+*/
+static int copy_stream(FILE *out, FILE *in)
+	{
+	char buffer[8192];
+	size_t len;
+	while((len = fread(buffer, sizeof(char), sizeof(buffer), in)) > 0)
+		{
+		if(fwrite(buffer, sizeof(char), len, out) != len)
+			return -1;
+		}
+	return ferror(in) ? -1 : 0;
+	}
+
+/*
+** Move the -comments, -pages, and -text files of a job into a container.
+** Returns 1 if the job was converted, 0 if it was skipped, -1 on error.
+*/
+static int to_container(const char qfname[])
+	{
+	char fname[MAX_PPR_PATH], tempname[MAX_PPR_PATH];
+	FILE *f[3], *spool;
+	struct stat statbuf;
+	int x, ret = 1;
+
+	ppr_fnamef(fname, "%s/%s-spool", DATADIR, qfname);
+	if(stat(fname, &statbuf) == 0)
+		return 0;
+
+	/* Skip jobs which have no body yet and the fragments of split jobs. */
+	ppr_fnamef(fname, "%s/%s-text", DATADIR, qfname);
+	if(stat(fname, &statbuf) == -1 || statbuf.st_nlink > 1)
+		return 0;
+
+	for(x=0; sections[x]; x++)
+		{
+		ppr_fnamef(fname, "%s/%s-%s", DATADIR, qfname, sections[x]);
+		if(!(f[x] = fopen(fname, "rb")))
+			{
+			fprintf(stderr, _("%s: can't open \"%s\", errno=%d (%s)\n"), myname, fname, errno, gu_strerror(errno));
+			while(--x >= 0)
+				fclose(f[x]);
+			return -1;
+			}
+		}
+
+	ppr_fnamef(tempname, "%s/.%s-spool", DATADIR, qfname);
+	if(!(spool = fopen(tempname, "wb")))
+		{
+		fprintf(stderr, _("%s: can't create \"%s\", errno=%d (%s)\n"), myname, tempname, errno, gu_strerror(errno));
+		ret = -1;
+		}
+	else
+		{
+		if(fseek(spool, SPOOLFILE_HEADER_SIZE, SEEK_SET) == -1
+				|| copy_stream(spool, f[2]) == -1
+				|| spoolfile_finish(spool, f[0], f[1]) == -1)
+			ret = -1;
+		if(fclose(spool) == EOF)
+			ret = -1;
+		if(ret == -1)
+			fprintf(stderr, _("%s: can't write \"%s\", errno=%d (%s)\n"), myname, tempname, errno, gu_strerror(errno));
+		}
+
+	for(x=0; sections[x]; x++)
+		fclose(f[x]);
+
+	if(ret == 1)
+		{
+		ppr_fnamef(fname, "%s/%s-spool", DATADIR, qfname);
+		if(rename(tempname, fname) == -1)
+			ret = -1;
+		}
+
+	if(ret == -1)
+		{
+		unlink(tempname);
+		return -1;
+		}
+
+	for(x=0; sections[x]; x++)
+		{
+		ppr_fnamef(fname, "%s/%s-%s", DATADIR, qfname, sections[x]);
+		unlink(fname);
+		}
+
+	return 1;
+	} /* end of to_container() */
+
+/*
+** Extract the sections of a job's container into separate files.
+** Returns 1 if the job was converted, 0 if it was skipped, -1 on error.
+*/
+static int to_separate(const char qfname[])
+	{
+	char fname[MAX_PPR_PATH], tempname[MAX_PPR_PATH];
+	struct stat statbuf;
+	int x;
+
+	ppr_fnamef(fname, "%s/%s-spool", DATADIR, qfname);
+	if(stat(fname, &statbuf) == -1)
+		return 0;
+
+	for(x=0; sections[x]; x++)
+		{
+		FILE *in, *out;
+		int ret = 0;
+
+		if(!(in = spoolfile_open_section(qfname, sections[x])))
+			{
+			fprintf(stderr, _("%s: can't read \"%s\" section of \"%s\", errno=%d (%s)\n"), myname, sections[x], fname, errno, gu_strerror(errno));
+			return -1;
+			}
+
+		ppr_fnamef(tempname, "%s/.%s-%s", DATADIR, qfname, sections[x]);
+		if(!(out = fopen(tempname, "wb")))
+			{
+			fprintf(stderr, _("%s: can't create \"%s\", errno=%d (%s)\n"), myname, tempname, errno, gu_strerror(errno));
+			fclose(in);
+			return -1;
+			}
+
+		if(copy_stream(out, in) == -1)
+			ret = -1;
+		if(fclose(out) == EOF)
+			ret = -1;
+		fclose(in);
+
+		if(ret == 0)
+			{
+			char newname[MAX_PPR_PATH];
+			ppr_fnamef(newname, "%s/%s-%s", DATADIR, qfname, sections[x]);
+			if(rename(tempname, newname) == -1)
+				ret = -1;
+			}
+
+		if(ret == -1)
+			{
+			fprintf(stderr, _("%s: can't write \"%s\", errno=%d (%s)\n"), myname, tempname, errno, gu_strerror(errno));
+			unlink(tempname);
+			return -1;
+			}
+		}
+
+	unlink(fname);
+	return 1;
+	} /* end of to_separate() */
+
+int main(int argc, char *argv[])
+	{
+	gu_boolean opt_to_separate = FALSE;
+	gu_boolean opt_verbose = FALSE;
+	DIR *dir;
+	struct dirent *direntp;
+	int converted = 0, failed = 0;
+
+	/* Initialize international messages library. */
+	#ifdef INTERNATIONAL
+	setlocale(LC_ALL, "");
+	bindtextdomain(PACKAGE, LOCALEDIR);
+	textdomain(PACKAGE);
+	#endif
+
+	/* Become the specified PPR user if not already. */
+	{
+	int ret;
+	if((ret = renounce_root_privs(myname, USER_PPR, NULL)) != 0)
+		return ret;
+	}
+
+	/* Parse the options. */
+	{
+	struct gu_getopt_state getopt_state;
+	int optchar;
+	gu_getopt_init(&getopt_state, argc, argv, option_chars, option_words);
+	while((optchar = ppr_getopt(&getopt_state)) != -1)
+		{
+		switch(optchar)
+			{
+			case 1000:					/* --to-container */
+				opt_to_separate = FALSE;
+				break;
+
+			case 1001:					/* --to-separate */
+				opt_to_separate = TRUE;
+				break;
+
+			case 'v':					/* --verbose */
+				opt_verbose = TRUE;
+				break;
+
+			case 9000:					/* --help */
+				help_usage(stdout);
+				return EXIT_OK;
+
+			case 9001:					/* --version */
+				puts(VERSION);
+				puts(COPYRIGHT);
+				puts(AUTHOR);
+				return EXIT_OK;
+
+			default:					/* other getopt errors or missing case */
+				gu_getopt_default(myname, optchar, &getopt_state, stderr);
+				return EXIT_SYNTAX;
+			}
+		}
+	if(getopt_state.optind < argc)
+		{
+		help_usage(stderr);
+		return EXIT_SYNTAX;
+		}
+	}
+
+	if(pprd_running())
+		{
+		fprintf(stderr, _("%s: pprd must be stopped first\n"), myname);
+		return EXIT_NOTPOSSIBLE;
+		}
+
+	if(!(dir = opendir(QUEUEDIR)))
+		{
+		fprintf(stderr, _("%s: can't open directory \"%s\", errno=%d (%s)\n"), myname, QUEUEDIR, errno, gu_strerror(errno));
+		return EXIT_INTERNAL;
+		}
+
+	while((direntp = readdir(dir)))
+		{
+		int ret;
+
+		if(direntp->d_name[0] == '.')
+			continue;
+
+		if(opt_to_separate)
+			ret = to_separate(direntp->d_name);
+		else
+			ret = to_container(direntp->d_name);
+
+		if(ret == 1)
+			{
+			converted++;
+			if(opt_verbose)
+				printf(_("Converted %s\n"), direntp->d_name);
+			}
+		else if(ret == -1)
+			{
+			failed++;
+			}
+		}
+
+	closedir(dir);
+
+	printf(_("%d jobs converted, %d failed.\n"), converted, failed);
+
+	return failed ? EXIT_INTERNAL : EXIT_OK;
+	} /* end of main() */
+
+/* end of file */
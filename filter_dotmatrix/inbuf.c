@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 1 April 2005.
+** Last modified 19 October 2026.
 */
 
 #include "filter_dotmatrix.h"
@@ -53,7 +53,8 @@ int input(void)
 		if((bytes_left = read(0,inbuf,sizeof(inbuf))) == -1)
 			gu_Throw(_("%s(): %s() failed, errno=%d (%s)"), "input", "read", errno, gu_strerror(errno));
 
-		if(bytes_left < (int)sizeof(inbuf))
+		/* A short read from a pipe doesn't mean end of file. */
+		if(bytes_left == 0)
 			eof = TRUE;
 
 		ptr = inbuf;
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 5 November 2003.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
@@ -54,6 +54,10 @@ const char myname[] = "lib/indexfonts";
 const char ppr_conf[] = PPR_CONF;
 const char section_name[] = "fonts";
 const char fontindex_db[] = FONT_INDEX;
+const char fontindex_cdb[] = FONT_INDEX_CDB;
+
+/* The hashed copy of the index which libppr/findres.c prefers */
+static void *index_cdb = NULL;
 
 static void indent(int i)
 	{
@@ -355,7 +359,16 @@ static int do_file(FILE *indexfile, const char filename[])
 
 	if(font_info)
 		{
+		char *data;
 		fprintf(indexfile, "%s:%d:%s\n", font_info->font_psname, font_info->font_type, filename);
+		gu_asprintf(&data, "%d:%s", font_info->font_type, filename);
+		if(index_cdb && gu_cdb_make_add(index_cdb, font_info->font_psname, data, strlen(data)) == -1)
+			{
+			fprintf(stderr, _("%s: write to \"%s\" failed, errno=%d (%s)\n"), myname, fontindex_cdb, errno, gu_strerror(errno));
+			gu_cdb_make_finish(index_cdb, TRUE);
+			index_cdb = NULL;
+			}
+		gu_free(data);
 		font_info_delete(font_info);
 		}
 	else
@@ -473,6 +486,7 @@ int main(int argc, char *argv[])
 		if(strcmp(argv[1], "--delete") == 0)
 			{
 			unlink(fontindex_db);
+			unlink(fontindex_cdb);
 			return EXIT_OK;
 			}
 		else
@@ -518,6 +532,14 @@ int main(int argc, char *argv[])
 	/* Warn */
 	fprintf(indexfile, "# %s\n", SHORT_VERSION);
 
+	/* Start the hashed copy.  If we can't create it, we remove the old
+	   one so that lookups fall back to the text index. */
+	if(!(index_cdb = gu_cdb_make_new(fontindex_cdb)))
+		{
+		fprintf(stderr, _("%s: can't create \"%s\", errno=%d (%s)\n"), myname, fontindex_cdb, errno, gu_strerror(errno));
+		unlink(fontindex_cdb);
+		}
+
 	/* iterate over the nameless values */
 	for(i=0; section[i].name; i++)
 		{
@@ -535,6 +557,17 @@ int main(int argc, char *argv[])
 	/* Close the completed font index file. */
 	fclose(indexfile);
 
+	/* Finish the hashed copy.  This renames it into place, so it must come
+	   after the text index is closed so that it is never older. */
+	if(index_cdb)
+		{
+		if(gu_cdb_make_finish(index_cdb, retval != EXIT_OK) == -1 && retval == EXIT_OK)
+			{
+			fprintf(stderr, _("%s: can't write \"%s\", errno=%d (%s)\n"), myname, fontindex_cdb, errno, gu_strerror(errno));
+			unlink(fontindex_cdb);
+			}
+		}
+
 	return retval;
 	} /* end of main() */
 
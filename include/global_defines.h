@@ -8,7 +8,7 @@
 ** described in the accompanying file LICENSE.txt.
 **
 ** The PPR project was begun 28 December 1992.
-** This file was last modified 28 April 2006.
+** This file was last modified 19 October 2026.
 */
 
 /*
@@ -95,11 +95,12 @@
 #define MAX_TYPENAME 16				/* max chars media type name */
 
 #define MAX_DOCMEDIA 4				/* max media types per job */
+#define MAX_JOBID 99999999			/* largest "max job id" allowed in ppr.conf */
+#define SPOOLFILE_HEADER_SIZE 512	/* directory at the front of a -spool file */
 
-#define MAX_PRINTERS 250			/* no more than 250 printers */
+#define MAX_PRINTERS 16384			/* printer ids which fit below the group ids */
 #define MAX_BINS 10					/* max bins per printer */
-#define MAX_GROUPS 150				/* no more than this may groups */
-#define MAX_GROUPSIZE 8				/* no more than 8 printers per group */
+#define MAX_GROUPS 16383			/* group ids which fit in an INT16_T destid */
 
 #define STATE_UPDATE_MAXLINES 1000
 #define STATE_UPDATE_PPRDRV_MAXBYTES 30000
@@ -354,8 +355,18 @@ const char *quote(const char *);
 gu_boolean destination_protected(const char destname[]);
 char *money(int amount_times_ten);
 const char *jobid(const char *destname, int id, int subid);
+long nextid_next(void);
+void *nextid_set_open(gu_boolean writable);
+void nextid_set_add(void *set, int id);
+void nextid_set_remove(void *set, int id);
+gu_boolean nextid_set_contains(void *set, int id);
+gu_boolean spoolfile_enabled(void);
+int spoolfile_finish(FILE *spool, FILE *comments, FILE *pages);
+FILE *spoolfile_open_section(const char qfname[], const char section[]);
 int pagesize(const char keyword[], char **corrected_keyword, double *width, double *length, gu_boolean *envelope);
 char *find_resource(const char res_type[], const char res_name[], double version, int revision, int *features);
+gu_boolean cached_body_name_ok(const char body[]);
+char *find_cached_body(const char body[], gu_boolean verify);
 int get_responder_width(const char *name);
 double convert_dimension(const char *string);
 void filter_options_error(int exlevel, struct OPTIONS_STATE *o, const char *format, ...)
@@ -377,6 +388,7 @@ char *ppd_readline(void);
 PPDOBJ ppdobj_new(const char ppdname[]);
 void ppdobj_free(PPDOBJ self);
 char *ppdobj_readline(PPDOBJ self);
+void *ppdobj_files(PPDOBJ self);
 void *ppd_finish_quoted_string(PPDOBJ self, char *initial_segment);
 char *ppd_finish_QuotedValue(PPDOBJ self, char *initial_segment);
 int ppd_decode_QuotedValue(char *p);
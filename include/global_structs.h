@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified: 10 October 2013
+** Last modified: 19 October 2026
 */
 
 /* =================== for pprd queue entries =====================*/
@@ -18,7 +18,7 @@ struct QEntry
 	{
 	/* encoded in queue file name */
 	INT16_T destid;					/* destination key number */
-	INT16_T id;						/* queue id */
+	int id;							/* queue id */
 	INT16_T subid;					/* fractional queue id */
 
 	/* encoding in "PPRD:" mini header */
@@ -31,8 +31,13 @@ struct QEntry
 
 	INT16_T media[MAX_DOCMEDIA];		/* list of id numbers of media types req. */
 	INT16_T pass;						/* number of current pass thru printers in group */
-	unsigned char never;				/* bitmap of group member which can't print */
-	unsigned char notnow;				/* bitmap of group members without required media mounted */
+	struct gu_bitset never;				/* offsets of group members which can't print */
+	struct gu_bitset notnow;			/* offsets of group members without required media mounted */
+	struct JOB_CAPS *caps;				/* pprd's summary of what it needs, may be NULL */
+	int pages;							/* pprd's estimate of sides in all copies, -1 if unknown */
+	INT16_T prerip;						/* pprd's PRERIP_* state */
+	int prerip_kbytes;					/* size of its pre-RIPed output */
+	int board_slot;						/* pprd's status board slot, -1 if none */
 	} ;
 
 /*
@@ -56,7 +61,7 @@ struct QEntry
 struct Jobname
 	{
 	const char *destname;
-	INT16_T id;
+	int id;
 	INT16_T subid;
 	} ;
 
@@ -204,12 +209,23 @@ struct QEntryFile
 #define WILDCARD_JOBID -1
 #define WILDCARD_SUBID -1
 
+/*
+** Parts of the queue file which ppop can ask pprd to include in a queue
+** listing.  If it asks for none of them, pprd doesn't open the queue files
+** at all.  The "EndAddon" line is always sent so that the reader can find
+** the end of the Addon section whether or not it asked for its lines.
+*/
+#define QF_PART_MISC 1					/* through "EndMisc", for qentryfile_load() */
+#define QF_PART_ADDON 2					/* the lines of the Addon section */
+#define QF_PART_REST 4					/* "Media:", "Reason:", and the rest */
+#define QF_PART_ALL 7
+
 void qentryfile_clear(struct QEntryFile *job);
 int qentryfile_load(struct QEntryFile *job, FILE *qfile);
 int qentryfile_save(const struct QEntryFile *qentry, FILE *Qfile);
 void qentryfile_free(struct QEntryFile *job);
 
-int parse_qfname(char *buffer, const char **destname, short int *id, short int *subid);
+int parse_qfname(char *buffer, const char **destname, int *id, short int *subid);
 int pagemask_encode(struct QEntryFile *job, const char pages[]);
 void  pagemask_print(const struct QEntryFile *job);
 int pagemask_get_bit(const struct QEntryFile *job, int page);
@@ -272,5 +288,75 @@ struct COMPUTED_CHARGE
 void compute_charge(struct COMPUTED_CHARGE *charge, int per_duplex_sheet, int per_simplex_sheet, int vpages,
 		int n_up_n, int vpages_per_sheet, int sigsheets, int sigpart, int copies);
 
+/* =============== compiled PPD images (libppr/ppdimage.c) ================ */
+
+/* Every compiled PPD image begins with this. */
+struct PPDIMAGE_HEADER {
+	int magic;					/* identifies the image type */
+	int version;				/* version of that type */
+	int image_size;
+	int ppdFile;				/* offset of PPD file name as given */
+	int file_count;				/* PPD file, includes, and PPD index */
+	int files;					/* offset of struct PPDIMAGE_FILE array */
+	} ;
+
+/* A file from which an image was compiled */
+struct PPDIMAGE_FILE {
+	int name;					/* offset of file name */
+	long mtime;
+	long size;
+	long ino;
+	} ;
+
+/* An image under construction */
+struct PPDIMAGE {
+	char *image;
+	int size;
+	int alloc;
+	} ;
+
+void ppdimage_begin(struct PPDIMAGE *b, int header_size, int magic, int version, const char ppdname[], void *files);
+int ppdimage_reserve(struct PPDIMAGE *b, int size);
+int ppdimage_string(struct PPDIMAGE *b, const char string[]);
+char *ppdimage_finish(struct PPDIMAGE *b);
+gu_boolean ppdimage_string_ok(const char *image, int offset);
+gu_boolean ppdimage_table_ok(const char *image, int offset, int count, int element_size);
+const char *ppdimage_load(const char fname[], int magic, int version, const char ppdname[], gu_boolean (*check)(const char *image));
+void ppdimage_unmap(const char *image);
+void ppdimage_save(const char fname[], const char *image);
+int ppdimage_hash(const char s1[], const char s2[], int tabsize);
+
+/* ============ structured print log (libppr/printlog.c) ============ */
+
+#define PRINTLOG_MAGIC 0x50524C31		/* "PRL1" */
+#define PRINTLOG_CURRENT "current"		/* segment being appended to */
+#define PRINTLOG_INDEX_SUFFIX ".idx"	/* index of a closed segment */
+
+/* One job.  The strings are truncated to fit and NUL terminated. */
+struct PRINTLOG_RECORD {
+	int magic;
+	int pages;					/* logical pages, -1 if unknown */
+	int sheets;					/* sheets in all copies */
+	int sides;					/* printed sides in all copies */
+	int charge;					/* in hundredths */
+	int pjl_pages;				/* sides the printer says it printed */
+	int pagecount_start;		/* printer's lifetime page count */
+	int pagecount_change;
+	int run_time;				/* pprdrv run time in hundredths of a second */
+	int reserved;
+	time_t submitted;
+	time_t printed;
+	long postscript_bytes;
+	long bytes_sent;
+	char jobid[48];
+	char printer[32];
+	char username[48];
+	char for_name[64];
+	char title[120];
+	} ;
+
+int printlog_append(const struct PRINTLOG_RECORD *record);
+int printlog_rotate(void);
+
 /* end of file */
 
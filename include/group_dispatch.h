@@ -0,0 +1,41 @@
+/*
+** mouse:~ppr/src/include/group_dispatch.h
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** The policies which decide which member of a group should print a group
+** job.  See libppr/group_dispatch.c.  They are used by pprd and by
+** ppr-dispatch-sim, which replays a print log to compare them.
+*/
+
+#define DISPATCH_ORDER 0			/* first member in the order listed */
+#define DISPATCH_ROTATE 1			/* first member after the one last used */
+#define DISPATCH_LEAST_PAGES 2		/* member with the fewest pages ahead of the job */
+#define DISPATCH_THROUGHPUT 3		/* member which should finish the job soonest */
+#define DISPATCH_AFFINITY 4			/* big jobs as throughput, small to slow members */
+
+#define DISPATCH_AFFINITY_PAGES 20	/* default size of a big job for affinity */
+
+/* What the caller knows about one member which could print the job. */
+struct DISPATCH_MEMBER {
+	int member;						/* offset in the group */
+	gu_boolean idle;				/* can start the job right now */
+	int outstanding;				/* pages it must print first, -1 if unknown */
+	double ppm;						/* measured pages per minute, 0.0 if unknown */
+	double cost;					/* set by dispatch_choose() */
+	int rank;						/* set by dispatch_choose() */
+	} ;
+
+int dispatch_policy_parse(const char name[]);
+const char *dispatch_policy_name(int policy);
+int dispatch_choose(int policy, int affinity_pages, int last, int group_members, struct DISPATCH_MEMBER members[], int count, int job_pages);
+
+/* end of file */
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 19 April 2006.
+** Last modified 19 October 2026.
 */
 
 /*! \file
@@ -485,6 +485,15 @@ char *gu_pch_nextkey(void *pch, void **value);
 int gu_pch_size(void *pch);
 int gu_hash(const char string[], int modus);
 
+/* Constant Database */
+void *gu_cdb_open(const char filename[]);
+void gu_cdb_close(void *cdb);
+const char *gu_cdb_find(void *cdb, const char key[], int *len);
+const char *gu_cdb_next(void *cdb, unsigned int *pos, int *key_len, const char **data, int *data_len);
+void *gu_cdb_make_new(const char filename[]);
+int gu_cdb_make_add(void *cdbm, const char key[], const char data[], int data_len);
+int gu_cdb_make_finish(void *cdbm, gu_boolean abort);
+
 /* Perl Compatible Array */
 void *gu_pca_new(int initial_size, int increment);
 void  gu_pca_free(void *pca);
@@ -501,6 +510,33 @@ char *gu_pca_join(const char separator[], void *array);
 void *gu_pcre_match(const char pattern[], const char string[]);
 void *gu_pcre_split(const char pattern[], const char string[]);
 
+/*===================================================================
+** Variable width bitsets
+===================================================================*/
+
+#define GU_BITSET_WORD_BITS (int)(sizeof(unsigned long) * 8)
+
+struct gu_bitset {
+	int nwords;					/* 0 if the bits are in u.word */
+	union {
+		unsigned long word;		/* storage for small sets */
+		unsigned long *words;	/* storage for large sets */
+		} u;
+	} ;
+
+void gu_bitset_init(struct gu_bitset *set);
+void gu_bitset_free(struct gu_bitset *set);
+void gu_bitset_set(struct gu_bitset *set, int n);
+void gu_bitset_clear(struct gu_bitset *set, int n);
+gu_boolean gu_bitset_test(const struct gu_bitset *set, int n);
+void gu_bitset_clear_all(struct gu_bitset *set);
+gu_boolean gu_bitset_any(const struct gu_bitset *set);
+gu_boolean gu_bitset_all(const struct gu_bitset *set, int n);
+gu_boolean gu_bitset_all_either(const struct gu_bitset *set, const struct gu_bitset *other, int n);
+int gu_bitset_next_clear(const struct gu_bitset *set, const struct gu_bitset *other, int start, int limit);
+char *gu_bitset_format(const struct gu_bitset *set);
+int gu_bitset_parse(struct gu_bitset *set, const char str[]);
+
 /*===================================================================
 ** HTTP functions
 ===================================================================*/
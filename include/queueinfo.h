@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 9 September 2010.
+** Last modified 19 October 2026.
 */
 
 /* An opaque type declaration */
@@ -46,6 +46,7 @@ gu_boolean  queueinfo_transparentMode(QUEUE_INFO qip);
 gu_boolean queueinfo_psPassThru(QUEUE_INFO qip);
 gu_boolean  queueinfo_binaryOK(QUEUE_INFO qip);
 const char *queueinfo_ppdFile(QUEUE_INFO qip);
+gu_boolean  queueinfo_ppdLoaded(QUEUE_INFO qip);
 const char *queueinfo_product(QUEUE_INFO qip);
 int         queueinfo_psLanguageLevel(QUEUE_INFO qip);
 const char *queueinfo_shortNickName(QUEUE_INFO qip);
@@ -55,6 +56,8 @@ int         queueinfo_psRevision(QUEUE_INFO qip);
 int         queueinfo_psFreeVM(QUEUE_INFO qip);
 const char *queueinfo_resolution(QUEUE_INFO qip);			/* "300dpi", "600x300dpi" */
 gu_boolean  queueinfo_colorDevice(QUEUE_INFO qip);
+gu_boolean  queueinfo_duplex(QUEUE_INFO qip);
+gu_boolean  queueinfo_duplexTumble(QUEUE_INFO qip);
 const char *queueinfo_faxSupport(QUEUE_INFO qip);			/* "Base" */
 const char *queueinfo_ttRasterizer(QUEUE_INFO qip);			/* "None", "Type42", "Accept68K" */
 gu_boolean  queueinfo_chargeExists(QUEUE_INFO qip);
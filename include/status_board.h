@@ -0,0 +1,105 @@
+/*
+** mouse:~ppr/src/include/status_board.h
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** The layout of the status board (STATUS_BOARD_FILE) which pprd and pprdrv
+** keep up to date and which queue display programs map into memory.  See
+** libppr/status_board.c.  The file is a header followed by the printer
+** slots and then the job slots.
+*/
+
+#define STATUS_BOARD_MAGIC 0x50505342		/* "PPSB" */
+#define STATUS_BOARD_VERSION 1
+
+#define STATUS_BOARD_PRINTERS 16384			/* same as MAX_PRINTERS in pprd */
+#define STATUS_BOARD_JOBS 50000				/* same as QUEUE_SIZE_MAX in pprd */
+#define STATUS_BOARD_NAME_MAX 64
+#define STATUS_BOARD_MESSAGE_MAX 128
+
+struct STATUS_BOARD_HEADER {
+	int magic;
+	int version;
+	volatile int stale;					/* set when pprd starts a new board */
+	int printer_slots;
+	int job_slots;
+	volatile int printers_used;			/* no printer slot at or above this used */
+	volatile int jobs_used;				/* no job slot at or above this used */
+	volatile unsigned int events;		/* number of the last change */
+	long started;						/* time at which pprd created it */
+	int pad[6];
+	};
+
+/*
+** The slot for a printer is indexed by its pprd printer id.  The first part
+** belongs to pprd and the second to the pprdrv which is printing on it.  Each
+** part has its own sequence number which is odd while it is being changed,
+** and records in changed the number of the event which last changed it.
+*/
+struct STATUS_BOARD_PRINTER {
+	volatile unsigned int seq;
+	unsigned int changed;
+	char name[STATUS_BOARD_NAME_MAX];	/* empty if slot is not in use */
+	int status;							/* PRNSTATUS_* */
+	int retry;							/* retry number if fault or engaged */
+	int countdown;						/* seconds until that retry */
+	char job_destname[STATUS_BOARD_NAME_MAX];	/* job being printed, if any */
+	int job_id;
+	int job_subid;
+
+	volatile unsigned int drv_seq;
+	unsigned int drv_changed;
+	int drv_job_id;						/* job to which these figures belong */
+	int drv_job_subid;
+	int pages_started;
+	int pages_printed;
+	long bytes_sent;
+	long bytes_total;
+	char message[STATUS_BOARD_MESSAGE_MAX];	/* last status message from printer */
+	};
+
+/*
+** There is a job slot for each job in pprd's queue.  The slots are not in
+** queue order.
+*/
+struct STATUS_BOARD_JOB {
+	volatile unsigned int seq;
+	unsigned int changed;
+	char destname[STATUS_BOARD_NAME_MAX];	/* empty if slot is not in use */
+	int id;
+	int subid;
+	int priority;
+	int status;							/* STATUS_*, or printer slot if printing */
+	};
+
+/* A mapped board. */
+struct STATUS_BOARD {
+	struct STATUS_BOARD_HEADER *header;
+	struct STATUS_BOARD_PRINTER *printers;
+	struct STATUS_BOARD_JOB *jobs;
+	size_t size;
+	};
+
+struct STATUS_BOARD *status_board_create(void);
+struct STATUS_BOARD *status_board_open(gu_boolean writable);
+void status_board_close(struct STATUS_BOARD *board);
+void status_board_write_begin(volatile unsigned int *seq);
+void status_board_write_end(struct STATUS_BOARD *board, volatile unsigned int *seq, unsigned int *changed);
+unsigned int status_board_events(const struct STATUS_BOARD *board);
+gu_boolean status_board_is_stale(const struct STATUS_BOARD *board);
+gu_boolean status_board_printer_changed(const struct STATUS_BOARD *board, int slot, unsigned int since);
+gu_boolean status_board_job_changed(const struct STATUS_BOARD *board, int slot, unsigned int since);
+int status_board_read_printer(const struct STATUS_BOARD *board, int slot, struct STATUS_BOARD_PRINTER *copy);
+int status_board_read_job(const struct STATUS_BOARD *board, int slot, struct STATUS_BOARD_JOB *copy);
+const char *status_board_printer_status_word(int status);
+const char *status_board_job_status_word(int status);
+
+/* end of file */
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 9 September 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -240,22 +240,18 @@ void cups_add_modify_class(struct IPP *ipp)
 	/* This must be first in case we are creating the printer. */
 	if(retcode == 0 && (attr = ipp_claim_attribute(ipp, IPP_TAG_PRINTER, IPP_TAG_URI, "member-uris")))
 		{
-		const char *args[4 + MAX_GROUPSIZE];
-		int si = 0, di = 0;
+		const char **args = gu_alloc(5 + attr->num_values, sizeof(const char *));
+		int si, di = 0;
 
-		if(attr->num_values > MAX_GROUPSIZE)
-			{
-			ipp->response_code = IPP_BAD_REQUEST;
-			return;
-			}
-		
 		args[di++] = PPAD_PATH;
 		args[di++] = "group";
 		args[di++] = "members";
-		while(di < attr->num_values)
+		args[di++] = printer_uri->basename;
+		for(si=0; si < attr->num_values; si++)
 			args[di++] = attr->values[si].string.text;
 		args[di++] = NULL;
 		retcode = runv(PPAD_PATH, args);
+		gu_free(args);
 		}
 
 	/* Set other attributes */
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 4 September 2008.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -465,19 +465,18 @@ static void add_queue_attributes(struct IPP *ipp, struct REQUEST_ATTRS *req, QUE
 		{
 	   	if(request_attrs_attr_requested(req, "member-names") || request_attrs_attr_requested(req, "member-uris"))
 			{
-			int iii;
-			const char *members[MAX_GROUPSIZE];
-			const char *temp;
-			for(iii=0; iii < MAX_GROUPSIZE; iii++)
-				{
-				if(!(temp = queueinfo_membername(qip, iii)))
-					break;
-				members[iii] = queueinfo_hoist_value(qip, temp);
-				}
+			int iii, count;
+			const char **members;
+			for(count=0; queueinfo_membername(qip, count); count++)
+				;
+			members = gu_alloc(count + 1, sizeof(const char *));
+			for(iii=0; iii < count; iii++)
+				members[iii] = queueinfo_hoist_value(qip, queueinfo_membername(qip, iii));
 	   		if(request_attrs_attr_requested(req, "member-names"))
 				ipp_add_strings(ipp, IPP_TAG_PRINTER, IPP_TAG_NAME, "member-names", iii, members);
 	   		if(request_attrs_attr_requested(req, "member-uris"))
 				ipp_add_templates(ipp, IPP_TAG_PRINTER, IPP_TAG_NAME, "member-uris", "/printers/%s", iii, members);
+			gu_free(members);
 			}
 		}
 
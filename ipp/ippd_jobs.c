@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 5 August 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -39,7 +39,7 @@ struct IPP_QUEUE_ENTRY {
 	INT16_T priority;
 	unsigned int sequence_number;
 	const char *destname;
-	INT16_T id;
+	int id;
 	INT16_T subid;
 	};
 
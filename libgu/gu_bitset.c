@@ -0,0 +1,248 @@
+/*
+** mouse:~ppr/src/libgu/gu_bitset.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*! \file
+
+Variable Width Bitsets
+
+A struct gu_bitset holds a set of small non-negative integers, such as the
+offsets of group members.  Sets of up to GU_BITSET_WORD_BITS members are kept
+in the structure itself, so a set which never grows that large never calls
+malloc().  Larger sets grow as needed.  A structure full of zero bytes is a
+valid empty set, so one need not call gu_bitset_init() on memory which has
+been cleared.
+
+Since a large set points to memory which it owns, a structure containing one
+may be moved with memcpy() but must not be copied and then used in both
+places.  That memory is obtained from malloc() directly rather than from
+gu_alloc() so that it does not become part of whatever memory pool happens
+to be current when a set grows.  Sets in pprd's queue outlive the pool which
+surrounds each ppop command.
+
+*/
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "gu.h"
+
+/* Return a pointer to the words which hold the set and the number of them. */
+#define WORDS(set) ((set)->nwords ? (set)->u.words : &(set)->u.word)
+#define NWORDS(set) ((set)->nwords ? (set)->nwords : 1)
+
+/* A word with the low n bits set, for 0 <= n <= GU_BITSET_WORD_BITS. */
+#define LOW_BITS(n) ((n) >= GU_BITSET_WORD_BITS ? ~0UL : ((1UL << (n)) - 1))
+
+/** Initialize a bitset to empty
+*/
+void gu_bitset_init(struct gu_bitset *set)
+	{
+	set->nwords = 0;
+	set->u.word = 0;
+	}
+
+/** Free the storage of a bitset and leave it empty
+*/
+void gu_bitset_free(struct gu_bitset *set)
+	{
+	if(set->nwords)
+		free(set->u.words);
+	gu_bitset_init(set);
+	}
+
+/* Make sure the set has room for bit n. */
+static void gu_bitset_grow(struct gu_bitset *set, int n)
+	{
+	int needed = n / GU_BITSET_WORD_BITS + 1;
+	if(needed > NWORDS(set))
+		{
+		unsigned long *words;
+		if(set->nwords)
+			{
+			if(!(words = realloc(set->u.words, needed * sizeof(unsigned long))))
+				gu_CodeThrow(errno, "gu_bitset_grow(): realloc() failed, errno=%d (%s)", errno, gu_strerror(errno));
+			}
+		else
+			{
+			if(!(words = malloc(needed * sizeof(unsigned long))))
+				gu_CodeThrow(errno, "gu_bitset_grow(): malloc() failed, errno=%d (%s)", errno, gu_strerror(errno));
+			words[0] = set->u.word;
+			set->nwords = 1;
+			}
+		memset(&words[set->nwords], 0, (needed - set->nwords) * sizeof(unsigned long));
+		set->u.words = words;
+		set->nwords = needed;
+		}
+	}
+
+/** Add n to the set
+*/
+void gu_bitset_set(struct gu_bitset *set, int n)
+	{
+	gu_bitset_grow(set, n);
+	WORDS(set)[n / GU_BITSET_WORD_BITS] |= (1UL << (n % GU_BITSET_WORD_BITS));
+	}
+
+/** Remove n from the set
+*/
+void gu_bitset_clear(struct gu_bitset *set, int n)
+	{
+	if(n / GU_BITSET_WORD_BITS < NWORDS(set))
+		WORDS(set)[n / GU_BITSET_WORD_BITS] &= ~(1UL << (n % GU_BITSET_WORD_BITS));
+	}
+
+/** Return TRUE if n is in the set
+*/
+gu_boolean gu_bitset_test(const struct gu_bitset *set, int n)
+	{
+	if(n < 0 || n / GU_BITSET_WORD_BITS >= NWORDS(set))
+		return FALSE;
+	return (WORDS(set)[n / GU_BITSET_WORD_BITS] & (1UL << (n % GU_BITSET_WORD_BITS))) ? TRUE : FALSE;
+	}
+
+/** Empty the set without freeing its storage
+*/
+void gu_bitset_clear_all(struct gu_bitset *set)
+	{
+	memset(WORDS(set), 0, NWORDS(set) * sizeof(unsigned long));
+	}
+
+/** Return TRUE if the set is not empty
+*/
+gu_boolean gu_bitset_any(const struct gu_bitset *set)
+	{
+	const unsigned long *words = WORDS(set);
+	int x;
+	for(x=0; x < NWORDS(set); x++)
+		{
+		if(words[x])
+			return TRUE;
+		}
+	return FALSE;
+	}
+
+/* Return word x of the set, or zero if it is beyond the end. */
+static unsigned long gu_bitset_word(const struct gu_bitset *set, int x)
+	{
+	return x < NWORDS(set) ? WORDS(set)[x] : 0;
+	}
+
+/** Return TRUE if 0 thru n-1 are all in the set or in the other set
+ * The other set may be NULL.
+*/
+gu_boolean gu_bitset_all_either(const struct gu_bitset *set, const struct gu_bitset *other, int n)
+	{
+	int x;
+	for(x=0; n > 0; x++, n -= GU_BITSET_WORD_BITS)
+		{
+		unsigned long want = LOW_BITS(n);
+		unsigned long have = gu_bitset_word(set, x);
+		if(other)
+			have |= gu_bitset_word(other, x);
+		if((have & want) != want)
+			return FALSE;
+		}
+	return TRUE;
+	}
+
+/** Return TRUE if 0 thru n-1 are all in the set
+*/
+gu_boolean gu_bitset_all(const struct gu_bitset *set, int n)
+	{
+	return gu_bitset_all_either(set, NULL, n);
+	}
+
+/** Return the first number from start thru limit-1 which is in neither set
+ * The other set may be NULL.  Whole words which are full are skipped.  If
+ * there is no such number, -1 is returned.
+*/
+int gu_bitset_next_clear(const struct gu_bitset *set, const struct gu_bitset *other, int start, int limit)
+	{
+	int n = start;
+	while(n < limit)
+		{
+		int x = n / GU_BITSET_WORD_BITS;
+		unsigned long have = gu_bitset_word(set, x);
+		if(other)
+			have |= gu_bitset_word(other, x);
+		have |= LOW_BITS(n % GU_BITSET_WORD_BITS);		/* treat those before start as set */
+		if(have != ~0UL)
+			{
+			int bit = n % GU_BITSET_WORD_BITS;
+			while(have & (1UL << bit))
+				bit++;
+			n = x * GU_BITSET_WORD_BITS + bit;
+			return n < limit ? n : -1;
+			}
+		n = (x + 1) * GU_BITSET_WORD_BITS;
+		}
+	return -1;
+	}
+
+/** Format the set as a hexadecimal number
+ * Bit 0 is the least significant bit of the last digit.  Leading zeros are
+ * dropped, so an empty set is "0".  The caller should gu_free() the result.
+*/
+char *gu_bitset_format(const struct gu_bitset *set)
+	{
+	const unsigned long *words = WORDS(set);
+	int digits_per_word = GU_BITSET_WORD_BITS / 4;
+	char *str = gu_alloc(NWORDS(set) * digits_per_word + 1, sizeof(char));
+	char *p = str;
+	int x, y;
+	for(x = NWORDS(set) - 1; x >= 0; x--)
+		{
+		for(y = digits_per_word - 1; y >= 0; y--)
+			{
+			int digit = (words[x] >> (y * 4)) & 0x0F;
+			if(digit || p > str || (x == 0 && y == 0))
+				*p++ = "0123456789abcdef"[digit];
+			}
+		}
+	*p = '\0';
+	return str;
+	}
+
+/** Set the bitset from a hexadecimal number in the form gu_bitset_format() produces
+ * Returns -1 if the string contains anything other than hexadecimal digits.
+*/
+int gu_bitset_parse(struct gu_bitset *set, const char str[])
+	{
+	int len = strlen(str);
+	int x;
+
+	gu_bitset_clear_all(set);
+	if(len == 0)
+		return -1;
+	for(x=0; x < len; x++)
+		{
+		int c = str[len - 1 - x];
+		int digit, y;
+		if(c >= '0' && c <= '9')
+			digit = c - '0';
+		else if(c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if(c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			return -1;
+		for(y=0; y < 4; y++)
+			{
+			if(digit & (1 << y))
+				gu_bitset_set(set, x * 4 + y);
+			}
+		}
+	return 0;
+	}
+
+/* end of file */
@@ -0,0 +1,363 @@
+/*
+** mouse:~ppr/src/libgu/gu_cdb.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*! \file
+
+This module implements reading and writing of constant databases in the
+format invented by D. J. Bernstein for his cdb package.  A constant
+database is written once and then used for fast lookups.  A lookup
+generally touches only two pages of the file, so it costs the same
+whether the database holds ten records or ten thousand.
+
+The file starts with 256 pairs of 32 bit numbers, each giving the
+position and number of slots of one hash table.  Then come the records,
+each of which is the key length, the data length, the key, and the data.
+Finally come the hash tables, each slot of which is the hash value and
+the position of a record.  All numbers are little-endian.
+
+Databases are opened with gu_cdb_open() which maps them into memory.
+They are written by calling gu_cdb_make_new(), gu_cdb_make_add() for each
+record, and gu_cdb_make_finish() which writes the file under a temporary
+name and renames it into place.
+
+*/
+
+#include "config.h"
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gu.h"
+
+#define HEADER_SIZE 2048
+
+struct CDB {
+	const unsigned char *map;
+	unsigned int size;
+	};
+
+struct CDB_MAKE_RECORD {
+	unsigned int hash;
+	unsigned int pos;
+	};
+
+struct CDB_MAKE {
+	char *filename;
+	char *temp_filename;
+	int fd;
+	unsigned int pos;					/* where the next record goes */
+	struct CDB_MAKE_RECORD *records;
+	int record_count;
+	int record_space;
+	};
+
+static unsigned int cdb_hash(const char key[], int len)
+	{
+	unsigned int h = 5381;
+	while(len-- > 0)
+		h = ((h << 5) + h) ^ (unsigned char)*key++;
+	return h & 0xFFFFFFFF;
+	}
+
+static unsigned int unpack(const unsigned char *p)
+	{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+	}
+
+static void pack(unsigned char *p, unsigned int n)
+	{
+	p[0] = n & 0xFF;
+	p[1] = (n >> 8) & 0xFF;
+	p[2] = (n >> 16) & 0xFF;
+	p[3] = (n >> 24) & 0xFF;
+	}
+
+/** Open a constant database
+
+This function maps the named constant database into memory and returns a
+pointer to an object which may be passed to gu_cdb_find().  If the file
+can't be opened or is too short to be a constant database, NULL is returned
+and errno is set.
+
+*/
+void *gu_cdb_open(const char filename[])
+	{
+	int fd;
+	struct stat statbuf;
+	void *map;
+	struct CDB *cdb;
+
+	if((fd = open(filename, O_RDONLY)) == -1)
+		return NULL;
+	if(fstat(fd, &statbuf) == -1)
+		{
+		close(fd);
+		return NULL;
+		}
+	if(statbuf.st_size < HEADER_SIZE)
+		{
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+		}
+	map = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+		return NULL;
+
+	cdb = gu_alloc(1, sizeof(struct CDB));
+	cdb->map = map;
+	cdb->size = statbuf.st_size;
+	return (void*)cdb;
+	} /* end of gu_cdb_open() */
+
+/** Close a constant database
+*/
+void gu_cdb_close(void *p)
+	{
+	struct CDB *cdb = (struct CDB *)p;
+	munmap((void*)cdb->map, cdb->size);
+	gu_free(cdb);
+	}
+
+/** Look up a key in a constant database
+
+This function returns a pointer to the data of the first record with the
+indicated key, or NULL if there is none.  The length of the data is stored
+in *len.  The data is not NUL terminated and remains valid until the
+database is closed.
+
+*/
+const char *gu_cdb_find(void *p, const char key[], int *len)
+	{
+	struct CDB *cdb = (struct CDB *)p;
+	int key_len = strlen(key);
+	unsigned int h = cdb_hash(key, key_len);
+	const unsigned char *header = cdb->map + (h & 0xFF) * 8;
+	unsigned int table_pos = unpack(header);
+	unsigned int slots = unpack(header + 4);
+	unsigned int slot, i;
+
+	if(slots == 0 || table_pos > cdb->size || slots > (cdb->size - table_pos) / 8)
+		return NULL;
+
+	for(i = 0, slot = (h >> 8) % slots; i < slots; i++, slot = (slot + 1) % slots)
+		{
+		const unsigned char *entry = cdb->map + table_pos + slot * 8;
+		unsigned int record_pos = unpack(entry + 4);
+		unsigned int record_key_len, record_data_len;
+
+		if(record_pos == 0)
+			break;
+		if(unpack(entry) != h)
+			continue;
+		if(record_pos > cdb->size - 8)
+			break;
+		record_key_len = unpack(cdb->map + record_pos);
+		record_data_len = unpack(cdb->map + record_pos + 4);
+		if(record_key_len != key_len || record_key_len > cdb->size - record_pos - 8
+				|| record_data_len > cdb->size - record_pos - 8 - record_key_len)
+			continue;
+		if(memcmp(cdb->map + record_pos + 8, key, key_len) == 0)
+			{
+			*len = record_data_len;
+			return (const char *)(cdb->map + record_pos + 8 + key_len);
+			}
+		}
+
+	return NULL;
+	} /* end of gu_cdb_find() */
+
+/** Step through the records of a constant database
+
+This function returns the key of the record which follows the position
+stored in *pos, which should be zero for the first call, and advances *pos.
+The key is not NUL terminated.  Its length is stored in *key_len and the
+data and its length in *data and *data_len.  When there are no more
+records, NULL is returned.
+
+*/
+const char *gu_cdb_next(void *p, unsigned int *pos, int *key_len, const char **data, int *data_len)
+	{
+	struct CDB *cdb = (struct CDB *)p;
+	unsigned int records_end = unpack(cdb->map);	/* the first hash table follows the records */
+	unsigned int record_key_len, record_data_len;
+	const char *key;
+
+	if(*pos < HEADER_SIZE)
+		*pos = HEADER_SIZE;
+	if(records_end > cdb->size || *pos > records_end || records_end - *pos < 8)
+		return NULL;
+
+	record_key_len = unpack(cdb->map + *pos);
+	record_data_len = unpack(cdb->map + *pos + 4);
+	if(record_key_len > records_end - *pos - 8 || record_data_len > records_end - *pos - 8 - record_key_len)
+		return NULL;
+
+	key = (const char *)(cdb->map + *pos + 8);
+	*key_len = record_key_len;
+	*data = key + record_key_len;
+	*data_len = record_data_len;
+	*pos += 8 + record_key_len + record_data_len;
+	return key;
+	} /* end of gu_cdb_next() */
+
+/** Start writing a constant database
+
+This function creates a temporary file in the same directory as the named
+database and returns an object which should be passed to gu_cdb_make_add()
+and gu_cdb_make_finish().  If the temporary file can't be created, NULL is
+returned and errno is set.
+
+*/
+void *gu_cdb_make_new(const char filename[])
+	{
+	struct CDB_MAKE *cdbm;
+
+	cdbm = gu_alloc(1, sizeof(struct CDB_MAKE));
+	cdbm->filename = gu_strdup(filename);
+	gu_asprintf(&cdbm->temp_filename, "%s.%ld", filename, (long)getpid());
+	if((cdbm->fd = open(cdbm->temp_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1)
+		{
+		int saved_errno = errno;
+		gu_free(cdbm->filename);
+		gu_free(cdbm->temp_filename);
+		gu_free(cdbm);
+		errno = saved_errno;
+		return NULL;
+		}
+
+	/* Leave room for the header which we will write at the end. */
+	lseek(cdbm->fd, HEADER_SIZE, SEEK_SET);
+
+	cdbm->pos = HEADER_SIZE;
+	cdbm->record_count = 0;
+	cdbm->record_space = 256;
+	cdbm->records = gu_alloc(cdbm->record_space, sizeof(struct CDB_MAKE_RECORD));
+	return (void*)cdbm;
+	} /* end of gu_cdb_make_new() */
+
+/** Add a record to a constant database under construction
+
+If the same key is added more than once, gu_cdb_find() will return the
+data of the first record.  Returns 0 on success, -1 on failure.
+
+*/
+int gu_cdb_make_add(void *p, const char key[], const char data[], int data_len)
+	{
+	struct CDB_MAKE *cdbm = (struct CDB_MAKE *)p;
+	int key_len = strlen(key);
+	unsigned char lengths[8];
+
+	if(cdbm->record_count == cdbm->record_space)
+		{
+		cdbm->record_space *= 2;
+		cdbm->records = gu_realloc(cdbm->records, cdbm->record_space, sizeof(struct CDB_MAKE_RECORD));
+		}
+	cdbm->records[cdbm->record_count].hash = cdb_hash(key, key_len);
+	cdbm->records[cdbm->record_count].pos = cdbm->pos;
+	cdbm->record_count++;
+
+	pack(lengths, key_len);
+	pack(lengths + 4, data_len);
+	if(write(cdbm->fd, lengths, 8) != 8
+			|| write(cdbm->fd, key, key_len) != key_len
+			|| write(cdbm->fd, data, data_len) != data_len)
+		return -1;
+	cdbm->pos += 8 + key_len + data_len;
+	return 0;
+	} /* end of gu_cdb_make_add() */
+
+/** Finish writing a constant database
+
+This function writes the hash tables and the header and renames the
+temporary file into place.  If abort is TRUE, the temporary file is removed
+instead.  Returns 0 on success, -1 on failure.
+
+*/
+int gu_cdb_make_finish(void *p, gu_boolean abort)
+	{
+	struct CDB_MAKE *cdbm = (struct CDB_MAKE *)p;
+	unsigned char header[HEADER_SIZE];
+	int counts[256];
+	int retval = 0;
+	int i, x;
+
+	if(abort)
+		retval = -1;
+
+	memset(counts, 0, sizeof(counts));
+	for(i=0; i < cdbm->record_count; i++)
+		counts[cdbm->records[i].hash & 0xFF]++;
+
+	/* Build each hash table, write it out, and note it in the header.  The
+	 * records are inserted in the order in which they were added so that
+	 * the first record with a given key is the first one found. */
+	for(x=0; retval == 0 && x < 256; x++)
+		{
+		int slots = counts[x] * 2;
+		unsigned char *table = NULL;
+
+		pack(header + x * 8, cdbm->pos);
+		pack(header + x * 8 + 4, slots);
+		if(slots == 0)
+			continue;
+
+		table = gu_alloc(slots * 8, sizeof(unsigned char));
+		memset(table, 0, slots * 8);
+		for(i=0; i < cdbm->record_count; i++)
+			{
+			unsigned int h = cdbm->records[i].hash;
+			int slot;
+			if((h & 0xFF) != x)
+				continue;
+			for(slot = (h >> 8) % slots; unpack(table + slot * 8 + 4) != 0; slot = (slot + 1) % slots)
+				;
+			pack(table + slot * 8, h);
+			pack(table + slot * 8 + 4, cdbm->records[i].pos);
+			}
+		if(write(cdbm->fd, table, slots * 8) != slots * 8)
+			retval = -1;
+		cdbm->pos += slots * 8;
+		gu_free(table);
+		}
+
+	if(retval == 0)
+		{
+		if(lseek(cdbm->fd, 0, SEEK_SET) == -1 || write(cdbm->fd, header, sizeof(header)) != sizeof(header))
+			retval = -1;
+		}
+
+	if(close(cdbm->fd) == -1)
+		retval = -1;
+
+	if(retval == 0 && rename(cdbm->temp_filename, cdbm->filename) == -1)
+		retval = -1;
+
+	if(retval == -1)
+		{
+		int saved_errno = errno;
+		unlink(cdbm->temp_filename);
+		errno = saved_errno;
+		}
+
+	gu_free(cdbm->records);
+	gu_free(cdbm->filename);
+	gu_free(cdbm->temp_filename);
+	gu_free(cdbm);
+	return retval;
+	} /* end of gu_cdb_make_finish() */
+
+/* end of file */
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 9 September 2005.
+** Last modified 19 October 2026.
 */
 
 /*+ \file
@@ -464,10 +464,11 @@ char *gu_ini_query(const char file_name[], const char section_name[], const char
 	FILE *cf = fopen(file_name, "r");
 	struct GU_INI_ENTRY *section = gu_ini_section_load(cf, section_name);
 	const char *value = gu_ini_value_index(gu_ini_section_get_value(section, key_name), index, default_value);
+	char *copy = value ? gu_strdup(value) : NULL;	/* value may point into section */
 	gu_ini_section_free(section);
 	if(cf)
 		fclose(cf);
-	return value ? gu_strdup(value) : NULL;
+	return copy;
 	} /* end of gu_ini_query() */
 
 /** Copy missing section from sample file to INI file
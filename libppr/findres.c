@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 16 March 2005.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -34,21 +34,48 @@
 ** one is the "permanent cache".  This is located in /usr/share/ppr/cache.  Files
 ** must be deliverately placed in the cache.  The second is the "automatic
 ** cache".  Files are placed in this cache automatically when they are found
-** in incoming print jobs.
+** in incoming print jobs (see ppr/ppr_rcache.c).  Since anyone can submit a
+** job, the automatic cache is not searched by name.  Instead, a job from
+** which ppr has removed a resource names the body it removed by its MD5
+** digest and length and find_cached_body() checks that the file in the
+** cache still has that digest.
+**
+** Fonts are located using the font index which lib/indexfonts builds.  It
+** writes both a text version and a hashed version (a constant database,
+** see libgu/gu_cdb.c).  We use the hashed version if it is at least as new
+** as the text version.  Since a job may ask for the same font many times,
+** the answers (including negative ones) are cached for the life of the
+** process.  Long-running processes recheck the index files once a minute.
 */
 
 #include "config.h"
 #include <stdio.h>
+#include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
 #include <errno.h>
+#include <unistd.h>
 #include <string.h>
 #include <stdlib.h>
 #ifdef INTERNATIONAL
 #include <libintl.h>
 #endif
 #include "gu.h"
+#include "gu_md5.h"
 #include "global_defines.h"
 
+/* These are variables so that the test program can substitute others. */
+static const char *fontindex_filename = FONT_INDEX;
+static const char *fontindex_cdb_filename = FONT_INDEX_CDB;
+
+static void *fontindex_cdb = NULL;		/* open hashed index */
+static void *fontindex_cache = NULL;	/* previous answers */
+static time_t fontindex_checked = 0;	/* when we last looked at the files */
+static time_t fontindex_mtime = 0;		/* mtime of text index at that time */
+static time_t fontindex_cdb_mtime = 0;	/* mtime of hashed index at that time */
+
+#define FONTINDEX_CHECK_INTERVAL 60
 static char *try_resource_dir(const char cachedir[],
 				const char res_type[], const char res_name[],
 				double version, int revision)
@@ -69,10 +96,13 @@ static char *try_resource_dir(const char cachedir[],
 	return (char*)NULL;
 	}
 
-static char *try_fontindex(const char res_name[], int *features)
+/*
+** Search the text version of the font index.  This reads the whole file.
+*/
+static char *try_fontindex_text(const char res_name[], int *features)
 	{
-	const char function[] = "try_fontindex";
-	const char filename[] = FONT_INDEX;
+	const char function[] = "try_fontindex_text";
+	const char *filename = fontindex_filename;
 	FILE *dbf;
 	char *line = NULL;
 	int line_space = 256;
@@ -114,6 +144,136 @@ static char *try_fontindex(const char res_name[], int *features)
 
 	fclose(dbf);
 
+	return answer;
+	} /* end of try_fontindex_text() */
+
+/*
+** Search the hashed version of the font index.  The data part of each
+** record is the font features and the file name separated by a colon.
+*/
+static char *try_fontindex_cdb(const char res_name[], int *features)
+	{
+	const char *data;
+	int len;
+	const char *p;
+
+	if(!(data = gu_cdb_find(fontindex_cdb, res_name, &len)))
+		return NULL;
+	if(!(p = memchr(data, ':', len)) || p == data || (p - data + 1) == len)
+		{
+		error("try_fontindex_cdb(): entry for \"%s\" in \"%s\" is invalid", res_name, fontindex_cdb_filename);
+		return NULL;
+		}
+	if(features)
+		*features = atoi(data);
+	p++;
+	return gu_strndup(p, len - (p - data));
+	} /* end of try_fontindex_cdb() */
+
+/*
+** Throw away the cached answers and close the hashed index.
+*/
+static void fontindex_flush(void)
+	{
+	if(fontindex_cache)
+		{
+		char *key;
+		void *value;
+		for(gu_pch_rewind(fontindex_cache); (key = gu_pch_nextkey(fontindex_cache, &value)); )
+			{
+			gu_free(key);
+			gu_free(value);
+			}
+		gu_pch_free(fontindex_cache);
+		fontindex_cache = NULL;
+		}
+	if(fontindex_cdb)
+		{
+		gu_cdb_close(fontindex_cdb);
+		fontindex_cdb = NULL;
+		}
+	} /* end of fontindex_flush() */
+
+/*
+** Make sure the cache and the hashed index are ready for use.  If the index
+** files have been replaced since we last looked, start over.
+*/
+static void fontindex_check(void)
+	{
+	time_t now = time(NULL);
+	struct stat statbuf;
+	time_t mtime, cdb_mtime;
+
+	if(fontindex_cache && (now - fontindex_checked) < FONTINDEX_CHECK_INTERVAL && now >= fontindex_checked)
+		return;
+
+	fontindex_checked = now;
+	mtime = stat(fontindex_filename, &statbuf) == 0 ? statbuf.st_mtime : 0;
+	cdb_mtime = stat(fontindex_cdb_filename, &statbuf) == 0 ? statbuf.st_mtime : 0;
+
+	if(fontindex_cache && mtime == fontindex_mtime && cdb_mtime == fontindex_cdb_mtime)
+		return;
+
+	fontindex_flush();
+	fontindex_mtime = mtime;
+	fontindex_cdb_mtime = cdb_mtime;
+
+	/* These last for the life of the process, so keep them out of any
+	   memory pool the caller may have pushed. */
+	gu_pool_suspend(TRUE);
+	fontindex_cache = gu_pch_new(64);
+
+	/* If the hashed index is older than the text one, someone has edited
+	   the text one or indexfonts failed part way through. */
+	if(cdb_mtime && cdb_mtime >= mtime)
+		fontindex_cdb = gu_cdb_open(fontindex_cdb_filename);
+	gu_pool_suspend(FALSE);
+	} /* end of fontindex_check() */
+
+/*
+** Look up a font in the font index.  The cached answer is stored as a
+** string containing the features and the file name or as an empty string
+** if the font is not in the index.
+*/
+static char *try_fontindex(const char res_name[], int *features)
+	{
+	const char *cached;
+	char *answer;
+	int answer_features = 0;
+
+	fontindex_check();
+
+	if((cached = gu_pch_get(fontindex_cache, res_name)))
+		{
+		const char *p;
+		if(!*cached || !(p = strchr(cached, ':')))
+			return NULL;
+		if(features)
+			*features = atoi(cached);
+		return gu_strdup(p + 1);
+		}
+
+	if(fontindex_cdb)
+		answer = try_fontindex_cdb(res_name, &answer_features);
+	else
+		answer = try_fontindex_text(res_name, &answer_features);
+
+	gu_pool_suspend(TRUE);
+	if(answer)
+		{
+		char *value;
+		gu_asprintf(&value, "%d:%s", answer_features, answer);
+		gu_pch_set(fontindex_cache, gu_strdup(res_name), value);
+		}
+	else
+		{
+		gu_pch_set(fontindex_cache, gu_strdup(res_name), gu_strdup(""));
+		}
+	gu_pool_suspend(FALSE);
+
+	if(answer && features)
+		*features = answer_features;
+
 	return answer;
 	} /* end of try_fontindex() */
 
@@ -151,5 +311,192 @@ char *find_resource(
 	return (char*)NULL;
 	} /* end of find_resource() */
 
+/*
+** Return TRUE if body[] looks like the name of a body in the automatic
+** cache: 32 hexadecimal digits of MD5 digest, a hyphen, and the length.
+*/
+gu_boolean cached_body_name_ok(const char body[])
+	{
+	int x;
+	for(x=0; x < 32; x++)
+		{
+		if(!strchr("0123456789abcdef", body[x]) || body[x] == '\0')
+			return FALSE;
+		}
+	if(body[32] != '-' || body[33] == '\0')
+		return FALSE;
+	return body[33 + strspn(body + 33, "0123456789")] == '\0';
+	}
+
+/*
+** Return the name of the file in the automatic cache which holds the
+** resource body named by body[] (as in a "Res:" line), or NULL if there is
+** no such body.  If verify is TRUE, the file is read and NULL is also
+** returned if its length or MD5 digest isn't what the name says.
+*/
+char *find_cached_body(const char body[], gu_boolean verify)
+	{
+	char fname[MAX_PPR_PATH];
+	struct stat statbuf;
+
+	if(!cached_body_name_ok(body))
+		return NULL;
+
+	ppr_fnamef(fname, "%s/data/%s", RESOURCE_AUTOCACHE, body);
+	if(stat(fname, &statbuf) == -1 || !S_ISREG(statbuf.st_mode) || statbuf.st_size != atol(body + 33))
+		return NULL;
+
+	if(verify)
+		{
+		FILE *f;
+		md5_state_t md5;
+		md5_byte_t digest[16];
+		char buffer[8192];
+		int len, x;
+		char hex[3];
+
+		if(!(f = fopen(fname, "r")))
+			return NULL;
+		md5_init(&md5);
+		while((len = fread(buffer, sizeof(char), sizeof(buffer), f)) > 0)
+			md5_append(&md5, (md5_byte_t*)buffer, len);
+		len = ferror(f);
+		fclose(f);
+		if(len)
+			return NULL;
+		md5_finish(&md5, digest);
+		for(x=0; x < 16; x++)
+			{
+			snprintf(hex, sizeof(hex), "%02x", digest[x]);
+			if(hex[0] != body[x * 2] || hex[1] != body[x * 2 + 1])
+				return NULL;
+			}
+		}
+
+	return gu_strdup(fname);
+	} /* end of find_cached_body() */
+
+/*
+** Benchmark the font index.  This builds a text index and a hashed index
+** with the indicated number of fonts (10,000 if not specified) in /tmp
+** and times lookups using each of them and using the cache.  About half
+** of the names looked up are not in the index.
+*/
+#ifdef TEST
+static double elapsed_since(struct timeval *start)
+	{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return (now.tv_sec - start->tv_sec) + (now.tv_usec - start->tv_usec) / 1000000.0;
+	}
+
+int main(int argc, char *argv[])
+	{
+	int font_count = argc > 1 ? atoi(argv[1]) : 10000;
+	int lookups = 1000;
+	char text_name[MAX_PPR_PATH], cdb_name[MAX_PPR_PATH];
+	FILE *f;
+	void *cdbm;
+	int i;
+	struct timeval start;
+	double t_text, t_cdb, t_cache;
+	char name[64], data[MAX_PPR_PATH];
+	int mismatches = 0;
+
+	ppr_fnamef(text_name, "/tmp/findres-%ld.db", (long)getpid());
+	ppr_fnamef(cdb_name, "/tmp/findres-%ld.cdb", (long)getpid());
+	fontindex_filename = text_name;
+	fontindex_cdb_filename = cdb_name;
+
+	if(!(f = fopen(text_name, "w")) || !(cdbm = gu_cdb_make_new(cdb_name)))
+		{
+		fprintf(stderr, "Can't create index files\n");
+		return 1;
+		}
+	fprintf(f, "# benchmark\n");
+	for(i=0; i < font_count; i++)
+		{
+		snprintf(name, sizeof(name), "BenchFont-%d", i);
+		snprintf(data, sizeof(data), "%d:/usr/share/fonts/bench/%d.pfb", i % 4, i);
+		fprintf(f, "%s:%s\n", name, data);
+		gu_cdb_make_add(cdbm, name, data, strlen(data));
+		}
+	fclose(f);
+	gu_cdb_make_finish(cdbm, FALSE);
+
+	fontindex_check();
+	if(!fontindex_cdb)
+		{
+		fprintf(stderr, "Hashed index not used\n");
+		return 1;
+		}
+
+	srand(1);
+	gettimeofday(&start, NULL);
+	for(i=0; i < lookups; i++)
+		{
+		char *answer;
+		snprintf(name, sizeof(name), "BenchFont-%d", rand() % (font_count * 2));
+		if((answer = try_fontindex_text(name, NULL)))
+			gu_free(answer);
+		}
+	t_text = elapsed_since(&start);
+
+	srand(1);
+	gettimeofday(&start, NULL);
+	for(i=0; i < lookups; i++)
+		{
+		char *answer;
+		snprintf(name, sizeof(name), "BenchFont-%d", rand() % (font_count * 2));
+		if((answer = try_fontindex_cdb(name, NULL)))
+			gu_free(answer);
+		}
+	t_cdb = elapsed_since(&start);
+
+	/* The same names again through the cache, twice so that the second
+	   pass is all hits. */
+	for(i=0; i < lookups * 2; i++)
+		{
+		char *answer;
+		if(i == lookups)
+			{
+			srand(1);
+			gettimeofday(&start, NULL);
+			}
+		else if(i == 0)
+			srand(1);
+		snprintf(name, sizeof(name), "BenchFont-%d", rand() % (font_count * 2));
+		if((answer = try_fontindex(name, NULL)))
+			gu_free(answer);
+		}
+	t_cache = elapsed_since(&start);
+
+	/* Make sure the two indexes agree. */
+	for(i=0; i < font_count * 2; i += 97)
+		{
+		char *a1, *a2;
+		int f1 = -1, f2 = -1;
+		snprintf(name, sizeof(name), "BenchFont-%d", i);
+		a1 = try_fontindex_text(name, &f1);
+		a2 = try_fontindex_cdb(name, &f2);
+		if((a1 == NULL) != (a2 == NULL) || (a1 && (strcmp(a1, a2) != 0 || f1 != f2)))
+			mismatches++;
+		gu_free_if(a1);
+		gu_free_if(a2);
+		}
+
+	printf("%d fonts, %d lookups\n", font_count, lookups);
+	printf("text index:   %10.3f us per lookup\n", t_text * 1000000.0 / lookups);
+	printf("hashed index: %10.3f us per lookup\n", t_cdb * 1000000.0 / lookups);
+	printf("cached:       %10.3f us per lookup\n", t_cache * 1000000.0 / lookups);
+	printf("mismatches: %d\n", mismatches);
+
+	fontindex_flush();
+	unlink(text_name);
+	unlink(cdb_name);
+	return mismatches ? 1 : 0;
+	}
+#endif
+
 /* end of file */
 
@@ -0,0 +1,199 @@
+/*
+** mouse:~ppr/src/libppr/group_dispatch.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*+ \file
+
+This module holds the policies which decide which member of a group should
+print a group job.  It knows nothing of pprd's data structures.  The caller
+describes each member which could print the job (whether it is idle, how
+many pages it has to print before it could get to the job, and how fast it
+has been printing) and dispatch_choose() puts them in the order in which
+they should be tried.  pprd uses it when a group job becomes ready to print
+and ppr-dispatch-sim uses it to replay a print log.
+
+order
+	Try the members in the order in which they are listed.
+
+rotate
+	Try the members starting with the one after the one which was last
+	used.  This spreads the work out.
+
+least-pages
+	Prefer the member with the fewest pages to print ahead of the job.
+	Ties are broken in rotation order.
+
+throughput
+	Prefer the member which should finish the job first, considering the
+	pages it must print first and the number of pages per minute it has
+	been printing.  If that member is busy, the job is held for it.
+
+affinity
+	Big jobs (the size is a parameter) are placed as for throughput.
+	Small jobs go to the slowest idle member so as to leave the fast
+	members free for the big ones.  Small jobs are never held.
+
+*/
+
+#include "config.h"
+#include <string.h>
+#include <math.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "group_dispatch.h"
+
+static const char *policy_names[] =
+	{
+	"order",
+	"rotate",
+	"least-pages",
+	"throughput",
+	"affinity",
+	NULL
+	};
+
+/** Convert a policy name to a DISPATCH_* value
+ *
+ * Returns -1 if the name is not recognized.
+ */
+int dispatch_policy_parse(const char name[])
+	{
+	int x;
+	for(x=0; policy_names[x]; x++)
+		{
+		if(strcmp(name, policy_names[x]) == 0)
+			return x;
+		}
+	return -1;
+	}
+
+/** Convert a DISPATCH_* value to its name
+ */
+const char *dispatch_policy_name(int policy)
+	{
+	if(policy < 0 || policy > DISPATCH_AFFINITY)
+		return "?";
+	return policy_names[policy];
+	}
+
+/*
+** Return TRUE if member a should be tried before member b.
+*/
+static gu_boolean better(const struct DISPATCH_MEMBER *a, const struct DISPATCH_MEMBER *b)
+	{
+	if(a->cost != b->cost)
+		return a->cost < b->cost;
+	if(a->idle != b->idle)
+		return a->idle;
+	return a->rank < b->rank;
+	}
+
+/** Put the members which could print a job in the order in which they should be tried
+ *
+ * The members[] array describes the count members which could print the job
+ * (those which can't have been left out).  last is the offset of the member
+ * which was last used, or -1, group_members is the number of members in the
+ * group, and job_pages is the number of pages in the job or -1 if that is
+ * not known.
+ *
+ * The idle members are moved to the front of the array in the order in
+ * which they should be tried and the number of them is returned.  If the
+ * job should instead wait for a busy member, -1 is returned.
+ */
+int dispatch_choose(int policy, int affinity_pages, int last, int group_members, struct DISPATCH_MEMBER members[], int count, int job_pages)
+	{
+	double mean_ppm = 0.0;
+	int known_ppm = 0;
+	int pages = job_pages > 0 ? job_pages : 1;
+	gu_boolean small = FALSE;
+	int x, y, idle;
+
+	/* Members which haven't been measured yet are assumed to be
+	   average.  If none have, they are all taken to be equal. */
+	for(x=0; x < count; x++)
+		{
+		if(members[x].ppm > 0.0)
+			{
+			mean_ppm += members[x].ppm;
+			known_ppm++;
+			}
+		}
+	mean_ppm = known_ppm > 0 ? mean_ppm / known_ppm : 1.0;
+
+	if(policy == DISPATCH_AFFINITY && job_pages < affinity_pages)
+		small = TRUE;
+
+	for(x=0; x < count; x++)
+		{
+		struct DISPATCH_MEMBER *m = &members[x];
+		double ppm = m->ppm > 0.0 ? m->ppm : mean_ppm;
+		int outstanding = m->idle && m->outstanding < 0 ? 0 : m->outstanding;
+
+		if(policy == DISPATCH_ORDER || last < 0 || group_members < 1)
+			m->rank = m->member;
+		else
+			m->rank = (m->member - last - 1 + group_members) % group_members;
+
+		switch(policy)
+			{
+			case DISPATCH_LEAST_PAGES:
+				m->cost = outstanding < 0 ? HUGE_VAL : (double)outstanding;
+				break;
+			case DISPATCH_THROUGHPUT:
+			case DISPATCH_AFFINITY:
+				if(small)
+					m->cost = m->idle ? ppm : HUGE_VAL;
+				else
+					m->cost = outstanding < 0 ? HUGE_VAL : (outstanding + pages) / ppm;
+				break;
+			default:
+				m->cost = 0.0;
+				break;
+			}
+		}
+
+	/* There are seldom more than a few members, so insertion sort will do. */
+	for(x=1; x < count; x++)
+		{
+		struct DISPATCH_MEMBER temp = members[x];
+		for(y=x; y > 0 && better(&temp, &members[y-1]); y--)
+			members[y] = members[y-1];
+		members[y] = temp;
+		}
+
+	/* If a busy member should finish the job before any idle one could,
+	   wait for it.  We can't judge this if we don't know how long the job is. */
+	if(count > 0 && !members[0].idle && members[0].cost != HUGE_VAL && job_pages > 0
+			&& (policy == DISPATCH_THROUGHPUT || policy == DISPATCH_AFFINITY))
+		{
+		for(x=1; x < count; x++)
+			{
+			if(members[x].idle)
+				return -1;
+			}
+		}
+
+	/* Move the idle members to the front, keeping their order. */
+	for(x=idle=0; x < count; x++)
+		{
+		if(members[x].idle)
+			{
+			struct DISPATCH_MEMBER temp = members[x];
+			for(y=x; y > idle; y--)
+				members[y] = members[y-1];
+			members[idle++] = temp;
+			}
+		}
+
+	return idle;
+	} /* end of dispatch_choose() */
+
+/* end of file */
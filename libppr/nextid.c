@@ -0,0 +1,492 @@
+/*
+** mouse:~ppr/src/libppr/nextid.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*+ \file
+
+This module allocates job ID numbers.  The last number used is kept in a
+small binary file (NEXTIDFILE) which each ppr process maps into memory.  A
+new number is obtained by atomically incrementing the counter in the
+mapped file, so submissions don't wait for each other.  If the compiler
+doesn't provide atomic operations, the file is locked around the increment
+instead.
+
+Since ID numbers wrap around, a new number may belong to a job which is
+still in the queue.  To save ppr from having to stat() queue files to find
+out, pprd publishes the set of ID numbers in use in another mapped file
+(JOBID_SET_FILE).  This is an open-addressed hash table with a reference
+count for each ID since jobs which have been split share an ID.  When an
+ID leaves the table, the entries after it in its probe run are moved back
+to close the gap, so there are no deleted slots to clean out and each
+addition or removal touches only a few slots.  Only pprd writes it.
+Readers don't lock it, so they may occasionally miss an ID which is being
+added or moved, but ppr still checks the queue file of the number it
+finally chooses.
+
+Since these files are private to this machine, they are in native byte
+order.
+
+*/
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gu.h"
+#include "global_defines.h"
+
+#define NEXTID_MAGIC 0x5050494E			/* "PPIN" */
+#define NEXTID_SET_MAGIC 0x50504953		/* "PPIS" */
+#define NEXTID_SET_SLOTS 32768			/* must be a power of two */
+
+struct NEXTID_FILE {
+	int magic;
+	unsigned int counter;				/* last number handed out */
+	};
+
+struct NEXTID_SET_SLOT {
+	int id;								/* 0 means empty */
+	int count;							/* jobs with this ID */
+	};
+
+struct NEXTID_SET {
+	int magic;
+	int slots;
+	int used;							/* slots with non-zero id */
+	int pad;
+	struct NEXTID_SET_SLOT table[NEXTID_SET_SLOTS];
+	};
+
+static const char *nextid_filename = NEXTIDFILE;
+static const char *nextid_set_filename = JOBID_SET_FILE;
+static struct NEXTID_FILE *nextid_map = NULL;
+
+/*
+** Map the counter file, creating it or converting it from the old text
+** format if necessary.  The conversion is done with the file locked so
+** that only one process does it.
+*/
+static int nextid_open(void)
+	{
+	int fd;
+	struct stat statbuf;
+	void *map;
+
+	if((fd = open(nextid_filename, O_RDWR | O_CREAT, UNIX_644)) == -1)
+		return -1;
+
+	if(fstat(fd, &statbuf) == -1)
+		{
+		close(fd);
+		return -1;
+		}
+
+	if(statbuf.st_size != sizeof(struct NEXTID_FILE))
+		{
+		if(gu_lock_exclusive(fd, TRUE))
+			{
+			close(fd);
+			return -1;
+			}
+		if(fstat(fd, &statbuf) == 0 && statbuf.st_size != sizeof(struct NEXTID_FILE))
+			{
+			struct NEXTID_FILE init;
+			char temp[16];
+			int len;
+
+			/* An old ID file contains the last ID as a decimal number. */
+			if((len = read(fd, temp, sizeof(temp) - 1)) < 0)
+				len = 0;
+			temp[len] = '\0';
+
+			init.magic = NEXTID_MAGIC;
+			init.counter = atoi(temp) > 0 ? atoi(temp) : 0;
+			if(lseek(fd, 0, SEEK_SET) == -1
+					|| write(fd, &init, sizeof(init)) != sizeof(init)
+					|| ftruncate(fd, sizeof(init)) == -1)
+				{
+				close(fd);
+				return -1;
+				}
+			}
+		}
+
+	map = mmap(NULL, sizeof(struct NEXTID_FILE), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED)
+		{
+		close(fd);
+		return -1;
+		}
+
+	close(fd);			/* also releases the lock, if any */
+
+	nextid_map = (struct NEXTID_FILE *)map;
+	return 0;
+	} /* end of nextid_open() */
+
+/** get the next number from the job ID counter
+ *
+ * The numbers returned start at 1 and increase without limit (until the
+ * counter itself wraps around).  It is up to the caller to reduce them
+ * to the range of valid job IDs.  If the counter file can't be opened,
+ * -1 is returned and errno is set.
+ */
+long nextid_next(void)
+	{
+	unsigned int n;
+
+	if(!nextid_map && nextid_open() == -1)
+		return -1;
+
+	if(nextid_map->magic != NEXTID_MAGIC)
+		{
+		errno = EINVAL;
+		return -1;
+		}
+
+	#ifdef HAVE_ATOMIC_BUILTINS
+	n = __sync_add_and_fetch(&nextid_map->counter, 1);
+	#else
+	{
+	int fd;
+	if((fd = open(nextid_filename, O_RDWR)) == -1)
+		return -1;
+	gu_lock_exclusive(fd, TRUE);
+	n = ++nextid_map->counter;
+	close(fd);
+	}
+	#endif
+
+	return (long)n;
+	} /* end of nextid_next() */
+
+/** map the set of job IDs in use
+ *
+ * If writable is TRUE (which only pprd should do), the set is created
+ * empty.  Otherwise the existing set is mapped read-only and NULL is
+ * returned if there isn't one (for example, because pprd isn't running).
+ */
+void *nextid_set_open(gu_boolean writable)
+	{
+	int fd;
+	void *map;
+	struct NEXTID_SET *set;
+
+	if(writable)
+		{
+		char temp_fname[MAX_PPR_PATH];
+		ppr_fnamef(temp_fname, "%s.%ld", nextid_set_filename, (long)getpid());
+		if((fd = open(temp_fname, O_RDWR | O_CREAT | O_TRUNC, UNIX_644)) == -1)
+			return NULL;
+		if(ftruncate(fd, sizeof(struct NEXTID_SET)) == -1
+				|| (map = mmap(NULL, sizeof(struct NEXTID_SET), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+			{
+			close(fd);
+			unlink(temp_fname);
+			return NULL;
+			}
+		close(fd);
+		set = (struct NEXTID_SET *)map;
+		set->magic = NEXTID_SET_MAGIC;
+		set->slots = NEXTID_SET_SLOTS;
+		set->used = 0;
+
+		/* Readers may have the old set mapped.  It will stop changing,
+		   which is harmless since they check the queue file too. */
+		if(rename(temp_fname, nextid_set_filename) == -1)
+			{
+			munmap(map, sizeof(struct NEXTID_SET));
+			unlink(temp_fname);
+			return NULL;
+			}
+		}
+	else
+		{
+		struct stat statbuf;
+		if((fd = open(nextid_set_filename, O_RDONLY)) == -1)
+			return NULL;
+		if(fstat(fd, &statbuf) == -1 || statbuf.st_size != sizeof(struct NEXTID_SET)
+				|| (map = mmap(NULL, sizeof(struct NEXTID_SET), PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+			{
+			close(fd);
+			return NULL;
+			}
+		close(fd);
+		set = (struct NEXTID_SET *)map;
+		if(set->magic != NEXTID_SET_MAGIC || set->slots != NEXTID_SET_SLOTS)
+			{
+			munmap(map, sizeof(struct NEXTID_SET));
+			return NULL;
+			}
+		}
+
+	return (void*)set;
+	} /* end of nextid_set_open() */
+
+static unsigned int nextid_set_hash(int id)
+	{
+	return ((unsigned int)id * 2654435761U) & (NEXTID_SET_SLOTS - 1);
+	}
+
+/** note that a job with the indicated ID has entered the queue
+ */
+void nextid_set_add(void *p, int id)
+	{
+	struct NEXTID_SET *set = (struct NEXTID_SET *)p;
+	unsigned int slot;
+
+	if(!set || id <= 0)
+		return;
+
+	for(slot = nextid_set_hash(id); set->table[slot].id != 0; slot = (slot + 1) & (NEXTID_SET_SLOTS - 1))
+		{
+		if(set->table[slot].id == id)
+			{
+			set->table[slot].count++;
+			return;
+			}
+		}
+
+	/* Keep the probe runs short.  Readers will fall back to stat(). */
+	if(set->used >= (NEXTID_SET_SLOTS / 4 * 3))
+		return;
+
+	set->table[slot].count = 1;
+	set->table[slot].id = id;
+	set->used++;
+	} /* end of nextid_set_add() */
+
+/** note that a job with the indicated ID has left the queue
+ */
+void nextid_set_remove(void *p, int id)
+	{
+	struct NEXTID_SET *set = (struct NEXTID_SET *)p;
+	unsigned int hole, slot, home;
+
+	if(!set || id <= 0)
+		return;
+
+	for(hole = nextid_set_hash(id); set->table[hole].id != id; hole = (hole + 1) & (NEXTID_SET_SLOTS - 1))
+		{
+		if(set->table[hole].id == 0)
+			return;
+		}
+
+	if(--set->table[hole].count > 0)
+		return;
+
+	/*
+	** Close the gap.  Any later entry in this run whose home slot
+	** doesn't lie between the hole and the entry itself would no
+	** longer be found, so move it into the hole, leaving a new hole
+	** where it was.
+	*/
+	for(slot = (hole + 1) & (NEXTID_SET_SLOTS - 1); set->table[slot].id != 0; slot = (slot + 1) & (NEXTID_SET_SLOTS - 1))
+		{
+		home = nextid_set_hash(set->table[slot].id);
+		if(((slot - home) & (NEXTID_SET_SLOTS - 1)) >= ((slot - hole) & (NEXTID_SET_SLOTS - 1)))
+			{
+			set->table[hole] = set->table[slot];
+			hole = slot;
+			}
+		}
+	set->table[hole].id = 0;
+	set->table[hole].count = 0;
+	set->used--;
+	} /* end of nextid_set_remove() */
+
+/** is a job with the indicated ID in the queue?
+ */
+gu_boolean nextid_set_contains(void *p, int id)
+	{
+	const struct NEXTID_SET *set = (const struct NEXTID_SET *)p;
+	unsigned int slot;
+	int x;
+
+	for(x=0, slot = nextid_set_hash(id); x < NEXTID_SET_SLOTS && set->table[slot].id != 0; x++, slot = (slot + 1) & (NEXTID_SET_SLOTS - 1))
+		{
+		if(set->table[slot].id == id)
+			return set->table[slot].count > 0;
+		}
+	return FALSE;
+	} /* end of nextid_set_contains() */
+
+/*
+** Benchmark of job ID allocation.  This starts the indicated number of
+** processes (64 if not specified) which each allocate the indicated number
+** of IDs (1000 if not specified), first with the old method (lock the
+** file, read the number with stdio, write it back, and stat() the queue
+** file) and then with the counter, and reports the time taken and whether
+** any ID was handed out twice.
+*/
+#ifdef TEST
+#include <stdio.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+static long old_next_id(const char filename[])
+	{
+	int fd;
+	FILE *f;
+	long tid;
+	char qfname[MAX_PPR_PATH];
+	struct stat statbuf;
+
+	if((fd = open(filename, O_RDWR | O_CREAT, UNIX_644)) == -1)
+		return -1;
+	gu_lock_exclusive(fd, TRUE);
+	f = fdopen(fd, "r+");
+	if(fscanf(f, "%ld", &tid) != 1)
+		tid = 0;
+	tid++;
+	rewind(f);
+	fprintf(f, "%ld\n", tid);
+	fclose(f);
+
+	ppr_fnamef(qfname, "%s/test-%ld.0", QUEUEDIR, tid);
+	stat(qfname, &statbuf);
+
+	return tid;
+	}
+
+static double run(int method, int processes, int count, const char ids_fname[])
+	{
+	struct timeval start, end;
+	int x;
+
+	gettimeofday(&start, NULL);
+	for(x=0; x < processes; x++)
+		{
+		if(fork() == 0)
+			{
+			long *ids = gu_alloc(count, sizeof(long));
+			FILE *out;
+			int y;
+			for(y=0; y < count; y++)
+				ids[y] = method ? nextid_next() : old_next_id(nextid_filename);
+			/* Write them out only after the timed loop. */
+			out = fopen(ids_fname, "a");
+			for(y=0; y < count; y++)
+				fprintf(out, "%ld\n", ids[y]);
+			fclose(out);
+			_exit(0);
+			}
+		}
+	while(wait(NULL) > 0)
+		;
+	gettimeofday(&end, NULL);
+	return (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+	}
+
+static int count_duplicates(const char ids_fname[])
+	{
+	char command[MAX_PPR_PATH + 32];
+	FILE *p;
+	int dups = 0;
+	ppr_fnamef(command, "sort -n %s | uniq -d | wc -l", ids_fname);
+	if((p = popen(command, "r")))
+		{
+		if(fscanf(p, "%d", &dups) != 1)
+			dups = -1;
+		pclose(p);
+		}
+	return dups;
+	}
+
+int main(int argc, char *argv[])
+	{
+	int processes = argc > 1 ? atoi(argv[1]) : 64;
+	int count = argc > 2 ? atoi(argv[2]) : 1000;
+	char counter_fname[MAX_PPR_PATH];
+	char ids_fname[MAX_PPR_PATH];
+	double t;
+	struct timeval start, end;
+	void *set;
+	int x, found;
+
+	ppr_fnamef(counter_fname, "/tmp/nextid-test-%ld", (long)getpid());
+	ppr_fnamef(ids_fname, "/tmp/nextid-test-%ld.ids", (long)getpid());
+	nextid_filename = counter_fname;
+
+	printf("%d processes, %d IDs each\n", processes, count);
+
+	unlink(ids_fname);
+	t = run(0, processes, count, ids_fname);
+	printf("locked file:   %8.3f seconds, %8.2f us per ID, %d duplicates\n", t, t * 1000000.0 / (processes * count), count_duplicates(ids_fname));
+
+	/* The counter picks up where the old file left off. */
+	unlink(ids_fname);
+	t = run(1, processes, count, ids_fname);
+	printf("counter:       %8.3f seconds, %8.2f us per ID, %d duplicates\n", t, t * 1000000.0 / (processes * count), count_duplicates(ids_fname));
+
+	unlink(ids_fname);
+	unlink(counter_fname);
+
+	/* Exercise the set of IDs in use. */
+	ppr_fnamef(ids_fname, "/tmp/nextid-test-%ld.set", (long)getpid());
+	nextid_set_filename = ids_fname;
+	if(!(set = nextid_set_open(TRUE)))
+		{
+		fprintf(stderr, "can't create \"%s\"\n", ids_fname);
+		return 1;
+		}
+	/* Keep 10000 jobs in the queue while a million pass through it,
+	   the way a busy server would. */
+	gettimeofday(&start, NULL);
+	for(x=1; x <= 1000000; x++)
+		{
+		nextid_set_add(set, x);
+		if(x > 10000)
+			nextid_set_remove(set, x - 10000);
+		}
+	gettimeofday(&end, NULL);
+	t = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+	for(found=0, x=1; x <= 1000000; x++)
+		{
+		if(nextid_set_contains(set, x))
+			found++;
+		}
+	printf("set:           %8.3f seconds, %8.3f us per add and remove, %d of 10000 IDs in use found\n", t, t * 1000000.0 / 1000000, found);
+
+	/* Now the same, but with IDs which were split into two jobs and
+	   which leave the queue in a scrambled order. */
+	for(x=990001; x <= 1000000; x++)
+		nextid_set_remove(set, x);
+	for(x=1; x <= 20000; x++)
+		{
+		nextid_set_add(set, x);
+		nextid_set_add(set, x);
+		}
+	for(x=1; x <= 20000; x++)
+		{
+		int id = (x * 7919) % 20000 + 1;
+		nextid_set_remove(set, id);
+		if(id % 2)
+			nextid_set_remove(set, id);
+		}
+	for(found=0, x=1; x <= 20000; x++)
+		{
+		if(nextid_set_contains(set, x) != (x % 2 == 0))
+			found++;
+		}
+	printf("set:           %d wrong after splits and removals\n", found);
+	unlink(ids_fname);
+
+	return 0;
+	}
+#endif
+
+/* end of file */
@@ -0,0 +1,297 @@
+/*
+** mouse:~ppr/src/libppr/ppdimage.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*+ \file
+
+This module contains the common machinery for compiled PPD images.  A
+program which extracts information from a PPD file can store the result in
+a single block of memory made up of a header followed by the tables and
+strings to which it refers by offset.  The block can be saved to a cache
+file and later mapped into memory with mmap() and used as is, which is much
+faster than parsing the PPD file again.
+
+Each image starts with a struct PPDIMAGE_HEADER which records the name of
+the PPD file and the modification time, size, and inode number of it and of
+every file which it included.  If any of these files changes, the cached
+image is considered stale and ppdimage_load() will refuse to return it.
+
+Since the cache files are private to this machine, they are in native byte
+order.
+
+*/
+
+#include "config.h"
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+
+/** start building an image
+ *
+ * This reserves space for a header of the indicated size (which must begin
+ * with a struct PPDIMAGE_HEADER) and fills in the common part of it.  The
+ * files list should come from ppdobj_files().  The PPD index is added to it
+ * if ppdname[] is not an absolute path since a change to the index could
+ * change which file ppdobj_new() would open.
+ */
+void ppdimage_begin(struct PPDIMAGE *b, int header_size, int magic, int version, const char ppdname[], void *files)
+	{
+	int offset, i, file_count;
+
+	b->alloc = 4096;
+	b->size = 0;
+	b->image = gu_alloc(b->alloc, sizeof(char));
+	memset(b->image, 0, b->alloc);
+	ppdimage_reserve(b, header_size);
+
+	#define HDR ((struct PPDIMAGE_HEADER *)b->image)
+	HDR->magic = magic;
+	HDR->version = version;
+	offset = ppdimage_string(b, ppdname); HDR->ppdFile = offset;
+
+	file_count = gu_pca_size(files);
+	if(ppdname[0] != '/')
+		file_count++;
+	HDR->file_count = file_count;
+	offset = ppdimage_reserve(b, file_count * sizeof(struct PPDIMAGE_FILE)); HDR->files = offset;
+	for(i=0; i < file_count; i++)
+		{
+		const char *fname = i < gu_pca_size(files) ? gu_pca_index(files, i) : PPD_INDEX;
+		int name_offset = ppdimage_string(b, fname);
+		struct PPDIMAGE_FILE *f = (struct PPDIMAGE_FILE *)(b->image + HDR->files) + i;
+		struct stat statbuf;
+		f->name = name_offset;
+		if(stat(fname, &statbuf) == 0)
+			{
+			f->mtime = statbuf.st_mtime;
+			f->size = statbuf.st_size;
+			f->ino = statbuf.st_ino;
+			}
+		else
+			{
+			f->mtime = f->size = f->ino = -1;
+			}
+		}
+	#undef HDR
+	} /* end of ppdimage_begin() */
+
+/** append a block to an image under construction
+ *
+ * The new block is zeroed and aligned for any type.  Its offset is
+ * returned.  Since this can move the image, pointers into it must be
+ * recomputed after each call.
+ */
+int ppdimage_reserve(struct PPDIMAGE *b, int size)
+	{
+	int offset = (b->size + (sizeof(double) - 1)) & ~(sizeof(double) - 1);
+	if((offset + size) > b->alloc)
+		{
+		int old_alloc = b->alloc;
+		while((offset + size) > b->alloc)
+			b->alloc *= 2;
+		b->image = gu_realloc(b->image, b->alloc, sizeof(char));
+		memset(b->image + old_alloc, 0, b->alloc - old_alloc);
+		}
+	b->size = offset + size;
+	return offset;
+	} /* end of ppdimage_reserve() */
+
+/** append a string to an image under construction
+ *
+ * The offset of the copy is returned.  A NULL string is represented by
+ * offset 0 which is always the header.
+ */
+int ppdimage_string(struct PPDIMAGE *b, const char string[])
+	{
+	int offset;
+	if(!string)
+		return 0;
+	offset = ppdimage_reserve(b, strlen(string) + 1);
+	strcpy(b->image + offset, string);
+	return offset;
+	} /* end of ppdimage_string() */
+
+/** finish an image
+ *
+ * This records the final size in the header and returns the image.  The
+ * caller should free it with gu_free() when done.
+ */
+char *ppdimage_finish(struct PPDIMAGE *b)
+	{
+	((struct PPDIMAGE_HEADER *)b->image)->image_size = b->size;
+	return b->image;
+	} /* end of ppdimage_finish() */
+
+/** test whether a string offset in an image is valid
+ *
+ * Offset 0 stands for NULL and is accepted.  Otherwise the offset must
+ * point past the common header and the string must end within the image.
+ */
+gu_boolean ppdimage_string_ok(const char *image, int offset)
+	{
+	int image_size = ((const struct PPDIMAGE_HEADER *)image)->image_size;
+	if(offset == 0)
+		return TRUE;
+	if(offset < (int)sizeof(struct PPDIMAGE_HEADER) || offset >= image_size)
+		return FALSE;
+	return memchr(image + offset, '\0', image_size - offset) != NULL;
+	} /* end of ppdimage_string_ok() */
+
+/** test whether a table in an image is valid
+ *
+ * The table of count elements of element_size bytes each must lie
+ * entirely within the image, past the common header, and be aligned as
+ * ppdimage_reserve() aligns it.
+ */
+gu_boolean ppdimage_table_ok(const char *image, int offset, int count, int element_size)
+	{
+	int image_size = ((const struct PPDIMAGE_HEADER *)image)->image_size;
+	if(count < 0 || offset < (int)sizeof(struct PPDIMAGE_HEADER) || offset > image_size)
+		return FALSE;
+	if(offset & (sizeof(double) - 1))
+		return FALSE;
+	return count <= (image_size - offset) / element_size;
+	} /* end of ppdimage_table_ok() */
+
+/** map a cached image
+ *
+ * If the named cache file exists, is of the indicated type and version,
+ * was compiled from the PPD file ppdname[], and none of the files from
+ * which it was compiled have changed, it is mapped into memory and a
+ * pointer to it is returned.  Otherwise NULL is returned.  Release the
+ * image with ppdimage_unmap().
+ *
+ * Since the programs which use these images run with the privileges of
+ * the spooler, nothing in a cache file is trusted.  The offsets in the
+ * common header are checked here.  The caller's check() function, which
+ * is called only if they are good, must check every offset and count in
+ * the rest of the image using ppdimage_string_ok() and
+ * ppdimage_table_ok() and return FALSE if any is out of range.
+ */
+const char *ppdimage_load(const char fname[], int magic, int version, const char ppdname[], gu_boolean (*check)(const char *image))
+	{
+	int fd;
+	struct stat statbuf;
+	char *image;
+	const struct PPDIMAGE_HEADER *hdr;
+	const struct PPDIMAGE_FILE *files;
+	int i;
+
+	if((fd = open(fname, O_RDONLY)) == -1)
+		return NULL;
+	if(fstat(fd, &statbuf) == -1 || statbuf.st_size < sizeof(struct PPDIMAGE_HEADER))
+		{
+		close(fd);
+		return NULL;
+		}
+	image = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(image == MAP_FAILED)
+		return NULL;
+
+	hdr = (const struct PPDIMAGE_HEADER *)image;
+	if(hdr->magic != magic
+			|| hdr->version != version
+			|| hdr->image_size != statbuf.st_size
+			|| hdr->ppdFile == 0 || !ppdimage_string_ok(image, hdr->ppdFile)
+			|| strcmp(image + hdr->ppdFile, ppdname) != 0
+			|| !ppdimage_table_ok(image, hdr->files, hdr->file_count, sizeof(struct PPDIMAGE_FILE))
+			)
+		{
+		munmap(image, statbuf.st_size);
+		return NULL;
+		}
+
+	/* If the PPD file or any of the files it includes have changed, the
+	 * image is stale. */
+	files = (const struct PPDIMAGE_FILE *)(image + hdr->files);
+	for(i=0; i < hdr->file_count; i++)
+		{
+		if(files[i].name == 0 || !ppdimage_string_ok(image, files[i].name)
+				|| stat(image + files[i].name, &statbuf) == -1
+				|| statbuf.st_mtime != files[i].mtime
+				|| statbuf.st_size != files[i].size
+				|| statbuf.st_ino != files[i].ino)
+			{
+			munmap(image, hdr->image_size);
+			return NULL;
+			}
+		}
+
+	if(!(*check)(image))
+		{
+		munmap(image, hdr->image_size);
+		return NULL;
+		}
+
+	return image;
+	} /* end of ppdimage_load() */
+
+/** release an image mapped by ppdimage_load()
+ */
+void ppdimage_unmap(const char *image)
+	{
+	munmap((void*)image, ((const struct PPDIMAGE_HEADER *)image)->image_size);
+	}
+
+/** save an image to a cache file
+ *
+ * The cache is an optimization, so failure is silently ignored.  We write
+ * a temporary file and rename it into place so that readers never see a
+ * partial image.
+ */
+void ppdimage_save(const char fname[], const char *image)
+	{
+	int image_size = ((const struct PPDIMAGE_HEADER *)image)->image_size;
+	char temp_fname[MAX_PPR_PATH];
+	int fd;
+
+	ppr_fnamef(temp_fname, "%s.%ld", fname, (long)getpid());
+	if((fd = open(temp_fname, O_WRONLY | O_CREAT | O_TRUNC, UNIX_644)) == -1)
+		return;
+	if(write(fd, image, image_size) != image_size)
+		{
+		close(fd);
+		unlink(temp_fname);
+		return;
+		}
+	close(fd);
+	if(rename(temp_fname, fname) == -1)
+		unlink(temp_fname);
+	} /* end of ppdimage_save() */
+
+/** compute a hash value for use in image hash tables
+ *
+ * The string is hashed as if s1 and s2 were concatenated with a space
+ * between them.  If s2 is NULL or empty, no space is added.  The return
+ * value is less than tabsize.
+ */
+int ppdimage_hash(const char s1[], const char s2[], int tabsize)
+	{
+	unsigned int n = 0;
+	while(*s1)
+		n = 32 * n + (unsigned char)*s1++;
+	if(s2 && *s2)
+		{
+		n = 32 * n + ' ';
+		while(*s2)
+			n = 32 * n + (unsigned char)*s2++;
+		}
+	return n % tabsize;
+	} /* end of ppdimage_hash() */
+
+/* end of file */
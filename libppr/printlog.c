@@ -0,0 +1,308 @@
+/*
+** mouse:~ppr/src/libppr/printlog.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*+ \file
+
+If the directory PRINTLOG_DIR exists, pprdrv appends a fixed-size
+struct PRINTLOG_RECORD to the file "current" in it for each job printed.
+Each record goes out in a single write() to a file opened with O_APPEND,
+so records from different pprdrv processes never mix.
+
+When "current" reaches the size set by "segment size" (in kilobytes) in the
+[printlog] section of ppr.conf, it is closed.  An index is written for it
+and then it is renamed to the local times of the first and last jobs it
+holds, in the form "YYYYMMDDHHMMSS-YYYYMMDDHHMMSS".  The index is a
+constant database with the same name plus PRINTLOG_INDEX_SUFFIX.  In it
+the keys "u:username" and "p:printer" map to arrays of record numbers.  So
+ppr-printlog can skip whole segments by date and, within a segment, read
+only the records for one user or printer.
+
+Appenders hold a shared lock on the file ".lock" and the process which
+closes a segment holds an exclusive one.
+
+*/
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+
+#define PRINTLOG_SEGMENT_SIZE 16384		/* default segment size in kilobytes */
+#define PRINTLOG_INDEX_BUCKETS 1024
+
+/* The list of record numbers under one index key */
+struct PRINTLOG_POSTINGS {
+	char *key;
+	int count;
+	int space;
+	unsigned int *recnos;
+	} ;
+
+/*
+** Lock or unlock the log.
+*/
+static int printlog_lock(int fd, int type, gu_boolean wait)
+	{
+	struct flock lock;
+	int ret;
+
+	lock.l_type = type;
+	lock.l_whence = SEEK_SET;
+	lock.l_start = (off_t)0;
+	lock.l_len = (off_t)0;
+
+	while((ret = fcntl(fd, wait ? F_SETLKW : F_SETLK, &lock)) == -1 && errno == EINTR)
+		;
+	return ret;
+	}
+
+/*
+** Return the size at which the current segment is closed.
+*/
+static off_t printlog_segment_size(void)
+	{
+	static off_t answer = 0;
+	if(answer == 0)
+		{
+		char *p = gu_ini_query(PPR_CONF, "printlog", "segmentsize", 0, NULL);
+		long kilobytes = p ? atol(p) : PRINTLOG_SEGMENT_SIZE;
+		if(kilobytes < 1)
+			kilobytes = PRINTLOG_SEGMENT_SIZE;
+		answer = (off_t)kilobytes * 1024;
+		if(p)
+			gu_free(p);
+		}
+	return answer;
+	}
+
+/*
+** Add a record number to the list for a key.
+*/
+static void printlog_post(void *index, const char prefix[], const char name[], unsigned int recno)
+	{
+	char *key;
+	struct PRINTLOG_POSTINGS *p;
+
+	gu_asprintf(&key, "%s%s", prefix, name);
+	if((p = gu_pch_get(index, key)))
+		{
+		gu_free(key);
+		}
+	else
+		{
+		p = gu_alloc(1, sizeof(struct PRINTLOG_POSTINGS));
+		p->key = key;
+		p->count = p->space = 0;
+		p->recnos = NULL;
+		gu_pch_set(index, p->key, p);
+		}
+
+	if(p->count == p->space)
+		{
+		p->space = p->space ? p->space * 2 : 16;
+		p->recnos = gu_realloc(p->recnos, p->space, sizeof(unsigned int));
+		}
+	p->recnos[p->count++] = recno;
+	}
+
+/*
+** Close the current segment, index it, and rename it, provided it holds
+** at least min_size bytes.  The caller must hold an exclusive lock.
+*/
+static int printlog_close_segment(off_t min_size)
+	{
+	const char function[] = "printlog_close_segment";
+	char current[MAX_PPR_PATH], segment[MAX_PPR_PATH], index_name[MAX_PPR_PATH];
+	struct stat statbuf;
+	const struct PRINTLOG_RECORD *records;
+	unsigned int count, x;
+	void *index, *cdbm;
+	time_t first = 0, last = 0;
+	struct PRINTLOG_POSTINGS *p;
+	int fd, ret = 0;
+
+	ppr_fnamef(current, "%s/%s", PRINTLOG_DIR, PRINTLOG_CURRENT);
+	if((fd = open(current, O_RDONLY)) == -1)
+		return errno == ENOENT ? 0 : -1;
+	if(fstat(fd, &statbuf) == -1)
+		{
+		close(fd);
+		return -1;
+		}
+	count = statbuf.st_size / sizeof(struct PRINTLOG_RECORD);
+	if(count == 0 || statbuf.st_size < min_size)
+		{
+		close(fd);
+		return 0;
+		}
+	if((records = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		{
+		error("%s(): mmap() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+		close(fd);
+		return -1;
+		}
+	close(fd);
+
+	index = gu_pch_new(PRINTLOG_INDEX_BUCKETS);
+	for(x=0; x < count; x++)
+		{
+		if(records[x].magic != PRINTLOG_MAGIC)
+			continue;
+		if(first == 0 || records[x].printed < first)
+			first = records[x].printed;
+		if(records[x].printed > last)
+			last = records[x].printed;
+		printlog_post(index, "u:", records[x].username, x);
+		printlog_post(index, "p:", records[x].printer, x);
+		}
+	munmap((void*)records, statbuf.st_size);
+
+	/* Name the segment after the jobs in it. */
+	{
+	char first_str[15], last_str[15];
+	int n;
+	strftime(first_str, sizeof(first_str), "%Y%m%d%H%M%S", localtime(&first));
+	strftime(last_str, sizeof(last_str), "%Y%m%d%H%M%S", localtime(&last));
+	ppr_fnamef(segment, "%s/%s-%s", PRINTLOG_DIR, first_str, last_str);
+	for(n=1; lstat(segment, &statbuf) == 0; n++)
+		ppr_fnamef(segment, "%s/%s-%s.%d", PRINTLOG_DIR, first_str, last_str, n);
+	}
+
+	/* The index goes in first so that a segment is never without one. */
+	ppr_fnamef(index_name, "%s%s", segment, PRINTLOG_INDEX_SUFFIX);
+	if(!(cdbm = gu_cdb_make_new(index_name)))
+		{
+		error("%s(): can't create \"%s\", errno=%d (%s)", function, index_name, errno, gu_strerror(errno));
+		ret = -1;
+		}
+	gu_pch_rewind(index);
+	while(gu_pch_nextkey(index, (void**)&p))
+		{
+		if(cdbm && ret == 0)
+			ret = gu_cdb_make_add(cdbm, p->key, (char*)p->recnos, p->count * sizeof(unsigned int));
+		gu_free(p->key);
+		gu_free(p->recnos);
+		gu_free(p);
+		}
+	gu_pch_free(index);
+	if(cdbm && gu_cdb_make_finish(cdbm, ret == -1 ? TRUE : FALSE) == -1)
+		{
+		error("%s(): can't write \"%s\", errno=%d (%s)", function, index_name, errno, gu_strerror(errno));
+		ret = -1;
+		}
+
+	if(ret == 0 && rename(current, segment) == -1)
+		{
+		error("%s(): can't rename \"%s\" to \"%s\", errno=%d (%s)", function, current, segment, errno, gu_strerror(errno));
+		unlink(index_name);
+		ret = -1;
+		}
+
+	return ret;
+	} /* end of printlog_close_segment() */
+
+/*
+** Append a record to the log.  Returns -1 if the log is not enabled or the
+** record can't be written.
+*/
+int printlog_append(const struct PRINTLOG_RECORD *record)
+	{
+	const char function[] = "printlog_append";
+	char fname[MAX_PPR_PATH];
+	struct stat statbuf;
+	int lockfd, fd;
+	int ret = 0;
+
+	ppr_fnamef(fname, "%s/.lock", PRINTLOG_DIR);
+	if((lockfd = open(fname, O_RDWR | O_CREAT, UNIX_644)) == -1)
+		{
+		if(errno != ENOENT)
+			error("%s(): can't open \"%s\", errno=%d (%s)", function, fname, errno, gu_strerror(errno));
+		return -1;
+		}
+
+	if(printlog_lock(lockfd, F_RDLCK, TRUE) == -1)
+		{
+		error("%s(): can't lock \"%s\", errno=%d (%s)", function, fname, errno, gu_strerror(errno));
+		close(lockfd);
+		return -1;
+		}
+
+	ppr_fnamef(fname, "%s/%s", PRINTLOG_DIR, PRINTLOG_CURRENT);
+	if((fd = open(fname, O_WRONLY | O_APPEND | O_CREAT, UNIX_644)) == -1)
+		{
+		error("%s(): can't open \"%s\", errno=%d (%s)", function, fname, errno, gu_strerror(errno));
+		close(lockfd);
+		return -1;
+		}
+
+	if(write(fd, record, sizeof(struct PRINTLOG_RECORD)) != sizeof(struct PRINTLOG_RECORD))
+		{
+		error("%s(): write() to \"%s\" failed, errno=%d (%s)", function, fname, errno, gu_strerror(errno));
+		ret = -1;
+		}
+
+	/* If the segment is full, close it.  The shared lock is released first
+	   since two processes waiting to upgrade theirs would deadlock.  Whoever
+	   gets the exclusive lock first closes the segment and the others find
+	   a new one which isn't full. */
+	if(ret == 0 && fstat(fd, &statbuf) == 0 && statbuf.st_size >= printlog_segment_size())
+		{
+		printlog_lock(lockfd, F_UNLCK, TRUE);
+		if(printlog_lock(lockfd, F_WRLCK, TRUE) == 0)
+			printlog_close_segment(printlog_segment_size());
+		}
+
+	close(fd);
+	close(lockfd);			/* releases the lock */
+	return ret;
+	} /* end of printlog_append() */
+
+/*
+** Close the current segment now, regardless of its size.  This waits for
+** any appends in progress.
+*/
+int printlog_rotate(void)
+	{
+	const char function[] = "printlog_rotate";
+	char fname[MAX_PPR_PATH];
+	int lockfd, ret;
+
+	ppr_fnamef(fname, "%s/.lock", PRINTLOG_DIR);
+	if((lockfd = open(fname, O_RDWR | O_CREAT, UNIX_644)) == -1)
+		{
+		error("%s(): can't open \"%s\", errno=%d (%s)", function, fname, errno, gu_strerror(errno));
+		return -1;
+		}
+	if(printlog_lock(lockfd, F_WRLCK, TRUE) == -1)
+		{
+		error("%s(): can't lock \"%s\", errno=%d (%s)", function, fname, errno, gu_strerror(errno));
+		close(lockfd);
+		return -1;
+		}
+
+	ret = printlog_close_segment(0);
+
+	close(lockfd);
+	return ret;
+	} /* end of printlog_rotate() */
+
+/* end of file */
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 9 September 2010.
+** Last modified 19 October 2026.
 */
 
 /*+ \file
@@ -21,9 +21,12 @@ PPR queue.
 #include "config.h"
 #include <stdio.h>
 #include <string.h>
+#include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <limits.h>
 #ifdef INTERNATIONAL
 #include <libintl.h>
 #endif
@@ -34,7 +37,9 @@ PPR queue.
 #include "queueinfo.h"
 
 #ifdef TEST
-#define DODEBUG(a) { printf a; printf("\n"); }
+static gu_boolean test_benchmark = FALSE;	/* set by -b and -B */
+static gu_boolean test_no_cache = FALSE;	/* set by -B */
+#define DODEBUG(a) { if(!test_benchmark) { printf a; printf("\n"); } }
 #else
 #define DODEBUG(a) /* noop */
 #endif
@@ -54,10 +59,53 @@ struct PPD_INFO {
 	int psFreeVM;
 	char *resolution;
 	gu_boolean colorDevice;
+	int duplex;					/* PPD_INFO_DUPLEX_* bits */
 	char *faxSupport;
 	char *ttRasterizer;
-	void *fonts;				/* hash with empty values */
-	void *VMOptions;			/* hash */
+	const char *image;			/* compiled form, see ppd_info_compile() */
+	gu_boolean image_mapped;	/* TRUE if image is mmap()ed from the cache */
+	int font_count;
+	const int *fonts;			/* sorted offsets of font names in image */
+	int vmoption_count;
+	const int *VMOptions;		/* offsets of name and value pairs in image */
+	};
+
+/*
+** The facts which we extract from a PPD file are compiled into a
+** PPD image (see ppdimage.c) which starts with this header.  The image is
+** saved in the printer's purgable state directory so that the next
+** process which needs it can simply mmap() it rather than parsing the
+** PPD file again.
+*/
+#define PPD_INFO_CACHE_MAGIC 0x50504943		/* "PPIC" */
+#define PPD_INFO_CACHE_VERSION 3
+
+/* Which "*Duplex" options the PPD file has code for */
+#define PPD_INFO_DUPLEX 1				/* "*Duplex None", as pprdrv checks */
+#define PPD_INFO_DUPLEX_TUMBLE 2		/* "*Duplex DuplexTumble" */
+
+struct PPD_INFO_CACHE_HEADER {
+	struct PPDIMAGE_HEADER common;
+	int product;				/* offsets of strings, zero for NULL */
+	int modelName;
+	int nickName;
+	int shortNickName;
+	int psVersionStr;
+	int resolution;
+	int faxSupport;
+	int ttRasterizer;
+	int psLanguageLevel;
+	int psRevision;
+	int psFreeVM;
+	int colorDevice;
+	int duplex;
+	int TBCP;
+	int PJL;
+	double psVersion;
+	int font_count;
+	int fonts;					/* offset of sorted array of string offsets */
+	int vmoption_count;
+	int VMOptions;				/* offset of array of string offset pairs */
 	};
 
 /* Printer information */
@@ -150,21 +198,230 @@ static struct PRINTER_INFO *do_printer_new_obj(struct QUEUE_INFO *qip, const cha
 	return pip;
 	} /* end of do_printer_new_obj() */
 
+static const char *sort_image;
+static int image_string_compare(const void *a, const void *b)
+	{
+	return strcmp(sort_image + *(const int*)a, sort_image + *(const int*)b);
+	}
+
+/*
+ * Compile the facts which ppd_info_parse() found into an image in allocated
+ * memory.  The files list contains the names of the PPD file and any files
+ * it included.  We record their modification times so that we can tell
+ * if the cached image has gone stale.
+ */
+static char *ppd_info_compile(struct PRINTER_INFO *pip, void *fonts, void *VMOptions, void *files)
+	{
+	struct PPDIMAGE b;
+	int offset, i;
+	char *key;
+	void *value;
+	
+	ppdimage_begin(&b, sizeof(struct PPD_INFO_CACHE_HEADER), PPD_INFO_CACHE_MAGIC, PPD_INFO_CACHE_VERSION, pip->ppdFile, files);
+
+	/* The header pointer must be recomputed after each call which can move
+	 * the image, so we fill it in one field at a time. */
+	#define HDR ((struct PPD_INFO_CACHE_HEADER *)b.image)
+	offset = ppdimage_string(&b, pip->ppd->product); HDR->product = offset;
+	offset = ppdimage_string(&b, pip->ppd->modelName); HDR->modelName = offset;
+	offset = ppdimage_string(&b, pip->ppd->nickName); HDR->nickName = offset;
+	offset = ppdimage_string(&b, pip->ppd->shortNickName); HDR->shortNickName = offset;
+	offset = ppdimage_string(&b, pip->ppd->psVersionStr); HDR->psVersionStr = offset;
+	offset = ppdimage_string(&b, pip->ppd->resolution); HDR->resolution = offset;
+	offset = ppdimage_string(&b, pip->ppd->faxSupport); HDR->faxSupport = offset;
+	offset = ppdimage_string(&b, pip->ppd->ttRasterizer); HDR->ttRasterizer = offset;
+	HDR->psLanguageLevel = pip->ppd->psLanguageLevel;
+	HDR->psRevision = pip->ppd->psRevision;
+	HDR->psFreeVM = pip->ppd->psFreeVM;
+	HDR->colorDevice = pip->ppd->colorDevice;
+	HDR->duplex = pip->ppd->duplex;
+	HDR->TBCP = pip->ppd->protocols.TBCP;
+	HDR->PJL = pip->ppd->protocols.PJL;
+	HDR->psVersion = pip->ppd->psVersion;
+
+	/* The font names go in a sorted table so that we can use a binary search. */
+	HDR->font_count = gu_pch_size(fonts);
+	offset = ppdimage_reserve(&b, HDR->font_count * sizeof(int)); HDR->fonts = offset;
+	for(i=0, gu_pch_rewind(fonts); (key = gu_pch_nextkey(fonts, NULL)); i++)
+		{
+		offset = ppdimage_string(&b, key);
+		((int*)(b.image + HDR->fonts))[i] = offset;
+		}
+	sort_image = b.image;
+	qsort(b.image + HDR->fonts, HDR->font_count, sizeof(int), image_string_compare);
+
+	HDR->vmoption_count = gu_pch_size(VMOptions);
+	offset = ppdimage_reserve(&b, HDR->vmoption_count * 2 * sizeof(int)); HDR->VMOptions = offset;
+	for(i=0, gu_pch_rewind(VMOptions); (key = gu_pch_nextkey(VMOptions, &value)); i++)
+		{
+		offset = ppdimage_string(&b, key);
+		((int*)(b.image + HDR->VMOptions))[i * 2] = offset;
+		offset = ppdimage_string(&b, value);
+		((int*)(b.image + HDR->VMOptions))[i * 2 + 1] = offset;
+		}
+	#undef HDR
+
+	return ppdimage_finish(&b);
+	} /* end of ppd_info_compile() */
+
+/*
+ * Fill in a PPD_INFO structure from a compiled image.  The strings and 
+ * tables are not copied, they remain in the image.
+ */
+static void ppd_info_use_image(struct PPD_INFO *ppd, const char *image, gu_boolean mapped)
+	{
+	const struct PPD_INFO_CACHE_HEADER *hdr = (const struct PPD_INFO_CACHE_HEADER *)image;
+	#define IMAGE_STRING(offset) ((offset) ? (char*)(image + (offset)) : NULL)
+	ppd->image = image;
+	ppd->image_mapped = mapped;
+	ppd->product = IMAGE_STRING(hdr->product);
+	ppd->modelName = IMAGE_STRING(hdr->modelName);
+	ppd->nickName = IMAGE_STRING(hdr->nickName);
+	ppd->shortNickName = IMAGE_STRING(hdr->shortNickName);
+	ppd->psVersionStr = IMAGE_STRING(hdr->psVersionStr);
+	ppd->resolution = IMAGE_STRING(hdr->resolution);
+	ppd->faxSupport = IMAGE_STRING(hdr->faxSupport);
+	ppd->ttRasterizer = IMAGE_STRING(hdr->ttRasterizer);
+	#undef IMAGE_STRING
+	ppd->psLanguageLevel = hdr->psLanguageLevel;
+	ppd->psRevision = hdr->psRevision;
+	ppd->psFreeVM = hdr->psFreeVM;
+	ppd->colorDevice = hdr->colorDevice;
+	ppd->duplex = hdr->duplex;
+	ppd->protocols.TBCP = hdr->TBCP;
+	ppd->protocols.PJL = hdr->PJL;
+	ppd->psVersion = hdr->psVersion;
+	ppd->font_count = hdr->font_count;
+	ppd->fonts = (const int *)(image + hdr->fonts);
+	ppd->vmoption_count = hdr->vmoption_count;
+	ppd->VMOptions = (const int *)(image + hdr->VMOptions);
+	} /* end of ppd_info_use_image() */
+
+/*
+ * Return the name of the index-th font in the PPD file.
+ */
+static const char *ppd_info_font(const struct PPD_INFO *ppd, int index)
+	{
+	return ppd->image + ppd->fonts[index];
+	}
+
+/*
+ * Return TRUE if the named font is listed in the PPD file.
+ */
+static gu_boolean ppd_info_font_exists(const struct PPD_INFO *ppd, const char name[])
+	{
+	int low = 0, high = ppd->font_count - 1;
+	while(low <= high)
+		{
+		int mid = (low + high) / 2;
+		int cmp = strcmp(name, ppd->image + ppd->fonts[mid]);
+		if(cmp == 0)
+			return TRUE;
+		if(cmp < 0)
+			high = mid - 1;
+		else
+			low = mid + 1;
+		}
+	return FALSE;
+	}
+
+/*
+ * Return the value of the named *VMOption or NULL if there is none.
+ */
+static const char *ppd_info_vmoption(const struct PPD_INFO *ppd, const char name[])
+	{
+	int i;
+	for(i=0; i < ppd->vmoption_count; i++)
+		{
+		if(strcmp(name, ppd->image + ppd->VMOptions[i * 2]) == 0)
+			return ppd->image + ppd->VMOptions[i * 2 + 1];
+		}
+	return NULL;
+	}
+
+/*
+ * Return TRUE if every offset and count in a cached image is in range.
+ */
+static gu_boolean ppd_info_cache_check(const char *image)
+	{
+	const struct PPD_INFO_CACHE_HEADER *hdr = (const struct PPD_INFO_CACHE_HEADER *)image;
+	int i;
+
+	if(hdr->common.image_size < (int)sizeof(struct PPD_INFO_CACHE_HEADER))
+		return FALSE;
+
+	if(!ppdimage_string_ok(image, hdr->product)
+			|| !ppdimage_string_ok(image, hdr->modelName)
+			|| !ppdimage_string_ok(image, hdr->nickName)
+			|| !ppdimage_string_ok(image, hdr->shortNickName)
+			|| !ppdimage_string_ok(image, hdr->psVersionStr)
+			|| !ppdimage_string_ok(image, hdr->resolution)
+			|| !ppdimage_string_ok(image, hdr->faxSupport)
+			|| !ppdimage_string_ok(image, hdr->ttRasterizer))
+		return FALSE;
+
+	if(!ppdimage_table_ok(image, hdr->fonts, hdr->font_count, sizeof(int)))
+		return FALSE;
+	for(i=0; i < hdr->font_count; i++)
+		{
+		int offset = ((const int *)(image + hdr->fonts))[i];
+		if(offset == 0 || !ppdimage_string_ok(image, offset))
+			return FALSE;
+		}
+
+	if(hdr->vmoption_count > INT_MAX / 2
+			|| !ppdimage_table_ok(image, hdr->VMOptions, hdr->vmoption_count * 2, sizeof(int)))
+		return FALSE;
+	for(i=0; i < hdr->vmoption_count * 2; i++)
+		{
+		int offset = ((const int *)(image + hdr->VMOptions))[i];
+		if(offset == 0 || !ppdimage_string_ok(image, offset))
+			return FALSE;
+		}
+
+	return TRUE;
+	} /* end of ppd_info_cache_check() */
+
+/*
+ * Try to map the cached compiled PPD information for a printer.  If
+ * the cache file does not exist or is out of date, return FALSE.
+ */
+static gu_boolean ppd_info_cache_load(struct PRINTER_INFO *pip)
+	{
+	char fname[MAX_PPR_PATH];
+	const char *image;
+	ppr_fnamef(fname, "%s/%s/ppdinfo", PRINTERS_PURGABLE_STATEDIR, pip->name);
+	if(!(image = ppdimage_load(fname, PPD_INFO_CACHE_MAGIC, PPD_INFO_CACHE_VERSION, pip->ppdFile, ppd_info_cache_check)))
+		return FALSE;
+	ppd_info_use_image(pip->ppd, image, TRUE);
+	return TRUE;
+	} /* end of ppd_info_cache_load() */
+
+/*
+ * Save a compiled image in the printer's purgable state directory.
+ */
+static void ppd_info_cache_save(struct PRINTER_INFO *pip, const char *image)
+	{
+	char fname[MAX_PPR_PATH];
+	ppr_fnamef(fname, "%s/%s/ppdinfo", PRINTERS_PURGABLE_STATEDIR, pip->name);
+	ppdimage_save(fname, image);
+	} /* end of ppd_info_cache_save() */
+
 /*
  * This function opens a printer's specified PPD file and notes anything which 
- * might interest us.
+ * might interest us.  The result is compiled into an image which is
+ * returned in allocated memory.
  */
-static void do_printer_ppd(struct QUEUE_INFO *qip, struct PRINTER_INFO *pip)
+static char *ppd_info_parse(struct QUEUE_INFO *qip, struct PRINTER_INFO *pip)
 	{
 	void *ppdobj = NULL;
-
-	if(!pip->ppdFile)		/* PPD files are not mandatory in PPR */
-		return;
+	void *fonts = gu_pch_new(25);			/* hash with empty values */
+	void *VMOptions = gu_pch_new(6);		/* hash */
+	char *image = NULL;
 
 	if(qip->debug_level > 1)
 		printf(_("Extracting information about printer \"%s\" from PPD file \"%s\".\n"), pip->name, pip->ppdFile);
 
-	pip->ppd = gu_alloc(1, sizeof(struct PPD_INFO));
 	pip->ppd->product = NULL;
 	pip->ppd->modelName = NULL;
 	pip->ppd->nickName = NULL;
@@ -176,10 +433,9 @@ static void do_printer_ppd(struct QUEUE_INFO *qip, struct PRINTER_INFO *pip)
 	pip->ppd->psFreeVM = 0;
 	pip->ppd->resolution = NULL;
 	pip->ppd->colorDevice = FALSE;
+	pip->ppd->duplex = 0;
 	pip->ppd->faxSupport = NULL;
 	pip->ppd->ttRasterizer = NULL;
-	pip->ppd->fonts = gu_pch_new(25);
-	pip->ppd->VMOptions = gu_pch_new(6);
 	
 	gu_Try {
 		char *line;
@@ -218,6 +474,15 @@ static void do_printer_ppd(struct QUEUE_INFO *qip, struct PRINTER_INFO *pip)
 								}
 							}
 					case 'D':
+						if(lmatch(line, "*Duplex "))
+							{
+							p = line + 8;
+							if(strncmp(p, "None", 4) == 0 && (p[4] == ':' || p[4] == '/'))
+								pip->ppd->duplex |= PPD_INFO_DUPLEX;
+							else if(strncmp(p, "DuplexTumble", 12) == 0 && (p[12] == ':' || p[12] == '/'))
+								pip->ppd->duplex |= PPD_INFO_DUPLEX_TUMBLE;
+							continue;
+							}
 						if((p = lmatchp(line, "*DefaultResolution:")) || (p = lmatchp(line, "*DefaultJCLResolution:")))
 							{
 							/* if not seen yet and looks reasonable */
@@ -262,7 +527,7 @@ static void do_printer_ppd(struct QUEUE_INFO *qip, struct PRINTER_INFO *pip)
 						if((p = lmatchp(line, "*Font")))
 							{
 							p = gu_strndup(p, strcspn(p, ":"));
-							gu_pch_set(pip->ppd->fonts, p, "");	
+							gu_pch_set(fonts, p, "");	
 							continue;
 							}
 						if((p = lmatchp(line, "*FreeVM:")))
@@ -378,7 +643,7 @@ static void do_printer_ppd(struct QUEUE_INFO *qip, struct PRINTER_INFO *pip)
 								if(*p == '"')
 									{
 									p++;
-									gu_pch_set(pip->ppd->VMOptions, name, gu_strndup(p, strcspn(p, "\"")));	
+									gu_pch_set(VMOptions, name, gu_strndup(p, strcspn(p, "\"")));	
 									}
 								}
 							continue;
@@ -388,42 +653,76 @@ static void do_printer_ppd(struct QUEUE_INFO *qip, struct PRINTER_INFO *pip)
 				}
 			}
 
-		/* If these wern't specified in the configuration file, choose defaults based 
-		 * on the interface and supported protocols as indicated in the PPD file.
-		 */
-		if(pip->feedback == -1)
-			pip->codes = interface_default_codes(pip->interface, &pip->ppd->protocols);
-		if(pip->jobbreak == JOBBREAK_DEFAULT)
-			pip->codes = interface_default_codes(pip->interface, &pip->ppd->protocols);
-		if(pip->codes == CODES_DEFAULT)
-			pip->codes = interface_default_codes(pip->interface, &pip->ppd->protocols);
-
-		/* These two codes settings mean that any 8 bit value can be passed to the
-		 * PostScript interpreter without being interpreted as a control code.
-		 */
-		if(pip->codes == CODES_Binary || pip->codes == CODES_TBCP)
-			pip->ppd->binaryOK = TRUE;
-	
-		/* Is a memory expansion module installed? */
-		{
-		const char *name;
-		if((name = gu_pch_get(pip->ppdopts, "*InstalledMemory")))
-			{
-			const char *value_string;
-			if((value_string = gu_pch_get(pip->ppd->VMOptions, name)))
-				{
-				pip->ppd->psFreeVM = atoi(value_string);
-				}
-			}
-		}
+		image = ppd_info_compile(pip, fonts, VMOptions, ppdobj_files(ppdobj));
 		}
 	gu_Final {
 		if(ppdobj)
 			ppdobj_free(ppdobj);
+		gu_pch_free(fonts);
+		gu_pch_free(VMOptions);
 		}
 	gu_Catch {
 		gu_ReThrow();
 		}
+
+	return image;
+	} /* end of ppd_info_parse() */
+
+/*
+ * Fill in the PPD_INFO for a printer.  We use the cached compiled information
+ * if it is current, otherwise we parse the PPD file and, if the caller says 
+ * this is a real printer (rather than a hypothetical one), update the cache.
+ * We don't use the cache when warnings or debugging output have been 
+ * requested since the point is then to examine the PPD file itself.
+ */
+static void do_printer_ppd(struct QUEUE_INFO *qip, struct PRINTER_INFO *pip, gu_boolean use_cache)
+	{
+	if(!pip->ppdFile)		/* PPD files are not mandatory in PPR */
+		return;
+
+	pip->ppd = gu_alloc(1, sizeof(struct PPD_INFO));
+
+	#ifdef TEST
+	if(test_no_cache)
+		use_cache = FALSE;
+	#endif
+
+	if(!(use_cache && !qip->warnings && qip->debug_level == 0 && ppd_info_cache_load(pip)))
+		{
+		char *image = ppd_info_parse(qip, pip);
+		if(use_cache)
+			ppd_info_cache_save(pip, image);
+		ppd_info_use_image(pip->ppd, image, FALSE);
+		}
+
+	/* If these wern't specified in the configuration file, choose defaults based 
+	 * on the interface and supported protocols as indicated in the PPD file.
+	 */
+	if(pip->feedback == -1)
+		pip->codes = interface_default_codes(pip->interface, &pip->ppd->protocols);
+	if(pip->jobbreak == JOBBREAK_DEFAULT)
+		pip->codes = interface_default_codes(pip->interface, &pip->ppd->protocols);
+	if(pip->codes == CODES_DEFAULT)
+		pip->codes = interface_default_codes(pip->interface, &pip->ppd->protocols);
+
+	/* These two codes settings mean that any 8 bit value can be passed to the
+	 * PostScript interpreter without being interpreted as a control code.
+	 */
+	if(pip->codes == CODES_Binary || pip->codes == CODES_TBCP)
+		pip->ppd->binaryOK = TRUE;
+
+	/* Is a memory expansion module installed? */
+	{
+	const char *name;
+	if((name = gu_pch_get(pip->ppdopts, "*InstalledMemory")))
+		{
+		const char *value_string;
+		if((value_string = ppd_info_vmoption(pip->ppd, name)))
+			{
+			pip->ppd->psFreeVM = atoi(value_string);
+			}
+		}
+	}
 	} /* end of do_printer_ppd() */
 
 static gu_boolean do_printer(struct QUEUE_INFO *qip, const char name[], int depth)
@@ -557,11 +856,13 @@ static gu_boolean do_printer(struct QUEUE_INFO *qip, const char name[], int dept
 
 	/* Parse the PPD file and load info into this PRINTER_INFO structure. */
 	gu_Try {
-		do_printer_ppd(qip, pip);
+		do_printer_ppd(qip, pip, TRUE);
 		}
 	gu_Catch
 		{
-		/* If the printer already exists, we will not growse about the PPD file. */
+		/* If the printer already exists, we will not growse about the PPD file.
+		   But we must not leave a partly filled in PPD_INFO behind. */
+		pip->ppd = NULL;
 		}
 
 	/* Load the spool_state file (if there is one) into PRINTER_INFO. */
@@ -712,6 +1013,13 @@ QUEUE_INFO queueinfo_new(enum QUEUEINFO_TYPE qit, const char name[])
 */
 void queueinfo_free(QUEUE_INFO qip)
 	{
+	int i;
+	for(i=0; i < gu_pca_size(qip->printers); i++)
+		{
+		struct PRINTER_INFO *pip = gu_pca_index(qip->printers, i);
+		if(pip->ppd && pip->ppd->image_mapped)
+			ppdimage_unmap(pip->ppd->image);
+		}
 	gu_pool_free(qip->pool);
 	}
 
@@ -807,7 +1115,7 @@ void queueinfo_add_hypothetical_printer(QUEUE_INFO qip, const char name[], const
 	pip->ppdFile = gu_strdup(ppdfile);
 	if(installed_memory)
 		gu_pch_set(pip->ppdopts, "*InstalledMemory", gu_strdup(installed_memory));
-	do_printer_ppd(qip, pip);
+	do_printer_ppd(qip, pip, FALSE);
 	GU_OBJECT_POOL_POP(qip->pool);
 	}
 
@@ -1189,6 +1497,22 @@ int queueinfo_psLanguageLevel(QUEUE_INFO qip)
 		return 0;		/* unknown */
 	}
 
+/** Was information loaded from the PPD file of every printer?
+*/
+gu_boolean queueinfo_ppdLoaded(QUEUE_INFO qip)
+	{
+	int i;
+
+	for(i=0; i < gu_pca_size(qip->printers); i++)
+		{
+		struct PRINTER_INFO *pip = gu_pca_index(qip->printers, i);
+		if(!pip->ppd)
+			return FALSE;
+		}
+
+	return gu_pca_size(qip->printers) > 0;
+	}
+
 /** What is the version string of the PostScript interpreter?
  *
  * The version string is returned exactly as it appears in the PPD file.
@@ -1313,6 +1637,53 @@ gu_boolean queueinfo_colorDevice(QUEUE_INFO qip)
 	return answer;
 	}
 
+/** Can the printer(s) print on both sides of the paper?
+ *
+ * This is TRUE only if the PPD file of every printer has code for
+ * "*Duplex None", which is what pprdrv looks for when a job requires
+ * duplex.
+*/
+gu_boolean queueinfo_duplex(QUEUE_INFO qip)
+	{
+	int i;
+	gu_boolean answer = FALSE;
+
+	for(i=0; i < gu_pca_size(qip->printers); i++)
+		{
+		struct PRINTER_INFO *pip;
+		pip = gu_pca_index(qip->printers, i);
+		if(!pip->ppd || !(pip->ppd->duplex & PPD_INFO_DUPLEX))
+			return FALSE;
+		else
+			answer = TRUE;
+		}
+
+	return answer;
+	}
+
+/** Can the printer(s) print tumble duplex?
+ *
+ * This is TRUE only if the PPD file of every printer has code for
+ * "*Duplex DuplexTumble".
+*/
+gu_boolean queueinfo_duplexTumble(QUEUE_INFO qip)
+	{
+	int i;
+	gu_boolean answer = FALSE;
+
+	for(i=0; i < gu_pca_size(qip->printers); i++)
+		{
+		struct PRINTER_INFO *pip;
+		pip = gu_pca_index(qip->printers, i);
+		if(!pip->ppd || !(pip->ppd->duplex & PPD_INFO_DUPLEX_TUMBLE))
+			return FALSE;
+		else
+			answer = TRUE;
+		}
+
+	return answer;
+	}
+
 /** What kind of fax support does the printer have, if any?
  *
  * This is a string such as "None" or "Base".  If one or more printers
@@ -1388,24 +1759,26 @@ static void find_common_fonts(struct QUEUE_INFO *qip)
 		if(gu_pca_size(qip->printers) > 0)
 			{
 			struct PRINTER_INFO *pip, *pipy;
-			int y;
-			char *fontname;
+			int x, y;
+			const char *fontname;
 
 			/* Loop thru fonts in first printer. */
 			pip = gu_pca_index(qip->printers, 0);
 			if(pip->ppd)
 				{
-				for(gu_pch_rewind(pip->ppd->fonts); (fontname = gu_pch_nextkey(pip->ppd->fonts,NULL)); )
+				for(x=0; x < pip->ppd->font_count; x++)
 					{
+					fontname = ppd_info_font(pip->ppd, x);
+
 					/* Look for the font in second and subsequent printers. */
 					for(y=1; y < gu_pca_size(qip->printers); y++)
 						{
 						pipy = gu_pca_index(qip->printers, y);
-						if(!pipy->ppd || !gu_pch_get(pipy->ppd->fonts, fontname))
+						if(!pipy->ppd || !ppd_info_font_exists(pipy->ppd, fontname))
 							break;
 						}
 					if(y == gu_pca_size(qip->printers))
-						gu_pca_push(qip->fontlist, fontname);
+						gu_pca_push(qip->fontlist, (char*)fontname);
 					}
 				}
 			}
@@ -1443,7 +1816,7 @@ gu_boolean queueinfo_fontExists(QUEUE_INFO qip, const char name[])
 	for(i=0; i < gu_pca_size(qip->printers); i++)
 		{
 		pip = gu_pca_index(qip->printers, i);
-		if(!pip->ppd || !gu_pch_get(pip->ppd->fonts, name))
+		if(!pip->ppd || !ppd_info_font_exists(pip->ppd, name))
 			return FALSE;
 		}
 	return TRUE;
@@ -1684,6 +2057,37 @@ int main(int argc, char *argv[])
 	void *obj;
 	const char *p;
 	int i;
+
+	/* Benchmark mode: load the named queues over and over the way
+	   ippd does for a Get-Printers request and report the average
+	   time.  With -b the PPD information cache is used (and is written
+	   by the first pass if need be), with -B every pass parses the PPD
+	   files as was done before there was a cache. */
+	if(argc >= 4 && (strcmp(argv[1], "-b") == 0 || strcmp(argv[1], "-B") == 0))
+		{
+		int iterations = atoi(argv[2]);
+		int x;
+		struct timeval start, end;
+		double elapsed;
+		test_benchmark = TRUE;
+		test_no_cache = (argv[1][1] == 'B');
+		gettimeofday(&start, NULL);
+		for(i=0; i < iterations; i++)
+			{
+			for(x=3; x < argc; x++)
+				{
+				obj = queueinfo_new_load_config(QUEUEINFO_SEARCH, argv[x]);
+				queueinfo_fontExists(obj, "Times-Roman");
+				queueinfo_free(obj);
+				}
+			}
+		gettimeofday(&end, NULL);
+		elapsed = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+		printf("%d passes over %d queues: %.3f seconds, %.3f ms per pass\n",
+			iterations, argc - 3, elapsed, iterations > 0 ? elapsed * 1000.0 / iterations : 0.0);
+		return 0;
+		}
+
 	if(argc != 2)
 		{
 		fprintf(stderr, "%s: missing argument\n", argv[0]);
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 3 April 2006.
+** Last modified 19 October 2026.
 */
 
 /*+ \file
@@ -57,6 +57,7 @@ struct PPDOBJ {
 	int nest;						/* current nesting level */
 	char *fname[MAX_PPD_NEST];		/* list of names of open PPD files */
 	char line[MAX_PPD_LINE+2];		/* storage for the current line */
+	void *files;					/* names of all files opened so far */
 	#ifdef HAVE_ZLIB
 	gzFile f[MAX_PPD_NEST];
 	#else
@@ -156,6 +157,8 @@ static void ppdobj_open(struct PPDOBJ *self, const char ppdname[])
 		else
 			gu_Throw(_("can't open PPD file \"%s\", errno=%d (%s)"), self->fname[self->nest], errno, gu_strerror(errno));
 		}
+
+	gu_pca_push(self->files, gu_strdup(self->fname[self->nest]));
 	} /* ppdobj_open() */
 
 PPDOBJ ppdobj_new(const char ppdname[])
@@ -163,6 +166,7 @@ PPDOBJ ppdobj_new(const char ppdname[])
 	struct PPDOBJ *self = gu_alloc(1, sizeof(struct PPDOBJ));
 	self->magic = 0x4210;
 	self->nest = -1;
+	self->files = gu_pca_new(4, 4);
 	gu_Try {
 		ppdobj_open(self, ppdname);
 		}
@@ -193,9 +197,27 @@ void ppdobj_free(PPDOBJ self)
 		self->nest--;
 		}
 
+	{
+	char *p;
+	while((p = gu_pca_pop(self->files)))
+		gu_free(p);
+	gu_pca_free(self->files);
+	}
+
 	gu_free(self);
 	}
 
+/** return a list of the names of the PPD file and the files it has included so far
+ *
+ * The list belongs to the PPDOBJ.  The caller may add allocated strings to it.
+ * It is used to determine whether information derived from the PPD file is
+ * out of date.
+*/
+void *ppdobj_files(PPDOBJ self)
+	{
+	return self->files;
+	}
+
 char *ppdobj_readline(PPDOBJ self)
 	{
 	int len;
@@ -0,0 +1,263 @@
+/*
+** mouse:~ppr/src/libppr/spoolfile.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*+ \file
+
+Traditionally ppr has stored the body of each job in three files in DATADIR,
+"-comments", "-pages", and "-text".  If "spool format = container" is set in
+the [spooler] section of ppr.conf, ppr instead stores all three in a single
+"-spool" file, so that a job costs one file creation and one unlink() rather
+than three of each.
+
+The container begins with a directory of SPOOLFILE_HEADER_SIZE bytes.  The
+directory is text, one line per section giving the section name, its offset,
+and its length, ending with a blank line.  The rest of the header is padded
+with NULs.  The -text section comes right after the header so that ppr can
+write it in place.  The -comments and -pages sections, which are small, are
+appended when the job is complete.
+
+The queue file, the -log file, and the rarely created -cmdline, -infile,
+and -barbar files are kept separate in either format.
+
+*/
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gu.h"
+#include "global_defines.h"
+
+#define SPOOLFILE_MAGIC "PPR-Spool 1\n"
+
+/* The most recently mapped container.  pprdrv opens three sections of the
+ * same job one after another. */
+static char *map_qfname = NULL;
+static char *map = NULL;
+static size_t map_size = 0;
+
+/*
+** Return TRUE if new jobs should be spooled in a single container file.
+*/
+gu_boolean spoolfile_enabled(void)
+	{
+	static int answer = -1;
+	if(answer == -1)
+		{
+		char *p = gu_ini_query(PPR_CONF, "spooler", "spoolformat", 0, "separate");
+		if(gu_strcasecmp(p, "container") == 0)
+			answer = TRUE;
+		else
+			answer = FALSE;
+		gu_free(p);
+		}
+	return answer;
+	} /* end of spoolfile_enabled() */
+
+/*
+** Copy the remainder of one file to another.
+*/
+static int spoolfile_copy(FILE *out, FILE *in)
+	{
+	char buffer[8192];
+	size_t len;
+	while((len = fread(buffer, sizeof(char), sizeof(buffer), in)) > 0)
+		{
+		if(fwrite(buffer, sizeof(char), len, out) != len)
+			return -1;
+		}
+	return ferror(in) ? -1 : 0;
+	}
+
+/*
+** Complete a container.  The -text section must already have been written
+** starting at SPOOLFILE_HEADER_SIZE and the container must be positioned at
+** its end.  The -comments and -pages sections are copied from the files
+** provided (from the beginning) and the directory is written at the front.
+** The container is flushed but not closed.  Returns 0 on success, -1 on
+** failure.
+*/
+int spoolfile_finish(FILE *spool, FILE *comments, FILE *pages)
+	{
+	long text_end, comments_end, pages_end;
+	char header[SPOOLFILE_HEADER_SIZE];
+	int len;
+
+	if((text_end = ftell(spool)) < SPOOLFILE_HEADER_SIZE)
+		return -1;
+
+	rewind(comments);
+	if(spoolfile_copy(spool, comments) == -1)
+		return -1;
+	comments_end = ftell(spool);
+
+	rewind(pages);
+	if(spoolfile_copy(spool, pages) == -1)
+		return -1;
+	pages_end = ftell(spool);
+
+	memset(header, 0, sizeof(header));
+	len = snprintf(header, sizeof(header),
+		SPOOLFILE_MAGIC
+		"text %d %ld\n"
+		"comments %ld %ld\n"
+		"pages %ld %ld\n"
+		"\n",
+		SPOOLFILE_HEADER_SIZE, text_end - SPOOLFILE_HEADER_SIZE,
+		text_end, comments_end - text_end,
+		comments_end, pages_end - comments_end
+		);
+	if(len >= sizeof(header))
+		return -1;
+
+	if(fseek(spool, 0L, SEEK_SET) == -1
+			|| fwrite(header, sizeof(char), sizeof(header), spool) != sizeof(header)
+			|| fseek(spool, 0L, SEEK_END) == -1
+			|| fflush(spool) == EOF)
+		return -1;
+
+	return 0;
+	} /* end of spoolfile_finish() */
+
+/*
+** Map the container for the indicated job, or reuse the mapping if it is
+** already mapped.  Returns 0 on success, -1 if there is no container or it
+** can't be mapped.
+*/
+static int spoolfile_map(const char qfname[])
+	{
+	char fname[MAX_PPR_PATH];
+	int fd;
+	struct stat statbuf;
+	void *p;
+
+	if(map_qfname && strcmp(map_qfname, qfname) == 0)
+		return 0;
+
+	if(map_qfname)
+		{
+		munmap(map, map_size);
+		gu_free(map_qfname);
+		map_qfname = NULL;
+		}
+
+	ppr_fnamef(fname, "%s/%s-spool", DATADIR, qfname);
+	if((fd = open(fname, O_RDONLY)) == -1)
+		return -1;
+	if(fstat(fd, &statbuf) == -1)
+		{
+		close(fd);
+		return -1;
+		}
+	if(statbuf.st_size < SPOOLFILE_HEADER_SIZE)
+		{
+		close(fd);
+		errno = EINVAL;
+		return -1;
+		}
+	p = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(p == MAP_FAILED)
+		return -1;
+
+	map_qfname = gu_strdup(qfname);
+	map = (char*)p;
+	map_size = statbuf.st_size;
+	return 0;
+	} /* end of spoolfile_map() */
+
+/*
+** Find a section in the directory of the mapped container.  Returns 0
+** on success, -1 if the section is missing or the directory is damaged.
+*/
+static int spoolfile_find(const char section[], size_t *offset, size_t *length)
+	{
+	const char *p, *end;
+	int section_len = strlen(section);
+
+	if(strncmp(map, SPOOLFILE_MAGIC, sizeof(SPOOLFILE_MAGIC) - 1) != 0)
+		return -1;
+
+	for(p = map + sizeof(SPOOLFILE_MAGIC) - 1; p < map + SPOOLFILE_HEADER_SIZE && *p != '\n'; p = end + 1)
+		{
+		long off, len;
+		if(!(end = memchr(p, '\n', map + SPOOLFILE_HEADER_SIZE - p)))
+			break;
+		if(strncmp(p, section, section_len) == 0 && p[section_len] == ' '
+				&& sscanf(p + section_len, " %ld %ld", &off, &len) == 2)
+			{
+			if(off < SPOOLFILE_HEADER_SIZE || len < 0 || off > map_size || len > map_size - off)
+				return -1;
+			*offset = off;
+			*length = len;
+			return 0;
+			}
+		}
+
+	return -1;
+	} /* end of spoolfile_find() */
+
+/*
+** Open a section of a job for reading.  If the job has a container, the
+** section is read from the mapped container, otherwise the separate file
+** is opened.  The qfname is the job's queue file name such as
+** "mydest-1234.0".  Returns NULL and sets errno on failure.
+*/
+FILE *spoolfile_open_section(const char qfname[], const char section[])
+	{
+	FILE *f;
+
+	if(spoolfile_map(qfname) == 0)
+		{
+		size_t offset, length;
+
+		if(spoolfile_find(section, &offset, &length) == -1)
+			{
+			errno = EINVAL;
+			return NULL;
+			}
+
+		#ifdef HAVE_FMEMOPEN
+		if(length > 0)
+			return fmemopen(map + offset, length, "r");
+		#endif
+
+		/* Empty sections and systems without fmemopen() get a copy. */
+		if(!(f = tmpfile()))
+			return NULL;
+		if(fwrite(map + offset, sizeof(char), length, f) != length)
+			{
+			fclose(f);
+			return NULL;
+			}
+		rewind(f);
+		}
+	else
+		{
+		char fname[MAX_PPR_PATH];
+		if(errno != ENOENT)
+			return NULL;
+		ppr_fnamef(fname, "%s/%s-%s", DATADIR, qfname, section);
+		if(!(f = fopen(fname, "rb")))
+			return NULL;
+		}
+
+	gu_set_cloexec(fileno(f));
+	return f;
+	} /* end of spoolfile_open_section() */
+
+/* end of file */
@@ -0,0 +1,524 @@
+/*
+** mouse:~ppr/src/libppr/status_board.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*+ \file
+
+This module maps the status board, a file (STATUS_BOARD_FILE) which holds
+the current state of each printer and of each job in the queue.  It
+replaces reading the state_update files from the beginning and replaying
+every line in order to find out what is going on now.  pprd creates it when
+it starts and keeps the printer and job slots up to date.  The pprdrv which
+is printing on a printer fills in the progress figures in the second half
+of that printer's slot.
+
+Writers don't lock anything.  Each part of a slot has a sequence number
+which the writer makes odd before it changes anything and even again when
+it is done.  A reader copies the part and then checks that the sequence
+number was even and didn't change while it was copying.  If it did, the
+reader tries again.  Each change is also given a number from a counter in
+the header, and that number is recorded in the part which was changed, so
+a reader which remembers the counter's value from its last scan need only
+copy the slots changed since.
+
+When pprd restarts, it creates a new board and marks the old one stale so
+that readers know to open the file again.  The board is private to this
+machine, so it is in native byte order.  Since the file is sparse, slots
+which are never used take up neither disk space nor memory.
+
+*/
+
+#include "config.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "status_board.h"
+
+/* How many times will a reader try to get a consistent copy? */
+#define READ_TRIES 1000
+
+/* Keep the compiler and the CPU from moving loads and stores across this. */
+#ifdef HAVE_ATOMIC_BUILTINS
+#define BARRIER() __sync_synchronize()
+#else
+#define BARRIER()
+#endif
+
+static const char *status_board_filename = STATUS_BOARD_FILE;
+
+static size_t status_board_size(void)
+	{
+	return sizeof(struct STATUS_BOARD_HEADER)
+		+ STATUS_BOARD_PRINTERS * sizeof(struct STATUS_BOARD_PRINTER)
+		+ STATUS_BOARD_JOBS * sizeof(struct STATUS_BOARD_JOB);
+	}
+
+/*
+** Wrap a mapping of the file in a struct STATUS_BOARD.
+*/
+static struct STATUS_BOARD *status_board_wrap(void *map, size_t size)
+	{
+	struct STATUS_BOARD *board = gu_alloc(1, sizeof(struct STATUS_BOARD));
+	board->header = (struct STATUS_BOARD_HEADER *)map;
+	board->printers = (struct STATUS_BOARD_PRINTER *)((char*)map + sizeof(struct STATUS_BOARD_HEADER));
+	board->jobs = (struct STATUS_BOARD_JOB *)(board->printers + STATUS_BOARD_PRINTERS);
+	board->size = size;
+	return board;
+	}
+
+/** create a new, empty status board
+ *
+ * Only pprd should call this.  The old board, if there is one, is marked
+ * stale.  If the board can't be created, NULL is returned and errno is set.
+ */
+struct STATUS_BOARD *status_board_create(void)
+	{
+	char temp_fname[MAX_PPR_PATH];
+	size_t size = status_board_size();
+	struct STATUS_BOARD *old;
+	struct STATUS_BOARD_HEADER *header;
+	void *map;
+	int fd;
+
+	ppr_fnamef(temp_fname, "%s.%ld", status_board_filename, (long)getpid());
+	if((fd = open(temp_fname, O_RDWR | O_CREAT | O_TRUNC, UNIX_644)) == -1)
+		return NULL;
+	if(ftruncate(fd, size) == -1
+			|| (map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		{
+		int saved_errno = errno;
+		close(fd);
+		unlink(temp_fname);
+		errno = saved_errno;
+		return NULL;
+		}
+	close(fd);
+
+	/* The rest is already zero. */
+	header = (struct STATUS_BOARD_HEADER *)map;
+	header->magic = STATUS_BOARD_MAGIC;
+	header->version = STATUS_BOARD_VERSION;
+	header->printer_slots = STATUS_BOARD_PRINTERS;
+	header->job_slots = STATUS_BOARD_JOBS;
+	header->started = (long)time(NULL);
+
+	old = status_board_open(TRUE);
+
+	if(rename(temp_fname, status_board_filename) == -1)
+		{
+		int saved_errno = errno;
+		munmap(map, size);
+		unlink(temp_fname);
+		if(old)
+			status_board_close(old);
+		errno = saved_errno;
+		return NULL;
+		}
+
+	/* Readers of the old board should now open the new one. */
+	if(old)
+		{
+		old->header->stale = 1;
+		status_board_close(old);
+		}
+
+	return status_board_wrap(map, size);
+	} /* end of status_board_create() */
+
+/** map the existing status board
+ *
+ * pprdrv maps it writable so that it can fill in its half of its printer's
+ * slot.  Queue display programs map it read-only.  If there is no board,
+ * or it is of a different version, NULL is returned.
+ */
+struct STATUS_BOARD *status_board_open(gu_boolean writable)
+	{
+	size_t size = status_board_size();
+	struct STATUS_BOARD_HEADER *header;
+	struct stat statbuf;
+	void *map;
+	int fd;
+
+	if((fd = open(status_board_filename, writable ? O_RDWR : O_RDONLY)) == -1)
+		return NULL;
+	if(fstat(fd, &statbuf) == -1 || statbuf.st_size != size
+			|| (map = mmap(NULL, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		{
+		close(fd);
+		return NULL;
+		}
+	close(fd);
+
+	header = (struct STATUS_BOARD_HEADER *)map;
+	if(header->magic != STATUS_BOARD_MAGIC
+			|| header->version != STATUS_BOARD_VERSION
+			|| header->printer_slots != STATUS_BOARD_PRINTERS
+			|| header->job_slots != STATUS_BOARD_JOBS)
+		{
+		munmap(map, size);
+		return NULL;
+		}
+
+	return status_board_wrap(map, size);
+	} /* end of status_board_open() */
+
+/** unmap a status board
+ */
+void status_board_close(struct STATUS_BOARD *board)
+	{
+	munmap((void*)board->header, board->size);
+	gu_free(board);
+	}
+
+/** start changing part of a slot
+ *
+ * The argument is the seq or drv_seq member of the slot.
+ */
+void status_board_write_begin(volatile unsigned int *seq)
+	{
+	(*seq)++;
+	BARRIER();
+	}
+
+/** finish changing part of a slot
+ *
+ * The arguments are the members of the part which was changed.  The change
+ * is given the next event number.
+ */
+void status_board_write_end(struct STATUS_BOARD *board, volatile unsigned int *seq, unsigned int *changed)
+	{
+	#ifdef HAVE_ATOMIC_BUILTINS
+	*changed = __sync_add_and_fetch(&board->header->events, 1);
+	#else
+	*changed = ++board->header->events;
+	#endif
+	BARRIER();
+	(*seq)++;
+	}
+
+/** get the number of the last change
+ *
+ * A reader should fetch this before it scans the slots and then pass it
+ * to status_board_printer_changed() and status_board_job_changed() during
+ * the next scan.
+ */
+unsigned int status_board_events(const struct STATUS_BOARD *board)
+	{
+	unsigned int events = board->header->events;
+	BARRIER();
+	return events;
+	}
+
+/** has pprd started a new board?
+ */
+gu_boolean status_board_is_stale(const struct STATUS_BOARD *board)
+	{
+	return board->header->stale ? TRUE : FALSE;
+	}
+
+/* Is the event number changed later than since?  This allows for wrap-around. */
+#define LATER(changed, since) ((int)((changed) - (since)) > 0)
+
+/** has a printer slot changed since the indicated event?
+ */
+gu_boolean status_board_printer_changed(const struct STATUS_BOARD *board, int slot, unsigned int since)
+	{
+	const struct STATUS_BOARD_PRINTER *p = &board->printers[slot];
+	return LATER(p->changed, since) || LATER(p->drv_changed, since);
+	}
+
+/** has a job slot changed since the indicated event?
+ */
+gu_boolean status_board_job_changed(const struct STATUS_BOARD *board, int slot, unsigned int since)
+	{
+	return LATER(board->jobs[slot].changed, since);
+	}
+
+/*
+** Copy one part of a slot, trying again if a writer was in the middle of
+** changing it.  Return -1 if we never got a consistent copy.
+*/
+static int read_part(const volatile unsigned int *seq, const void *part, void *copy, size_t len)
+	{
+	int tries;
+	for(tries=0; tries < READ_TRIES; tries++)
+		{
+		unsigned int before = *seq;
+		if(before & 1)
+			{
+			sched_yield();
+			continue;
+			}
+		BARRIER();
+		memcpy(copy, part, len);
+		BARRIER();
+		if(*seq == before)
+			return 0;
+		}
+	errno = EAGAIN;
+	return -1;
+	}
+
+/** get a consistent copy of a printer slot
+ *
+ * The two halves are each consistent, but a change by pprdrv may come
+ * between them.
+ */
+int status_board_read_printer(const struct STATUS_BOARD *board, int slot, struct STATUS_BOARD_PRINTER *copy)
+	{
+	const struct STATUS_BOARD_PRINTER *p;
+	size_t half = offsetof(struct STATUS_BOARD_PRINTER, drv_seq);
+
+	if(slot < 0 || slot >= STATUS_BOARD_PRINTERS)
+		{
+		errno = EINVAL;
+		return -1;
+		}
+	p = &board->printers[slot];
+
+	if(read_part(&p->seq, p, copy, half) == -1
+			|| read_part(&p->drv_seq, (const char*)p + half, (char*)copy + half, sizeof(struct STATUS_BOARD_PRINTER) - half) == -1)
+		return -1;
+
+	return 0;
+	} /* end of status_board_read_printer() */
+
+/** get a consistent copy of a job slot
+ */
+int status_board_read_job(const struct STATUS_BOARD *board, int slot, struct STATUS_BOARD_JOB *copy)
+	{
+	if(slot < 0 || slot >= STATUS_BOARD_JOBS)
+		{
+		errno = EINVAL;
+		return -1;
+		}
+	return read_part(&board->jobs[slot].seq, &board->jobs[slot], copy, sizeof(struct STATUS_BOARD_JOB));
+	}
+
+/** name a printer status for queue display programs
+ *
+ * These are the words which "ppop status" uses.
+ */
+const char *status_board_printer_status_word(int status)
+	{
+	switch(status)
+		{
+		case PRNSTATUS_IDLE:		return "idle";
+		case PRNSTATUS_PRINTING:	return "printing";
+		case PRNSTATUS_CANCELING:	return "canceling";
+		case PRNSTATUS_SEIZING:		return "seizing";
+		case PRNSTATUS_FAULT:		return "fault";
+		case PRNSTATUS_ENGAGED:		return "engaged";
+		case PRNSTATUS_STARVED:		return "starved";
+		case PRNSTATUS_STOPT:		return "stopt";
+		case PRNSTATUS_STOPPING:	return "stopping";
+		case PRNSTATUS_HALTING:		return "halting";
+		default:					return "unknown";
+		}
+	}
+
+/** name a job status for queue display programs
+ *
+ * A job which is printing has the slot number of its printer as its status.
+ */
+const char *status_board_job_status_word(int status)
+	{
+	switch(status)
+		{
+		case STATUS_WAITING:		return "waiting";
+		case STATUS_HELD:			return "held";
+		case STATUS_WAITING4MEDIA:	return "waiting4media";
+		case STATUS_ARRESTED:		return "arrested";
+		case STATUS_CANCEL:			return "canceling";
+		case STATUS_SEIZING:		return "seizing";
+		case STATUS_STRANDED:		return "stranded";
+		case STATUS_FINISHED:		return "finished";
+		case STATUS_FUNDS:			return "funds";
+		case STATUS_RECEIVING:		return "receiving";
+		default:					return status >= 0 ? "printing" : "unknown";
+		}
+	}
+
+/*
+** Benchmark of queue display.  A writer process plays the part of 400
+** printers each reporting page progress, and a reader keeps track of the
+** state of every printer, first by reading and parsing the lines of a
+** state_update_pprdrv style file and then from the board.  It reports what
+** each costs the reader.  The number of printers and the number of events
+** may be given as arguments.
+*/
+#ifdef TEST
+#include <stdio.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+static double now(void)
+	{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+	}
+
+static double cpu(void)
+	{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+	}
+
+int main(int argc, char *argv[])
+	{
+	int printers = argc > 1 ? atoi(argv[1]) : 400;
+	int events = argc > 2 ? atoi(argv[2]) : 400000;
+	char text_fname[MAX_PPR_PATH];
+	char board_fname[MAX_PPR_PATH];
+	int *pages = gu_alloc(printers, sizeof(int));
+	struct STATUS_BOARD *board;
+	pid_t pid;
+	double start, cpu_start, used;
+	int x, y, seen;
+
+	ppr_fnamef(text_fname, "/tmp/status_board-test-%ld.txt", (long)getpid());
+	ppr_fnamef(board_fname, "/tmp/status_board-test-%ld", (long)getpid());
+	status_board_filename = board_fname;
+
+	printf("%d printers, %d events\n", printers, events);
+
+	/* The text file.  The writer finishes first so that we time only
+	   the reading. */
+	{
+	FILE *f = fopen(text_fname, "w");
+	char line[128];
+	char (*names)[STATUS_BOARD_NAME_MAX] = gu_alloc(printers, STATUS_BOARD_NAME_MAX);
+	for(x=0; x < printers; x++)
+		snprintf(names[x], STATUS_BOARD_NAME_MAX, "printer%d", x);
+	for(x=0; x < events; x++)
+		fprintf(f, "%s printer%d %d\n", (x & 1) ? "PGFIN" : "PGSTA", x % printers, x / printers);
+	fclose(f);
+
+	cpu_start = cpu();
+	f = fopen(text_fname, "r");
+	for(seen=0; fgets(line, sizeof(line), f); seen++)
+		{
+		char type[16], name[STATUS_BOARD_NAME_MAX];
+		int n;
+		if(sscanf(line, "%15s %63s %d", type, name, &n) != 3)
+			continue;
+		for(y=0; y < printers; y++)		/* display programs look the name up */
+			{
+			if(strcmp(names[y], name) == 0)
+				{
+				pages[y] = n;
+				break;
+				}
+			}
+		}
+	fclose(f);
+	used = cpu() - cpu_start;
+	printf("text feed: %8.3f CPU seconds for %d lines, %6.2f us per event\n", used, seen, used * 1000000.0 / events);
+	unlink(text_fname);
+	gu_free(names);
+	}
+
+	/* The board.  Here the writer runs at the same time as the reader,
+	   which scans whatever has changed until the writer is done. */
+	if(!(board = status_board_create()))
+		{
+		fprintf(stderr, "can't create \"%s\"\n", board_fname);
+		return 1;
+		}
+	for(x=0; x < printers; x++)
+		{
+		status_board_write_begin(&board->printers[x].seq);
+		snprintf(board->printers[x].name, STATUS_BOARD_NAME_MAX, "printer%d", x);
+		status_board_write_end(board, &board->printers[x].seq, &board->printers[x].changed);
+		}
+	board->header->printers_used = printers;
+
+	if((pid = fork()) == 0)
+		{
+		for(x=0; x < events; x++)
+			{
+			struct STATUS_BOARD_PRINTER *p = &board->printers[x % printers];
+			status_board_write_begin(&p->drv_seq);
+			if(x & 1)
+				p->pages_printed = x / printers;
+			else
+				p->pages_started = x / printers;
+			status_board_write_end(board, &p->drv_seq, &p->drv_changed);
+			}
+		_exit(0);
+		}
+
+	{
+	unsigned int since = 0;
+	int scans = 0, copies = 0, retries = 0;
+	gu_boolean done = FALSE;
+	struct STATUS_BOARD_PRINTER copy;
+	start = now();
+	cpu_start = cpu();
+	while(TRUE)
+		{
+		unsigned int events_now = status_board_events(board);
+		if(!done && waitpid(pid, NULL, WNOHANG) == pid)
+			done = TRUE;
+		if(events_now != since)
+			{
+			for(x=0; x < board->header->printers_used; x++)
+				{
+				if(status_board_printer_changed(board, x, since))
+					{
+					if(status_board_read_printer(board, x, &copy) == -1)
+						retries++;
+					pages[x] = copy.pages_printed;
+					copies++;
+					}
+				}
+			since = events_now;
+			scans++;
+			}
+		if(done && status_board_events(board) == since)
+			break;
+		}
+	used = cpu() - cpu_start;
+	printf("board:     %8.3f CPU seconds for %d scans copying %d slots (%.3f seconds elapsed), %6.2f us per event, %d failed\n",
+		used, scans, copies, now() - start, used * 1000000.0 / events, retries);
+	}
+
+	/* Check that the reader ended up with the final figures. */
+	for(x=0, seen=0; x < printers; x++)
+		{
+		struct STATUS_BOARD_PRINTER copy;
+		if(status_board_read_printer(board, x, &copy) == 0 && copy.pages_printed == pages[x])
+			seen++;
+		}
+	printf("board:     %d of %d printers up to date\n", seen, printers);
+
+	status_board_close(board);
+	unlink(board_fname);
+	gu_free(pages);
+
+	return 0;
+	}
+#endif
+
+/* end of file */
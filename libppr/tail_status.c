@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 27 March 2003.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
@@ -37,6 +37,10 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#include <sys/time.h>
+#ifdef HAVE_INOTIFY
+#include <sys/inotify.h>
+#endif
 #include "gu.h"
 #include "global_defines.h"
 
@@ -56,6 +60,16 @@ static int do_tail(gu_boolean (*callback)(char *p, void *extra), FILE **fd, cons
 			return -1;
 			}
 
+		/* If the other execute bit is already set, this is the file we
+		   just finished with and the writer hasn't unlinked it yet.
+		   Pretend that it isn't there. */
+		if(fstat(fileno(*fd), &statbuf) == 0 && (statbuf.st_mode & S_IXOTH))
+			{
+			fclose(*fd);
+			*fd = NULL;
+			return -1;
+			}
+
 		/* If this is the first file, skip to the end. */
 		if((*file_count)++ == 0)
 			{
@@ -79,18 +93,113 @@ static int do_tail(gu_boolean (*callback)(char *p, void *extra), FILE **fd, cons
 		return -1;
 		}
 
-	/* If the user execute bit is set, this file is done, close it. */
+	/* If the other execute bit is set, this file is done, close it.  Since
+	   the writer may have appended a few more lines between our last read
+	   and its fchmod(), read to the end once more first. */
 	if(statbuf.st_mode & S_IXOTH)
 		{
+		clearerr(*fd);
+		while(fgets(buffer, sizeof(buffer), *fd))
+			{
+			char *p;
+			if((p = strchr(buffer, '\n')))
+				*p = '\0';
+			if((*callback)(buffer, extra))
+				callback_hits++;
+			}
 		fclose(*fd);
 		*fd = NULL;
 		}
+	else
+		{
+		clearerr(*fd);					/* so that fgets() will try again */
+		}
 
 	/* Return the number of lines that the callback routines says it
 	   forwarded to its client. */
 	return callback_hits;
 	} /* end of do_tail() */
 
+#ifdef HAVE_INOTIFY
+/*
+** Create an inotify descriptor which watches the directory which contains
+** the state update files.  We watch the directory rather than the files
+** themselves since the files are replaced when they grow too long.  Events
+** for files in a watched directory are reported with the file name, so
+** inotify_wait() can ignore activity on unrelated files such as the pprd
+** lock file.  Returns -1 if inotify is not available.
+*/
+static int inotify_open(void)
+	{
+	int ifd;
+
+	if((ifd = inotify_init()) == -1)
+		return -1;
+
+	gu_set_cloexec(ifd);
+
+	if(inotify_add_watch(ifd, RUNDIR, IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_MOVED_TO | IN_DELETE) == -1)
+		{
+		close(ifd);
+		return -1;
+		}
+
+	return ifd;
+	}
+
+/*
+** Wait up to timeout seconds for something to happen to one of the state
+** update files.  Returns TRUE if there may be new lines to read, FALSE if
+** the timeout expired.
+*/
+static gu_boolean inotify_wait(int ifd, int timeout)
+	{
+	const char *basename_pprd = strrchr(STATE_UPDATE_FILE, '/') + 1;
+	const char *basename_pprdrv = strrchr(STATE_UPDATE_PPRDRV_FILE, '/') + 1;
+	union {
+		struct inotify_event event;		/* for alignment */
+		char bytes[4096];
+		} buffer;
+	fd_set rfds;
+	struct timeval tv;
+	ssize_t len;
+	char *p;
+	gu_boolean relevant = FALSE;
+
+	while(!relevant)
+		{
+		FD_ZERO(&rfds);
+		FD_SET(ifd, &rfds);
+		tv.tv_sec = timeout;
+		tv.tv_usec = 0;
+
+		switch(select(ifd + 1, &rfds, NULL, NULL, &tv))
+			{
+			case -1:
+				if(errno == EINTR)
+					continue;
+				return TRUE;		/* let the caller look */
+			case 0:
+				return FALSE;		/* timeout */
+			}
+
+		if((len = read(ifd, buffer.bytes, sizeof(buffer.bytes))) <= 0)
+			return TRUE;
+
+		for(p = buffer.bytes; p < buffer.bytes + len; )
+			{
+			struct inotify_event *event = (struct inotify_event *)p;
+			if((event->mask & IN_Q_OVERFLOW)
+					|| (event->len > 0 && (strcmp(event->name, basename_pprd) == 0 || strcmp(event->name, basename_pprdrv) == 0)))
+				relevant = TRUE;
+			p += sizeof(struct inotify_event) + event->len;
+			}
+		}
+
+	return TRUE;
+	}
+#endif
+
 /*
 ** This function never returns.  It just keeps monitoring the status files and
 ** feeding lines to the callback routine.  The callback routine should return
@@ -108,16 +217,48 @@ void tail_status(gu_boolean tail_pprd, gu_boolean tail_pprdrv, gu_boolean (*call
 	int pprd_file_count = 0;
 	FILE *pprdrv_fd = NULL;
 	int pprdrv_file_count = 0;
+	#ifdef HAVE_INOTIFY
+	/* If the system can tell us when the files change, we will sleep until
+	   it does rather than polling once a second. */
+	int ifd = inotify_open();
+	time_t idle_since = time(NULL);
+	#endif
 
 	while(TRUE)
 		{
-		if(		(tail_pprdrv && do_tail(callback, &pprdrv_fd, STATE_UPDATE_PPRDRV_FILE, &pprdrv_file_count, extra) > 0)
-			 || (tail_pprd	 && do_tail(callback, &pprd_fd,	  STATE_UPDATE_FILE,		&pprd_file_count,	extra) > 0)
-			)
+		/* Catch up on both files.  A file which was cut loose will have been
+		   closed by do_tail(), so go around again at once in order to open
+		   its successor. */
+		FILE *pprdrv_fd_before = pprdrv_fd;
+		FILE *pprd_fd_before = pprd_fd;
+		int pprdrv_hits = tail_pprdrv ? do_tail(callback, &pprdrv_fd, STATE_UPDATE_PPRDRV_FILE, &pprdrv_file_count, extra) : 0;
+		int pprd_hits = tail_pprd ? do_tail(callback, &pprd_fd, STATE_UPDATE_FILE, &pprd_file_count, extra) : 0;
+		gu_boolean cut_loose = (pprdrv_fd_before && !pprdrv_fd) || (pprd_fd_before && !pprd_fd);
+
+		if(pprdrv_hits > 0 || pprd_hits > 0)
 			{
 			countup = 0;
+			#ifdef HAVE_INOTIFY
+			idle_since = time(NULL);
+			#endif
+			continue;
+			}
+
+		if(cut_loose)
+			continue;
+
+		#ifdef HAVE_INOTIFY
+		if(ifd != -1)
+			{
+			int remaining = timeout - (int)(time(NULL) - idle_since);
+			if(remaining <= 0 || !inotify_wait(ifd, remaining))
+				{
+				(*callback)(NULL, extra);
+				idle_since = time(NULL);
+				}
 			continue;
 			}
+		#endif
 
 		if(countup >= timeout)
 			{
@@ -0,0 +1,177 @@
+/*
+** mouse:~ppr/src/libpprdb/dbbench.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This program times the user database backend which libpprdb.a was built
+** with by charging jobs from many processes at once, the way pprdrv does
+** when many printers are busy.  It adds the indicated number of users, then
+** forks the indicated number of drivers, each of which charges the indicated
+** number of jobs.  Each job is a db_auth() followed by a CHARGE of 1 to a
+** user picked at random.  Then it checks that the total of the balances went
+** down by the number of jobs which were charged and deletes the users.
+**
+** With -r, a driver which gets USER_ERROR waits 200 microseconds and tries
+** again, as many as 100000 times.  The gdbm backend can't be opened for
+** writing while another process has it open, so it must be timed this way.
+**
+** This uses the real user database, so it should be run as USER_PPR on a
+** test system.  The users it adds are named "dbbench00000" and up.
+**
+** Usage: dbbench [-r] users drivers jobs
+*/
+
+#include "config.h"
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "userdb.h"
+
+#define START_BALANCE 1000000
+
+/* The library calls these to report trouble. */
+void fatal(int exitval, const char message[], ...);
+
+void error(const char message[], ...)
+	{
+	va_list va;
+	va_start(va, message);
+	vfprintf(stderr, message, va);
+	fputc('\n', stderr);
+	va_end(va);
+	}
+
+void fatal(int exitval, const char message[], ...)
+	{
+	va_list va;
+	va_start(va, message);
+	vfprintf(stderr, message, va);
+	fputc('\n', stderr);
+	va_end(va);
+	exit(exitval);
+	}
+
+static double now(void)
+	{
+	struct timeval t;
+	gettimeofday(&t, NULL);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+	}
+
+/* Charge jobs and return how many couldn't be charged. */
+static int driver(int seed, int users, int jobs, gu_boolean retry)
+	{
+	char name[32];
+	struct userdb user;
+	enum USERDB_RESULT ret;
+	int failed = 0;
+	int tries;
+	int x;
+
+	srand(seed);
+	for(x=0; x < jobs; x++)
+		{
+		snprintf(name, sizeof(name), "dbbench%05d", rand() % users);
+		tries = 0;
+		while((ret = db_auth(&user, name)) == USER_ERROR && retry && ++tries < 100000)
+			usleep(200);
+		if(ret != USER_OK)
+			{
+			failed++;
+			continue;
+			}
+		while((ret = db_transaction(name, 1, TRANSACTION_CHARGE)) == USER_ERROR && retry && ++tries < 100000)
+			usleep(200);
+		if(ret != USER_OK)
+			failed++;
+		}
+
+	return failed;
+	}
+
+int main(int argc, char *argv[])
+	{
+	gu_boolean retry = FALSE;
+	int users, drivers, jobs;
+	struct userdb user;
+	char name[32];
+	double start, t;
+	int status, failed = 0;
+	long charged = 0;
+	int x;
+
+	if(argc > 1 && strcmp(argv[1], "-r") == 0)
+		{
+		retry = TRUE;
+		argc--;
+		argv++;
+		}
+	if(argc != 4 || (users = atoi(argv[1])) < 1 || users > 100000 || (drivers = atoi(argv[2])) < 1 || (jobs = atoi(argv[3])) < 1)
+		{
+		fprintf(stderr, "Usage: dbbench [-r] users drivers jobs\n");
+		return 1;
+		}
+
+	memset(&user, 0, sizeof(user));
+	strcpy(user.fullname, "Benchmark User");
+	user.balance = START_BALANCE;
+	user.cutoff = 0;
+	for(x=0; x < users; x++)
+		{
+		snprintf(name, sizeof(name), "dbbench%05d", x);
+		if(db_add_user(name, &user) != USER_OK)
+			{
+			fprintf(stderr, "Can't add user \"%s\".\n", name);
+			return 1;
+			}
+		}
+
+	start = now();
+	for(x=0; x < drivers; x++)
+		{
+		if(fork() == 0)
+			{
+			int f = driver(x + 1, users, jobs, retry);
+			_exit(f > 255 ? 255 : f);
+			}
+		}
+	while(wait(&status) > 0)
+		failed += WIFEXITED(status) ? WEXITSTATUS(status) : jobs;
+	t = now() - start;
+
+	for(x=0; x < users; x++)
+		{
+		snprintf(name, sizeof(name), "dbbench%05d", x);
+		if(db_auth(&user, name) == USER_ERROR)
+			{
+			fprintf(stderr, "Can't read user \"%s\".\n", name);
+			return 1;
+			}
+		charged += START_BALANCE - user.balance;
+		db_delete_user(name);
+		}
+
+	printf("%d users, %d drivers x %d jobs: %.2f seconds, %.0f jobs per second\n",
+		users, drivers, jobs, t, drivers * jobs / t);
+	printf("%d jobs failed, %ld charged, %s\n",
+		failed, charged, charged == (long)drivers * jobs - failed ? "correct" : "WRONG");
+
+	return 0;
+	}
+
+/* end of file */
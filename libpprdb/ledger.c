@@ -0,0 +1,516 @@
+/*
+** mouse:~ppr/src/libpprdb/ledger.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This is the core of the "ledger" user database backend.  The user
+** records are kept in a constant database (LEDGER_SNAPSHOT) which is never
+** modified in place.  Changes are appended to a journal (LEDGER_JOURNAL) as
+** fixed-size records, each with a single write() to a file opened with
+** O_APPEND, so charging a job doesn't wait for other processes which are
+** charging jobs.
+**
+** Each process keeps the snapshot mapped and the journal open for as long
+** as it runs.  Before each lookup it reads whatever has been added to the
+** journal since it last looked and applies it to a hash of the users it
+** mentions (the overlay).  When the journal holds LEDGER_BATCH records,
+** the process which notices builds a new snapshot from the old one and the
+** overlay, renames it into place, and empties the journal.
+**
+** A shared lock on the journal is held while reading or appending to it.
+** An exclusive lock is held while it is applied to the snapshot.  A
+** process which finds that the snapshot has been replaced discards its
+** overlay and reads the journal from the beginning.
+**
+** Each snapshot has a generation number, one more than that of the snapshot
+** it was built from, and each journal record carries the generation of the
+** snapshot which was current when it was appended.  Records for an older
+** generation are already in the snapshot and are skipped.  So if the system
+** crashes after a new snapshot has been renamed into place but before the
+** journal has been emptied, no one is charged twice.
+**
+** Journal records are not fsync()ed as they are appended, so if the system
+** crashes, the last few changes may be lost, just as they may be with the
+** gdbm backend.
+*/
+
+#include "config.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "userdb.h"
+#include "ledger.h"
+
+#define LEDGER_MAGIC 0x4C444732			/* "LDG2" */
+#define LEDGER_BATCH 1024				/* apply the journal when it holds this many records */
+#define LEDGER_BUCKETS 1024
+
+/* The snapshot's generation number is stored under this key.  Since
+   usernames are looked up in lower case, it can't be a user. */
+#define LEDGER_GENERATION_KEY "GENERATION"
+
+struct LEDGER_USER
+	{
+	char username[LEDGER_MAX_USERNAME+1];
+	gu_boolean deleted;
+	struct userdb user;
+	} ;
+
+static int journal_fd = -1;
+static off_t journal_pos = 0;			/* how much of the journal is in the overlay */
+static void *snapshot = NULL;
+static struct stat snapshot_stat;		/* to notice when the snapshot is replaced */
+static unsigned int snapshot_generation = 0;
+static void *overlay = NULL;			/* username -> struct LEDGER_USER */
+
+/*
+** Lock or unlock the journal.
+*/
+static int ledger_lock(int type, gu_boolean wait)
+	{
+	struct flock lock;
+	int ret;
+
+	lock.l_type = type;
+	lock.l_whence = SEEK_SET;
+	lock.l_start = (off_t)0;
+	lock.l_len = (off_t)0;
+
+	while((ret = fcntl(journal_fd, wait ? F_SETLKW : F_SETLK, &lock)) == -1 && errno == EINTR)
+		;
+	return ret;
+	}
+
+/*
+** Open the journal if this process hasn't already.
+*/
+static int ledger_open(void)
+	{
+	struct stat statbuf;
+
+	if(journal_fd != -1)
+		return 0;
+
+	if((journal_fd = open(LEDGER_JOURNAL, O_RDWR | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR)) == -1)
+		{
+		error("ledger_open(): can't open \"%s\", errno=%d (%s)", LEDGER_JOURNAL, errno, gu_strerror(errno));
+		return -1;
+		}
+	gu_set_cloexec(journal_fd);
+
+	/* Cut off any record torn by a system crash. */
+	if(ledger_lock(F_WRLCK, TRUE) == 0)
+		{
+		if(fstat(journal_fd, &statbuf) == 0 && statbuf.st_size % sizeof(struct LEDGER_RECORD) != 0)
+			{
+			error("ledger_open(): removing partial record from end of \"%s\"", LEDGER_JOURNAL);
+			ftruncate(journal_fd, statbuf.st_size - statbuf.st_size % sizeof(struct LEDGER_RECORD));
+			}
+		ledger_lock(F_UNLCK, TRUE);
+		}
+
+	memset(&snapshot_stat, 0, sizeof(snapshot_stat));
+	return 0;
+	} /* end of ledger_open() */
+
+/*
+** Store the lower-case version of username in key.
+*/
+static int ledger_key(char key[LEDGER_MAX_USERNAME+1], const char username[])
+	{
+	int x;
+
+	if(!username || strlen(username) > LEDGER_MAX_USERNAME)
+		return -1;
+
+	for(x=0; username[x]; x++)
+		key[x] = tolower(username[x]);
+	key[x] = '\0';
+	return 0;
+	}
+
+/*
+** Look up a user in the overlay and then in the snapshot.  Returns
+** TRUE and fills in *user if the user exists.
+*/
+static gu_boolean ledger_find(const char key[], struct userdb *user)
+	{
+	struct LEDGER_USER *u;
+	const char *data;
+	int len;
+
+	if((u = gu_pch_get(overlay, key)))
+		{
+		if(u->deleted)
+			return FALSE;
+		memcpy(user, &u->user, sizeof(struct userdb));
+		return TRUE;
+		}
+
+	if(snapshot && (data = gu_cdb_find(snapshot, key, &len)) && len == sizeof(struct userdb))
+		{
+		memcpy(user, data, sizeof(struct userdb));
+		return TRUE;
+		}
+
+	return FALSE;
+	} /* end of ledger_find() */
+
+/*
+** Apply a journal record to the overlay.
+*/
+static void ledger_apply(const struct LEDGER_RECORD *r)
+	{
+	struct LEDGER_USER *u;
+
+	if(!(u = gu_pch_get(overlay, r->username)))
+		{
+		u = gu_alloc(1, sizeof(struct LEDGER_USER));
+		strcpy(u->username, r->username);
+		u->deleted = !ledger_find(r->username, &u->user);
+		gu_pch_set(overlay, u->username, u);
+		}
+
+	switch(r->op)
+		{
+		case LEDGER_ADD:
+			memcpy(&u->user, &r->user, sizeof(struct userdb));
+			u->deleted = FALSE;
+			break;
+		case LEDGER_DELETE:
+			u->deleted = TRUE;
+			break;
+		case LEDGER_TRANSACTION:
+			if(u->deleted)
+				return;
+			switch(r->type)
+				{
+				case TRANSACTION_CHARGE:
+				case TRANSACTION_WITHDRAWAL:
+					u->user.balance -= r->amount;
+					break;
+				case TRANSACTION_DEPOSIT:		/* any deposit */
+					u->user.revoked = FALSE;	/* restores credit and falls thru */
+				case TRANSACTION_CORRECTION:
+					u->user.balance += r->amount;
+					break;
+				}
+			break;
+		case LEDGER_REVOKE:
+			if(u->deleted)
+				return;
+			u->user.revoked = TRUE;
+			break;
+		case LEDGER_AUTHCODE:
+			if(u->deleted)
+				return;
+			memcpy(u->user.authcode, r->user.authcode, sizeof(u->user.authcode));
+			break;
+		}
+
+	u->user.last_mod = r->when;
+	} /* end of ledger_apply() */
+
+/*
+** Discard the overlay.
+*/
+static void ledger_overlay_free(void)
+	{
+	struct LEDGER_USER *u;
+
+	if(!overlay)
+		return;
+	gu_pch_rewind(overlay);
+	while(gu_pch_nextkey(overlay, (void**)&u))
+		gu_free(u);
+	gu_pch_free(overlay);
+	overlay = NULL;
+	}
+
+/*
+** Bring the overlay up to date.  If the snapshot has been replaced, map
+** the new one and start over.  The caller must hold a lock on the journal.
+*/
+static int ledger_refresh(void)
+	{
+	struct stat statbuf;
+	struct LEDGER_RECORD records[64];
+	ssize_t len;
+	const char *data;
+	int data_len;
+
+	if(stat(LEDGER_SNAPSHOT, &statbuf) == -1)
+		{
+		if(errno != ENOENT)
+			{
+			error("ledger_refresh(): can't stat \"%s\", errno=%d (%s)", LEDGER_SNAPSHOT, errno, gu_strerror(errno));
+			return -1;
+			}
+		memset(&statbuf, 0, sizeof(statbuf));
+		}
+
+	if(!overlay || statbuf.st_ino != snapshot_stat.st_ino || statbuf.st_dev != snapshot_stat.st_dev
+			|| statbuf.st_mtime != snapshot_stat.st_mtime)
+		{
+		if(snapshot)
+			{
+			gu_cdb_close(snapshot);
+			snapshot = NULL;
+			}
+		if(statbuf.st_ino != 0 && !(snapshot = gu_cdb_open(LEDGER_SNAPSHOT)))
+			{
+			error("ledger_refresh(): can't open \"%s\", errno=%d (%s)", LEDGER_SNAPSHOT, errno, gu_strerror(errno));
+			memset(&snapshot_stat, 0, sizeof(snapshot_stat));
+			ledger_overlay_free();
+			return -1;
+			}
+		memcpy(&snapshot_stat, &statbuf, sizeof(struct stat));
+		snapshot_generation = 0;
+		if(snapshot && (data = gu_cdb_find(snapshot, LEDGER_GENERATION_KEY, &data_len)) && data_len == sizeof(unsigned int))
+			memcpy(&snapshot_generation, data, sizeof(unsigned int));
+		ledger_overlay_free();
+		overlay = gu_pch_new(LEDGER_BUCKETS);
+		journal_pos = 0;
+		}
+
+	while((len = pread(journal_fd, records, sizeof(records), journal_pos)) >= (ssize_t)sizeof(struct LEDGER_RECORD))
+		{
+		int count = len / sizeof(struct LEDGER_RECORD);
+		int x;
+		for(x=0; x < count; x++)
+			{
+			if(records[x].magic != LEDGER_MAGIC)
+				error("ledger_refresh(): bad record at offset %ld in \"%s\"", (long)journal_pos + x * (long)sizeof(struct LEDGER_RECORD), LEDGER_JOURNAL);
+			else if(records[x].generation == snapshot_generation)
+				ledger_apply(&records[x]);
+			else if(records[x].generation > snapshot_generation)	/* snapshot restored from a backup? */
+				error("ledger_refresh(): record at offset %ld in \"%s\" is for a newer snapshot", (long)journal_pos + x * (long)sizeof(struct LEDGER_RECORD), LEDGER_JOURNAL);
+			}
+		journal_pos += count * sizeof(struct LEDGER_RECORD);
+		}
+
+	if(len == -1)
+		{
+		error("ledger_refresh(): can't read \"%s\", errno=%d (%s)", LEDGER_JOURNAL, errno, gu_strerror(errno));
+		return -1;
+		}
+
+	return 0;
+	} /* end of ledger_refresh() */
+
+/*
+** Apply the journal to the snapshot by writing a new snapshot and
+** emptying the journal.  If another process holds a lock, we leave this
+** for a later call.
+*/
+static void ledger_compact(void)
+	{
+	const char function[] = "ledger_compact";
+	struct stat statbuf;
+	void *cdbm;
+	mode_t saved_umask;
+	unsigned int generation;
+	int ret = 0;
+	int fd;
+
+	if(ledger_lock(F_WRLCK, FALSE) == -1)
+		return;
+
+	/* Another process may have done it while we were waiting. */
+	if(fstat(journal_fd, &statbuf) == -1 || statbuf.st_size < LEDGER_BATCH * sizeof(struct LEDGER_RECORD))
+		goto unlock;
+
+	if(ledger_refresh() == -1)
+		goto unlock;
+
+	/* The snapshot holds authcodes, so it must not be world readable. */
+	saved_umask = umask(077);
+	cdbm = gu_cdb_make_new(LEDGER_SNAPSHOT);
+	umask(saved_umask);
+	if(!cdbm)
+		{
+		error("%s(): can't create new \"%s\", errno=%d (%s)", function, LEDGER_SNAPSHOT, errno, gu_strerror(errno));
+		goto unlock;
+		}
+
+	generation = snapshot_generation + 1;
+	ret = gu_cdb_make_add(cdbm, LEDGER_GENERATION_KEY, (char*)&generation, sizeof(unsigned int));
+
+	/* The users in the snapshot, as changed by the journal */
+	if(snapshot)
+		{
+		unsigned int pos = 0;
+		const char *key, *data;
+		int key_len, data_len;
+		char username[LEDGER_MAX_USERNAME+1];
+		struct LEDGER_USER *u;
+
+		while(ret == 0 && (key = gu_cdb_next(snapshot, &pos, &key_len, &data, &data_len)))
+			{
+			if(key_len > LEDGER_MAX_USERNAME)
+				continue;
+			memcpy(username, key, key_len);
+			username[key_len] = '\0';
+			if(strcmp(username, LEDGER_GENERATION_KEY) == 0)
+				continue;
+			if((u = gu_pch_get(overlay, username)))
+				{
+				if(!u->deleted)
+					ret = gu_cdb_make_add(cdbm, username, (char*)&u->user, sizeof(struct userdb));
+				}
+			else
+				{
+				ret = gu_cdb_make_add(cdbm, username, data, data_len);
+				}
+			}
+		}
+
+	/* The users added since */
+	{
+	struct LEDGER_USER *u;
+	const char *data;
+	int data_len;
+	gu_pch_rewind(overlay);
+	while(ret == 0 && gu_pch_nextkey(overlay, (void**)&u))
+		{
+		if(!u->deleted && !(snapshot && (data = gu_cdb_find(snapshot, u->username, &data_len))))
+			ret = gu_cdb_make_add(cdbm, u->username, (char*)&u->user, sizeof(struct userdb));
+		}
+	}
+
+	if(gu_cdb_make_finish(cdbm, ret == -1 ? TRUE : FALSE) == -1)
+		{
+		error("%s(): can't write new \"%s\", errno=%d (%s)", function, LEDGER_SNAPSHOT, errno, gu_strerror(errno));
+		goto unlock;
+		}
+
+	/* The new snapshot and its name must be on disk before the journal
+	   is emptied.  If we crash before then, the records in the journal
+	   are for the old generation and will be skipped. */
+	if((fd = open(LEDGER_SNAPSHOT, O_RDONLY)) != -1)
+		{
+		fsync(fd);
+		close(fd);
+		}
+	if((fd = open(CONFDIR, O_RDONLY)) != -1)
+		{
+		fsync(fd);
+		close(fd);
+		}
+	if(ftruncate(journal_fd, 0) == -1)
+		error("%s(): can't empty \"%s\", errno=%d (%s)", function, LEDGER_JOURNAL, errno, gu_strerror(errno));
+
+	unlock:
+	ledger_lock(F_UNLCK, TRUE);
+	} /* end of ledger_compact() */
+
+/*
+** Look up a user.  Returns USER_OK and fills in *user if the user
+** exists, USER_ISNT if not, or USER_ERROR.
+*/
+enum USERDB_RESULT ledger_get(const char username[], struct userdb *user)
+	{
+	char key[LEDGER_MAX_USERNAME+1];
+	int ret;
+
+	if(ledger_key(key, username) == -1)
+		return USER_ISNT;
+
+	if(ledger_open() == -1)
+		return USER_ERROR;
+
+	if(ledger_lock(F_RDLCK, TRUE) == -1)
+		{
+		error("ledger_get(): can't lock \"%s\", errno=%d (%s)", LEDGER_JOURNAL, errno, gu_strerror(errno));
+		return USER_ERROR;
+		}
+	ret = ledger_refresh();
+	ledger_lock(F_UNLCK, TRUE);
+
+	if(ret == -1)
+		return USER_ERROR;
+
+	return ledger_find(key, user) ? USER_OK : USER_ISNT;
+	} /* end of ledger_get() */
+
+/*
+** Append a record to the journal.  The caller fills in op and whichever
+** of type, amount, and user the op requires.  Returns USER_ISNT if the
+** user doesn't exist (or, for LEDGER_ADD, USER_ERROR if the user does).
+*/
+enum USERDB_RESULT ledger_put(const char username[], struct LEDGER_RECORD *record)
+	{
+	struct userdb user;
+	struct stat statbuf;
+	enum USERDB_RESULT ret = USER_OK;
+
+	if(ledger_key(record->username, username) == -1)
+		return record->op == LEDGER_ADD ? USER_ERROR : USER_ISNT;
+
+	if(ledger_open() == -1)
+		return USER_ERROR;
+
+	record->magic = LEDGER_MAGIC;
+	time(&record->when);
+
+	if(ledger_lock(F_RDLCK, TRUE) == -1)
+		{
+		error("ledger_put(): can't lock \"%s\", errno=%d (%s)", LEDGER_JOURNAL, errno, gu_strerror(errno));
+		return USER_ERROR;
+		}
+
+	if(ledger_refresh() == -1)
+		{
+		ret = USER_ERROR;
+		}
+	else if(ledger_find(record->username, &user))
+		{
+		if(record->op == LEDGER_ADD)
+			{
+			error("The entry already exists.");
+			ret = USER_ERROR;
+			}
+		}
+	else
+		{
+		if(record->op != LEDGER_ADD)
+			ret = USER_ISNT;
+		}
+
+	/* The exclusive lock held while the journal is applied keeps this
+	   from changing until we have appended the record. */
+	record->generation = snapshot_generation;
+
+	/* One write() to a file opened with O_APPEND, so records from
+	   different processes don't mix. */
+	if(ret == USER_OK && write(journal_fd, record, sizeof(struct LEDGER_RECORD)) != sizeof(struct LEDGER_RECORD))
+		{
+		error("ledger_put(): can't append to \"%s\", errno=%d (%s)", LEDGER_JOURNAL, errno, gu_strerror(errno));
+		ret = USER_ERROR;
+		}
+
+	ledger_lock(F_UNLCK, TRUE);
+
+	if(ret == USER_OK && fstat(journal_fd, &statbuf) == 0 && statbuf.st_size >= LEDGER_BATCH * sizeof(struct LEDGER_RECORD))
+		ledger_compact();
+
+	return ret;
+	} /* end of ledger_put() */
+
+/* end of file */
@@ -0,0 +1,42 @@
+/*
+** mouse:~ppr/src/libpprdb/ledger.h
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This header is shared by the modules of the "ledger" user
+** database backend.  See ledger.c.
+*/
+
+#define LEDGER_MAX_USERNAME 63
+
+/* Kinds of journal records */
+#define LEDGER_ADD 'A'				/* add user, user is the record */
+#define LEDGER_DELETE 'D'			/* delete user */
+#define LEDGER_TRANSACTION 'T'		/* transaction of type and amount */
+#define LEDGER_REVOKE 'R'			/* revoke credit */
+#define LEDGER_AUTHCODE 'C'			/* new authcode in user.authcode */
+
+struct LEDGER_RECORD
+	{
+	int magic;
+	int op;							/* LEDGER_ADD, etc. */
+	int type;						/* enum TRANSACTION */
+	int amount;
+	unsigned int generation;		/* generation of the snapshot it applies to */
+	time_t when;
+	char username[LEDGER_MAX_USERNAME+1];
+	struct userdb user;
+	} ;
+
+enum USERDB_RESULT ledger_get(const char username[], struct userdb *user);
+enum USERDB_RESULT ledger_put(const char username[], struct LEDGER_RECORD *record);
+
+/* end of file */
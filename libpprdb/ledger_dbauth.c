@@ -0,0 +1,80 @@
+/*
+** mouse:~ppr/src/libpprdb/ledger_dbauth.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** Authorization function for the "ledger" backend.  The record comes from
+** this process's copy of the snapshot and journal, so this doesn't block
+** while other processes are charging jobs.
+*/
+
+#include "config.h"
+#include <string.h>
+#include <time.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "userdb.h"
+#include "ledger.h"
+
+/*
+** Authorization function, return the user's record and indicate if printing
+** can be carried out in consideration of the amount of money currently
+** in the account.
+*/
+enum USERDB_RESULT db_auth(struct userdb *entry_copy, const char *username)
+	{
+	enum USERDB_RESULT ret;
+
+	if(!username)
+		return USER_ERROR;
+
+	if((ret = ledger_get(username, entry_copy)) != USER_OK)
+		return ret;
+
+	/*
+	** If the user is overdrawn and it is during business hours,
+	** then revoke the user's credit.  Business hours are defined
+	** as not Saturday or Sunday and between 9am (inclusive) and
+	** 5pm (exclusive).
+	*/
+	if(entry_copy->balance <= entry_copy->cutoff && !entry_copy->revoked)
+		{
+#ifdef BUSINESS_HOURS
+		time_t rawnow;			  /* seconds since 1 Jan 1970 */
+		struct tm *now;			  /* broken into day, hour, etc. */
+
+		time(&rawnow);
+		now = localtime(&rawnow);
+
+		if( (now->tm_wday != 0) && (now->tm_wday != 6)
+					&& (now->tm_hour>=9) && (now->tm_hour<17) )
+			{
+#endif
+			struct LEDGER_RECORD record;
+			memset(&record, 0, sizeof(record));
+			record.op = LEDGER_REVOKE;
+			if((ret = ledger_put(username, &record)) != USER_OK)
+				return ret;
+			entry_copy->revoked = TRUE;
+			entry_copy->last_mod = record.when;
+#ifdef BUSINESS_HOURS
+			}
+#endif
+		}
+
+	/* If credit has been revoked, then say the user is overdrawn. */
+	if(entry_copy->revoked)
+		return USER_OVERDRAWN;
+	else
+		return USER_OK;
+	} /* end of db_auth() */
+
+/* end of file */
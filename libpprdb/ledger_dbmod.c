@@ -0,0 +1,73 @@
+/*
+** mouse:~ppr/src/libpprdb/ledger_dbmod.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** Make modifications to the user database.
+*/
+
+#include "config.h"
+#include <string.h>
+#include <time.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "userdb.h"
+#include "ledger.h"
+
+/*
+** Add a user to the database.  Return non-zero if
+** the operation fails for any reason.
+*/
+enum USERDB_RESULT db_add_user(const char *username, struct userdb *user)
+	{
+	struct LEDGER_RECORD record;
+	enum USERDB_RESULT ret;
+
+	memset(&record, 0, sizeof(record));
+	record.op = LEDGER_ADD;
+	memcpy(&record.user, user, sizeof(struct userdb));
+
+	if((ret = ledger_put(username, &record)) == USER_OK)
+		user->last_mod = record.when;	/* last modification is now */
+
+	return ret;
+	} /* end of db_add_user() */
+
+/*
+** Delete a user from the database.  Return non-zero if
+** the operation fails for any reason.
+*/
+enum USERDB_RESULT db_delete_user(const char *username)
+	{
+	struct LEDGER_RECORD record;
+
+	memset(&record, 0, sizeof(record));
+	record.op = LEDGER_DELETE;
+
+	return ledger_put(username, &record) == USER_OK ? USER_OK : USER_ERROR;
+	} /* end of db_delete_user() */
+
+/*
+** Change a user's authcode.
+*/
+enum USERDB_RESULT db_new_authcode(const char *username, const char *newauthcode)
+	{
+	struct LEDGER_RECORD record;
+
+	memset(&record, 0, sizeof(record));
+	record.op = LEDGER_AUTHCODE;
+	strncpy(record.user.authcode, newauthcode, 16);		/* the AuthCode */
+	record.user.authcode[16] = '\0';
+
+	return ledger_put(username, &record);
+	} /* end of db_new_authcode() */
+
+/* end of file */
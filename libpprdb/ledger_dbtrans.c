@@ -0,0 +1,49 @@
+/*
+** mouse:~ppr/src/libpprdb/ledger_dbtrans.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+#include "config.h"
+#include <string.h>
+#include <time.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "userdb.h"
+#include "ledger.h"
+
+/*
+** Charge or credit a user's account.  This only appends a record to the
+** journal.  The balance store is brought up to date in batches.
+*/
+enum USERDB_RESULT db_transaction(const char *username, int amount, enum TRANSACTION transaction_type)
+	{
+	struct LEDGER_RECORD record;
+
+	switch(transaction_type)
+		{
+		case TRANSACTION_CHARGE:
+		case TRANSACTION_WITHDRAWAL:
+		case TRANSACTION_DEPOSIT:
+		case TRANSACTION_CORRECTION:
+			break;
+		default:
+			error("db_transaction(): invalid transaction type=%d, amount=%d\n", transaction_type, amount);
+			return USER_ERROR;
+		}
+
+	memset(&record, 0, sizeof(record));
+	record.op = LEDGER_TRANSACTION;
+	record.type = transaction_type;
+	record.amount = amount;
+
+	return ledger_put(username, &record);
+	} /* end of db_transaction() */
+
+/* end of file */
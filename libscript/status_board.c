@@ -0,0 +1,172 @@
+/*
+** mouse:~ppr/src/libscript/status_board.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This program is used by scripts that want to know what PPR is doing
+** without following the output of tail_status from the beginning.  It
+** prints the contents of the status board (see libppr/status_board.c), one
+** line per printer and one per job:
+**
+** PRINTER slot name status retry countdown job pages_started pages_printed bytes_sent bytes_total message
+** JOB slot jobid priority status [printer]
+**
+** A job of "-" means that the printer isn't printing anything.  The page
+** and byte figures are those which pprdrv reported for that job.  The
+** lines end with a line "EVENTS n".  With the --watch switch, it keeps
+** going, printing lines for only those slots which have changed and then
+** another EVENTS line.  Slots which are no longer in use are printed with
+** only their slot numbers.  If pprd restarts, it prints "RESTART" followed
+** by the whole board again.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "status_board.h"
+#include "version.h"
+
+/* How often do we look for changes (in milliseconds)? */
+#define WATCH_INTERVAL 250
+
+static void print_printer(const struct STATUS_BOARD *board, int slot, gu_boolean changes_only)
+	{
+	struct STATUS_BOARD_PRINTER p;
+
+	if(status_board_read_printer(board, slot, &p) == -1)
+		return;
+
+	if(!p.name[0])
+		{
+		if(changes_only)
+			printf("PRINTER %d\n", slot);
+		return;
+		}
+
+	printf("PRINTER %d %s %s %d %d ", slot, p.name, status_board_printer_status_word(p.status), p.retry, p.countdown);
+	if(p.job_destname[0])
+		{
+		printf("%s ", jobid(p.job_destname, p.job_id, p.job_subid));
+		if(p.drv_job_id == p.job_id && p.drv_job_subid == p.job_subid)
+			printf("%d %d %ld %ld %s\n", p.pages_started, p.pages_printed, p.bytes_sent, p.bytes_total, p.message);
+		else
+			printf("0 0 0 0\n");
+		}
+	else
+		{
+		printf("- 0 0 0 0 %s\n", p.message);
+		}
+	}
+
+static void print_job(const struct STATUS_BOARD *board, int slot, gu_boolean changes_only)
+	{
+	struct STATUS_BOARD_JOB j;
+
+	if(status_board_read_job(board, slot, &j) == -1)
+		return;
+
+	if(!j.destname[0])
+		{
+		if(changes_only)
+			printf("JOB %d\n", slot);
+		return;
+		}
+
+	printf("JOB %d %s %d %s", slot, jobid(j.destname, j.id, j.subid), j.priority, status_board_job_status_word(j.status));
+	if(j.status >= 0 && j.status < STATUS_BOARD_PRINTERS)
+		printf(" %s", board->printers[j.status].name);
+	printf("\n");
+	}
+
+/*
+** Print the slots which have changed since the indicated event, or all of
+** them if changes_only is FALSE.  Return the event number to pass next time.
+*/
+static unsigned int print_board(const struct STATUS_BOARD *board, unsigned int since, gu_boolean changes_only)
+	{
+	unsigned int events = status_board_events(board);
+	int x, used;
+
+	used = board->header->printers_used;
+	for(x=0; x < used; x++)
+		{
+		if(!changes_only || status_board_printer_changed(board, x, since))
+			print_printer(board, x, changes_only);
+		}
+
+	used = board->header->jobs_used;
+	for(x=0; x < used; x++)
+		{
+		if(!changes_only || status_board_job_changed(board, x, since))
+			print_job(board, x, changes_only);
+		}
+
+	printf("EVENTS %u\n", events);
+	fflush(stdout);
+
+	return events;
+	}
+
+int main(int argc, char *argv[])
+	{
+	gu_boolean watch = FALSE;
+	struct STATUS_BOARD *board;
+	unsigned int since;
+
+	if(argc == 2 && strcmp(argv[1], "--watch") == 0)
+		watch = TRUE;
+	else if(argc != 1)
+		{
+		fprintf(stderr, "Usage: %s [--watch]\n", argv[0]);
+		return 1;
+		}
+
+	if(!(board = status_board_open(FALSE)))
+		{
+		fprintf(stderr, "%s: can't open \"%s\"\n", argv[0], STATUS_BOARD_FILE);
+		return 1;
+		}
+
+	/* Scripts may want to check that they understand us. */
+	printf("VERSION %s\n", SHORT_VERSION);
+
+	since = print_board(board, 0, FALSE);
+
+	while(watch)
+		{
+		usleep(WATCH_INTERVAL * 1000);
+
+		if(status_board_is_stale(board))
+			{
+			struct STATUS_BOARD *new_board;
+			if(!(new_board = status_board_open(FALSE)))
+				continue;
+			status_board_close(board);
+			board = new_board;
+			printf("RESTART\n");
+			since = print_board(board, 0, FALSE);
+			continue;
+			}
+
+		if(status_board_events(board) != since)
+			since = print_board(board, since, TRUE);
+		}
+
+	status_board_close(board);
+
+	return 0;
+	} /* end of main() */
+
+/* end of file */
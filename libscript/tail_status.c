@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 17 November 2002.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -64,6 +64,7 @@ int main(int argc, char *argv[])
 	   of PPR with which it is compatible.
 	   */
 	printf("VERSION %s\n", SHORT_VERSION);
+	fflush(stdout);
 
 	tail_status(TRUE, TRUE, print_function, 60, (void*)NULL);
 
@@ -0,0 +1,757 @@
+/*
+** mouse:~ppr/src/misc/ppr-dispatch-sim.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This program replays a recorded job trace under each of the group
+** dispatch policies (see libppr/group_dispatch.c) and reports how long it
+** took to print everything (the makespan), how long the jobs waited to be
+** started, and how long they took to be printed after they arrived.
+** The trace is read from stdin in the format of "ppr-printlog --list".
+** Each job arrives at the time it was submitted (the time printed less the
+** wait) and takes as long as its printed sides take at its printer's speed.
+** The speed of each printer is its total sides over its total run time in
+** the trace unless it is given with --printer.
+**
+** A job whose destination is one of the printers in the trace is sent to
+** that printer.  The others are group jobs and the members of each group
+** are the printers which printed its jobs unless they are given with
+** --group.  As in pprd, the jobs wait in one queue in the order in which
+** they arrived, an idle printer takes the first job it may print, and a
+** group's policy is consulted when one of its jobs arrives, when a member
+** looks for work, and every five seconds while a job is being held for a
+** busy member.  The policies know the printer speeds exactly and printers
+** never fail, so the results are the best each policy could do.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#ifdef INTERNATIONAL
+#include <locale.h>
+#include <libintl.h>
+#endif
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "group_dispatch.h"
+#include "util_exits.h"
+#include "version.h"
+
+const char myname[] = "ppr-dispatch-sim";
+
+/* As in pprd */
+#define TICK_INTERVAL 5
+
+#define NEVER 1.0e30
+
+struct PRINTER {
+	char *name;
+	double ppm;				/* sides per minute */
+	double sides;			/* totals from the trace */
+	double seconds;
+	int job;				/* job it is printing, -1 if idle */
+	double busy_until;
+	} ;
+
+struct GROUP {
+	char *name;
+	int *printers;
+	int members;
+	int last;				/* member last used, -1 if none */
+	gu_boolean given;		/* members set with --group */
+	} ;
+
+struct JOB {
+	int seq;				/* line in trace */
+	int group;				/* -1 if sent to a printer */
+	int printer;			/* printer it was sent to or printed on */
+	double arrival;
+	double run_time;		/* as recorded */
+	int sides;				/* -1 if unknown */
+	gu_boolean waiting;
+	double start;
+	double finish;
+	} ;
+
+static struct PRINTER *printers = NULL;
+static int printer_count = 0, printer_space = 0;
+static struct GROUP *groups = NULL;
+static int group_count = 0, group_space = 0;
+static struct JOB *jobs = NULL;
+static int job_count = 0, job_space = 0;
+
+/* The policy being replayed */
+static int policy;
+static int affinity_pages = DISPATCH_AFFINITY_PAGES;
+static gu_boolean holding;
+
+void error(const char *message, ... )
+	{
+	va_list va;
+	fprintf(stderr, "%s: ", myname);
+	va_start(va,message);
+	vfprintf(stderr,message,va);
+	va_end(va);
+	fputc('\n', stderr);
+	} /* end of error() */
+
+static int find_printer(const char name[], gu_boolean create)
+	{
+	int x;
+	for(x=0; x < printer_count; x++)
+		{
+		if(strcmp(printers[x].name, name) == 0)
+			return x;
+		}
+	if(!create)
+		return -1;
+	if(printer_count == printer_space)
+		{
+		printer_space += 16;
+		printers = (struct PRINTER *)gu_realloc(printers, printer_space, sizeof(struct PRINTER));
+		}
+	memset(&printers[printer_count], 0, sizeof(struct PRINTER));
+	printers[printer_count].name = gu_strdup(name);
+	return printer_count++;
+	}
+
+static int find_group(const char name[])
+	{
+	int x;
+	for(x=0; x < group_count; x++)
+		{
+		if(strcmp(groups[x].name, name) == 0)
+			return x;
+		}
+	if(group_count == group_space)
+		{
+		group_space += 16;
+		groups = (struct GROUP *)gu_realloc(groups, group_space, sizeof(struct GROUP));
+		}
+	memset(&groups[group_count], 0, sizeof(struct GROUP));
+	groups[group_count].name = gu_strdup(name);
+	return group_count++;
+	}
+
+static void add_member(struct GROUP *group, int prnid)
+	{
+	int x;
+	for(x=0; x < group->members; x++)
+		{
+		if(group->printers[x] == prnid)
+			return;
+		}
+	group->printers = (int*)gu_realloc(group->printers, group->members + 1, sizeof(int));
+	group->printers[group->members++] = prnid;
+	}
+
+static int member_offset(const struct GROUP *group, int prnid)
+	{
+	int x;
+	for(x=0; x < group->members; x++)
+		{
+		if(group->printers[x] == prnid)
+			return x;
+		}
+	return -1;
+	}
+
+/*
+** Split a line of "ppr-printlog --list" output into fields.  The quoted
+** fields don't contain quotes.  Returns the number of fields.
+*/
+static int split_csv(char *line, char *fields[], int max)
+	{
+	int count = 0;
+	char *p = line;
+
+	while(count < max)
+		{
+		if(*p == '"')
+			{
+			fields[count++] = ++p;
+			if(!(p = strchr(p, '"')))
+				break;
+			*p++ = '\0';
+			}
+		else
+			{
+			fields[count++] = p;
+			p += strcspn(p, ",\n");
+			}
+		if(*p != ',')
+			{
+			*p = '\0';
+			break;
+			}
+		*p++ = '\0';
+		}
+
+	return count;
+	}
+
+/*
+** Convert the YYYYMMDDHHMMSS of the listing to a time_t.
+*/
+static time_t parse_time(const char s[])
+	{
+	struct tm tm;
+	if(strlen(s) != 14 || strspn(s, "0123456789") != 14)
+		return (time_t)-1;
+	memset(&tm, 0, sizeof(tm));
+	tm.tm_year = (s[0]-'0') * 1000 + (s[1]-'0') * 100 + (s[2]-'0') * 10 + (s[3]-'0') - 1900;
+	tm.tm_mon = (s[4]-'0') * 10 + (s[5]-'0') - 1;
+	tm.tm_mday = (s[6]-'0') * 10 + (s[7]-'0');
+	tm.tm_hour = (s[8]-'0') * 10 + (s[9]-'0');
+	tm.tm_min = (s[10]-'0') * 10 + (s[11]-'0');
+	tm.tm_sec = (s[12]-'0') * 10 + (s[13]-'0');
+	tm.tm_isdst = -1;
+	return mktime(&tm);
+	}
+
+/*
+** Read the trace from stdin.  Returns -1 if it is unusable.
+*/
+static int read_trace(void)
+	{
+	char *line = NULL;
+	int line_space = 256;
+	int linenum = 0;
+	char *fields[18];
+	struct JOB *job;
+	time_t printed;
+	char *destname;
+	int prnid, x;
+
+	/* First pass: the printers which printed each job. */
+	while((line = gu_getline(line, &line_space, stdin)))
+		{
+		linenum++;
+		if(split_csv(line, fields, 18) < 11 || (printed = parse_time(fields[0])) == (time_t)-1)
+			{
+			error(_("line %d is not in the format of ppr-printlog --list"), linenum);
+			return -1;
+			}
+
+		if(job_count == job_space)
+			{
+			job_space += 1024;
+			jobs = (struct JOB *)gu_realloc(jobs, job_space, sizeof(struct JOB));
+			}
+		job = &jobs[job_count++];
+		memset(job, 0, sizeof(struct JOB));
+		job->seq = linenum;
+
+		prnid = find_printer(fields[2], TRUE);
+		job->printer = prnid;
+		job->arrival = (double)(printed - atol(fields[9]));
+		job->run_time = atof(fields[10]);
+		job->sides = atoi(fields[8]) > 0 ? atoi(fields[8]) : -1;
+		if(job->sides > 0 && job->run_time > 0.0)
+			{
+			printers[prnid].sides += job->sides;
+			printers[prnid].seconds += job->run_time;
+			}
+
+		/* The destination is the jobid up to the last hyphen.  We keep
+		   it in group for now as an index into a temporary list. */
+		destname = fields[1];
+		if(!(fields[1] = strrchr(destname, '-')))
+			{
+			error(_("line %d: bad jobid \"%s\""), linenum, destname);
+			return -1;
+			}
+		*fields[1] = '\0';
+		job->group = find_group(destname);
+		}
+
+	if(job_count == 0)
+		{
+		error(_("no jobs in trace"));
+		return -1;
+		}
+
+	/* Second pass: those destinations which are printers aren't groups.
+	   The group list was built as we went, so rebuild it without them. */
+	{
+	struct GROUP *all = groups;
+	int all_count = group_count;
+	int *map = (int*)gu_alloc(all_count, sizeof(int));
+
+	groups = NULL;
+	group_count = group_space = 0;
+	for(x=0; x < all_count; x++)
+		{
+		if(find_printer(all[x].name, FALSE) != -1)
+			map[x] = -1;
+		else
+			map[x] = find_group(all[x].name);
+		}
+
+	for(x=0; x < job_count; x++)
+		{
+		int old = jobs[x].group;
+		if(map[old] == -1)
+			{
+			jobs[x].printer = find_printer(all[old].name, FALSE);
+			jobs[x].group = -1;
+			}
+		else
+			{
+			jobs[x].group = map[old];
+			}
+		}
+
+	for(x=0; x < all_count; x++)
+		gu_free(all[x].name);
+	gu_free(all);
+	gu_free(map);
+	}
+
+	return 0;
+	} /* end of read_trace() */
+
+/* Sort the jobs by arrival, keeping the order of those which arrived together. */
+static int compare_jobs(const void *a, const void *b)
+	{
+	const struct JOB *ja = (const struct JOB *)a;
+	const struct JOB *jb = (const struct JOB *)b;
+	if(ja->arrival != jb->arrival)
+		return ja->arrival < jb->arrival ? -1 : 1;
+	return ja->seq - jb->seq;
+	}
+
+/*
+** How long does printer prnid take to print job?
+*/
+static double service_time(int prnid, const struct JOB *job)
+	{
+	if(job->sides > 0)
+		return job->sides * 60.0 / printers[prnid].ppm;
+	return job->run_time;
+	}
+
+/*
+** Fill in the members of the job's group and let the policy order them,
+** as dispatch_order() in pprd does.
+*/
+static int order_members(int jobnum, double now, struct DISPATCH_MEMBER members[])
+	{
+	struct JOB *job = &jobs[jobnum];
+	struct GROUP *group = &groups[job->group];
+	int ahead_group = 0;
+	int x, y;
+
+	for(x=0; x < group->members; x++)
+		{
+		struct PRINTER *printer = &printers[group->printers[x]];
+		members[x].member = x;
+		members[x].ppm = printer->ppm;
+		members[x].idle = printer->job == -1;
+		members[x].outstanding = 0;
+		if(!members[x].idle)
+			{
+			struct JOB *current = &jobs[printer->job];
+			if(current->sides < 0 || current->finish <= current->start)
+				members[x].outstanding = -1;
+			else
+				members[x].outstanding = (int)(current->sides * (printer->busy_until - now) / (current->finish - current->start) + 0.999);
+			}
+		}
+
+	for(y=0; y < jobnum; y++)
+		{
+		struct JOB *q = &jobs[y];
+		if(!q->waiting)
+			continue;
+		if(q->group == job->group)
+			{
+			if(ahead_group != -1)
+				ahead_group = q->sides < 0 ? -1 : ahead_group + q->sides;
+			}
+		else if(q->group == -1 && (x = member_offset(group, q->printer)) != -1)
+			{
+			if(!members[x].idle && members[x].outstanding != -1)
+				members[x].outstanding = q->sides < 0 ? -1 : members[x].outstanding + q->sides;
+			}
+		}
+
+	for(x=0; x < group->members; x++)
+		{
+		if(!members[x].idle && members[x].outstanding != -1)
+			members[x].outstanding = ahead_group < 0 ? -1 : members[x].outstanding + ahead_group;
+		}
+
+	return dispatch_choose(policy, affinity_pages, group->last, group->members, members, group->members, job->sides);
+	}
+
+static void start_job(int jobnum, int prnid, double now)
+	{
+	struct JOB *job = &jobs[jobnum];
+	job->waiting = FALSE;
+	job->printer = prnid;
+	job->start = now;
+	job->finish = now + service_time(prnid, job);
+	printers[prnid].job = jobnum;
+	printers[prnid].busy_until = job->finish;
+	if(job->group != -1)
+		groups[job->group].last = member_offset(&groups[job->group], prnid);
+	}
+
+/*
+** A job has arrived.  Like printer_try_start_suitable_4_this_job().
+*/
+static void job_arrived(int jobnum, double now, struct DISPATCH_MEMBER members[])
+	{
+	struct JOB *job = &jobs[jobnum];
+	int count;
+
+	job->waiting = TRUE;
+
+	if(job->group == -1)
+		{
+		if(printers[job->printer].job == -1)
+			start_job(jobnum, job->printer, now);
+		return;
+		}
+
+	if((count = order_members(jobnum, now, members)) == -1)
+		holding = TRUE;
+	else if(count > 0)
+		start_job(jobnum, groups[job->group].printers[members[0].member], now);
+	}
+
+/*
+** A printer has become idle.  Like printer_look_for_work().
+*/
+static void look_for_work(int prnid, int arrived, double now, struct DISPATCH_MEMBER members[])
+	{
+	int x;
+	for(x=0; x < arrived; x++)
+		{
+		struct JOB *job = &jobs[x];
+		if(!job->waiting)
+			continue;
+		if(job->group == -1)
+			{
+			if(job->printer != prnid)
+				continue;
+			}
+		else
+			{
+			if(member_offset(&groups[job->group], prnid) == -1)
+				continue;
+			if((policy == DISPATCH_THROUGHPUT || (policy == DISPATCH_AFFINITY && job->sides >= affinity_pages))
+					&& job->sides > 0 && order_members(x, now, members) == -1)
+				{
+				holding = TRUE;
+				continue;
+				}
+			}
+		start_job(x, prnid, now);
+		break;
+		}
+	}
+
+/*
+** Replay the trace under the current policy.
+*/
+static void replay(double *makespan, double *mean_wait, double *max_wait, double *mean_turnaround)
+	{
+	struct DISPATCH_MEMBER *members;
+	int most_members = 1;
+	int arrived = 0, done = 0;
+	double now, next_tick, total_wait = 0.0, total_turnaround = 0.0;
+	int x;
+
+	for(x=0; x < group_count; x++)
+		{
+		groups[x].last = -1;
+		if(groups[x].members > most_members)
+			most_members = groups[x].members;
+		}
+	for(x=0; x < printer_count; x++)
+		printers[x].job = -1;
+	for(x=0; x < job_count; x++)
+		jobs[x].waiting = FALSE;
+
+	members = (struct DISPATCH_MEMBER *)gu_alloc(most_members, sizeof(struct DISPATCH_MEMBER));
+	holding = FALSE;
+	next_tick = jobs[0].arrival + TICK_INTERVAL;
+
+	while(done < job_count)
+		{
+		double next_arrival = arrived < job_count ? jobs[arrived].arrival : NEVER;
+		double next_finish = NEVER;
+		int finishing = -1;
+
+		for(x=0; x < printer_count; x++)
+			{
+			if(printers[x].job != -1 && printers[x].busy_until < next_finish)
+				{
+				next_finish = printers[x].busy_until;
+				finishing = x;
+				}
+			}
+
+		/* Ticks only matter while a job is being held. */
+		now = next_finish < next_arrival ? next_finish : next_arrival;
+		if(!holding && next_tick <= now)
+			next_tick += ((long)((now - next_tick) / TICK_INTERVAL) + 1) * TICK_INTERVAL;
+
+		if(holding && next_tick <= now)
+			{
+			now = next_tick;
+			next_tick += TICK_INTERVAL;
+			holding = FALSE;
+			for(x=0; x < printer_count; x++)
+				{
+				if(printers[x].job == -1)
+					look_for_work(x, arrived, now, members);
+				}
+			}
+		else if(finishing != -1 && next_finish <= next_arrival)
+			{
+			struct JOB *job = &jobs[printers[finishing].job];
+			double wait = job->start - job->arrival;
+			total_wait += wait;
+			total_turnaround += job->finish - job->arrival;
+			if(wait > *max_wait)
+				*max_wait = wait;
+			if(job->finish - jobs[0].arrival > *makespan)
+				*makespan = job->finish - jobs[0].arrival;
+			done++;
+			printers[finishing].job = -1;
+			look_for_work(finishing, arrived, now, members);
+			}
+		else
+			{
+			job_arrived(arrived, now, members);
+			arrived++;
+			}
+		}
+
+	gu_free(members);
+	*mean_wait = total_wait / job_count;
+	*mean_turnaround = total_turnaround / job_count;
+	} /* end of replay() */
+
+/*
+** Command line options:
+*/
+static const char *option_chars = "";
+static const struct gu_getopt_opt option_words[] = {
+	{"printer", 1000, TRUE},
+	{"group", 1001, TRUE},
+	{"policy", 1002, TRUE},
+	{"affinity-pages", 1003, TRUE},
+	{"help", 9000, FALSE},
+	{"version", 9001, FALSE},
+	{(char*)NULL, 0, FALSE}
+	} ;
+
+/*
+** Print help.
+*/
+static void help_usage(FILE *outfile)
+	{
+	fprintf(outfile, _("Usage: %s [switches] < trace\n"), myname);
+
+	fputc('\n', outfile);
+
+	fputs(_("Valid switches:\n"), outfile);
+
+	fputs(_(	"\t--printer=printer=ppm\n"
+				"\t--group=group=printer,printer...\n"
+				"\t--policy={order,rotate,least-pages,throughput,affinity}\n"
+				"\t--affinity-pages=pages\n"), outfile);
+
+	fputs(_(	"\t--version\n"
+				"\t--help\n"), outfile);
+	}
+
+int main(int argc, char *argv[])
+	{
+	int policies[DISPATCH_AFFINITY + 1];
+	int policy_count = 0;
+	char **printer_opts = NULL, **group_opts = NULL;
+	int printer_opt_count = 0, group_opt_count = 0;
+	int x, y;
+
+	/* Initialize international messages library. */
+	#ifdef INTERNATIONAL
+	setlocale(LC_ALL, "");
+	bindtextdomain(PACKAGE, LOCALEDIR);
+	textdomain(PACKAGE);
+	#endif
+
+	/* Parse the options. */
+	{
+	struct gu_getopt_state getopt_state;
+	int optchar;
+	gu_getopt_init(&getopt_state, argc, argv, option_chars, option_words);
+	while((optchar = ppr_getopt(&getopt_state)) != -1)
+		{
+		switch(optchar)
+			{
+			case 1000:					/* --printer */
+				if(!strchr(getopt_state.optarg, '=') || atof(strchr(getopt_state.optarg, '=') + 1) <= 0.0)
+					{
+					fprintf(stderr, _("%s: invalid --printer value: %s\n"), myname, getopt_state.optarg);
+					return EXIT_SYNTAX;
+					}
+				printer_opts = (char**)gu_realloc(printer_opts, printer_opt_count + 1, sizeof(char*));
+				printer_opts[printer_opt_count++] = gu_strdup(getopt_state.optarg);
+				break;
+
+			case 1001:					/* --group */
+				if(!strchr(getopt_state.optarg, '='))
+					{
+					fprintf(stderr, _("%s: invalid --group value: %s\n"), myname, getopt_state.optarg);
+					return EXIT_SYNTAX;
+					}
+				group_opts = (char**)gu_realloc(group_opts, group_opt_count + 1, sizeof(char*));
+				group_opts[group_opt_count++] = gu_strdup(getopt_state.optarg);
+				break;
+
+			case 1002:					/* --policy */
+				if((x = dispatch_policy_parse(getopt_state.optarg)) == -1)
+					{
+					fprintf(stderr, _("%s: invalid --policy value: %s\n"), myname, getopt_state.optarg);
+					return EXIT_SYNTAX;
+					}
+				if(policy_count <= DISPATCH_AFFINITY)
+					policies[policy_count++] = x;
+				break;
+
+			case 1003:					/* --affinity-pages */
+				if((affinity_pages = atoi(getopt_state.optarg)) < 1)
+					{
+					fprintf(stderr, _("%s: invalid --affinity-pages value: %s\n"), myname, getopt_state.optarg);
+					return EXIT_SYNTAX;
+					}
+				break;
+
+			case 9000:					/* --help */
+				help_usage(stdout);
+				return EXIT_OK;
+
+			case 9001:					/* --version */
+				puts(VERSION);
+				puts(COPYRIGHT);
+				puts(AUTHOR);
+				return EXIT_OK;
+
+			default:					/* other getopt errors or missing case */
+				gu_getopt_default(myname, optchar, &getopt_state, stderr);
+				return EXIT_SYNTAX;
+			}
+		}
+	if(getopt_state.optind < argc)
+		{
+		help_usage(stderr);
+		return EXIT_SYNTAX;
+		}
+	}
+
+	/* By default, try them all. */
+	if(policy_count == 0)
+		{
+		for(x=0; x <= DISPATCH_AFFINITY; x++)
+			policies[policy_count++] = x;
+		}
+
+	if(read_trace() == -1)
+		return EXIT_SYNTAX;
+
+	/* Printer speeds given on the command line override the trace. */
+	for(x=0; x < printer_count; x++)
+		{
+		if(printers[x].seconds > 0.0)
+			printers[x].ppm = printers[x].sides * 60.0 / printers[x].seconds;
+		}
+	for(x=0; x < printer_opt_count; x++)
+		{
+		char *p = strchr(printer_opts[x], '=');
+		*p++ = '\0';
+		printers[find_printer(printer_opts[x], TRUE)].ppm = atof(p);
+		}
+
+	/* Group memberships given on the command line replace those in
+	   the trace.  The others are taken from the printers which printed
+	   each group's jobs, in the order in which they first appear. */
+	for(x=0; x < group_opt_count; x++)
+		{
+		char *p = strchr(group_opts[x], '='), *name;
+		struct GROUP *group;
+		*p++ = '\0';
+		group = &groups[find_group(group_opts[x])];
+		group->given = TRUE;
+		while((name = gu_strsep(&p, ",")))
+			{
+			if(*name)
+				add_member(group, find_printer(name, TRUE));
+			}
+		}
+	for(x=0; x < job_count; x++)
+		{
+		if(jobs[x].group != -1 && !groups[jobs[x].group].given)
+			add_member(&groups[jobs[x].group], jobs[x].printer);
+		}
+
+	for(x=0; x < printer_count; x++)
+		{
+		if(printers[x].ppm <= 0.0)
+			{
+			error(_("speed of printer \"%s\" unknown, use --printer=%s=ppm"), printers[x].name, printers[x].name);
+			return EXIT_SYNTAX;
+			}
+		}
+	for(x=0; x < group_count; x++)
+		{
+		if(groups[x].members == 0)
+			{
+			error(_("group \"%s\" has no members"), groups[x].name);
+			return EXIT_SYNTAX;
+			}
+		}
+
+	qsort(jobs, job_count, sizeof(struct JOB), compare_jobs);
+
+	printf(_("%d jobs, %d printers, %d groups\n"), job_count, printer_count, group_count);
+	for(x=0; x < printer_count; x++)
+		printf("  %-20s %8.1f ppm\n", printers[x].name, printers[x].ppm);
+	for(x=0; x < group_count; x++)
+		{
+		printf("  %-20s", groups[x].name);
+		for(y=0; y < groups[x].members; y++)
+			printf(" %s", printers[groups[x].printers[y]].name);
+		printf("\n");
+		}
+	printf("\n");
+
+	printf(_("%-12s %12s %12s %12s %12s\n"), _("Policy"), _("Makespan"), _("Mean wait"), _("Max wait"), _("Turnaround"));
+	for(x=0; x < policy_count; x++)
+		{
+		double makespan = 0.0, mean_wait, max_wait = 0.0, mean_turnaround;
+		policy = policies[x];
+		replay(&makespan, &mean_wait, &max_wait, &mean_turnaround);
+		printf("%-12s %12.1f %12.1f %12.1f %12.1f\n", dispatch_policy_name(policy), makespan, mean_wait, max_wait, mean_turnaround);
+		}
+
+	return EXIT_OK;
+	} /* end of main() */
+
+/* end of file */
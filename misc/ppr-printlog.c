@@ -0,0 +1,577 @@
+/*
+** mouse:~ppr/src/misc/ppr-printlog.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This program reads the structured print log described in
+** libppr/printlog.c.  It totals the jobs, pages, sheets, sides, and charges
+** by user, printer, day, or month, or lists the jobs in the format of the
+** old text printlog.  Segments outside of the requested time range are
+** skipped by name and, when a user or printer is given, only that user's
+** or printer's records are read from the closed segments.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef INTERNATIONAL
+#include <locale.h>
+#include <libintl.h>
+#endif
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "util_exits.h"
+#include "version.h"
+
+const char myname[] = "ppr-printlog";
+
+enum BY { BY_USER, BY_PRINTER, BY_DAY, BY_MONTH };
+
+struct QUERY {
+	time_t from;
+	time_t to;
+	const char *user;
+	const char *printer;
+	enum BY by;
+	gu_boolean list;
+	} ;
+
+struct TOTAL {
+	char *key;
+	long jobs;
+	long pages;
+	long sheets;
+	long sides;
+	long charge;
+	} ;
+
+static void *totals = NULL;			/* key -> struct TOTAL */
+
+void error(const char *message, ... )
+	{
+	va_list va;
+	fprintf(stderr, "%s: ", myname);
+	va_start(va,message);
+	vfprintf(stderr,message,va);
+	va_end(va);
+	fputc('\n', stderr);
+	} /* end of error() */
+
+/*
+** Command line options:
+*/
+static const char *option_chars = "";
+static const struct gu_getopt_opt option_words[] = {
+	{"from", 1000, TRUE},
+	{"to", 1001, TRUE},
+	{"user", 1002, TRUE},
+	{"printer", 1003, TRUE},
+	{"by", 1004, TRUE},
+	{"list", 1005, FALSE},
+	{"rotate", 1006, FALSE},
+	{"help", 9000, FALSE},
+	{"version", 9001, FALSE},
+	{(char*)NULL, 0, FALSE}
+	} ;
+
+/*
+** Print help.
+*/
+static void help_usage(FILE *outfile)
+	{
+	fprintf(outfile, _("Usage: %s [switches]\n"), myname);
+
+	fputc('\n', outfile);
+
+	fputs(_("Valid switches:\n"), outfile);
+
+	fputs(_(	"\t--from=YYYYMMDD[HHMM[SS]]\n"
+				"\t--to=YYYYMMDD[HHMM[SS]]\n"
+				"\t--user=username\n"
+				"\t--printer=printer\n"
+				"\t--by={user,printer,day,month}\n"
+				"\t--list\n"
+				"\t--rotate\n"), outfile);
+
+	fputs(_(	"\t--version\n"
+				"\t--help\n"), outfile);
+	}
+
+/*
+** Convert n decimal digits to an int.
+*/
+static int digits(const char s[], int n)
+	{
+	int value = 0;
+	while(n-- > 0)
+		value = value * 10 + (*s++ - '0');
+	return value;
+	}
+
+/*
+** Convert a local time in the form YYYYMMDD[HHMM[SS]] to a time_t.  If
+** end is TRUE, the missing fields are filled in so as to give the end
+** of the day or minute.  Returns -1 if the time is invalid.
+*/
+static time_t parse_time(const char s[], int len, gu_boolean end)
+	{
+	struct tm tm;
+	int x;
+
+	if(len != 8 && len != 12 && len != 14)
+		return (time_t)-1;
+	for(x=0; x < len; x++)
+		{
+		if(s[x] < '0' || s[x] > '9')
+			return (time_t)-1;
+		}
+
+	memset(&tm, 0, sizeof(tm));
+	tm.tm_year = digits(s + 0, 4) - 1900;
+	tm.tm_mon = digits(s + 4, 2) - 1;
+	tm.tm_mday = digits(s + 6, 2);
+	tm.tm_hour = len >= 12 ? digits(s + 8, 2) : end ? 23 : 0;
+	tm.tm_min = len >= 12 ? digits(s + 10, 2) : end ? 59 : 0;
+	tm.tm_sec = len == 14 ? digits(s + 12, 2) : end ? 59 : 0;
+	tm.tm_isdst = -1;
+
+	return mktime(&tm);
+	} /* end of parse_time() */
+
+/*
+** Print a record in the format of the text printlog.
+*/
+static void list_record(const struct PRINTLOG_RECORD *r)
+	{
+	char time_str[15];
+	strftime(time_str, sizeof(time_str), "%Y%m%d%H%M%S", localtime(&r->printed));
+	printf("%s,%s,%s,\"%s\",%s,\"%s\",%d,%d,%d,%ld,%d.%02d,%d.%02d,%d,%d,%d,%ld,%ld,\"%s\"\n",
+		time_str,
+		r->jobid,
+		r->printer,
+		r->for_name,
+		r->username,
+		"",
+		r->pages,
+		r->sheets,
+		r->sides,
+		(long)(r->printed - r->submitted),
+		r->run_time / 100, r->run_time % 100,
+		r->charge / 100, abs(r->charge % 100),
+		r->pjl_pages,
+		r->pagecount_start, r->pagecount_change,
+		r->postscript_bytes,
+		r->bytes_sent,
+		r->title
+		);
+	}
+
+/*
+** Add a record to the totals (or list it) if it matches the query.
+*/
+static void consider_record(const struct PRINTLOG_RECORD *r, const struct QUERY *q)
+	{
+	char key[64];
+	struct TOTAL *t;
+
+	if(r->magic != PRINTLOG_MAGIC)
+		return;
+	if(r->printed < q->from || r->printed > q->to)
+		return;
+	if(q->user && strcmp(r->username, q->user) != 0)
+		return;
+	if(q->printer && strcmp(r->printer, q->printer) != 0)
+		return;
+
+	if(q->list)
+		{
+		list_record(r);
+		return;
+		}
+
+	switch(q->by)
+		{
+		case BY_USER:
+			gu_strlcpy(key, r->username, sizeof(key));
+			break;
+		case BY_PRINTER:
+			gu_strlcpy(key, r->printer, sizeof(key));
+			break;
+		case BY_DAY:
+			strftime(key, sizeof(key), "%Y-%m-%d", localtime(&r->printed));
+			break;
+		case BY_MONTH:
+			strftime(key, sizeof(key), "%Y-%m", localtime(&r->printed));
+			break;
+		}
+
+	if(!(t = gu_pch_get(totals, key)))
+		{
+		t = gu_alloc(1, sizeof(struct TOTAL));
+		memset(t, 0, sizeof(struct TOTAL));
+		t->key = gu_strdup(key);
+		gu_pch_set(totals, t->key, t);
+		}
+	t->jobs++;
+	if(r->pages > 0)
+		t->pages += r->pages;
+	t->sheets += r->sheets;
+	t->sides += r->sides;
+	t->charge += r->charge;
+	} /* end of consider_record() */
+
+/*
+** Read the matching records from one segment.
+*/
+static int query_segment(const char name[], const struct QUERY *q)
+	{
+	char fname[MAX_PPR_PATH];
+	struct stat statbuf;
+	const struct PRINTLOG_RECORD *records;
+	unsigned int count, x;
+	void *index = NULL;
+	int fd;
+
+	/* Closed segments are named after the times of their first and last jobs. */
+	if(strcmp(name, PRINTLOG_CURRENT) != 0)
+		{
+		time_t first, last;
+		if(strlen(name) < 29 || name[14] != '-'
+				|| (first = parse_time(name, 14, FALSE)) == (time_t)-1
+				|| (last = parse_time(name + 15, 14, FALSE)) == (time_t)-1)
+			return 0;
+		if(last < q->from || first > q->to)
+			return 0;
+		}
+
+	ppr_fnamef(fname, "%s/%s", PRINTLOG_DIR, name);
+	if((fd = open(fname, O_RDONLY)) == -1)
+		{
+		if(errno == ENOENT)		/* just closed */
+			return 0;
+		fprintf(stderr, _("%s: can't open \"%s\", errno=%d (%s)\n"), myname, fname, errno, gu_strerror(errno));
+		return -1;
+		}
+	if(fstat(fd, &statbuf) == -1 || (count = statbuf.st_size / sizeof(struct PRINTLOG_RECORD)) == 0)
+		{
+		close(fd);
+		return 0;
+		}
+	if((records = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+		{
+		fprintf(stderr, _("%s: can't map \"%s\", errno=%d (%s)\n"), myname, fname, errno, gu_strerror(errno));
+		close(fd);
+		return -1;
+		}
+	close(fd);
+
+	if(q->user || q->printer)
+		{
+		char index_name[MAX_PPR_PATH];
+		ppr_fnamef(index_name, "%s%s", fname, PRINTLOG_INDEX_SUFFIX);
+		index = gu_cdb_open(index_name);
+		}
+
+	if(index)
+		{
+		char *key;
+		const unsigned int *recnos;
+		int len;
+
+		if(q->user)
+			gu_asprintf(&key, "u:%s", q->user);
+		else
+			gu_asprintf(&key, "p:%s", q->printer);
+
+		if((recnos = (const unsigned int *)gu_cdb_find(index, key, &len)))
+			{
+			for(x=0; x < len / sizeof(unsigned int); x++)
+				{
+				if(recnos[x] < count)
+					consider_record(&records[recnos[x]], q);
+				}
+			}
+
+		gu_free(key);
+		gu_cdb_close(index);
+		}
+	else
+		{
+		for(x=0; x < count; x++)
+			consider_record(&records[x], q);
+		}
+
+	munmap((void*)records, statbuf.st_size);
+	return 0;
+	} /* end of query_segment() */
+
+static int compare_strings(const void *a, const void *b)
+	{
+	return strcmp(*(const char **)a, *(const char **)b);
+	}
+
+static int compare_totals(const void *a, const void *b)
+	{
+	return strcmp((*(const struct TOTAL **)a)->key, (*(const struct TOTAL **)b)->key);
+	}
+
+/*
+** Read the segments in order of time, the current one last.
+*/
+static int query(const struct QUERY *q)
+	{
+	DIR *dir;
+	struct dirent *direntp;
+	char **names = NULL;
+	int count = 0, space = 0, x;
+	int ret = 0;
+	int lockfd;
+
+	/* Keep the current segment from being closed while we read. */
+	{
+	char fname[MAX_PPR_PATH];
+	ppr_fnamef(fname, "%s/.lock", PRINTLOG_DIR);
+	if((lockfd = open(fname, O_RDONLY)) != -1)
+		{
+		struct flock lock;
+		lock.l_type = F_RDLCK;
+		lock.l_whence = SEEK_SET;
+		lock.l_start = (off_t)0;
+		lock.l_len = (off_t)0;
+		fcntl(lockfd, F_SETLKW, &lock);
+		}
+	}
+
+	if(!(dir = opendir(PRINTLOG_DIR)))
+		{
+		fprintf(stderr, _("%s: can't open directory \"%s\", errno=%d (%s)\n"), myname, PRINTLOG_DIR, errno, gu_strerror(errno));
+		if(lockfd != -1)
+			close(lockfd);
+		return -1;
+		}
+	while((direntp = readdir(dir)))
+		{
+		int len = strlen(direntp->d_name);
+		if(direntp->d_name[0] == '.' || strcmp(direntp->d_name, PRINTLOG_CURRENT) == 0)
+			continue;
+		if(len >= sizeof(PRINTLOG_INDEX_SUFFIX) && strcmp(direntp->d_name + len - (sizeof(PRINTLOG_INDEX_SUFFIX) - 1), PRINTLOG_INDEX_SUFFIX) == 0)
+			continue;
+		if(count == space)
+			{
+			space = space ? space * 2 : 64;
+			names = gu_realloc(names, space, sizeof(char*));
+			}
+		names[count++] = gu_strdup(direntp->d_name);
+		}
+	closedir(dir);
+
+	if(count > 0)
+		{
+		qsort(names, count, sizeof(char*), compare_strings);
+		for(x=0; x < count; x++)
+			{
+			if(query_segment(names[x], q) == -1)
+				ret = -1;
+			gu_free(names[x]);
+			}
+		gu_free(names);
+		}
+
+	if(query_segment(PRINTLOG_CURRENT, q) == -1)
+		ret = -1;
+
+	if(lockfd != -1)
+		close(lockfd);
+
+	return ret;
+	} /* end of query() */
+
+/*
+** Print the totals sorted by key.
+*/
+static void print_totals(enum BY by)
+	{
+	struct TOTAL **list, *t;
+	struct TOTAL grand;
+	int count = gu_pch_size(totals);
+	int x = 0;
+	const char *heading = "";
+
+	switch(by)
+		{
+		case BY_USER:
+			heading = _("User");
+			break;
+		case BY_PRINTER:
+			heading = _("Printer");
+			break;
+		case BY_DAY:
+			heading = _("Day");
+			break;
+		case BY_MONTH:
+			heading = _("Month");
+			break;
+		}
+
+	list = gu_alloc(count + 1, sizeof(struct TOTAL *));
+	gu_pch_rewind(totals);
+	while(gu_pch_nextkey(totals, (void**)&t))
+		list[x++] = t;
+	qsort(list, count, sizeof(struct TOTAL *), compare_totals);
+
+	printf("%-24s %8s %8s %8s %8s %12s\n", heading, _("Jobs"), _("Pages"), _("Sheets"), _("Sides"), _("Charge"));
+	memset(&grand, 0, sizeof(grand));
+	for(x=0; x < count; x++)
+		{
+		t = list[x];
+		printf("%-24s %8ld %8ld %8ld %8ld %12s\n", t->key, t->jobs, t->pages, t->sheets, t->sides, money((int)t->charge));
+		grand.jobs += t->jobs;
+		grand.pages += t->pages;
+		grand.sheets += t->sheets;
+		grand.sides += t->sides;
+		grand.charge += t->charge;
+		}
+	printf("%-24s %8ld %8ld %8ld %8ld %12s\n", _("Total"), grand.jobs, grand.pages, grand.sheets, grand.sides, money((int)grand.charge));
+
+	gu_free(list);
+	} /* end of print_totals() */
+
+int main(int argc, char *argv[])
+	{
+	struct QUERY q;
+	gu_boolean opt_rotate = FALSE;
+
+	/* Initialize international messages library. */
+	#ifdef INTERNATIONAL
+	setlocale(LC_ALL, "");
+	bindtextdomain(PACKAGE, LOCALEDIR);
+	textdomain(PACKAGE);
+	#endif
+
+	memset(&q, 0, sizeof(q));
+	q.from = 0;
+	q.to = (time_t)LONG_MAX;
+	q.by = BY_USER;
+	q.list = FALSE;
+
+	/* Parse the options. */
+	{
+	struct gu_getopt_state getopt_state;
+	int optchar;
+	gu_getopt_init(&getopt_state, argc, argv, option_chars, option_words);
+	while((optchar = ppr_getopt(&getopt_state)) != -1)
+		{
+		switch(optchar)
+			{
+			case 1000:					/* --from */
+			case 1001:					/* --to */
+				{
+				time_t t = parse_time(getopt_state.optarg, strlen(getopt_state.optarg), optchar == 1001);
+				if(t == (time_t)-1)
+					{
+					fprintf(stderr, _("%s: invalid time: %s\n"), myname, getopt_state.optarg);
+					return EXIT_SYNTAX;
+					}
+				if(optchar == 1000)
+					q.from = t;
+				else
+					q.to = t;
+				}
+				break;
+
+			case 1002:					/* --user */
+				q.user = getopt_state.optarg;
+				break;
+
+			case 1003:					/* --printer */
+				q.printer = getopt_state.optarg;
+				break;
+
+			case 1004:					/* --by */
+				if(strcmp(getopt_state.optarg, "user") == 0)
+					q.by = BY_USER;
+				else if(strcmp(getopt_state.optarg, "printer") == 0)
+					q.by = BY_PRINTER;
+				else if(strcmp(getopt_state.optarg, "day") == 0)
+					q.by = BY_DAY;
+				else if(strcmp(getopt_state.optarg, "month") == 0)
+					q.by = BY_MONTH;
+				else
+					{
+					fprintf(stderr, _("%s: invalid --by value: %s\n"), myname, getopt_state.optarg);
+					return EXIT_SYNTAX;
+					}
+				break;
+
+			case 1005:					/* --list */
+				q.list = TRUE;
+				break;
+
+			case 1006:					/* --rotate */
+				opt_rotate = TRUE;
+				break;
+
+			case 9000:					/* --help */
+				help_usage(stdout);
+				return EXIT_OK;
+
+			case 9001:					/* --version */
+				puts(VERSION);
+				puts(COPYRIGHT);
+				puts(AUTHOR);
+				return EXIT_OK;
+
+			default:					/* other getopt errors or missing case */
+				gu_getopt_default(myname, optchar, &getopt_state, stderr);
+				return EXIT_SYNTAX;
+			}
+		}
+	if(getopt_state.optind < argc)
+		{
+		help_usage(stderr);
+		return EXIT_SYNTAX;
+		}
+	}
+
+	/* The files which rotating creates, including the lock file if it
+	   doesn't exist yet, must belong to USER_PPR so that pprdrv can
+	   open them, so drop root privileges first. */
+	if(opt_rotate)
+		{
+		if(renounce_root_privs(myname, USER_PPR, NULL) != 0)
+			return EXIT_DENIED;
+		return printlog_rotate() == -1 ? EXIT_INTERNAL : EXIT_OK;
+		}
+
+	totals = gu_pch_new(1024);
+
+	if(query(&q) == -1)
+		return EXIT_INTERNAL;
+
+	if(!q.list)
+		print_totals(q.by);
+
+	return EXIT_OK;
+	} /* end of main() */
+
+/* end of file */
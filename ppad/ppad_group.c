@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 27 May 2007.
+** Last modified 19 October 2026.
 */
 
 /*==============================================================
@@ -21,6 +21,7 @@
 ==============================================================*/
 
 #include "config.h"
+#include <stdlib.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -34,6 +35,7 @@
 #include "util_exits.h"
 #include "queueinfo.h"
 #include "ppad.h"
+#include "group_dispatch.h"
 #include "dispatch_table.h"
 
 /*
@@ -55,9 +57,11 @@ int command_group_show(const char *argv[])
 	int x;
 
 	int rotate = TRUE;					/* Is rotate set for this group? */
+	char *dispatch = (char*)NULL;		/* Dispatch policy, if set. */
 	char *comment = (char*)NULL;		/* Group comment. */
 	int member_count = 0;				/* Keep count of members. */
-	char *members[MAX_GROUPSIZE];		/* The names of the members. */
+	int member_space = 0;
+	char **members = NULL;				/* The names of the members. */
 	char *deffiltopts = (char*)NULL;	/* The default filter options string. */
 	char *switchset = (char*)NULL;		/* The compressed switchset string. */
 	char *passthru = (char*)NULL;
@@ -77,6 +81,12 @@ int command_group_show(const char *argv[])
 				gu_utf8_fprintf(stderr, _("WARNING: invalid \"%s\" setting: %s\n"), "Rotate", ptr);
 			continue;
 			}
+		if(gu_sscanf(line, "Dispatch: %T", &ptr) == 1)
+			{
+			gu_free_if(dispatch);
+			dispatch = ptr;
+			continue;
+			}
 		if(gu_sscanf(line, "Comment: %T", &ptr) == 1)
 			{
 			gu_free_if(comment);
@@ -85,15 +95,12 @@ int command_group_show(const char *argv[])
 			}
 		if(gu_sscanf(line, "Printer: %S", &ptr) == 1)
 			{
-			if(member_count < MAX_GROUPSIZE)
-				{
-				members[member_count++] = ptr;
-				}
-			else
+			if(member_count == member_space)
 				{
-				gu_utf8_fprintf(stderr, "%s(): too many members: %s\n", function, ptr);
-				gu_free(ptr);
+				member_space += 16;
+				members = (char**)gu_realloc(members, member_space, sizeof(char*));
 				}
+			members[member_count++] = ptr;
 			continue;
 			}
 		if(gu_sscanf(line, "Switchset: %T", &ptr) == 1)
@@ -152,6 +159,10 @@ int command_group_show(const char *argv[])
 
 		gu_utf8_printf(_("Rotate: %s\n"), rotate ? _("True") : _("False"));
 
+		/* If not set, Rotate decides. */
+		if(dispatch)
+			gu_utf8_printf(_("Dispatch: %s\n"), dispatch);
+
 		{
 		const char *s = _("Default Filter Options: ");
 		gu_utf8_puts(s);
@@ -195,6 +206,7 @@ int command_group_show(const char *argv[])
 			gu_utf8_printf("%s%s", x > 0 ? " " : "", members[x]);
 		gu_utf8_puts("\n");
 		gu_utf8_printf("rotate\t%s\n", rotate ? "yes" : "no");
+		gu_utf8_printf("dispatch\t%s\n", dispatch ? dispatch : "");
 		gu_utf8_printf("deffiltopts\t%s\n", deffiltopts ? deffiltopts : "");
 		gu_utf8_puts("switchset\t");
 			if(switchset)
@@ -228,8 +240,10 @@ int command_group_show(const char *argv[])
 		}
 
 	gu_free_if(comment);
+	gu_free_if(dispatch);
 	for(x=0;x<member_count;x++)
 		gu_free(members[x]);
+	gu_free_if(members);
 	gu_free_if(deffiltopts);
 	gu_free_if(switchset);
 	gu_free_if(passthru);
@@ -292,6 +306,50 @@ int command_group_rotate(const char *argv[])
 	return conf_set_name(QUEUE_TYPE_GROUP, group, CONF_RELOAD, "Rotate", "%s", newstate ? "True" : "False");
 	} /* group_rotate() */
 
+/*
+<command acl="ppad" helptopics="group">
+	<name><word>group</word><word>dispatch</word></name>
+	<desc>choose how jobs are given to the group's members</desc>
+	<args>
+		<arg><name>group</name><desc>name of group to be modified</desc></arg>
+		<arg flags="optional"><name>policy</name><desc>order, rotate, least-pages, throughput, or affinity (ommit to let rotate decide)</desc></arg>
+		<arg flags="optional"><name>pages</name><desc>size of a big job for affinity</desc></arg>
+	</args>
+</command>
+*/
+int command_group_dispatch(const char *argv[])
+	{
+	const char *group = argv[0];
+	const char *policy = argv[1];
+	int pages = DISPATCH_AFFINITY_PAGES;
+
+	if(!policy)
+		return conf_set_name(QUEUE_TYPE_GROUP, group, CONF_RELOAD, "Dispatch", NULL);
+
+	if(dispatch_policy_parse(policy) == -1)
+		{
+		gu_utf8_fputs(_("Policy must be \"order\", \"rotate\", \"least-pages\", \"throughput\", or \"affinity\".\n"), stderr);
+		return EXIT_SYNTAX;
+		}
+
+	if(argv[2])
+		{
+		if(dispatch_policy_parse(policy) != DISPATCH_AFFINITY)
+			{
+			gu_utf8_fputs(_("Only the affinity policy takes a page count.\n"), stderr);
+			return EXIT_SYNTAX;
+			}
+		if((pages = atoi(argv[2])) < 1)
+			{
+			gu_utf8_fputs(_("The page count must be a positive integer.\n"), stderr);
+			return EXIT_SYNTAX;
+			}
+		return conf_set_name(QUEUE_TYPE_GROUP, group, CONF_RELOAD, "Dispatch", "%s %d", policy, pages);
+		}
+
+	return conf_set_name(QUEUE_TYPE_GROUP, group, CONF_RELOAD, "Dispatch", "%s", policy);
+	} /* command_group_dispatch() */
+
 static int group_members_or_add_internal(gu_boolean do_add, const char *argv[])
 	{
 	const char *group = argv[0];
@@ -299,7 +357,6 @@ static int group_members_or_add_internal(gu_boolean do_add, const char *argv[])
 	char *line;
 	int x;
 	char *ptr;
-	int count = 0;
 	void *qobj = NULL;
 
 	if(strpbrk(group, DEST_DISALLOWED))
@@ -361,9 +418,8 @@ static int group_members_or_add_internal(gu_boolean do_add, const char *argv[])
 					{
 					if(strcmp(ptr, argv[x]) == 0)
 						gu_CodeThrow(EXIT_ALREADY, _("Printer \"%s\" is already a member of \"%s\".\n"), argv[x], group);
-					queueinfo_add_printer(qobj, ptr);
-					count++;
 					}
+				queueinfo_add_printer(qobj, ptr);
 				}
 
 			/* Delete old "DefFiltOpts:" lines as we go. */
@@ -379,7 +435,6 @@ static int group_members_or_add_internal(gu_boolean do_add, const char *argv[])
 			{
 			conf_printf(obj, "Printer: %s\n", argv[x]);
 			queueinfo_add_printer(qobj, argv[x]);
-			count++;
 			}
 
 		/* Emmit the new "DefFiltOpts:" line. */
@@ -389,10 +444,6 @@ static int group_members_or_add_internal(gu_boolean do_add, const char *argv[])
 			conf_printf(obj, "DefFiltOpts: %s\n", cp);
 		}
 
-		/* See if adding our printer will make the group too big. */
-		if(count > MAX_GROUPSIZE)
-			gu_CodeThrow(EXIT_OVERFLOW, _("Group \"%s\" would have %d members, only %d are allowed.\n"), group, count, MAX_GROUPSIZE);
-
 		/* Commit the changes. */
 		conf_close(obj);
 		}
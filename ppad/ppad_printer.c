@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 22 May 2006.
+** Last modified 19 October 2026.
 */
 
 /*==============================================================
@@ -454,6 +454,7 @@ int command_show(const char *argv[])
 	gu_boolean grayok = TRUE;
 	char *acls = (char*)NULL;
 	int pagetimelimit = 0;
+	int ripparallel_workers = 0, ripparallel_pages = 0;
 	char *userparams = (char*)NULL;
 	#define MAX_ADDONS 32
 	char *addon[MAX_ADDONS];
@@ -511,6 +512,10 @@ int command_show(const char *argv[])
 			rip_options = NULL;
 			gu_sscanf(p, "%S %S %T", &rip_name, &rip_output_language, &rip_options);
 			}
+		else if(gu_sscanf(line, "RIPParallel: %d %d", &ripparallel_workers, &ripparallel_pages) == 2)
+			{
+			/* nothing to do */
+			}
 		else if(gu_sscanf(line, "PPDFile: %A", &p) == 1)
 			{
 			PPDFile = p;
@@ -840,6 +845,11 @@ int command_show(const char *argv[])
 				rip_output_language ? rip_output_language : "?",
 				rip_options ? rip_options : "");
 			}
+		if(ripparallel_workers > 1)
+			{
+			gu_utf8_puts("  ");
+			gu_utf8_printf(_("RIPParallel: %d RIPs, %d pages each\n"), ripparallel_workers, ripparallel_pages);
+			}
 
 		/* Optional printer equipment. */
 		{
@@ -991,6 +1001,7 @@ int command_show(const char *argv[])
 				rip_ppd_options ? rip_ppd_options : "");
 		gu_utf8_printf("rip_which\t%s\n",
 				rip_name==rip_ppd_name ? "PPD" : "CONFIG");
+		gu_utf8_printf("rip_parallel\t%d %d\n", ripparallel_workers, ripparallel_pages);
 
 		/* Alerts */
 		gu_utf8_printf("alerts\t%d %s %s\n",
@@ -2865,6 +2876,35 @@ int command_userparams(const char *argv[])
 	return result;
 	} /* command_userparams() */
 
+/*
+<command acl="ppad">
+	<name><word>ripparallel</word></name>
+	<desc>divide each job's pages among several RIPs</desc>
+	<args>
+		<arg><name>printer</name><desc>name of printer to be modified</desc></arg>
+		<arg><name>rips</name><desc>number of RIPs to run at once (0 for just one)</desc></arg>
+		<arg flags="optional"><name>pages</name><desc>number of pages to give each RIP</desc></arg>
+	</args>
+</command>
+*/
+/*
+** Set the number of RIPs which may work on a job at once
+*/
+int command_ripparallel(const char *argv[])
+	{
+	const char *printer = argv[0];
+	int workers, pages = 10;
+
+	if((workers = atoi(argv[1])) < 0 || (argv[2] && (pages = atoi(argv[2])) < 1))
+		{
+		gu_utf8_fputs(_("The number of RIPs must be 0 or a positive integer and the number of\n"
+						"pages must be a positive integer.\n"), stderr);
+		return EXIT_SYNTAX;
+		}
+
+	return conf_set_name(QUEUE_TYPE_PRINTER, printer, 0, "RIPParallel", (workers > 1) ? "%d %d" : NULL, workers, pages);
+	} /* command_ripparallel() */
+
 /*
 <command acl="ppad">
 	<name><word>pagetimelimit</word></name>
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 1 June 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -44,6 +44,7 @@ const char myname[] = "ppop";
 /* Command line options */
 gu_boolean			opt_verbose = FALSE;
 int 				opt_machine_readable = FALSE;
+gu_boolean			opt_json = FALSE;
 static char			*opt_user = NULL;	
 static const char	*opt_magic_cookie = NULL;
 int					opt_arrest_interest_interval = -1;
@@ -103,6 +104,58 @@ void puts_detabbed(const char *string)
 		}
 	}
 
+/*
+** This is used in JSON output.  It prints the string as a quoted JSON
+** string, or null if there is no string.  JSON is always UTF-8, so unlike
+** puts_detabbed() we don't convert to the locale's character set, we just
+** escape the characters which JSON requires us to escape.
+*/
+void puts_json(const char *string)
+	{
+	const char *p;
+	size_t len;
+
+	if(!string)
+		{
+		gu_utf8_puts("null");
+		return;
+		}
+
+	fputc('"', stdout);
+	for(p = string; *p; p += len)
+		{
+		/* Copy the run of characters which need no escaping. */
+		for(len = 0; p[len] && p[len] != '"' && p[len] != '\\' && (unsigned char)p[len] >= 0x20; len++)
+			;
+		if(len > 0)
+			{
+			fwrite(p, sizeof(char), len, stdout);
+			continue;
+			}
+
+		switch(*p)
+			{
+			case '"':
+				gu_utf8_puts("\\\"");
+				break;
+			case '\\':
+				gu_utf8_puts("\\\\");
+				break;
+			case '\n':
+				gu_utf8_puts("\\n");
+				break;
+			case '\t':
+				gu_utf8_puts("\\t");
+				break;
+			default:
+				gu_utf8_printf("\\u%04x", (unsigned int)*p);
+				break;
+			}
+		len = 1;
+		}
+	fputc('"', stdout);
+	}
+
 /*======================================================================
 ** IPC functions
 ======================================================================*/
@@ -761,6 +814,7 @@ static void help(void)
 		{
 		N_("-M\tselect machine-readable output"),
 		N_("--machine-readable\tsame as -M"),
+		N_("--json\tqquery prints JSON Lines"),
 		N_("-A <seconds>\thide arrested jobs older than <seconds>"),
 		N_("--arrest-interest-time=<seconds>\tsame as -A"),
 		N_("-u <user>\tcheck access as if run by <user>"),
@@ -812,6 +866,7 @@ static const struct gu_getopt_opt option_words[] =
 	{"version", 1001, FALSE},
 	{"verbose", 1003, FALSE},
 	{"magic-cookie", 1004, TRUE},
+	{"json", 1005, FALSE},
 	{(char*)NULL, 0, FALSE}
 	} ;
 
@@ -896,6 +951,10 @@ int main(int argc, char *argv[])
 				opt_magic_cookie = getopt_state.optarg;
 				break;
 
+			case 1005:					/* --json */
+				opt_json = TRUE;
+				break;
+
 			default:
 				gu_getopt_default(myname, optchar, &getopt_state, stderr);
 
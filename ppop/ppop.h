@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 27 September 2006.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -36,6 +36,7 @@ const struct Jobname *parse_jobname(const char jobname[]);
 
 extern gu_boolean	opt_verbose;
 extern int 			opt_machine_readable;
+extern gu_boolean	opt_json;
 extern int			opt_arrest_interest_interval;
 
 void fatal(int exitval, const char *string, ...)
@@ -51,6 +52,7 @@ __attribute__ ((format (printf, 1, 2)))
 ;
 
 void puts_detabbed(const char *string);
+void puts_json(const char *string);
 
 FILE *get_ready(void);
 FILE *wait_for_pprd(int do_timeout);
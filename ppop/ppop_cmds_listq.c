@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 1 June 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -149,7 +149,7 @@ static void job_status(const struct QEntry *qentry, const struct QEntryFile *qen
 			/* If one or more printers disqualified, assume this is a 
 			 * group and explain.
 			 */
-			if(qentry->never)
+			if(gu_bitset_any(&qentry->never))
 				{
 				gu_utf8_printf(
 					_("%*s(Not all \"%s\"\n"
@@ -404,6 +404,14 @@ static const char *describe_orientation(int orientation)
 		}
 	} /* end of describe_orienation() */
 
+/*
+** The parts of each queue file which custom_list() asks pprd to send.  Most
+** commands read the whole thing, but qquery narrows it down to what the
+** requested fields need.  If QF_PART_MISC is left out, the struct
+** QEntryFile which is passed to (*item)() has only the job name filled in.
+*/
+static int list_parts = QF_PART_ALL;
+
 /*====================================================================
 ** This routine is passed pointers to functions with which
 ** to print a queue listing.
@@ -454,8 +462,8 @@ int custom_list(const char *argv[],
 	int subid;
 	int priority;
 	int status;
-	int never;
-	int notnow;
+	char *never;
+	char *notnow;
 	int pass;
 	long int arrest_time;
 	char *onprinter;
@@ -463,6 +471,9 @@ int custom_list(const char *argv[],
 	if(arrested_drop_time >= 0)			/* maybe get current time to compare to arrest time */
 		time(&time_now);				/* of arrested jobs */
 
+	gu_bitset_init(&qentry.never);
+	gu_bitset_init(&qentry.notnow);
+
 	if(!suppress)						/* If we should always print header, */
 		{								/* print it now */
 		if(!opt_machine_readable)		/* unless a program is reading our output. */
@@ -484,7 +495,7 @@ int custom_list(const char *argv[],
 		FIFO = get_ready();
 
 		/* Send command. */
-		fprintf(FIFO, "l %s %d %d\n", job->destname, job->id, job->subid);
+		fprintf(FIFO, "l %s %d %d %d\n", job->destname, job->id, job->subid, list_parts);
 		fflush(FIFO);
 
 		/* Wait for pprd to reply. */
@@ -496,10 +507,10 @@ int custom_list(const char *argv[],
 		*/
 		while( ! stop && (line = gu_getline(line, &line_available, reply_file)))
 			{
-			destname = onprinter = (char*)NULL;
-			never = notnow = pass = 0;
+			destname = onprinter = never = notnow = (char*)NULL;
+			pass = 0;
 
-			if(gu_sscanf(line,"%S %d %d %d %d %S %d %d %d %ld",
+			if(gu_sscanf(line,"%S %d %d %d %d %S %S %S %d %ld",
 					&destname, &id, &subid,
 					&priority, &status, &onprinter, &never, &notnow, &pass, &arrest_time) < 6)
 				{
@@ -508,6 +519,10 @@ int custom_list(const char *argv[],
 					gu_free(destname);
 				if(onprinter)
 					gu_free(onprinter);
+				if(never)
+					gu_free(never);
+				if(notnow)
+					gu_free(notnow);
 				continue;
 				}
 
@@ -516,7 +531,7 @@ int custom_list(const char *argv[],
 			** in the reply file.
 			*/
 			qentryfile_clear(&qentryfile);
-			if(qentryfile_load(&qentryfile, reply_file) == -1)
+			if((list_parts & QF_PART_MISC) && qentryfile_load(&qentryfile, reply_file) == -1)
 				gu_utf8_printf("Invalid queue entry:\n");
 
 			/* Copy everything into a QEntry structure for easy parameter passing. */
@@ -524,8 +539,18 @@ int custom_list(const char *argv[],
 			qentry.subid = subid;
 			qentry.priority = priority;
 			qentry.status = status;
-			qentry.never = never;
-			qentry.notnow = notnow;
+			gu_bitset_clear_all(&qentry.never);
+			gu_bitset_clear_all(&qentry.notnow);
+			if(never)
+				{
+				gu_bitset_parse(&qentry.never, never);
+				gu_free(never);
+				}
+			if(notnow)
+				{
+				gu_bitset_parse(&qentry.notnow, notnow);
+				gu_free(notnow);
+				}
 			qentry.pass = pass;
 
 			/* And into the QEntryFile structure too, this will take care of deallocation. */
@@ -577,6 +602,9 @@ int custom_list(const char *argv[],
 
 	if(line) gu_free(line);
 
+	gu_bitset_free(&qentry.never);
+	gu_bitset_free(&qentry.notnow);
+
 	return EXIT_OK;						/* no errors */
 	} /* end of custom_list() */
 
@@ -1289,8 +1317,14 @@ static int ppop_details_item(
 	job_status(qentry, qentryfile, onprinter, (FILE*)NULL, 8, 8);
 
 	/* show the never and notnow masks */
-	gu_utf8_printf(_("Never mask: %d\n"), qentry->never);
-	gu_utf8_printf(_("NotNow mask: %d\n"), qentry->notnow);
+	{
+	char *never = gu_bitset_format(&qentry->never);
+	char *notnow = gu_bitset_format(&qentry->notnow);
+	gu_utf8_printf(_("Never mask: %s\n"), never);
+	gu_utf8_printf(_("NotNow mask: %s\n"), notnow);
+	gu_free(never);
+	gu_free(notnow);
+	}
 
 	/* Copy the tail end of the queue file to stdout. */
 	{
@@ -1347,6 +1381,46 @@ struct ADDON
 static struct ADDON addon[MAX_QQUERY_ADDON_ITEMS];
 static int addon_count;
 
+static const char *qquery_names[MAX_QQUERY_ITEMS];
+
+/*
+** These print a field value.  Normally the fields are separated by tabs,
+** so tabs within strings are changed to spaces and a missing value is
+** printed as an empty field.  With --json we print JSON values instead:
+** strings are quoted, missing values are null, and flags are true or false.
+*/
+static void qquery_string(const char *value)
+	{
+	if(opt_json)
+		puts_json(value);
+	else if(value)
+		puts_detabbed(value);
+	}
+
+static void qquery_number(long value)
+	{
+	gu_utf8_printf("%ld", value);
+	}
+
+/* A count which is unknown if it is negative. */
+static void qquery_count(int value)
+	{
+	if(value >= 0)
+		gu_utf8_printf("%d", value);
+	else if(opt_json)
+		gu_utf8_puts("null");
+	else
+		gu_utf8_puts("?");
+	}
+
+static void qquery_boolean(gu_boolean value, const char true_word[], const char false_word[])
+	{
+	if(opt_json)
+		gu_utf8_puts(value ? "true" : "false");
+	else
+		gu_utf8_puts(value ? true_word : false_word);
+	}
+
 static int ppop_qquery_item(
 		int rank,
 		const struct QEntry *qentry,
@@ -1456,7 +1530,7 @@ static int ppop_qquery_item(
 		{
 		case STATUS_WAITING:			/* <--- waiting for printer */
 			status = "waiting for printer";
-			if(qentry->never)			/* If one or more counted out, */
+			if(gu_bitset_any(&qentry->never))	/* If one or more counted out, */
 				snprintf(explain, sizeof(explain), "Not all \"%s\" members are suitable", qentryfile->jobname.destname);
 			else
 				explain[0] = '\0';
@@ -1498,142 +1572,145 @@ static int ppop_qquery_item(
 	/* Print the requested fields. */
 	{
 	int x;
+	if(opt_json)
+		gu_putwc('{');
 	for(x=0; x < qquery_query_count; x++)
 		{
-		if(x)
+		if(opt_json)
+			{
+			if(x)
+				gu_putwc(',');
+			puts_json(qquery_names[x]);
+			gu_putwc(':');
+			}
+		else if(x)
+			{
 			gu_putwc('\t');
+			}
 
 		switch(qquery_query[x])
 			{
 			case 0:						/* jobname */
-				gu_utf8_puts(jobid(qentryfile->jobname.destname, qentryfile->jobname.id, qentryfile->jobname.subid));
+				qquery_string(jobid(qentryfile->jobname.destname, qentryfile->jobname.id, qentryfile->jobname.subid));
 				break;
 			case 1:						/* for */
-				puts_detabbed(qentryfile->For ? qentryfile->For : "?");
+				qquery_string(qentryfile->For ? qentryfile->For : "?");
 				break;
 			case 2:						/* title */
-				puts_detabbed(qentryfile->Title ? qentryfile->Title : "");
+				qquery_string(qentryfile->Title);
 				break;
 			case 3:						/* status */
-				gu_utf8_puts(status);
+				qquery_string(status);
 				break;
 			case 4:						/* explain */
-				puts_detabbed(explain);
+				qquery_string(explain);
 				break;
 			case 5:						/* copies */
 				if(qentryfile->opts.copies >= 0)
-					gu_utf8_printf("%d", qentryfile->opts.copies);
+					qquery_number(qentryfile->opts.copies);
+				else
+					qquery_string(NULL);
 				break;
 			case 6:						/* copiescollate */
-				if(qentryfile->opts.collate)
-					gu_utf8_puts("true");		/* don't internationalize */
-				else
-					gu_utf8_puts("false");
+				qquery_boolean(qentryfile->opts.collate, "true", "false");	/* don't internationalize */
 				break;
 			case 7:						/* pagefactor */
-				gu_utf8_printf("%d", qentryfile->attr.pagefactor);
+				qquery_number(qentryfile->attr.pagefactor);
 				break;
 			case 8:						/* routing */
-				if(qentryfile->Routing)
-					puts_detabbed(qentryfile->Routing);
+				qquery_string(qentryfile->Routing);
 				break;
 			case 9:						/* creator */
-				if(qentryfile->Creator)
-					puts_detabbed(qentryfile->Creator);
+				qquery_string(qentryfile->Creator);
 				break;
 			case 10:					/* nupn */
-				gu_utf8_printf("%d", qentryfile->N_Up.N);
+				qquery_number(qentryfile->N_Up.N);
 				break;
 			case 11:					/* nupborders */
-				gu_utf8_puts(qentryfile->N_Up.borders ? "true" : "false");	/* don't internationalize */
+				qquery_boolean(qentryfile->N_Up.borders, "true", "false");	/* don't internationalize */
 				break;
 			case 12:					/* sigsheets */
-				gu_utf8_printf("%d", qentryfile->N_Up.sigsheets);
+				qquery_number(qentryfile->N_Up.sigsheets);
 				break;
 			case 13:					/* sigpart */
-				gu_utf8_puts(describe_sigpart(qentryfile->N_Up.sigpart));
+				qquery_string(describe_sigpart(qentryfile->N_Up.sigpart));
 				break;
 			case 14:					/* pageorder */
-				gu_utf8_puts(describe_pageorder(qentryfile->attr.pageorder));
+				qquery_string(describe_pageorder(qentryfile->attr.pageorder));
 				break;
 			case 15:					/* proofmode */
-				gu_utf8_puts(describe_proofmode(qentryfile->attr.proofmode));
+				qquery_string(describe_proofmode(qentryfile->attr.proofmode));
 				break;
 			case 16:					/* priority */
-				gu_utf8_printf("%d", qentryfile->spool_state.priority);
+				qquery_number(qentry->priority);
 				break;
 			case 17:					/* opriority */
 				/* removed */
+				qquery_string(NULL);
 				break;
 			case 18:					/* banner */
-				gu_utf8_puts(describe_flag_page_setting(qentryfile->do_banner));
+				qquery_string(describe_flag_page_setting(qentryfile->do_banner));
 				break;
 			case 19:					/* trailer */
-				gu_utf8_puts(describe_flag_page_setting(qentryfile->do_trailer));
+				qquery_string(describe_flag_page_setting(qentryfile->do_trailer));
 				break;
 			case 20:					/* inputbytes */
-				gu_utf8_printf("%ld", qentryfile->attr.input_bytes);
+				qquery_number(qentryfile->attr.input_bytes);
 				break;
 			case 21:					/* postscriptbytes */
-				gu_utf8_printf("%ld", qentryfile->attr.postscript_bytes);
+				qquery_number(qentryfile->attr.postscript_bytes);
 				break;
 			case 22:					/* prolog */
-				gu_utf8_puts( (qentryfile->attr.prolog ? "yes" : "no"));	/* don't internationalize */
+				qquery_boolean(qentryfile->attr.prolog, "yes", "no");	/* don't internationalize */
 				break;
 			case 23:					/* docsetup */
-				gu_utf8_puts( (qentryfile->attr.docsetup ? "yes" : "no"));	/* don't internationalize */
+				qquery_boolean(qentryfile->attr.docsetup, "yes", "no");	/* don't internationalize */
 				break;
 			case 24:					/* script */
-				gu_utf8_puts( (qentryfile->attr.script ? "yes" : "no"));	/* don't internationalize */
+				qquery_boolean(qentryfile->attr.script, "yes", "no");	/* don't internationalize */
 				break;
 			case 25:					/* orientation */
-				gu_utf8_puts( describe_orientation(qentryfile->attr.orientation));
+				qquery_string(describe_orientation(qentryfile->attr.orientation));
 				break;
 			case 26:					/* draft-notice */
-				if(qentryfile->draft_notice)
-					puts_detabbed(qentryfile->draft_notice);
+				qquery_string(qentryfile->draft_notice);
 				break;
 			case 27:					/* username */
-				gu_utf8_puts(qentryfile->user);
+				qquery_string(qentryfile->user);
 				break;
 			case 28:					/* userid */
 				/* removed */
+				qquery_string(NULL);
 				break;
 			case 29:					/* proxy-for */
 				/* removed */
+				qquery_string(NULL);
 				break;
 			case 30:					/* longsubtime */
 				{
 				const char *t = ctime((time_t*)&qentryfile->time);
-				gu_utf8_printf("%.*s", (int)strcspn(t, "\n"), t);
+				char timestr[64];
+				snprintf(timestr, sizeof(timestr), "%.*s", (int)strcspn(t, "\n"), t);
+				qquery_string(timestr);
 				}
 				break;
 			case 31:					/* subtime */
 				{
 				char timestr[64];		/* 9 chars expected, but large buffer for utf-8 */
-				gu_utf8_puts(format_time(timestr, sizeof(timestr), (time_t)qentryfile->time));
+				qquery_string(format_time(timestr, sizeof(timestr), (time_t)qentryfile->time));
 				}
 				break;
 			case 32:					/* pages */
-				if(qentryfile->attr.pages >= 0)
-					gu_utf8_printf("%d", pagemask_count(qentryfile));
-				else
-					gu_utf8_puts("?");
+				qquery_count(qentryfile->attr.pages >= 0 ? pagemask_count(qentryfile) : -1);
 				break;
 			case 33:					/* lpqfilename */
-				if(qentryfile->lpqFileName)
-					puts_detabbed(qentryfile->lpqFileName);
-				else if(qentryfile->Title)
-					puts_detabbed(qentryfile->Title);
+				qquery_string(qentryfile->lpqFileName ? qentryfile->lpqFileName : qentryfile->Title);
 				break;
 			case 34:					/* totalpages */
 				{
 				int total = qentryfile->attr.pages;
 				if(qentryfile->opts.copies > 1) total *= qentryfile->opts.copies;
-				if(total >= 0)
-					gu_utf8_printf("%d", total);
-				else
-					gu_utf8_puts("?");
+				qquery_count(total);
 				}
 				break;
 			case 35:					/* totalsides */
@@ -1642,10 +1719,7 @@ static int ppop_qquery_item(
 				total = (total + qentryfile->N_Up.N - 1) / qentryfile->N_Up.N;
 				if(qentryfile->opts.copies > 1)
 					total *= qentryfile->opts.copies;
-				if(total >= 0)
-					gu_utf8_printf("%d", total);
-				else
-					gu_utf8_puts("?");
+				qquery_count(total);
 				}
 				break;
 			case 36:					/* totalsheets */
@@ -1654,70 +1728,86 @@ static int ppop_qquery_item(
 				total = (total + qentryfile->attr.pagefactor - 1) / qentryfile->attr.pagefactor;
 				if(qentryfile->opts.copies > 1)
 					total *= qentryfile->opts.copies;
-
-				if(total >= 0)
-					gu_utf8_printf("%d", total);
-				else
-					gu_utf8_puts("?");
+				qquery_count(total);
 				}
 				break;
 			case 37:					/* fulljobname */
-				gu_utf8_printf("%s-%d.%d", qentryfile->jobname.destname, qentryfile->jobname.id, qentryfile->jobname.subid);
+				{
+				char *fulljobname;
+				gu_asprintf(&fulljobname, "%s-%d.%d", qentryfile->jobname.destname, qentryfile->jobname.id, qentryfile->jobname.subid);
+				qquery_string(fulljobname);
+				gu_free(fulljobname);
+				}
 				break;
 			case 38:					/* intype */
-				if(qentryfile->Filters)
-					gu_utf8_puts(qentryfile->Filters);
+				qquery_string(qentryfile->Filters);
 				break;
 			case 39:					/* commentary */
-				gu_utf8_printf("%d", qentryfile->commentary);
+				qquery_number(qentryfile->commentary);
 				break;
 
 			case 43:					/* destname */
-				gu_utf8_puts(qentryfile->jobname.destname);
+				qquery_string(qentryfile->jobname.destname);
 				break;
 			case 44:					/* responder */
-				if(qentryfile->responder.name)
-					gu_utf8_puts(qentryfile->responder.name);
+				qquery_string(qentryfile->responder.name);
 				break;
 			case 45:					/* responder-address */
-				if(qentryfile->responder.address);
-					gu_utf8_puts(qentryfile->responder.address);
+				qquery_string(qentryfile->responder.address);
 				break;
 			case 46:					/* responder-options */
-				if(qentryfile->responder.options)
-					gu_utf8_puts(qentryfile->responder.options);
+				qquery_string(qentryfile->responder.options);
 				break;
 			case 47:					/* status/explain */
-				gu_utf8_puts(status);
+				{
+				char status_explain[sizeof(status_scratch) + sizeof(explain) + 3];
 				if(explain[0])
-					{
-					gu_utf8_puts(" (");
-					puts_detabbed(explain);
-					gu_utf8_puts(")");
-					}
+					snprintf(status_explain, sizeof(status_explain), "%s (%s)", status, explain);
+				else
+					strlcpy(status_explain, status, sizeof(status_explain));
+				qquery_string(status_explain);
+				}
 				break;
 			case 48:					/* pagesxcopies */
+				{
+				char pagesxcopies[32];
 				if(qentryfile->attr.pages >= 0)
-					gu_utf8_printf("%d", qentryfile->attr.pages);
+					snprintf(pagesxcopies, sizeof(pagesxcopies), "%d", qentryfile->attr.pages);
 				else
-					gu_utf8_printf("?");
+					strlcpy(pagesxcopies, "?", sizeof(pagesxcopies));
 				if(qentryfile->opts.copies > 1)
-					gu_utf8_printf("x%d", qentryfile->opts.copies);
+					snprintf(pagesxcopies + strlen(pagesxcopies), sizeof(pagesxcopies) - strlen(pagesxcopies), "x%d", qentryfile->opts.copies);
+				qquery_string(pagesxcopies);
+				}
 				break;
 			case 49:					/* page-list */
-				pagemask_print(qentryfile);
+				if(!opt_json)
+					pagemask_print(qentryfile);
+				else if(!qentryfile->page_list.mask)
+					qquery_string(NULL);
+				else
+					{
+					int page, count = 0;
+					gu_putwc('[');
+					for(page=1; page <= qentryfile->attr.pages; page++)
+						{
+						if(pagemask_get_bit(qentryfile, page))
+							gu_utf8_printf(count++ ? ",%d" : "%d", page);
+						}
+					gu_putwc(']');
+					}
 				break;
 
 			default:
 				if(qquery_query[x] >= 1000)
-					{
-					struct ADDON *ap = &addon[qquery_query[x] - 1000];
-					if(ap->value)
-						puts_detabbed(ap->value);
-					}
+					qquery_string(addon[qquery_query[x] - 1000].value);
+				else
+					qquery_string(NULL);
 				break;
 			} /* end of switch */
 		} /* end of for loop */
+	if(opt_json)
+		gu_putwc('}');
 	}
 
 	/* Free the Addon lines. */
@@ -1766,6 +1856,8 @@ int command_qquery(const char *argv[])
 			return EXIT_SYNTAX;
 			}
 
+		qquery_names[x] = ptr;
+
 		if(strncmp(ptr, "addon:", 6) == 0)
 			{
 			if(addon_count >= MAX_QQUERY_ADDON_ITEMS)
@@ -1885,8 +1977,41 @@ int command_qquery(const char *argv[])
 
 	qquery_query_count = x;
 
+	/*
+	** Figure out which parts of the queue files we need so that pprd can
+	** leave the rest out.  If we need none, pprd answers from its job list.
+	*/
+	list_parts = 0;
+	for(x=0; x < qquery_query_count; x++)
+		{
+		switch(qquery_query[x])
+			{
+			case 0:						/* jobname */
+			case 3:						/* status */
+			case 16:					/* priority */
+			case 17:					/* opriority (removed) */
+			case 28:					/* userid (removed) */
+			case 29:					/* proxy-for (removed) */
+			case 37:					/* fulljobname */
+			case 43:					/* destname */
+				break;
+			case 4:						/* explain */
+			case 47:					/* status/explain */
+				list_parts |= QF_PART_REST;
+				break;
+			default:
+				if(qquery_query[x] >= 1000)
+					list_parts |= QF_PART_ADDON;
+				else
+					list_parts |= QF_PART_MISC;
+				break;
+			}
+		}
+
 	retval = custom_list(argv, NULL, ppop_qquery_item, FALSE, opt_arrest_interest_interval);
 
+	list_parts = QF_PART_ALL;
+
 	return retval;
 	} /* end of ppop_qquery() */
 
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 1 June 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -84,6 +84,7 @@ struct Resource
 	char *R_Name;					/* resource name */
 	double R_Version;				/* incompatiblity version number */
 	int R_Revision;					/* upward compatible version number */
+	char *R_CacheBody;				/* automatic cache body which replaced it */
 	} ;
 
 /* types of references to media */
@@ -206,12 +207,15 @@ void prepare_thing_bitmap(void);
 void set_thing_bit(int bitoffset);
 void Y_switch(const char *optarg);
 int split_job(struct QEntryFile *qentry);
+gu_boolean split_requested(void);
 int is_thing_in_current_fragment(int thing_number, int fragment);
 extern char default_pagemedia[MAX_MEDIANAME+1];
 
 /* ppr_outfile.c */
 void get_next_id(struct Jobname *jobname);
 void open_output(void);
+void close_output(void);
+long text_offset(void);
 
 /* ppr_dscdoc.c */
 void read_header_comments(void);
@@ -224,6 +228,7 @@ void do_dsc_For(const char *forstr);
 /* ppr_res.c */
 int resource(int reftype, const char *restype, int first);
 void resource_clear(int reftype, const char *restype);
+void resource_cache_body(const char body[]);
 void dump_page_resources(void);
 void rationalize_resources(void);
 void write_resource_lines(FILE *out, int fragment);
@@ -257,6 +262,7 @@ int get_cache_strip_count(void);
 void begin_resource(void);
 void end_resource(void);
 void abort_resource(void);
+void rcache_log(void);
 
 /* ppr_mactt.c */
 gu_boolean truetype_more_needed(int current_features);
@@ -290,6 +296,8 @@ int outermost_current(void);
 
 /* ppr_things.c */
 void things_space_check(void);
+void things_index(int x, const char key[]);
+int things_lookup(int th_type, const char key[], int after);
 
 /* ppr_editps.c */
 const char **editps_identify(const unsigned char *in_ptr, int in_left);
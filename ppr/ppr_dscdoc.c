@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 10 January 2006.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -1261,7 +1261,7 @@ void read_pages(void)
 				pageheader = TRUE;				/* we in header now */
 				pagetrailer = FALSE;			/* certainly not in trailer */
 				fprintf(page_comments, "%s\n", line);
-				fprintf(page_comments, "Offset: %ld\n", ftell(text));
+				fprintf(page_comments, "Offset: %ld\n", text_offset());
 				fprintf(text,"%s\n", line);
 				continue;
 				}
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 2 June 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -26,6 +26,12 @@
 #include <string.h>
 #include <errno.h>
 #include <ctype.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_BZLIB
+#include <bzlib.h>
+#endif
 #ifdef INTERNATIONAL
 #include <locale.h>
 #include <libintl.h>
@@ -342,6 +348,208 @@ static void in_reset_buffering(void)
 	in_comment = FALSE;
 	}
 
+/*
+** Gzip and bzip2 compressed input is decompressed right here rather than
+** by a gunzip or bunzip2 filter so that there is no extra process or pipe.
+** While a decompressor is in effect, in_read() reads compressed blocks
+** from in_handle into in_zbuffer and decompresses them into the caller's
+** buffer.  Anything which must hand in_handle to another process
+** (stubborn_rewind()) or replace it must first copy out the decompressed
+** data through in_read() and then call in_decompress_end().  As when
+** gunzip was a filter, the unfiltered size (qentry.attr.input_bytes) is
+** that of the decompressed data, counted by stubborn_rewind() and
+** do_passthru() as they copy it.
+*/
+#define DECOMPRESS_NONE 0
+#define DECOMPRESS_GZIP 1
+#define DECOMPRESS_BZIP2 2
+static int in_decompress = DECOMPRESS_NONE;
+static unsigned char *in_zbuffer = NULL;		/* compressed bytes read but not yet decompressed */
+static gu_boolean in_zeof;						/* TRUE if in_handle has reached end of file */
+static gu_boolean in_zdone;						/* TRUE if the compressed stream is finished */
+#ifdef HAVE_ZLIB
+static z_stream in_zstream;
+#endif
+#ifdef HAVE_BZLIB
+static bz_stream in_bzstream;
+#endif
+
+/*
+** Read from in_handle, retrying interupted reads.
+*/
+static int in_read_raw(unsigned char *buffer, int size)
+	{
+	int len;
+	/* Under DEC OSF/1 3.2 we get mysterious interuptions of
+	   system calls.  That is why we have to be fancy here. */
+	while((len = read(in_handle, buffer, size)) < 0)
+		{
+		if(errno != EINTR)
+			fatal(PPREXIT_OTHERERR, "read() failed on input file, errno=%d (%s)", errno, gu_strerror(errno));
+		}
+	return len;
+	} /* end of in_read_raw() */
+
+/*
+** Make sure that at least want bytes are waiting in in_zbuffer for the
+** decompressor, unless the end of the file comes first.  Bytes which are
+** already there are moved to the start of the buffer and more are read
+** after them.  Returns the number of compressed bytes now available.
+*/
+static int in_zfill(unsigned char **next, unsigned int *avail, unsigned int want)
+	{
+	while(*avail < want && !in_zeof)
+		{
+		int len;
+		if(*avail > 0)
+			memmove(in_zbuffer, *next, *avail);
+		*next = in_zbuffer;
+		if((len = in_read_raw(in_zbuffer + *avail, in_bsize - *avail)) == 0)
+			in_zeof = TRUE;
+		*avail += len;
+		}
+	return *avail;
+	} /* end of in_zfill() */
+
+/*
+** Read up to size bytes of the input file into buffer, decompressing it
+** if necessary.  Returns 0 at end of file.
+*/
+static int in_read(unsigned char *buffer, int size)
+	{
+	const char function[] = "in_read";
+
+	switch(in_decompress)
+		{
+		#ifdef HAVE_ZLIB
+		case DECOMPRESS_GZIP:
+			in_zstream.next_out = buffer;
+			in_zstream.avail_out = size;
+			while(in_zstream.avail_out == size && !in_zdone)
+				{
+				int ret;
+				in_zfill(&in_zstream.next_in, &in_zstream.avail_in, 1);
+				ret = inflate(&in_zstream, Z_NO_FLUSH);
+				if(ret == Z_STREAM_END)
+					{
+					/* Like gunzip, go on to the next member if there is one.
+					   Its magic number may not all have been read yet. */
+					if(in_zfill(&in_zstream.next_in, &in_zstream.avail_in, 2) >= 2
+							&& in_zstream.next_in[0] == (unsigned char)'\37' && in_zstream.next_in[1] == (unsigned char)'\213')
+						inflateReset(&in_zstream);
+					else
+						in_zdone = TRUE;
+					}
+				else if(ret == Z_BUF_ERROR && in_zeof)
+					fatal(PPREXIT_OTHERERR, "%s(): gzip compressed input file is truncated", function);
+				else if(ret != Z_OK && ret != Z_BUF_ERROR)
+					fatal(PPREXIT_OTHERERR, "%s(): can't decompress gzip compressed input file: %s", function, in_zstream.msg ? in_zstream.msg : "?");
+				}
+			return size - in_zstream.avail_out;
+		#endif
+
+		#ifdef HAVE_BZLIB
+		case DECOMPRESS_BZIP2:
+			in_bzstream.next_out = (char*)buffer;
+			in_bzstream.avail_out = size;
+			while(in_bzstream.avail_out == size && !in_zdone)
+				{
+				int ret;
+				in_zfill((unsigned char **)&in_bzstream.next_in, &in_bzstream.avail_in, 1);
+				ret = BZ2_bzDecompress(&in_bzstream);
+				if(ret == BZ_STREAM_END)
+					{
+					/* Like bunzip2, go on to the next stream if there is one. */
+					if(in_zfill((unsigned char **)&in_bzstream.next_in, &in_bzstream.avail_in, 3) >= 3
+							&& strncmp(in_bzstream.next_in, "BZh", 3) == 0)
+						{
+						char *next_in = in_bzstream.next_in;
+						unsigned int avail_in = in_bzstream.avail_in;
+						BZ2_bzDecompressEnd(&in_bzstream);
+						if(BZ2_bzDecompressInit(&in_bzstream, 0, 0) != BZ_OK)
+							fatal(PPREXIT_OTHERERR, "%s(): BZ2_bzDecompressInit() failed", function);
+						in_bzstream.next_in = next_in;
+						in_bzstream.avail_in = avail_in;
+						}
+					else
+						{
+						in_zdone = TRUE;
+						}
+					}
+				else if(ret == BZ_OK && in_zeof && in_bzstream.avail_in == 0 && in_bzstream.avail_out == size)
+					fatal(PPREXIT_OTHERERR, "%s(): bzip2 compressed input file is truncated", function);
+				else if(ret != BZ_OK)
+					fatal(PPREXIT_OTHERERR, "%s(): can't decompress bzip2 compressed input file, error %d", function, ret);
+				}
+			return size - in_bzstream.avail_out;
+		#endif
+
+		default:
+			return in_read_raw(buffer, size);
+		}
+	} /* end of in_read() */
+
+/*
+** Start decompressing the input file.  The compressed data already in
+** the buffer is handed to the decompressor first.
+*/
+static void in_decompress_start(int type)
+	{
+	const char function[] = "in_decompress_start";
+
+	if(!in_zbuffer)
+		in_zbuffer = (unsigned char *)gu_alloc(in_bsize, sizeof(unsigned char));
+	memcpy(in_zbuffer, in_ptr, in_left);
+	in_zeof = in_lastbuf;
+	in_zdone = FALSE;
+
+	switch(type)
+		{
+		#ifdef HAVE_ZLIB
+		case DECOMPRESS_GZIP:
+			memset(&in_zstream, 0, sizeof(in_zstream));
+			in_zstream.next_in = in_zbuffer;
+			in_zstream.avail_in = in_left;
+			if(inflateInit2(&in_zstream, 15 + 16) != Z_OK)		/* gzip header only */
+				fatal(PPREXIT_OTHERERR, "%s(): inflateInit2() failed", function);
+			break;
+		#endif
+		#ifdef HAVE_BZLIB
+		case DECOMPRESS_BZIP2:
+			memset(&in_bzstream, 0, sizeof(in_bzstream));
+			in_bzstream.next_in = (char*)in_zbuffer;
+			in_bzstream.avail_in = in_left;
+			if(BZ2_bzDecompressInit(&in_bzstream, 0, 0) != BZ_OK)
+				fatal(PPREXIT_OTHERERR, "%s(): BZ2_bzDecompressInit() failed", function);
+			break;
+		#endif
+		}
+
+	in_decompress = type;
+	input_is_file = FALSE;				/* can't be rewound any more */
+	} /* end of in_decompress_start() */
+
+/*
+** Stop decompressing.  This is called when in_handle is closed or replaced.
+*/
+static void in_decompress_end(void)
+	{
+	switch(in_decompress)
+		{
+		#ifdef HAVE_ZLIB
+		case DECOMPRESS_GZIP:
+			inflateEnd(&in_zstream);
+			break;
+		#endif
+		#ifdef HAVE_BZLIB
+		case DECOMPRESS_BZIP2:
+			BZ2_bzDecompressEnd(&in_bzstream);
+			break;
+		#endif
+		}
+	in_decompress = DECOMPRESS_NONE;
+	} /* end of in_decompress_end() */
+
 /*
 ** Load the next block into the input file buffer.
 **
@@ -354,13 +562,7 @@ static void in_reset_buffering(void)
 */
 static void in_load_buffer(void)
 	{
-	/* Under DEC OSF/1 3.2 we get mysterious interuptions of
-	   system calls.  That is why we have to be fancy here. */
-	while((in_left = read(in_handle, in_buffer, in_bsize)) < 0)
-		{
-		if(errno != EINTR)
-			fatal(PPREXIT_OTHERERR, "read() failed on input file, errno=%d (%s)", errno, gu_strerror(errno));
-		}
+	in_left = in_read(in_buffer, in_bsize);
 
 	if(in_left == 0)					/* If didn't get any bytes, */
 		in_lastbuf = TRUE;				/* it was end of file. */
@@ -1505,6 +1707,7 @@ static void stubborn_rewind(void)
 			}
 
 		/* Close file we just read from. */
+		in_decompress_end();
 		close(in_handle);
 
 		/* Rewind the temporary file and make it the input file. */
@@ -1915,9 +2118,14 @@ static void no_filter(const char *file_type_str)
 
 /*
 ** If the block in the buffer is the first block of a
-** compressed or gziped file, execute a filter to uncompress
-** it and return TRUE.  This is called from the function
-** get_input_file(), below.
+** compressed or gziped file, start decompressing it
+** or execute a filter to uncompress it and return the
+** name of the filter.  This is called from the function
+** infile_open(), below.
+**
+** Gzip and bzip2 files are decompressed by in_read() if we
+** were built with the libraries.  If the file turns out to be
+** compressed twice, the inner layer gets an external filter.
 */
 static const char *compressed(void)
 	{
@@ -1926,6 +2134,15 @@ static const char *compressed(void)
 		/* Check for files compressed with gzip. */
 		if(in_ptr[0] == (unsigned char)'\37' && in_ptr[1] == (unsigned char)'\213')
 			{
+			#ifdef HAVE_ZLIB
+			if(in_decompress == DECOMPRESS_NONE)
+				{
+				in_decompress_start(DECOMPRESS_GZIP);
+				in_reset_buffering();
+				in_load_buffer();
+				return "gunzip";
+				}
+			#endif
 			#ifdef GUNZIP_PATH
 			exec_filter(GUNZIP_PATH, "gunzip", "-c", (char*)NULL);
 			#else
@@ -1951,8 +2168,17 @@ static const char *compressed(void)
 		if(in_ptr[0] == (unsigned char)'B' && in_ptr[1] == (unsigned char)'Z'
 						&& in_ptr[2] == (unsigned char)'h')
 			{
-			#ifdef BUNZIP2
-			exec_filter(BUNZIP2, "bunzip2", "-c", (char*)NULL);
+			#ifdef HAVE_BZLIB
+			if(in_decompress == DECOMPRESS_NONE)
+				{
+				in_decompress_start(DECOMPRESS_BZIP2);
+				in_reset_buffering();
+				in_load_buffer();
+				return "bunzip2";
+				}
+			#endif
+			#ifdef BUNZIP2_PATH
+			exec_filter(BUNZIP2_PATH, "bunzip2", "-c", (char*)NULL);
 			#else
 			no_filter("bzip2ed files");
 			#endif
@@ -2104,7 +2330,7 @@ static void save_infile(void)
 
 	keepinfile_file_created = TRUE;
 
-	while(in_left > 0 || (in_left = read(in_handle, in_buffer, in_bsize)) > 0)
+	while(in_left > 0 || (in_left = in_read(in_buffer, in_bsize)) > 0)
 		{
 		if((bytes_written = write(out_handle, in_ptr, in_left)) < 0)
 			fatal(PPREXIT_OTHERERR, "%s(): write() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
@@ -2210,7 +2436,7 @@ static void do_passthru(const struct FILTER *f)
 
 	/* Copy what is already in the buffer to the -barbar file, then keep
 	   reading blocks and copying them too to the -barbar file. */
-	while(in_left > 0 || (in_left = read(in_handle, in_buffer, in_bsize)) > 0)
+	while(in_left > 0 || (in_left = in_read(in_buffer, in_bsize)) > 0)
 		{
 		qentry.attr.input_bytes += in_left;
 
@@ -2229,6 +2455,7 @@ static void do_passthru(const struct FILTER *f)
 		fatal(PPREXIT_OTHERERR, _("input file read error, errno=%d (%s)"), errno, gu_strerror(errno));
 
 	close(out_handle);
+	in_decompress_end();
 	close(in_handle);
 	in_handle = -1;
 
@@ -2428,6 +2655,8 @@ void infile_close(void)
 	{
 	in_scotch();
 
+	in_decompress_end();
+
 	if(in_handle != -1)
 		{
 		close(in_handle);
@@ -2439,6 +2668,12 @@ void infile_close(void)
 		gu_free(in_buffer_rock_bottom);
 		in_buffer_rock_bottom = NULL;
 		}
+
+	if(in_zbuffer)
+		{
+		gu_free(in_zbuffer);
+		in_zbuffer = NULL;
+		}
 	} /* end of infile_close() */
 
 /*
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 2 August 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -640,6 +640,9 @@ void file_cleanup(void)
 
 		ppr_fnamef(fname, "%s/%s-%d.0-pages", DATADIR, qentry.jobname.destname, qentry.jobname.id);
 		unlink(fname);
+
+		ppr_fnamef(fname, "%s/%s-%d.0-spool", DATADIR, qentry.jobname.destname, qentry.jobname.id);
+		unlink(fname);
 		}
 
 	/* Let's not do this twice: */
@@ -2281,7 +2284,7 @@ int main(int argc, char *argv[])
 
 	/* We will always have a "%%Trailer" comment */
 	fputs("%%Trailer\n", page_comments);
-	fprintf(page_comments, "Offset: %ld\n", ftell(text));
+	fprintf(page_comments, "Offset: %ld\n", text_offset());
 	fputs("%%Trailer\n", text);
 
 	/* If we hit "%%Trailer", read the trailer, otherwise
@@ -2440,14 +2443,11 @@ int main(int argc, char *argv[])
 	** Close those queue files which we are done with.
 	** Only the one in the "queue" directory remains open.
 	**
-	** We must be sure to set the pointers to NULL, otherwise
+	** close_output() sets the pointers to NULL, otherwise
 	** file_cleanup() could try to close them again and thereby
 	** cause a core dump.
 	*/
-	fclose(comments);
-	fclose(page_comments);
-	fclose(text);
-	comments = page_comments = text = (FILE*)NULL;
+	close_output();
 
 	/* =================== Input PostScript Processing Ends ===================== */
 
@@ -2582,6 +2582,11 @@ int main(int argc, char *argv[])
 		submit_job(&qentry, 0);
 		}
 
+	/*
+	** Note how much the automatic resource cache saved.
+	*/
+	rcache_log();
+
 	skeleton_skip_point:
 
 	/*
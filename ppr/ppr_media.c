@@ -10,7 +10,7 @@
 ** documentation.  This software is provided "as is" without express or
 ** implied warranty.
 **
-** Last modified 8 March 2002.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -53,6 +53,8 @@ extern struct Media guess_media;		/* in ppr_main.c */
 */
 void media(int reftype, int first)
 	{
+	char key[MAX_MEDIANAME+1];			/* medium name for the index */
+
 	#ifdef DEBUG_MEDIA_MATCHING
 	printf("media(reftype = %d, first = %d): %s\n", reftype, first, tokens[first] ? tokens[first] : "NULL");
 	#endif
@@ -99,6 +101,9 @@ void media(int reftype, int first)
 		things[thing_count].th_type = TH_MEDIA;
 		things[thing_count].R_Flags = MREF_DOC;
 		thing_count++;
+
+		padded_to_ASCIIZ(key, newmedia->medianame, sizeof(newmedia->medianame));
+		things_index(thing_count - 1, key);
 		} /* MREF_DOC */
 
 	/* If page level media reference, */
@@ -109,12 +114,11 @@ void media(int reftype, int first)
 		int found=FALSE;
 
 		ASCIIZ_to_padded(medianame,tokens[first],sizeof(medianame));
+		padded_to_ASCIIZ(key, medianame, sizeof(medianame));
 
-		for(x=0; x < thing_count; x++)			/* Look thru the whole thing list */
+		/* Look at each medium which the index says might have this name. */
+		for(x = things_lookup(TH_MEDIA, key, -1); x != -1; x = things_lookup(TH_MEDIA, key, x))
 			{
-			if(things[x].th_type != TH_MEDIA)	/* Ignore those that are not media */
-				continue;
-
 			if(padded_cmp(medianame,((struct Media*)things[x].th_ptr)->medianame,MAX_MEDIANAME))
 				{
 				found = TRUE;
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 1 June 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -34,71 +34,98 @@
 ** Returns the next available job id number.  The last ID number
 ** is stored in the file indicated by NEXTIDFILE.
 **
-** The file is locked, the last id is read, and incremented making the new id,
-** and the new id is written back to the file, the file is closed, and the new
-** id is returned.
+** The counter in the file is incremented atomically (see libppr/nextid.c)
+** and the result is reduced to the range 1 thru the maximum job ID, which
+** is 9999 unless a different one is set in ppr.conf.  Since the IDs wrap
+** around, we skip those which pprd says are still in use, and then make
+** sure that the one we settle on doesn't have a queue file.
 */
 void get_next_id(struct Jobname *jobname)
 	{
 	const char function[] = "get_next_id";
-	const char filename[] = NEXTIDFILE;
-	int fd;
-	FILE *f;
+	static int max_id = 0;
+	static void *ids_in_use = NULL;
+	long n;
 	int tid;						/* for holding id */
 	char tempqfname[MAX_PPR_PATH];
 	struct stat statbuf;
 	int paranoid = 0;
 
+	if(max_id == 0)
+		{
+		char *p;
+		max_id = 9999;
+		if((p = gu_ini_query(PPR_CONF, "spooler", "maxjobid", 0, NULL)))
+			{
+			int temp = atoi(p);
+			if(temp >= 99 && temp <= MAX_JOBID)
+				max_id = temp;
+			else
+				warning(WARNING_SEVERE, _("Ignoring \"max job id = %s\" in \"%s\""), p, PPR_CONF);
+			gu_free(p);
+			}
+		ids_in_use = nextid_set_open(FALSE);
+		}
+
 	do	{
 		/* Let's not chew CPU time under some wierd circumstance. */
-		if(paranoid++ > 10000)
+		if(paranoid++ > max_id)
 			fatal(PPREXIT_OTHERERR, "%s(): all job id numbers used", function);
 
-		/* If we can open an existing id file: */
-		if((fd = open(filename, O_RDWR, S_IRUSR | S_IWUSR)) >= 0)
-			{
-			/* lock the file. */
-			if(gu_lock_exclusive(fd, TRUE))
-				fatal(PPREXIT_OTHERERR, "can't lock \"%s\", errno=%d (%s)", filename, errno, gu_strerror(errno));
-
-			/* Create a streams object for read and update. */
-			f = fdopen(fd, "r+");
-
-			tid = gu_fgetint(f);				/* get last value used */
-			tid++;								/* add one to it */
-			if(tid < 1 || tid > 9999)			/* if resulting id unreasonable or too large */
-				tid = 1;						/* force it to one */
-			rewind(f);							/* move to start of file for write */
-			}
+		if((n = nextid_next()) == -1)
+			fatal(PPREXIT_OTHERERR, "%s(): can't use \"%s\", errno=%d (%s)", function, NEXTIDFILE, errno, gu_strerror(errno));
 
-		/* Open failed, assume file does not exist and create a new one. */
-		else
-			{
-			tid = 1;					/* start id's at 1 */
-			if(!(f = fopen(filename, "w")))
-				fatal(PPREXIT_OTHERERR, "can't create new id file \"%s\"", filename);
-			}
+		tid = (int)((n - 1) % max_id) + 1;
 
-		fprintf(f, "%d\n", tid);		/* Write the new id */
-		fclose(f);
+		/* If pprd says that a job with this ID is in the queue, skip it. */
+		if(ids_in_use && nextid_set_contains(ids_in_use, tid))
+			continue;
 
-		/* Perform a crude test to alieviate the problems of ID wraparound.
-		   If a job exists with which we would collide, then skip this id. */
+		/* It could be in the queue but not yet known to pprd. */
 		ppr_fnamef(tempqfname, "%s/%s-%d.%d", QUEUEDIR, jobname->destname, tid, 0);
-		} while(stat(tempqfname, &statbuf) == 0);
+		if(stat(tempqfname, &statbuf) == 0)
+			continue;
+
+		break;
+		} while(TRUE);
 
 	jobname->id = tid;
 	} /* end of get_next_id() */
 
+/*
+** TRUE if the job is being spooled in a single container file.
+** See libppr/spoolfile.c.
+*/
+static gu_boolean spool_container = FALSE;
+
 /*
 ** Open the output files.
 ** These are three in number:  one for the text, one for the header
 ** and trailer comments, and one for the page level comments.
+**
+** If ppr.conf calls for single file spooling, the text is written
+** directly into the container after the space reserved for its
+** directory and the two comment files are temporary files which
+** close_output() will append to it.
 */
 void open_output(void)
 	{
+	const char function[] = "open_output";
 	char temp[MAX_PPR_PATH];
 
+	if(spoolfile_enabled() && !split_requested())
+		{
+		ppr_fnamef(temp, "%s/%s-%d.%d-spool", DATADIR, qentry.jobname.destname, qentry.jobname.id, qentry.jobname.subid);
+		if(!(text = fopen(temp, "wb")))
+			fatal(PPREXIT_OTHERERR, _("can't open \"%s\", errno=%d (%s)"), temp, errno, gu_strerror(errno));
+		if(fseek(text, SPOOLFILE_HEADER_SIZE, SEEK_SET) == -1)
+			fatal(PPREXIT_OTHERERR, "%s(): fseek() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+		if(!(comments = tmpfile()) || !(page_comments = tmpfile()))
+			fatal(PPREXIT_OTHERERR, "%s(): tmpfile() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+		spool_container = TRUE;
+		return;
+		}
+
 	/* file for header and trailer comments */
 	ppr_fnamef(temp, "%s/%s-%d.%d-comments", DATADIR, qentry.jobname.destname, qentry.jobname.id, qentry.jobname.subid);
 	if(!(comments = fopen(temp, "wb")))
@@ -115,5 +142,33 @@ void open_output(void)
 		fatal(PPREXIT_OTHERERR, _("can't open \"%s\", errno=%d (%s)"), temp, errno, gu_strerror(errno));
 	} /* end of open_output() */
 
+/*
+** Close the output files.  If we are spooling to a container, copy the
+** comments into it and write its directory first.
+*/
+void close_output(void)
+	{
+	if(spool_container && spoolfile_finish(text, comments, page_comments) == -1)
+		fatal(PPREXIT_DISKFULL, _("Disk full"));
+
+	fclose(comments);
+	fclose(page_comments);
+	fclose(text);
+	comments = page_comments = text = (FILE*)NULL;
+	} /* end of close_output() */
+
+/*
+** Return the current offset in the -text file.  This is what goes in
+** the "Offset:" lines of the -pages file.  In a container, the text
+** starts after the directory.
+*/
+long text_offset(void)
+	{
+	long offset = ftell(text);
+	if(spool_container)
+		offset -= SPOOLFILE_HEADER_SIZE;
+	return offset;
+	} /* end of text_offset() */
+
 /* end of file */
 
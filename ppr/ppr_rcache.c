@@ -10,7 +10,7 @@
 ** documentation.  This software is provided "as is" without express or
 ** implied warranty.
 **
-** Last modified 9 August 1999.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -21,18 +21,46 @@
 ** in the cache.  If the strip resources switch (-S) was used, the
 ** resource will be removed from the incoming file and will later be
 ** re-inserted from the cache.
+**
+** Resources which are not in the permanent cache or the font index are
+** candidates for the automatic cache.  The body of the resource is copied
+** to a temporary file and its MD5 digest computed.  The automatic cache
+** stores each distinct body once in RESOURCE_AUTOCACHE/data under a name
+** made from the digest and the length.
+**
+** If a body with the same name is already there, the resource is a repeat,
+** so we replace it with "%%IncludeResource:" and the name of the body goes
+** into the resource's "Res:" line in the queue file.  pprdrv will copy
+** that very body into the job, after checking its digest, when the job is
+** printed.  Bodies are never looked up by resource name, so a job can't
+** pick up code which some other user's job supplied under the same name.
+** If the body isn't there, it is stored and the resource is left in the
+** job.
+**
+** When the cache grows beyond the size set in ppr.conf, the bodies which
+** have gone the longest without being used are removed, but never ones
+** named in the queue file of a job which is still in the queue, nor ones
+** which have been used within the number of days set there (or the last
+** hour), since a job which is being submitted right now may be about to
+** name them.  The number of bytes by which each job was shrunk is appended
+** to LOGDIR/rcache.
 */
 
 #include "config.h"
+#include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <utime.h>
+#include <dirent.h>
 #ifdef INTERNATIONAL
 #include <libintl.h>
 #endif
 #include "gu.h"
+#include "gu_md5.h"
 #include "global_defines.h"
 #include "global_structs.h"
 #include "ppr.h"
@@ -42,6 +70,375 @@
 /* Options set from command line: */
 extern gu_boolean option_strip_fontindex;
 
+#define RCACHE_LOGFILE LOGDIR"/rcache"
+
+/* Resources smaller than this aren't worth the trouble. */
+#define RCACHE_MIN_RESOURCE 2048
+
+/* Settings from the [resource cache] section of ppr.conf.  A maximum
+   size of zero disables the automatic cache. */
+static gu_boolean rcache_conf_loaded = FALSE;
+static long rcache_max_size = 64;		/* megabytes */
+static int rcache_keep_days = 7;
+
+/* Statistics for the log. */
+static int rcache_stored = 0;
+static int rcache_replaced = 0;
+static long rcache_saved = 0;
+
+static gu_boolean rcache_enabled(void)
+	{
+	if(!rcache_conf_loaded)
+		{
+		char *p;
+		struct stat statbuf;
+
+		if((p = gu_ini_query(PPR_CONF, "resourcecache", "maxsize", 0, NULL)))
+			{
+			rcache_max_size = atol(p);
+			gu_free(p);
+			}
+		if((p = gu_ini_query(PPR_CONF, "resourcecache", "keepdays", 0, NULL)))
+			{
+			rcache_keep_days = atoi(p);
+			gu_free(p);
+			}
+
+		/* If the directory isn't there, don't try to use it. */
+		if(stat(RESOURCE_AUTOCACHE, &statbuf) == -1 || !S_ISDIR(statbuf.st_mode))
+			rcache_max_size = 0;
+
+		rcache_conf_loaded = TRUE;
+		}
+	return rcache_max_size > 0;
+	}
+
+/*
+** Copy the body of a resource from a temporary file to another file
+** (or just compute its digest if out is NULL).  The digest is formatted
+** as the name by which the body is stored in the data directory.
+*/
+static int rcache_copy_body(FILE *in, FILE *out, char *data_name, long size)
+	{
+	md5_state_t md5;
+	md5_byte_t digest[16];
+	char buffer[8192];
+	int len, x;
+
+	rewind(in);
+	md5_init(&md5);
+	while((len = fread(buffer, sizeof(char), sizeof(buffer), in)) > 0)
+		{
+		md5_append(&md5, (md5_byte_t*)buffer, len);
+		if(out && fwrite(buffer, sizeof(char), len, out) != len)
+			return -1;
+		}
+	md5_finish(&md5, digest);
+
+	if(data_name)
+		{
+		for(x=0; x < 16; x++)
+			sprintf(data_name + x * 2, "%02x", digest[x]);
+		sprintf(data_name + 32, "-%ld", size);
+		}
+
+	return ferror(in) ? -1 : 0;
+	}
+
+/*
+** Return a hash of the names of the bodies which the queue files of the
+** jobs in the queue refer to.
+*/
+static void *rcache_referenced(void)
+	{
+	void *referenced = gu_pch_new(64);
+	DIR *dir;
+	struct dirent *direntp;
+	char fname[MAX_PPR_PATH];
+	FILE *f;
+	char *line = NULL;
+	int line_space = 80;
+
+	if(!(dir = opendir(QUEUEDIR)))
+		return referenced;
+	while((direntp = readdir(dir)))
+		{
+		if(direntp->d_name[0] == '.')
+			continue;
+		ppr_fnamef(fname, "%s/%s", QUEUEDIR, direntp->d_name);
+		if(!(f = fopen(fname, "r")))
+			continue;
+		while((line = gu_getline(line, &line_space, f)))
+			{
+			char *p, *body = NULL;
+			int x;
+			if(strcmp(line, "EndRes") == 0)
+				break;
+			if(!(p = lmatchp(line, "Res:")))
+				continue;
+			for(x=0; x < 6 && p; x++)
+				{
+				if(x == 3)
+					gu_strsep_quoted(&p, " ", NULL);
+				else
+					gu_strsep(&p, " ");
+				}
+			if(p && (body = gu_strsep(&p, " ")) && cached_body_name_ok(body))
+				gu_pch_set(referenced, body, "");
+			}
+		fclose(f);
+		}
+	closedir(dir);
+	if(line)
+		gu_free(line);
+
+	return referenced;
+	}
+
+/*
+** Remove the least recently used bodies from the automatic cache until
+** it is no larger than the configured size.  Return TRUE if there is
+** room for another body of the indicated size.
+*/
+struct RCACHE_FILE { char *name; char *data_name; time_t mtime; off_t size; };
+
+static int rcache_file_cmp(const void *a, const void *b)
+	{
+	time_t ta = ((const struct RCACHE_FILE *)a)->mtime;
+	time_t tb = ((const struct RCACHE_FILE *)b)->mtime;
+	return ta < tb ? -1 : ta > tb ? 1 : 0;
+	}
+
+static gu_boolean rcache_make_room(long size)
+	{
+	const char dirname[] = RESOURCE_AUTOCACHE"/data";
+	off_t limit = (off_t)rcache_max_size * 1048576;
+	off_t total = 0;
+	time_t keep_after = time(NULL) - (rcache_keep_days > 0 ? (time_t)rcache_keep_days * 86400 : 3600);
+	void *referenced = NULL;
+	DIR *dir;
+	struct dirent *direntp;
+	struct RCACHE_FILE *files = NULL;
+	int count = 0, space = 0, x;
+	char fname[MAX_PPR_PATH];
+	struct stat statbuf;
+
+	if(!(dir = opendir(dirname)))
+		return FALSE;
+	while((direntp = readdir(dir)))
+		{
+		if(direntp->d_name[0] == '.')
+			continue;
+		ppr_fnamef(fname, "%s/%s", dirname, direntp->d_name);
+		if(stat(fname, &statbuf) == -1)
+			continue;
+		if(count == space)
+			{
+			space = space ? space * 2 : 64;
+			files = gu_realloc(files, space, sizeof(struct RCACHE_FILE));
+			}
+		files[count].name = gu_strdup(fname);
+		files[count].data_name = files[count].name + strlen(dirname) + 1;
+		files[count].mtime = statbuf.st_mtime;
+		files[count].size = statbuf.st_size;
+		total += statbuf.st_size;
+		count++;
+		}
+	closedir(dir);
+
+	if(count > 0)
+		qsort(files, count, sizeof(struct RCACHE_FILE), rcache_file_cmp);
+
+	for(x=0; x < count && (total + size) > limit && files[x].mtime < keep_after; x++)
+		{
+		/* Only read the queue if something must go. */
+		if(!referenced)
+			referenced = rcache_referenced();
+		if(gu_pch_get(referenced, files[x].data_name))
+			continue;
+		if(unlink(files[x].name) == 0)
+			total -= files[x].size;
+		}
+
+	for(x=0; x < count; x++)
+		gu_free(files[x].name);
+	if(files)
+		gu_free(files);
+	if(referenced)
+		gu_pch_free(referenced);
+
+	return (total + size) <= limit;
+	}
+
+/*
+** Store the body of a resource in the automatic cache.  Failure is
+** silently ignored since the cache is only an optimization.
+*/
+static void rcache_store(FILE *body, long size, const char data_name[])
+	{
+	char data_fname[MAX_PPR_PATH];
+	char temp_fname[MAX_PPR_PATH];
+	FILE *out;
+
+	ppr_fnamef(data_fname, "%s/data/%s", RESOURCE_AUTOCACHE, data_name);
+
+	mkdir(RESOURCE_AUTOCACHE"/data", UNIX_755);
+
+	if(!rcache_make_room(size))
+		return;
+
+	ppr_fnamef(temp_fname, "%s.%ld", data_fname, (long)getpid());
+	if(!(out = fopen(temp_fname, "w")))
+		return;
+	if(rcache_copy_body(body, out, NULL, size) == -1 || fclose(out) == EOF || rename(temp_fname, data_fname) == -1)
+		{
+		unlink(temp_fname);
+		return;
+		}
+
+	rcache_stored++;
+	}
+
+/*
+** This is called by begin_resource() for a resource which isn't in the
+** permanent cache or the font index.  It reads the whole resource,
+** leaving a fresh line in line[] just as when a resource is stripped out,
+** and writes either the resource or an "%%IncludeResource:" comment to
+** the -text file.
+*/
+static void rcache_resource(const char type_in[], const char name_in[], double version, int revision)
+	{
+	char *type, *name;
+	char *begin_line;
+	FILE *saved_text = text;
+	FILE *body;
+	gu_boolean nested = FALSE;
+	long size;
+	char data_name[64];
+	char *data_fname;
+
+	if(!(body = tmpfile()))
+		return;
+
+	/* These point into line[] which we are about to overwrite. */
+	type = gu_strdup(type_in);
+	name = gu_strdup(name_in);
+	begin_line = gu_strdup(line);
+
+	/*
+	** Read the body of the resource.  The -text file is temporarily
+	** replaced with the temporary file so that %%BeginData: sections,
+	** which getline_simplify() copies itself, end up there too.
+	*/
+	text = body;
+	while(TRUE)
+		{
+		getline_simplify();
+		if(in_eof() || nest_level() == 0)
+			break;
+		if(nest_level() > 1)
+			nested = TRUE;
+		fwrite(line, sizeof(unsigned char), line_len, body);
+		if(!line_overflow)
+			fputc('\n', body);
+		}
+	text = saved_text;
+	fflush(body);
+	size = ftell(body);
+
+	/*
+	** See if we can replace it with a reference to the cache.  We don't
+	** try if the resource contains other resources since they would be
+	** removed too, nor for subsets of fonts (which have names like
+	** "ABCDEF+Times-Roman") since they are seldom the same twice.
+	*/
+	if(!in_eof() && !nested && size >= RCACHE_MIN_RESOURCE && size <= (rcache_max_size * 1048576 / 8)
+			&& !(strcmp(type, "font") == 0 && strlen(name) > 7 && name[6] == '+')
+			&& rcache_copy_body(body, NULL, data_name, size) == 0
+			)
+		{
+		/* If this very body is already there, this is a repeat. */
+		if((data_fname = find_cached_body(data_name, TRUE)))
+			{
+			char include_line[MAX_LINE + 1];
+
+			#ifdef DEBUG_RESOURCES
+			printf("rcache_resource(): replacing repeat of %s\n", data_name);
+			#endif
+
+			/* Mark it as removed.  This requires the tokens of the
+			   "%%BeginResource:" line. */
+			strcpy(line, begin_line);
+			line_len = strlen(line);
+			tokenize();
+			resource(REREF_REMOVED, tokens[1], 2);
+			resource_cache_body(data_name);
+
+			if(strcmp(type, "procset") == 0)
+				snprintf(include_line, sizeof(include_line), "%%%%IncludeResource: %s %s %s %d\n", type, quote(name), gu_dtostr(version), revision);
+			else
+				snprintf(include_line, sizeof(include_line), "%%%%IncludeResource: %s %s\n", type, quote(name));
+			fputs(include_line, text);
+
+			/* Mark it as recently used. */
+			utime(data_fname, NULL);
+			gu_free(data_fname);
+
+			rcache_replaced++;
+			rcache_saved += (strlen(begin_line) + 1 + size + sizeof("%%EndResource\n") - 1 - strlen(include_line));
+
+			gu_free(type);
+			gu_free(name);
+			gu_free(begin_line);
+			fclose(body);
+			getline_simplify();		/* leave a fresh line in line[] */
+			return;
+			}
+
+		rcache_store(body, size, data_name);
+		}
+
+	/* Put the resource in the -text file as it was. */
+	fprintf(text, "%s\n", begin_line);
+	rcache_copy_body(body, text, NULL, size);
+	if(!in_eof())
+		{
+		fprintf(text, "%s\n", line);
+		getline_simplify();
+		}
+
+	gu_free(type);
+	gu_free(name);
+	gu_free(begin_line);
+	fclose(body);
+	} /* end of rcache_resource() */
+
+/*
+** This is called at the end of the job.  If the automatic cache
+** did anything, make a note of it in the log.
+*/
+void rcache_log(void)
+	{
+	FILE *f;
+	char timestr[32];
+	time_t now;
+
+	if(rcache_stored == 0 && rcache_replaced == 0)
+		return;
+
+	time(&now);
+	strftime(timestr, sizeof(timestr), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+	if((f = fopen(RCACHE_LOGFILE, "a")))
+		{
+		fprintf(f, "%s %s-%d stored=%d replaced=%d saved=%ld\n",
+				timestr,
+				qentry.jobname.destname, qentry.jobname.id,
+				rcache_stored, rcache_replaced, rcache_saved);
+		fclose(f);
+		}
+	} /* end of rcache_log() */
+
 /*
 ** This routine is called by getline_simplify() in ppr_simplify.c in order
 ** to allow the resource cache to examine the start of a new resource.
@@ -105,6 +502,8 @@ void begin_resource(void)
 	found = find_resource(type, name, version, revision, &font_features);
 
 	/*
+	** If it is a font from the font index and the -S switch was used,
+	** strip it out.
 	*/
 	if(found && is_font && option_strip_fontindex)
 		{
@@ -126,6 +525,15 @@ void begin_resource(void)
 		getline_simplify();		 /* and leave a fresh line in line[] */
 		}
 
+	/*
+	** If it isn't in the permanent cache or the font index, try the
+	** automatic cache.
+	*/
+	else if(!found && rcache_enabled())
+		{
+		rcache_resource(type, name, version, revision);
+		}
+
 	if(found)
 		gu_free(found);
 	
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 15 November 2002.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -87,18 +87,15 @@ void requirement(int reftype, const char req_name[])
 		}
 
 	/* Look for this requirement in the list of known ones. */
-	for(x=0; x<thing_count; x++)
+	for(x = things_lookup(TH_REQUIREMENT, req_name, -1); x != -1; x = things_lookup(TH_REQUIREMENT, req_name, x))
 		{
-		if(things[x].th_type != TH_REQUIREMENT)
-			continue;
-
 		sptr = (char*)things[x].th_ptr;
 		if(strcmp(sptr, req_name) == 0)
 			break;
 		}
 
 	/* If it is not found, */
-	if(x == thing_count)
+	if(x == -1)
 		{
 		/* A page requirement should have been mentioned in the header. */
 		if(reftype == REQ_PAGE)
@@ -106,11 +103,11 @@ void requirement(int reftype, const char req_name[])
 
 		things_space_check();			/* make room in the array */
 
+		x = thing_count++;
 		things[x].th_type = TH_REQUIREMENT;
 		things[x].R_Flags = reftype;
 		things[x].th_ptr = (void*)gu_strdup(req_name);
-
-		thing_count++;
+		things_index(x, req_name);
 		}
 
 	else							/* if already present, */
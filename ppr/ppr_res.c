@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 12 November 2004.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -95,6 +95,9 @@ static char *resname_to_str(const char *type, const char *name, double version,
 	return result;
 	} /* end of resname_to_str() */
 
+/* The thing which resource() last referenced */
+static int last_resource = -1;
+
 /*
 ** Called on each reference to a resource, whether needed, provided, or
 ** included.  
@@ -111,6 +114,7 @@ int resource(int reftype, const char *restype, int first)
 	int x;
 	int rval;					/* number of words `eaten' */
 	char *ptr;
+	const char *key;			/* resource name as text for the index */
 
 	#ifdef DEBUG_RESOURCES_DETAILED
 	printf("resource(): %d %s %s %s %s\n",
@@ -121,6 +125,7 @@ int resource(int reftype, const char *restype, int first)
 		tokens[first+2]?tokens[first+2]:"<NULL>" );
 	#endif
 
+	last_resource = -1;
 	resname = tokens[first];	/* resource name is first */
 
 	if(restype == (char*)NULL || resname == (char*)NULL)
@@ -172,21 +177,19 @@ int resource(int reftype, const char *restype, int first)
 	#endif
 
 	/* search for the resource */
-	for(x=0; x < thing_count; x++)
+	key = resname_to_str(restype, resname, version, revision);
+	for(x = things_lookup(TH_RESOURCE, key, -1); x != -1; x = things_lookup(TH_RESOURCE, key, x))
 		{
-		if(things[x].th_type == TH_RESOURCE)
-			{
-			resource = (struct Resource*)things[x].th_ptr;
-			if( ( strcmp(resource->R_Type, restype) == 0 ) &&
-						( strcmp(resource->R_Name, resname) == 0 ) &&
-						( resource->R_Version == version ) &&
-						( resource->R_Revision == revision ) )
-				break;
-			}
+		resource = (struct Resource*)things[x].th_ptr;
+		if( ( strcmp(resource->R_Type, restype) == 0 ) &&
+					( strcmp(resource->R_Name, resname) == 0 ) &&
+					( resource->R_Version == version ) &&
+					( resource->R_Revision == revision ) )
+			break;
 		}
 
 	/* if wasn't found, add it */
-	if(x == thing_count)
+	if(x == -1)
 		{
 		#ifdef DEBUG_RESOURCES_DETAILED
 		printf("resource(): this is 1st reference\n");
@@ -194,7 +197,7 @@ int resource(int reftype, const char *restype, int first)
 
 		things_space_check();					/* make space in the array */
 
-		thing_count++;
+		x = thing_count++;
 		things[x].th_type = TH_RESOURCE;		/* this thing is resource */
 		resource = (struct Resource*)gu_alloc(1, sizeof(struct Resource));
 		things[x].th_ptr = (void*)resource;		/* point thing ptr to it */
@@ -203,9 +206,12 @@ int resource(int reftype, const char *restype, int first)
 		resource->R_Name = gu_strdup(resname);
 		resource->R_Version = version;
 		resource->R_Revision = revision;
+		resource->R_CacheBody = NULL;
+		things_index(x, key);					/* so we can find it next time */
 		}
 
 	/* note our reference to it */
+	last_resource = x;
 	things[x].R_Flags |= reftype;				/* or our reference into it */
 	if(reftype & REREF_PAGE)					/* add to the bitmap */
 		set_thing_bit(x);						/* for this page */
@@ -214,6 +220,18 @@ int resource(int reftype, const char *restype, int first)
 	return rval;
 	} /* end of resource() */
 
+/*
+** This is called when the automatic resource cache has replaced a resource
+** with "%%IncludeResource:", right after it has called resource() to mark
+** it as removed.  The name of the body in the cache is noted so that
+** pprdrv will use that very body.
+*/
+void resource_cache_body(const char body[])
+	{
+	if(last_resource != -1)
+		((struct Resource*)things[last_resource].th_ptr)->R_CacheBody = gu_strdup(body);
+	} /* end of resource_cache_body() */
+
 /*
 ** This is called whenever a new resource comment is found in the
 ** trailer section which supersedes a previous one.  It clears
@@ -495,10 +513,12 @@ void rationalize_resources(void)
 ** Write one "Res:" line into the queue file for each resource.
 **
 ** The format of a "Res:" line is:
-** "Res: ?NEEDED ?ADDINCLUDE TYPE NAME VERSION REVISION"
+** "Res: ?NEEDED ?ADDINCLUDE TYPE NAME VERSION REVISION [BODY]"
 **
 ** These lines will be used by pprdrv to determine if a file
-** can be printed and to re-construct the DSC comments.
+** can be printed and to re-construct the DSC comments.  BODY is
+** present if the resource was removed by the automatic resource cache.
+** It is the name of the body in RESOURCE_AUTOCACHE/data.
 */
 void write_resource_lines(FILE *out, int fragment)
 	{
@@ -532,8 +552,11 @@ void write_resource_lines(FILE *out, int fragment)
 				fputc('\\', out);
 			fputc(c, out);
 			}
-		fprintf(out, "\" %s %d\n",
+		fprintf(out, "\" %s %d",
 				gu_dtostr(resource->R_Version), resource->R_Revision);
+		if(resource->R_CacheBody && (things[x].R_Flags & REREF_REMOVED))
+			fprintf(out, " %s", resource->R_CacheBody);
+		fputc('\n', out);
 		}
 
 	} /* end of write_resource_lines() */
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 20 July 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -97,6 +97,16 @@ void Y_switch(const char *optarg)
 
 	} /* end of Y_switch() */
 
+/*
+** Return TRUE if the -Y switch was used.  The fragments of a split
+** job share the -text file, so such jobs are never spooled in a
+** single container file.
+*/
+gu_boolean split_requested(void)
+	{
+	return splitting;
+	}
+
 /*
 ** This function is called just before ppr_main.c calls
 ** write_queue_file().  This function may split the job
@@ -10,10 +10,22 @@
 ** documentation.  This software is provided "as is" without express or
 ** implied warranty.
 **
-** Last modified 19 July 2001.
+** Last modified 19 October 2026.
+*/
+
+/*
+** The things[] array holds the resources, media, and requirements which
+** the document refers to in the order in which they were first mentioned.
+** The queue file writers depend on that order, so the array is never
+** rearranged.  Instead, this module keeps a hash index of it so that
+** resource(), media(), and requirement() can find an existing entry
+** without comparing it to every other entry.  Documents which refer to
+** hundreds of resources on each of thousands of pages would otherwise take
+** time proportional to the product of the two.
 */
 
 #include "config.h"
+#include <limits.h>
 #include "gu.h"
 #include "global_defines.h"
 #include "global_structs.h"
@@ -21,6 +33,11 @@
 
 static int things_space = 0;
 
+static int *index_buckets = NULL;		/* first thing in each bucket or -1 */
+static int index_bucket_count = 0;		/* always a power of two */
+static int *index_next = NULL;			/* next thing in same bucket, parallel to things[] */
+static unsigned int *index_hash = NULL;	/* full hash value, parallel to things[] */
+
 /*
 ** Make sure there is space to add at least one more entry to things[].
 */
@@ -28,9 +45,94 @@ void things_space_check(void)
 	{
 	if( (things_space - thing_count) < 1 )
 		{
-		things_space += 100;
+		things_space = things_space ? things_space * 2 : 100;
 		things = (struct Thing *)gu_realloc(things, things_space, sizeof(struct Thing));
+		index_next = (int *)gu_realloc(index_next, things_space, sizeof(int));
+		index_hash = (unsigned int *)gu_realloc(index_hash, things_space, sizeof(unsigned int));
 		}
 	} /* end of things_space_check() */
 
+/*
+** Compute the hash value of a thing of the indicated type.  The key is
+** whatever string identifies the thing within its type.
+*/
+static unsigned int things_hash(int th_type, const char key[])
+	{
+	return (unsigned int)gu_hash(key, INT_MAX) * 3 + th_type;
+	}
+
+/*
+** Make the bucket table larger and put each thing already
+** indexed into its new bucket.
+*/
+static void things_rehash(void)
+	{
+	int x;
+
+	if(index_buckets)
+		gu_free(index_buckets);
+
+	index_bucket_count = index_bucket_count ? index_bucket_count * 2 : 256;
+	index_buckets = (int *)gu_alloc(index_bucket_count, sizeof(int));
+
+	for(x=0; x < index_bucket_count; x++)
+		index_buckets[x] = -1;
+
+	for(x=0; x < thing_count; x++)
+		{
+		int bucket = index_hash[x] & (index_bucket_count - 1);
+		index_next[x] = index_buckets[bucket];
+		index_buckets[bucket] = x;
+		}
+	} /* end of things_rehash() */
+
+/*
+** Add things[x] to the index.  This must be called just after the
+** caller has filled in the new entry and incremented thing_count.
+*/
+void things_index(int x, const char key[])
+	{
+	int bucket;
+
+	index_hash[x] = things_hash(things[x].th_type, key);
+
+	if(thing_count > index_bucket_count)
+		{
+		things_rehash();		/* indexes things[x] too */
+		return;
+		}
+
+	bucket = index_hash[x] & (index_bucket_count - 1);
+	index_next[x] = index_buckets[bucket];
+	index_buckets[bucket] = x;
+	} /* end of things_index() */
+
+/*
+** Return the index in things[] of a thing of the indicated type which may
+** have the indicated key, or -1 if there is none.  To get the next
+** candidate, pass the previous return value as "after", otherwise pass -1.
+** The caller must compare each candidate to what it is looking for since
+** different keys may have the same hash value.
+*/
+int things_lookup(int th_type, const char key[], int after)
+	{
+	unsigned int hash;
+	int x;
+
+	if(index_bucket_count == 0)
+		return -1;
+
+	hash = things_hash(th_type, key);
+
+	if(after == -1)
+		x = index_buckets[hash & (index_bucket_count - 1)];
+	else
+		x = index_next[after];
+
+	while(x != -1 && (index_hash[x] != hash || things[x].th_type != th_type))
+		x = index_next[x];
+
+	return x;
+	} /* end of things_lookup() */
+
 /* end of file */
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 28 September 2006.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -28,6 +28,9 @@
 #include <time.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#ifdef HAVE_POSIX_SPAWN
+#include <spawn.h>
+#endif
 #ifdef INTERNATIONAL
 #include <locale.h>
 #include <libintl.h>
@@ -50,6 +53,7 @@ time_t daemon_start_time;		/* time at which this daemon started */
 struct QEntry *queue;			/* array holding terse queue */
 int queue_size;					/* number of entries for which there is room */
 int queue_entries = 0;			/* entries currently used */
+void *queue_id_set = NULL;		/* job IDs in use, published for ppr */
 
 struct Printer *printers;		/* array of printer description structures */
 int printer_count = 0;			/* how many printers do we have? */
@@ -76,35 +80,160 @@ void child_unblock_all(void)
 	} /* end of child_unblock_all() */
 
 /*
-** We calls this from the child side of fork() because pprd has no stdin,
-** stdout, or stderr handles open.  It directs the child's stdin to /dev/null
-** and stdout and stderr to the pprd log file.
+** Start a program in a child process.  The child's descriptors 0 through 3
+** are connected as directed by fds[], each member of which is a descriptor
+** of ours or one of the CHILD_* values defined in pprd.h.  The caller
+** remains responsible for closing its own copies of any descriptors it
+** passes.
+**
+** If it can, this uses posix_spawn() which, unlike fork(), doesn't copy
+** our address space (the queue array may be several megabytes) only to
+** have exec() throw it away.
+**
+** Returns the PID of the child.  If it couldn't be started, returns -1
+** with errno set.  Note that if the program couldn't be executed, that
+** is also reported here rather than by the child's exit code.
 */
-void child_stdin_stdout_stderr(const char input_file[], const char output_file[])
+pid_t child_spawn(const char path[], const char *argv[], const int fds[CHILD_FDS])
 	{
-	const char function[] = "child_stdin_stdout_stderr";
-	int fd;
+	FUNCTION4DEBUG("child_spawn")
+	int moved[CHILD_FDS];
+	pid_t pid = -1;
+	int saved_errno = 0;
+	int x;
+
+	DODEBUG_SPAWN(("%s(\"%s\", {%d, %d, %d, %d})", function, path, fds[0], fds[1], fds[2], fds[3]));
+
+	/* Since pprd doesn't keep stdin, stdout, or stderr open, the descriptors
+	   we were given may be among 0 thru 3.  Copy them to higher numbers
+	   so that connecting one can't clobber another.  The copies are closed
+	   at exec() time. */
+	for(x=0; x < CHILD_FDS; x++)
+		{
+		moved[x] = -1;
+		if(fds[x] >= 0)
+			{
+			if((moved[x] = fcntl(fds[x], F_DUPFD, CHILD_FDS)) == -1)
+				{
+				saved_errno = errno;
+				goto cleanup;
+				}
+			gu_set_cloexec(moved[x]);
+			}
+		}
+
+	#ifdef HAVE_POSIX_SPAWN
+	{
+	extern char **environ;
+	posix_spawn_file_actions_t actions;
+	posix_spawnattr_t attr;
+	sigset_t sigset;
+
+	posix_spawn_file_actions_init(&actions);
+	for(x=0; x < CHILD_FDS; x++)
+		{
+		if(moved[x] != -1)
+			posix_spawn_file_actions_adddup2(&actions, moved[x], x);
+		else if(fds[x] == CHILD_DEVNULL)
+			posix_spawn_file_actions_addopen(&actions, x, "/dev/null", O_RDWR, 0);
+		else if(fds[x] == CHILD_LOGFILE && x > 0 && fds[x-1] == CHILD_LOGFILE)
+			posix_spawn_file_actions_adddup2(&actions, x-1, x);
+		else if(fds[x] == CHILD_LOGFILE)
+			posix_spawn_file_actions_addopen(&actions, x, PPRD_LOGFILE, O_WRONLY | O_CREAT | O_APPEND, UNIX_644);
+		}
+
+	/* pprd likely has SIGCHLD and possibly other signals blocked. */
+	posix_spawnattr_init(&attr);
+	sigemptyset(&sigset);
+	posix_spawnattr_setsigmask(&attr, &sigset);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+	if((saved_errno = posix_spawn(&pid, path, &actions, &attr, (char *const *)argv, environ)) != 0)
+		pid = -1;
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+	}
+
+	#else
+	{
+	int report[2];			/* pipe for reporting exec() failure */
+	ssize_t len;
+
+	if(pipe(report) == -1)
+		{
+		saved_errno = errno;
+		goto cleanup;
+		}
+	gu_set_cloexec(report[0]);
+	gu_set_cloexec(report[1]);
 
-	/* Open the indicated file for input.  If that doesn't work, open /dev/null. */
-	if((fd = open(input_file, O_RDONLY)) < 0)
+	if((pid = fork()) == -1)
 		{
-		if((fd = open("/dev/null", O_RDONLY)) < 0)
-			fatal(1, "child: %s(): can't open \"/dev/null\", errno=%d (%s)", function, errno, gu_strerror(errno) );
+		saved_errno = errno;
+		close(report[0]);
+		close(report[1]);
+		goto cleanup;
 		}
 
-	/* If the handle we got was not stdin, make it stdin. */
-	if(fd != 0) dup2(fd, 0);
-	if(fd > 0) close(fd);
+	if(pid == 0)			/* child */
+		{
+		child_unblock_all();
+		for(x=0; x < CHILD_FDS; x++)
+			{
+			int fd = moved[x];
+			if(fds[x] == CHILD_INHERIT)
+				continue;
+			if(fds[x] == CHILD_DEVNULL)
+				fd = open("/dev/null", O_RDWR);
+			else if(fds[x] == CHILD_LOGFILE)
+				fd = open(PPRD_LOGFILE, O_WRONLY | O_CREAT | O_APPEND, UNIX_644);
+			if(fd == -1)
+				break;
+			if(fd != x)
+				{
+				dup2(fd, x);
+				if(moved[x] == -1)
+					close(fd);
+				}
+			}
+		if(x == CHILD_FDS)
+			execv(path, (char *const *)argv);
+		saved_errno = errno;
+		write(report[1], &saved_errno, sizeof(saved_errno));
+		_exit(242);
+		}
 
-	/* Open the second file for output. */
-	if((fd = open(output_file, O_WRONLY | O_CREAT | O_APPEND, UNIX_644)) < 0)
-		fatal(1, "child: %s(): can't open \"%s\", errno=%d (%s)", function, output_file, errno, gu_strerror(errno));
+	/* If exec() succeeds, the pipe is closed without anything having
+	   been written to it. */
+	close(report[1]);
+	while((len = read(report[0], &saved_errno, sizeof(saved_errno))) == -1 && errno == EINTR)
+		;
+	close(report[0]);
+	if(len == sizeof(saved_errno))
+		{
+		waitpid(pid, NULL, 0);
+		pid = -1;
+		}
+	else
+		{
+		saved_errno = 0;
+		}
+	}
+	#endif
+
+	cleanup:
+	for(x=0; x < CHILD_FDS; x++)
+		{
+		if(moved[x] != -1)
+			close(moved[x]);
+		}
+
+	DODEBUG_SPAWN(("%s(): pid=%ld, errno=%d", function, (long)pid, saved_errno));
 
-	/* Connect the second file to stdout and stderr. */
-	if(fd != 1) dup2(fd, 1);
-	if(fd != 2) dup2(fd, 2);
-	if(fd > 2) close(fd);
-	} /* end of child_stdin_stdout_stderr() */
+	errno = saved_errno;
+	return pid;
+	} /* end of child_spawn() */
 
 /*=========================================================================
 ** Lock and unlock those data structures which must not be simultainiously
@@ -176,9 +305,13 @@ static void reapchild(void)
 
 			/* Is it pprd-question? */
 			if(!question_child_hook(pid, wstat))
-				/* Is it a responder? */
-				if(!responder_child_hook(pid, wstat))
-					debug("process %ld unclaimed", (long)pid);
+				/* Is it pprdrv --prerip? */
+				if(!prerip_child_hook(pid, wstat))
+					/* Is it a responder? */
+					if(!responder_child_hook(pid, wstat))
+						/* Is it the SNMP poller's name lookup? */
+						if(!snmp_poller_child_hook(pid, wstat))
+							debug("process %ld unclaimed", (long)pid);
 			}
 		}
 
@@ -214,7 +347,11 @@ static void sigterm_handler(int sig)
 static void tick(void)
 	{
 	printer_tick();
+	dispatch_tick();
+	snmp_poller_tick();
 	question_tick();
+	prerip_tick();
+	journal_checkpoint(FALSE);
 	} /* end of tick() */
 
 /*========================================================================
@@ -350,6 +487,7 @@ static int real_main(int argc, char *argv[])
 	int usock;					/* Unix-domain socket for communicating with ipp */
 	sigset_t lock_set;
 	struct timeval next_tick;	/* time of next call to tick() */
+	struct timeval journal_due;	/* time by which journal records must be committed */
 
 	time(&daemon_start_time);
 
@@ -423,10 +561,13 @@ static int real_main(int argc, char *argv[])
 	** programs that we are starting up.
 	*/
 	debug("PPRD startup, pid=%ld", (long)getpid());
+	board_init();
 	state_update("STARTUP");
 
 	/* Initialize other subsystems. */
 	question_init();
+	prerip_init();
+	responder_init();
 
 	/* Set up the FIFO. */
 	DODEBUG_STARTUP(("opening FIFO"));
@@ -436,10 +577,22 @@ static int real_main(int argc, char *argv[])
 	DODEBUG_STARTUP(("opening Unix-domain socket"));
 	usock = create_unix_socket();
 
+	/* Bring the queue and spool_state files up to date from the journal
+	   before anything is loaded from them. */
+	DODEBUG_STARTUP(("replaying journal"));
+	journal_init();
+
+	/* Start the SNMP poller.  This must come before the printers are loaded. */
+	DODEBUG_STARTUP(("starting SNMP poller"));
+	snmp_poller_init();
+
 	/* Load the printers database. */
 	DODEBUG_STARTUP(("loading printers database"));
 	load_printers();
 
+	/* Learn how fast they print from the print log. */
+	dispatch_init();
+
 	/* Load the groups database. */
 	DODEBUG_STARTUP(("loading groups database"));
 	load_groups();
@@ -474,6 +627,10 @@ static int real_main(int argc, char *argv[])
 
 		gettimeofday(&time_now, NULL);
 
+		/* If the window for batching journal records has closed, commit them. */
+		if(journal_pending(&journal_due) && gu_timeval_cmp(&time_now, &journal_due) >= 0)
+			journal_flush();
+
 		/* If it is time for or past time for the next tick, */
 		if(gu_timeval_cmp(&time_now, &next_tick) >= 0)
 			readyfds = 0;
@@ -484,8 +641,10 @@ static int real_main(int argc, char *argv[])
 			int lastfd;
 
 			/* Set the select() timeout so that it will return in time for the
-			   next tick(). */
+			   next tick() or to commit the journal records, whichever is first. */
 			gu_timeval_cpy(&select_tv, &next_tick);
+			if(journal_pending(&journal_due) && gu_timeval_cmp(&journal_due, &next_tick) < 0)
+				gu_timeval_cpy(&select_tv, &journal_due);
 			gu_timeval_sub(&select_tv, &time_now);
 
 			/* Listen for activity on FIFO or on any listening sockets. */
@@ -496,6 +655,7 @@ static int real_main(int argc, char *argv[])
 			if(usock > lastfd)
 				lastfd = usock;
 			lastfd = listener_fd_set(lastfd, &rfds);
+			lastfd = snmp_poller_fd_set(lastfd, &rfds);
 
 			/* Call select() with SIGCHLD unblocked. */
 			sigprocmask(SIG_UNBLOCK, &lock_set, (sigset_t*)NULL);
@@ -512,6 +672,8 @@ static int real_main(int argc, char *argv[])
 				do_socket_command(usock);
 			else if(listener_hook(readyfds, &rfds))
 				;
+			else if(snmp_poller_hook(readyfds, &rfds))
+				;
 			else
 				fatal(0, "%s(): assertion failed: select() returned but no file descriptor ready", function);
 			continue;
@@ -528,9 +690,13 @@ static int real_main(int argc, char *argv[])
 			}
 
 		/* If there was no error and no file descriptors are ready, then the 
-		   timeout must have expired.  Call tick(). */
+		   timeout must have expired.  If it was the one for the journal,
+		   go back to the top of the loop to commit it, otherwise call tick(). */
 		if(readyfds == 0)
 			{
+			gettimeofday(&time_now, NULL);
+			if(gu_timeval_cmp(&time_now, &next_tick) < 0)
+				continue;
 			tick();
 			next_tick.tv_sec += TICK_INTERVAL;
 			continue;
@@ -546,6 +712,12 @@ static int real_main(int argc, char *argv[])
 
 	state_update("SHUTDOWN");
 
+	/* Write everything out and empty the journal. */
+	journal_checkpoint(TRUE);
+
+	/* Save the queue so that the next pprd can start quickly. */
+	recover_snapshot_save();
+
 	/* We use fatal because it removes the lock file. */
 	fatal(0, "Received SIGTERM, exiting");
 	} /* end of real_main() */
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 30 March 2007.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -28,7 +28,7 @@
 
 #define QUEUE_SIZE_INITIAL 200			/* entries allocated at startup */
 #define QUEUE_SIZE_GROWBY 50			/* additional entries allocated at each overflow */
-#define QUEUE_SIZE_MAX 10000			/* absolute maximum size we will attempt to allocate */
+#define QUEUE_SIZE_MAX 50000			/* absolute maximum size we will attempt to allocate */
 
 /*
 ** These are the pprd debugging options.  Change "#if 0" to "#if 1" to turn 
@@ -56,6 +56,9 @@
 //#define DEBUG_QUESTIONS 1				/* sending questions to job submitters */
 #define DEBUG_IPP 1						/* Internet Printing Protocol operations */
 #define DEBUG_LISTENER 1				/* TCP socket listeners */
+//#define DEBUG_SNMP 1					/* SNMP status poller */
+//#define DEBUG_PRERIP 1				/* pre-RIPing of waiting jobs */
+//#define DEBUG_SPAWN 1					/* launching of child processes */
 #endif
 
 /*
@@ -101,6 +104,79 @@ __attribute__ (( format (printf, 1, 2) ))
 #define ERROR_DIE 0
 #define ERROR_DUMPCORE 100
 
+/* what the SNMP poller knows about a network printer (pprd_snmp.c) */
+#define SNMP_POLLER_BITS 32
+struct PRINTER_SNMP
+	{
+	unsigned long int ip_address;		/* printer's address in network byte order */
+	char *host;							/* name still to be looked up, else NULL */
+	gu_boolean lookup_failed;			/* lookup of host failed and was logged */
+	char *community;					/* SNMP community, NULL for "public" */
+	int request_id;						/* id of query outstanding, 0 if none */
+	time_t last_query;					/* when the last query was sent */
+	time_t last_response;				/* when the last answer came, 0 if never */
+	gu_boolean unsupported;				/* printer lacks the Printer MIB */
+	int hrDeviceStatus;
+	int hrPrinterStatus;
+	unsigned int hrPrinterDetectedErrorState;
+	time_t status_since;				/* when hrDeviceStatus last changed */
+	time_t error_since[SNMP_POLLER_BITS];	/* when each error bit was set */
+	gu_boolean held;					/* TRUE if status bars new jobs */
+	} ;
+
+/* what a printer can print (pprd_capable.c) */
+struct PRINTER_CAPS
+	{
+	void *ppd_info;						/* QUEUE_INFO with PPD facts, NULL if none */
+	int langlevel;						/* PostScript language level, 0 if unknown */
+	gu_boolean color;
+	gu_boolean duplex;
+	gu_boolean duplex_tumble;
+	gu_boolean fax;
+	gu_boolean grayok;					/* "GrayOK:" from the configuration */
+	int limit_pages_lower;				/* "LimitPages:" */
+	int limit_pages_upper;
+	int limit_kilobytes_lower;			/* "LimitKilobytes:" */
+	int limit_kilobytes_upper;
+	} ;
+
+/* what a job needs, from its queue file (pprd_capable.c) */
+struct JOB_CAPS
+	{
+	int screened_pass;					/* pass for which never bits were set, 0 if none */
+	int langlevel;
+	int proofmode;
+	int pages;
+	int kilobytes;
+	gu_boolean color;
+	gu_boolean duplex;
+	gu_boolean duplex_tumble;
+	gu_boolean fax;
+	int font_count;
+	char **fonts;						/* fonts needed which are not in the cache */
+	char **bodies;						/* their digests until capable_job_fonts() */
+	} ;
+
+/* what the size of a job is worked out from (pprd_dispatch.c) */
+struct JOB_SIZE
+	{
+	int pages;							/* from "Attr-Pages:" */
+	int n_up;							/* from "N_Up:" */
+	int copies;							/* from "Opts:" */
+	} ;
+
+/* how far a job has gotten toward having its RIP output saved (pprd_prerip.c) */
+#define PRERIP_NONE 0					/* not attempted yet */
+#define PRERIP_RUNNING 1				/* pprdrv --prerip is running */
+#define PRERIP_DONE 2					/* output saved */
+#define PRERIP_FAILED 3					/* not possible or not worthwhile */
+
+/* what child_spawn() should connect to a child's descriptors 0 thru 3 (pprd.c) */
+#define CHILD_FDS 4						/* stdin, stdout, stderr, and 3 */
+#define CHILD_INHERIT -1				/* whatever pprd has there */
+#define CHILD_DEVNULL -2				/* /dev/null */
+#define CHILD_LOGFILE -3				/* the pprd log file */
+
 /* structure to describe a printer */
 struct Printer
 	{
@@ -119,7 +195,14 @@ struct Printer
 	int job_destid;						/* dest id of the job we are printing */
 	int job_id;							/* queue id of job being printed */
 	int job_subid;						/* queue subid of job being printed */
+	time_t job_started;					/* when pprdrv was started on it */
+	int job_pages;						/* sides in it, -1 if unknown */
+	double dispatch_sides;				/* sides printed, as they count now */
+	double dispatch_seconds;			/* time it took, likewise */
 	pid_t ppop_pid;						/* send SIGUSR1 to this process when stopt */
+	struct PRINTER_SNMP *snmp;			/* SNMP poller state, NULL if not polled */
+	struct PRINTER_CAPS caps;			/* what it can print */
+	gu_boolean no_rip;					/* pprdrv --prerip found no RIP */
 	} ;
 
 /* a group */
@@ -127,10 +210,14 @@ struct Group
 	{
 	char *name;							/* name of group */
 	struct GROUP_SPOOL_STATE spool_state;
-	int printers[MAX_GROUPSIZE];		/* printer id's of members */
+	int *printers;						/* printer id's of members */
 	int members;						/* number of members */
+	int members_space;					/* number of slots in printers[] */
 	int last;							/* member offset of member last used */
 	gu_boolean rotate;					/* TRUE if we should use in rotation */
+	int dispatch;						/* DISPATCH_* policy */
+	int affinity_pages;					/* size of a big job for DISPATCH_AFFINITY */
+	gu_boolean holding;					/* a job is waiting for a busy member */
 	gu_boolean deleted;					/* TRUE if group has been deleted */
 	} ;
 
@@ -257,4 +344,22 @@ struct Group
 #define DODEBUG_LISTENER(a)
 #endif
 
+#ifdef DEBUG_SNMP
+#define DODEBUG_SNMP(a) debug a
+#else
+#define DODEBUG_SNMP(a)
+#endif
+
+#ifdef DEBUG_PRERIP
+#define DODEBUG_PRERIP(a) debug a
+#else
+#define DODEBUG_PRERIP(a)
+#endif
+
+#ifdef DEBUG_SPAWN
+#define DODEBUG_SPAWN(a) debug a
+#else
+#define DODEBUG_SPAWN(a)
+#endif
+
 /* end of file */
@@ -0,0 +1,331 @@
+/*
+** mouse:~ppr/src/pprd/pprd_capable.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This module screens the members of a group for jobs which they can't
+** print so that pprd doesn't start pprdrv only to have check_if_capable()
+** in pprdrv_capable.c turn the job away.
+**
+** When a printer's configuration is loaded, we note the facts from its PPD
+** file and configuration which check_if_capable() considers.  When a job
+** is accepted, or loaded when pprd starts, we note what it needs from its
+** queue file.  Before pprd first tries to start a member of the group for
+** a job in each pass, the never bits of the members which would certainly
+** turn it away are set.
+**
+** Only sure things are screened.  Anything which pprdrv might be able to
+** work around, such as a missing font which font substitution might
+** replace, is left for pprdrv to decide.  If screening would exclude every
+** member, nothing is excluded so that pprdrv runs, explains the problem in
+** the job log, and moves the job on to the next pass or arrests it just as
+** before.
+**
+** The job summaries are allocated with malloc() since jobs may be removed
+** from the queue by ppop commands, during which gu_free() does nothing.
+*/
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "pprd.h"
+#include "pprd.auto_h"
+#include "queueinfo.h"
+
+/*
+** Load the facts about a printer which come from its PPD file.  The
+** configuration file lines have already been read by load_printer().
+*/
+void capable_printer_load(struct Printer *printer)
+	{
+	QUEUE_INFO qip = NULL;
+	const char *fax;
+
+	printer->caps.ppd_info = NULL;
+	printer->caps.langlevel = 0;
+	printer->caps.color = printer->caps.duplex = printer->caps.duplex_tumble = printer->caps.fax = FALSE;
+
+	gu_Try {
+		qip = queueinfo_new_load_config(QUEUEINFO_PRINTER, printer->name);
+		}
+	gu_Catch {
+		error("can't load capabilities of printer \"%s\": %s", printer->name, gu_exception);
+		return;
+		}
+
+	/* Without a PPD file, pprdrv assumes little, so we assume nothing. */
+	if(!queueinfo_ppdLoaded(qip))
+		{
+		queueinfo_free(qip);
+		return;
+		}
+
+	printer->caps.ppd_info = qip;
+	printer->caps.langlevel = queueinfo_psLanguageLevel(qip);
+	printer->caps.color = queueinfo_colorDevice(qip);
+	printer->caps.duplex = queueinfo_duplex(qip);
+	printer->caps.duplex_tumble = queueinfo_duplexTumble(qip);
+	printer->caps.fax = (fax = queueinfo_faxSupport(qip)) && strstr(fax, "Base");
+
+	/* Build the font list now so that looking up fonts later allocates
+	   no memory.  That may happen within a ppop command. */
+	queueinfo_fontCount(qip);
+	} /* end of capable_printer_load() */
+
+/*
+** Discard what capable_printer_load() loaded.
+*/
+void capable_printer_free(struct Printer *printer)
+	{
+	if(printer->caps.ppd_info)
+		{
+		queueinfo_free(printer->caps.ppd_info);
+		printer->caps.ppd_info = NULL;
+		}
+	} /* end of capable_printer_free() */
+
+/*
+** Start a summary of what a job needs.
+*/
+struct JOB_CAPS *capable_job_new(void)
+	{
+	const char function[] = "capable_job_new";
+	struct JOB_CAPS *caps;
+	if(!(caps = calloc(1, sizeof(struct JOB_CAPS))))
+		fatal(0, "%s(): calloc() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+	caps->proofmode = PROOFMODE_SUBSTITUTE;
+	return caps;
+	} /* end of capable_job_new() */
+
+/*
+** Add what a queue file line says to the summary.  The line may be
+** modified.  Since this is called from recover_parse()'s worker threads,
+** it uses malloc() rather than libgu's allocator and leaves looking the
+** fonts up to capable_job_fonts().
+*/
+void capable_job_line(struct JOB_CAPS *caps, char *line)
+	{
+	const char function[] = "capable_job_line";
+	char *p;
+
+	if((p = lmatchp(line, "Res:")))
+		{
+		char *needed, *type, *name, *body = NULL;
+		if(!(needed = gu_strsep(&p, " "))
+				|| !gu_strsep(&p, " ")
+				|| !(type = gu_strsep(&p, " "))
+				|| !(name = gu_strsep_quoted(&p, " ", NULL))
+				|| strcmp(needed, "1") != 0
+				|| strcmp(type, "font") != 0)
+			return;
+		if(gu_strsep(&p, " ") && gu_strsep(&p, " "))
+			body = gu_strsep(&p, " ");
+		if(!(caps->fonts = realloc(caps->fonts, (caps->font_count + 1) * sizeof(char*)))
+				|| !(caps->bodies = realloc(caps->bodies, (caps->font_count + 1) * sizeof(char*)))
+				|| !(caps->fonts[caps->font_count] = strdup(name))
+				|| (body && !(body = strdup(body))))
+			fatal(0, "%s(): out of memory, errno=%d (%s)", function, errno, gu_strerror(errno));
+		caps->bodies[caps->font_count++] = body;
+		}
+	else if((p = lmatchp(line, "Req:")))
+		{
+		if(strcmp(p, "color") == 0)
+			caps->color = TRUE;
+		else if(strcmp(p, "duplex") == 0)
+			caps->duplex = TRUE;
+		else if(strcmp(p, "duplex(tumble)") == 0)
+			caps->duplex_tumble = TRUE;
+		else if(strcmp(p, "fax") == 0)
+			caps->fax = TRUE;
+		}
+	else if(lmatch(line, "Attr-DSC:"))
+		{
+		float dsclevel;
+		int orientation;
+		gu_sscanf(line, "Attr-DSC: %f %*s %d %d", &dsclevel, &orientation, &caps->proofmode);
+		}
+	else if(lmatch(line, "Attr-LangLevel:"))
+		{
+		gu_sscanf(line, "Attr-LangLevel: %d", &caps->langlevel);
+		}
+	else if(lmatch(line, "Attr-Pages:"))
+		{
+		gu_sscanf(line, "Attr-Pages: %d", &caps->pages);
+		}
+	else if(lmatch(line, "Attr-ByteCounts:"))
+		{
+		long input_bytes, postscript_bytes;
+		if(gu_sscanf(line, "Attr-ByteCounts: %ld %ld", &input_bytes, &postscript_bytes) == 2)
+			caps->kilobytes = (int)(postscript_bytes / 1024);
+		}
+	} /* end of capable_job_line() */
+
+/*
+** Drop the fonts which are in the cache or installed on the system so
+** that only those which the printer would have to have remain in the
+** list.  If ppr's automatic cache removed a font, pprdrv will put it back.
+** pprdrv checks the digest, so here we just see if it is there.  This
+** must be called from the main thread once all of the lines are in.
+*/
+void capable_job_fonts(struct JOB_CAPS *caps)
+	{
+	char *found;
+	int x, kept = 0;
+
+	for(x=0; x < caps->font_count; x++)
+		{
+		if((caps->bodies[x] && (found = find_cached_body(caps->bodies[x], FALSE)))
+				|| (found = find_resource("font", caps->fonts[x], 0.0, 0, NULL)))
+			{
+			gu_free(found);
+			free(caps->fonts[x]);
+			}
+		else
+			{
+			caps->fonts[kept++] = caps->fonts[x];
+			}
+		if(caps->bodies[x])
+			free(caps->bodies[x]);
+		}
+
+	caps->font_count = kept;
+	if(caps->bodies)
+		{
+		free(caps->bodies);
+		caps->bodies = NULL;
+		}
+	} /* end of capable_job_fonts() */
+
+/*
+** Discard a job summary.
+*/
+void capable_job_free(struct JOB_CAPS *caps)
+	{
+	int x;
+	for(x=0; x < caps->font_count; x++)
+		{
+		free(caps->fonts[x]);
+		if(caps->bodies && caps->bodies[x])
+			free(caps->bodies[x]);
+		}
+	if(caps->fonts)
+		free(caps->fonts);
+	if(caps->bodies)
+		free(caps->bodies);
+	free(caps);
+	} /* end of capable_job_free() */
+
+/*
+** Return TRUE if check_if_capable() would certainly turn the job away
+** from this printer in the indicated pass.
+*/
+static gu_boolean capable_incapable(const struct Printer *printer, const struct JOB_CAPS *caps, int pass)
+	{
+	/* These rule the printer out no matter what the pass or ProofMode. */
+	if(!caps->color && !printer->caps.grayok)
+		return TRUE;
+	if(caps->pages > 0 && (caps->pages < printer->caps.limit_pages_lower
+			|| (printer->caps.limit_pages_upper > 0 && caps->pages > printer->caps.limit_pages_upper)))
+		return TRUE;
+	if(caps->kilobytes < printer->caps.limit_kilobytes_lower
+			|| (printer->caps.limit_kilobytes_upper > 0 && caps->kilobytes > printer->caps.limit_kilobytes_upper))
+		return TRUE;
+
+	/* The rest come from the PPD file. */
+	if(!printer->caps.ppd_info)
+		return FALSE;
+
+	if(printer->caps.langlevel > 0 && caps->langlevel > printer->caps.langlevel)
+		return TRUE;
+
+	/* Unmet requirements and missing fonts only keep the job off of the
+	   printer during the first pass or if the ProofMode is NotifyMe. */
+	if(pass != 1 && caps->proofmode != PROOFMODE_NOTIFYME)
+		return FALSE;
+
+	if((caps->color && !printer->caps.color)
+			|| (caps->duplex && !printer->caps.duplex)
+			|| (caps->duplex_tumble && !printer->caps.duplex_tumble)
+			|| (caps->fax && !printer->caps.fax))
+		return TRUE;
+
+	/* In Substitute mode pprdrv may find a replacement font. */
+	if(caps->proofmode != PROOFMODE_SUBSTITUTE)
+		{
+		int x;
+		for(x=0; x < caps->font_count; x++)
+			{
+			if(!queueinfo_fontExists(printer->caps.ppd_info, caps->fonts[x]))
+				return TRUE;
+			}
+		}
+
+	return FALSE;
+	} /* end of capable_incapable() */
+
+/*
+** If the job is for a group and its members have not yet been screened
+** for the current pass, set the never bits of those which can't print it.
+** This must be called with the tables locked.
+*/
+void capable_prescreen(struct QEntry *job)
+	{
+	FUNCTION4DEBUG("capable_prescreen")
+	struct Group *group;
+	struct gu_bitset screen;
+	int member, count = 0;
+
+	if(!job->caps || !destid_is_group(job->destid) || job->caps->screened_pass == job->pass)
+		return;
+
+	job->caps->screened_pass = job->pass;
+	group = &groups[destid_to_gindex(job->destid)];
+
+	gu_bitset_init(&screen);
+	for(member=0; member < group->members; member++)
+		{
+		if(!gu_bitset_test(&job->never, member)
+				&& capable_incapable(&printers[group->printers[member]], job->caps, job->pass))
+			{
+			gu_bitset_set(&screen, member);
+			count++;
+			}
+		}
+
+	if(count > 0 && !gu_bitset_all_either(&job->never, &screen, group->members))
+		{
+		for(member=0; member < group->members; member++)
+			{
+			if(gu_bitset_test(&screen, member))
+				gu_bitset_set(&job->never, member);
+			}
+		DODEBUG_PRNSTART(("%s(): %d of %d members of \"%s\" can't print %d in pass %d",
+			function, count, group->members, group->name, job->id, job->pass));
+		}
+
+	gu_bitset_free(&screen);
+	} /* end of capable_prescreen() */
+
+/*
+** Arrange for the job to be screened again, such as when the group's
+** membership changes or its never bits are cleared.
+*/
+void capable_rescreen(struct QEntry *job)
+	{
+	if(job->caps)
+		job->caps->screened_pass = 0;
+	} /* end of capable_rescreen() */
+
+/* end of file */
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 13 June 2008.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -162,37 +162,29 @@ int destid_get_member_offset(int destid, int prnid)
 	} /* end of destid_get_member_offset() */
 
 /*
-** Get the bitmask which identifies a particular printer in the "never" and
-** "notnow" bit fields of jobs with a certain destination id.
+** Get the number of the bit which identifies a particular printer in the
+** "never" and "notnow" bitsets of jobs with a certain destination id.
 **
 ** If the printer is not included in the specified destination (i.e. the
 ** destination id is not the printer id and is not that of a group containing
-** the printer) then, return 0.
+** the printer) then, return -1.
 **
-** If the destination is the printer, return 1.
+** If the destination is the printer, return 0.
 */
-int destid_printer_bit(int destid, int prnid)
+int destid_printer_bitnum(int destid, int prnid)
 	{
-	int off;
-
-	/* If the destination is the printer, set bit one. */
+	/* If the destination is the printer, use bit zero. */
 	if(prnid == destid)
-		return 1;
-
-	/* If not but the destination is a printer, set no bits. */
-	if(!destid_is_group(destid))
 		return 0;
 
-	/* Since it is a group, get the bit number. */
-	off = destid_get_member_offset(destid , prnid);
-
-	/* If the printer is not a member, set no bits. */
-	if(off == -1)
-		return 0;
+	/* If not but the destination is a printer, there is no bit. */
+	if(!destid_is_group(destid))
+		return -1;
 
-	/* It is a member, set the correct bit. */
-	return 1 << off;
-	} /* end of destid_printer_bit() */
+	/* Since it is a group, the bit number is the member offset,
+	   or -1 if the printer is not a member. */
+	return destid_get_member_offset(destid, prnid);
+	} /* end of destid_printer_bitnum() */
 
 /*
 ** Convert a destination id to a group array index.
@@ -0,0 +1,346 @@
+/*
+** mouse:~ppr/src/pprd/pprd_dispatch.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This module decides which members of a group should be offered a group
+** job.  The policies themselves are in libppr/group_dispatch.c.  Here we
+** gather what they need to know about each member: whether it is idle, how
+** many pages it has to print before it could get to the job, and how fast
+** it prints.
+**
+** Printing speed is measured in printed sides per minute.  It is learned
+** from the time each pprdrv takes to print a job and, at startup, from the
+** recent records in the structured print log.  Older measurements count
+** for less and less.  The number of pages remaining in the job a member is
+** printing comes from the progress figures which pprdrv puts on the status
+** board.
+**
+** pprd doesn't give printers queues of their own, so the pages a member
+** must print first are the rest of the job it is printing plus the waiting
+** jobs ahead of this one in the queue which it would take first: those
+** sent to it directly and those for the same group.  If a policy decides
+** that a job should wait for a busy member, the group is marked and the
+** decision is reconsidered at every tick.  A member which has been printing
+** for much longer than expected or which is in any state but idle or
+** printing is not waited for.
+*/
+
+#include "config.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "pprd.h"
+#include "./pprd.auto_h"
+#include "group_dispatch.h"
+
+/* How many print log records to learn from at startup? */
+#define HISTORY_RECORDS 2000
+
+/* How much does each measurement count for compared to the next one? */
+#define DECAY 0.9
+
+/* A busy member isn't waited for once it has taken this many times as
+   long as expected, plus this many seconds. */
+#define OVERDUE_FACTOR 2
+#define OVERDUE_GRACE 60
+
+/*
+** Add a measurement of how long a printer took to print a job.
+*/
+static void learn(int prnid, int sides, double seconds)
+	{
+	struct Printer *printer = &printers[prnid];
+	if(sides <= 0 || seconds < 1.0)
+		return;
+	printer->dispatch_sides = printer->dispatch_sides * DECAY + sides;
+	printer->dispatch_seconds = printer->dispatch_seconds * DECAY + seconds;
+	}
+
+/*
+** Return the measured speed of a printer in sides per minute, 0.0 if
+** it hasn't been measured.
+*/
+static double printer_ppm(int prnid)
+	{
+	struct Printer *printer = &printers[prnid];
+	if(printer->dispatch_seconds <= 0.0)
+		return 0.0;
+	return printer->dispatch_sides * 60.0 / printer->dispatch_seconds;
+	}
+
+/*
+** Learn the speed of the printers from the most recent records in the
+** structured print log, if there is one.  This is called once the printers
+** have been loaded.
+*/
+void dispatch_init(void)
+	{
+	char fname[MAX_PPR_PATH];
+	struct PRINTLOG_RECORD record;
+	struct stat statbuf;
+	off_t records;
+	int fd, prnid;
+
+	ppr_fnamef(fname, "%s/%s", PRINTLOG_DIR, PRINTLOG_CURRENT);
+	if((fd = open(fname, O_RDONLY)) == -1)
+		return;
+
+	if(fstat(fd, &statbuf) == 0)
+		{
+		records = statbuf.st_size / sizeof(record);
+		if(records > HISTORY_RECORDS)
+			lseek(fd, (records - HISTORY_RECORDS) * sizeof(record), SEEK_SET);
+		while(read(fd, &record, sizeof(record)) == sizeof(record))
+			{
+			if(record.magic != PRINTLOG_MAGIC)
+				break;
+			record.printer[sizeof(record.printer) - 1] = '\0';
+			if((prnid = destid_by_printer(record.printer)) != -1)
+				learn(prnid, record.sides, record.run_time / 100.0);
+			}
+		}
+
+	close(fd);
+	} /* end of dispatch_init() */
+
+/*
+** Forget what was learned about a printer.  This is called when a slot
+** which belonged to a deleted printer is given to a new one.
+*/
+void dispatch_printer_new(int prnid)
+	{
+	printers[prnid].dispatch_sides = 0.0;
+	printers[prnid].dispatch_seconds = 0.0;
+	}
+
+/*
+** These are called by pprdrv_start() and by pprdrv_exited() when the job
+** was printed.
+*/
+void dispatch_started(int prnid, struct QEntry *job)
+	{
+	printers[prnid].job_started = time(NULL);
+	printers[prnid].job_pages = job->pages;
+	}
+
+void dispatch_printed(int prnid)
+	{
+	learn(prnid, printers[prnid].job_pages, (double)(time(NULL) - printers[prnid].job_started));
+	}
+
+/*
+** The size of a job is worked out from these lines of its queue file.
+** These functions must not use the libgu memory allocator since they are
+** also called from recover_parse().
+*/
+void dispatch_size_init(struct JOB_SIZE *size)
+	{
+	size->pages = -1;
+	size->n_up = 1;
+	size->copies = 1;
+	}
+
+gu_boolean dispatch_size_line(struct JOB_SIZE *size, const char line[])
+	{
+	switch(line[0])
+		{
+		case 'A':
+			return gu_sscanf(line, "Attr-Pages: %d", &size->pages) == 1;
+		case 'N':
+			return gu_sscanf(line, "N-Up: %d", &size->n_up) == 1;
+		case 'O':
+			{
+			int binselect;
+			return gu_sscanf(line, "Opts: %d %d", &binselect, &size->copies) == 2;
+			}
+		}
+	return FALSE;
+	}
+
+/* Return the number of printed sides, as in the print log. */
+int dispatch_size_pages(const struct JOB_SIZE *size)
+	{
+	int n_up = size->n_up > 0 ? size->n_up : 1;
+	if(size->pages < 0)
+		return -1;
+	return (size->pages + n_up - 1) / n_up * (size->copies > 1 ? size->copies : 1);
+	}
+
+/*
+** Return the number of pages a member has left to print of the job it is
+** printing, or -1 if it shouldn't be waited for.
+*/
+static int member_remaining(int prnid, time_t now)
+	{
+	struct Printer *printer = &printers[prnid];
+	double ppm;
+	int started;
+
+	if(printer->spool_state.status != PRNSTATUS_PRINTING || printer->job_pages < 0)
+		return -1;
+
+	if((ppm = printer_ppm(prnid)) > 0.0
+			&& (now - printer->job_started) > OVERDUE_FACTOR * printer->job_pages * 60.0 / ppm + OVERDUE_GRACE)
+		return -1;
+
+	if((started = board_printer_pages_started(prnid)) < 0)
+		started = 0;
+
+	return started < printer->job_pages ? printer->job_pages - started : 0;
+	}
+
+/*
+** Put the offsets of the members of the job's group which should be offered
+** it into order[], which must have room for all of them, in the order in
+** which they should be tried.  The number of them is returned.  If the job
+** should wait for a busy member, -1 is returned and the group is marked so
+** that dispatch_tick() will look at it again.
+*/
+int dispatch_order(struct QEntry *job, int order[])
+	{
+	int gindex = destid_to_gindex(job->destid);
+	struct Group *cl = &groups[gindex];
+	struct DISPATCH_MEMBER *members;
+	int count = 0, x, y;
+
+	members = (struct DISPATCH_MEMBER *)gu_alloc(cl->members + 1, sizeof(struct DISPATCH_MEMBER));
+
+	for(x=0; x < cl->members; x++)
+		{
+		int prnid = cl->printers[x];
+
+		if(gu_bitset_test(&job->never, x) || gu_bitset_test(&job->notnow, x))
+			continue;
+
+		members[count].member = x;
+		members[count].ppm = printer_ppm(prnid);
+
+		/* The old policies leave it to printer_start() to decide whether
+		   the printer can start the job. */
+		if(cl->dispatch == DISPATCH_ORDER || cl->dispatch == DISPATCH_ROTATE)
+			members[count].idle = TRUE;
+		else
+			members[count].idle = printers[prnid].spool_state.status == PRNSTATUS_IDLE && !snmp_poller_held(prnid);
+
+		members[count].outstanding = 0;
+		count++;
+		}
+
+	/* The policies which care what the members have to do first
+	   need to know what is ahead of this job. */
+	if(cl->dispatch != DISPATCH_ORDER && cl->dispatch != DISPATCH_ROTATE)
+		{
+		time_t now = time(NULL);
+		int position = (job >= queue && job < queue + queue_entries) ? job - queue : queue_entries;
+		int ahead_group = 0;
+
+		for(x=0; x < count; x++)
+			{
+			if(!members[x].idle)
+				members[x].outstanding = member_remaining(cl->printers[members[x].member], now);
+			}
+
+		for(y=0; y < position; y++)
+			{
+			struct QEntry *q = &queue[y];
+			if(q->status != STATUS_WAITING)
+				continue;
+			if(q->destid == job->destid)
+				{
+				if(ahead_group != -1)
+					ahead_group = q->pages < 0 ? -1 : ahead_group + q->pages;
+				continue;
+				}
+			if(!destid_is_printer(q->destid))
+				continue;
+			for(x=0; x < count; x++)
+				{
+				if(cl->printers[members[x].member] == q->destid)
+					{
+					if(!members[x].idle && members[x].outstanding != -1)
+						members[x].outstanding = q->pages < 0 ? -1 : members[x].outstanding + q->pages;
+					break;
+					}
+				}
+			}
+
+		for(x=0; x < count; x++)
+			{
+			if(!members[x].idle && members[x].outstanding != -1)
+				members[x].outstanding = ahead_group < 0 ? -1 : members[x].outstanding + ahead_group;
+			}
+		}
+
+	count = dispatch_choose(cl->dispatch, cl->affinity_pages, cl->last, cl->members, members, count, job->pages);
+
+	for(x=0; x < count; x++)
+		order[x] = members[x].member;
+
+	gu_free(members);
+
+	if(count == -1)
+		cl->holding = TRUE;
+
+	return count;
+	} /* end of dispatch_order() */
+
+/*
+** This is called by printer_look_for_work() when it comes to a group job
+** which prnid could print.  It returns TRUE if the job should instead wait
+** for a busy member.
+*/
+gu_boolean dispatch_holds(struct QEntry *job, int prnid)
+	{
+	struct Group *cl = &groups[destid_to_gindex(job->destid)];
+	int bitnum, *order, ret;
+
+	if(cl->dispatch != DISPATCH_THROUGHPUT && cl->dispatch != DISPATCH_AFFINITY)
+		return FALSE;
+	if(job->pages <= 0 || (cl->dispatch == DISPATCH_AFFINITY && job->pages < cl->affinity_pages))
+		return FALSE;
+
+	/* If printer_start() will turn it down anyway, don't bother. */
+	if((bitnum = destid_printer_bitnum(job->destid, prnid)) == -1)
+		return FALSE;
+	if(gu_bitset_test(&job->never, bitnum) || gu_bitset_test(&job->notnow, bitnum))
+		return FALSE;
+
+	order = (int*)gu_alloc(cl->members + 1, sizeof(int));
+	ret = dispatch_order(job, order);
+	gu_free(order);
+
+	return ret == -1;
+	} /* end of dispatch_holds() */
+
+/*
+** This is called every TICK_INTERVAL seconds.  If any job is waiting for a
+** busy member of a group, see if it should still wait.
+*/
+void dispatch_tick(void)
+	{
+	int x;
+	for(x=0; x < group_count; x++)
+		{
+		if(groups[x].holding && !groups[x].deleted)
+			{
+			groups[x].holding = FALSE;
+			group_look_for_work(x);
+			}
+		}
+	} /* end of dispatch_tick() */
+
+/* end of file */
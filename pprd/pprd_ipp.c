@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 1 June 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -520,6 +520,13 @@ struct PPRD_CALL_RETVAL cups_move_job(const char command_args[])
 					destid_to_name(new_destid),
 					rank2++);
 
+			/* Changes to the queue file which are still in the journal
+			   must be made before it is renamed. */
+			journal_checkpoint(FALSE);
+
+			/* Output pre-RIPed for the old printer is no good. */
+			prerip_forget(q);
+
 			/* Rename the queue file. */
 			ppr_fnamef(oldname,"%s/%s-%d.%d", QUEUEDIR,
 				destid_to_name(q->destid),q->id,q->subid);
@@ -529,7 +536,7 @@ struct PPRD_CALL_RETVAL cups_move_job(const char command_args[])
 
 			/* Rename all of the data files. */
 			{
-			char *list[] = {"comments", "pages", "text", "log", "infile", "barbar", NULL};
+			char *list[] = {"spool", "comments", "pages", "text", "log", "infile", "barbar", "rip", NULL};
 			int x;
 			for(x=0; list[x]; x++)
 				{
@@ -573,6 +580,7 @@ struct PPRD_CALL_RETVAL cups_move_job(const char command_args[])
 		** after the rename code or the rename code will break.
 		*/
 		q->destid = new_destid;
+		board_job(q);
 
 		/* If this job was stranded, maybe it will print here. */
 		if(q->status == STATUS_STRANDED)
@@ -582,7 +590,8 @@ struct PPRD_CALL_RETVAL cups_move_job(const char command_args[])
 		** Clear any "never" (printer unsuitable) flags, set new "notnow" 
 		** (required media not present) flags, and update the job status.
 		*/
-		q->never = 0;
+		gu_bitset_clear_all(&q->never);
+		capable_rescreen(q);
 
 		/* Reset pass number just like in queue_insert(). */
 		if(destid_is_group(q->destid))
@@ -0,0 +1,463 @@
+/*
+** mouse:~ppr/src/pprd/pprd_journal.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This module keeps a write-ahead journal of pprd's state changes.
+**
+** pprd used to rewrite the "PPRD:" line of a job's queue file every time
+** the job changed status and rewrite a printer's or group's spool_state
+** file every time its job count changed.  Now each such change is appended
+** to the journal (PPRD_JOURNAL) instead.  Records are collected for a short
+** window ("journal window" in the [spooler] section of ppr.conf, in
+** milliseconds) and then written and fsync()ed together.  A state change
+** is therefore on disk at most one window after it is made.
+**
+** As soon as a batch has been committed, the files are brought up to date
+** (but not fsync()ed), so that other programs which read them, and pprd
+** itself when it reloads a printer or group, see the changes.  Those files
+** which have been rewritten are fsync()ed and the journal is emptied when
+** it grows too large and when pprd shuts down.  At startup the journal is
+** replayed against the files before anything is loaded from them.
+**
+** Each record is a line consisting of a letter, a space, a file name, a tab,
+** and the data.  The letters are:
+**
+**	H	overwrite the start of the file with the data (a "PPRD:" line)
+**	R	replace the contents of the file with the data (a spool_state file)
+**	D	the file was removed, forget any earlier records for it
+*/
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "pprd.h"
+#include "pprd.auto_h"
+
+#define JOURNAL_MAX_SIZE 262144			/* empty the journal when it gets this big */
+#define JOURNAL_BUCKETS 256
+
+struct JOURNAL_PENDING {
+	char mode;							/* 'H' or 'R' */
+	char *path;							/* also the hash key */
+	char *data;
+	};
+
+/*
+** A file which the journal has changed since it was last emptied.  If data
+** is not NULL, the change has not yet been made.  These are allocated with
+** malloc() rather than gu_alloc() because journal_record() is often called
+** from within ppop commands and anything allocated with gu_alloc() there
+** belongs to the memory pool which ppop_dispatch() frees when the command
+** is done.
+*/
+struct JOURNAL_FILE {
+	struct JOURNAL_FILE *next;
+	char mode;							/* 'H' or 'R' */
+	char *data;							/* change to make or NULL */
+	char path[1];						/* extends past end */
+	};
+
+static int journal_fd = -1;
+static off_t journal_size = 0;
+static int journal_window = 50;			/* milliseconds */
+static char *batch = NULL;				/* records not yet written */
+static int batch_len = 0;
+static int batch_space = 0;
+static struct timeval batch_due;		/* when the batch must be committed */
+static struct JOURNAL_FILE *files[JOURNAL_BUCKETS];	/* files changed since the journal was emptied */
+static int pending_count = 0;			/* how many of them have data */
+
+/*
+** Apply one record to its file.  Files which are missing are left alone
+** since the job or destination has been deleted.
+*/
+static void journal_apply(char mode, const char path[], const char data[], gu_boolean sync)
+	{
+	int fd;
+	int len = strlen(data);
+
+	if(mode == 'H')
+		fd = open(path, O_WRONLY);
+	else
+		fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, UNIX_644);
+
+	if(fd == -1)
+		{
+		if(errno != ENOENT)
+			error("can't open \"%s\", errno=%d (%s)", path, errno, gu_strerror(errno));
+		return;
+		}
+
+	if(write(fd, data, len) != len)
+		error("write() to \"%s\" failed, errno=%d (%s)", path, errno, gu_strerror(errno));
+	if(sync)
+		fsync(fd);
+	close(fd);
+	} /* end of journal_apply() */
+
+/*
+** Read the journal left by the last run of pprd and apply what it says to
+** the files, then empty it.  Later records for the same file supersede
+** earlier ones.  A partial record at the end (from a crash in the middle of
+** a write) is ignored.
+*/
+static void journal_replay(void)
+	{
+	const char function[] = "journal_replay";
+	struct stat statbuf;
+	char *buffer, *line, *end;
+	void *latest = gu_pch_new(JOURNAL_BUCKETS);
+	int count = 0;
+
+	/* The journal is read whole since it is never allowed to grow very large
+	   and since the whitespace at the ends of the records is significant. */
+	if(fstat(journal_fd, &statbuf) == -1)
+		fatal(0, "%s(): fstat() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+	buffer = gu_alloc(statbuf.st_size + 1, sizeof(char));
+	if(pread(journal_fd, buffer, statbuf.st_size, 0) != statbuf.st_size)
+		fatal(0, "%s(): can't read \"%s\", errno=%d (%s)", function, PPRD_JOURNAL, errno, gu_strerror(errno));
+	buffer[statbuf.st_size] = '\0';
+
+	for(line = buffer; (end = strchr(line, '\n')); line = end + 1)
+		{
+		char *path, *data;
+		struct JOURNAL_PENDING *p;
+
+		*end = '\0';
+		if(strlen(line) < 3 || line[1] != ' ' || !(data = strchr(line + 2, '\t')))
+			{
+			error("%s(): ignoring malformed record: %s", function, line);
+			continue;
+			}
+		*data++ = '\0';
+		path = line + 2;
+		count++;
+
+		if(line[0] == 'D')
+			{
+			if((p = gu_pch_delete(latest, path)))
+				{
+				gu_free(p->path);
+				gu_free(p->data);
+				gu_free(p);
+				}
+			continue;
+			}
+
+		if((p = gu_pch_get(latest, path)))
+			{
+			gu_free(p->data);
+			}
+		else
+			{
+			p = gu_alloc(1, sizeof(struct JOURNAL_PENDING));
+			p->path = gu_strdup(path);
+			gu_pch_set(latest, p->path, p);
+			}
+		p->mode = line[0];
+		gu_asprintf(&p->data, "%s\n", data);
+		}
+
+	gu_free(buffer);
+
+	if(count > 0)
+		{
+		char *key;
+		struct JOURNAL_PENDING *p;
+		debug("replaying %d journal records", count);
+		gu_pch_rewind(latest);
+		while((key = gu_pch_nextkey(latest, (void**)&p)))
+			{
+			journal_apply(p->mode, p->path, p->data, TRUE);
+			gu_free(p->path);
+			gu_free(p->data);
+			gu_free(p);
+			}
+		}
+	gu_pch_free(latest);
+
+	if(ftruncate(journal_fd, 0) == -1 || fsync(journal_fd) == -1)
+		fatal(0, "%s(): can't empty \"%s\", errno=%d (%s)", function, PPRD_JOURNAL, errno, gu_strerror(errno));
+	lseek(journal_fd, 0, SEEK_SET);
+	journal_size = 0;
+	} /* end of journal_replay() */
+
+/*
+** Open the journal and replay it.  This must be called before anything
+** is loaded from the queue files or the spool_state files.
+*/
+void journal_init(void)
+	{
+	const char function[] = "journal_init";
+	char *p;
+
+	if((p = gu_ini_query(PPR_CONF, "spooler", "journalwindow", 0, NULL)))
+		{
+		journal_window = atoi(p);
+		if(journal_window < 0)
+			journal_window = 0;
+		gu_free(p);
+		}
+
+	if((journal_fd = open(PPRD_JOURNAL, O_RDWR | O_CREAT | O_APPEND, UNIX_644)) == -1)
+		fatal(0, "%s(): can't open \"%s\", errno=%d (%s)", function, PPRD_JOURNAL, errno, gu_strerror(errno));
+	gu_set_cloexec(journal_fd);
+
+	journal_replay();
+	} /* end of journal_init() */
+
+/*
+** Find a file in the table.  If it is not there and create is TRUE, add it.
+** If prev is not NULL, it is set to the link which points to the entry.
+*/
+static struct JOURNAL_FILE *journal_lookup(const char path[], gu_boolean create, struct JOURNAL_FILE ***prev)
+	{
+	const char function[] = "journal_lookup";
+	unsigned int hash = 0;
+	const char *s;
+	struct JOURNAL_FILE **pp, *f;
+
+	for(s = path; *s; s++)
+		hash = hash * 31 + (unsigned char)*s;
+
+	for(pp = &files[hash % JOURNAL_BUCKETS]; (f = *pp); pp = &f->next)
+		{
+		if(strcmp(f->path, path) == 0)
+			break;
+		}
+
+	if(!f && create)
+		{
+		if(!(f = malloc(sizeof(struct JOURNAL_FILE) + strlen(path))))
+			fatal(0, "%s(): malloc() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+		f->next = NULL;
+		f->mode = '\0';
+		f->data = NULL;
+		strcpy(f->path, path);
+		*pp = f;
+		}
+
+	if(prev)
+		*prev = pp;
+	return f;
+	} /* end of journal_lookup() */
+
+/*
+** Add a record to the batch.  If this is the first record, start the
+** window at the end of which the batch will be committed.
+*/
+static void journal_append(char mode, const char path[], const char data[])
+	{
+	const char function[] = "journal_append";
+	int len = strlen(path) + strlen(data) + 4;
+
+	if(batch_len + len > batch_space)
+		{
+		batch_space = (batch_len + len) * 2;
+		if(!(batch = realloc(batch, batch_space)))		/* not gu_realloc(), see above */
+			fatal(0, "%s(): realloc() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+		}
+
+	if(batch_len == 0)
+		{
+		struct timeval window;
+		gettimeofday(&batch_due, NULL);
+		window.tv_sec = journal_window / 1000;
+		window.tv_usec = (journal_window % 1000) * 1000;
+		gu_timeval_add(&batch_due, &window);
+		}
+
+	/* The data of 'H' and 'R' records already ends with a newline. */
+	batch_len += gu_snprintf(batch + batch_len, batch_space - batch_len, "%c %s\t%s", mode, path, data);
+	if(batch[batch_len - 1] != '\n')
+		batch[batch_len++] = '\n';
+
+	if(journal_window == 0)
+		journal_flush();
+	} /* end of journal_append() */
+
+/*
+** Note that a file must be changed.  The change is journaled now and
+** made when the batch is committed.
+*/
+static void journal_record(char mode, const char path[], const char data[])
+	{
+	const char function[] = "journal_record";
+	struct JOURNAL_FILE *f;
+
+	if(journal_fd == -1)				/* not yet initialized */
+		{
+		journal_apply(mode, path, data, FALSE);
+		return;
+		}
+
+	f = journal_lookup(path, TRUE, NULL);
+	if(f->data)
+		free(f->data);
+	else
+		pending_count++;
+	f->mode = mode;
+	if(!(f->data = strdup(data)))
+		fatal(0, "%s(): strdup() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+
+	/* This may commit the batch at once, so it comes last. */
+	journal_append(mode, path, data);
+	} /* end of journal_record() */
+
+/*
+** Journal a new "PPRD:" line for a queue file.
+*/
+void journal_write_head(const char path[], const char data[])
+	{
+	journal_record('H', path, data);
+	}
+
+/*
+** Journal new contents for a small file.
+*/
+void journal_write_file(const char path[], const char data[])
+	{
+	journal_record('R', path, data);
+	}
+
+/*
+** Journal the removal of a queue file so that earlier changes to it
+** won't be applied to a new job which gets the same name.
+*/
+void journal_forget(const char path[])
+	{
+	struct JOURNAL_FILE *f, **prev;
+
+	if(journal_fd == -1)
+		return;
+
+	if((f = journal_lookup(path, FALSE, &prev)))
+		{
+		*prev = f->next;
+		if(f->data)
+			{
+			free(f->data);
+			pending_count--;
+			}
+		free(f);
+		}
+
+	journal_append('D', path, "");
+	} /* end of journal_forget() */
+
+/*
+** If there is a batch waiting to be committed, set *when to the time
+** when it should be and return TRUE.
+*/
+gu_boolean journal_pending(struct timeval *when)
+	{
+	if(batch_len == 0)
+		return FALSE;
+	gu_timeval_cpy(when, &batch_due);
+	return TRUE;
+	}
+
+/*
+** Write the batch to the journal and fsync() it, then make the changes
+** which it describes.
+*/
+void journal_flush(void)
+	{
+	const char function[] = "journal_flush";
+	struct JOURNAL_FILE *f;
+	int written;
+	int x;
+
+	if(batch_len > 0)
+		{
+		if((written = write(journal_fd, batch, batch_len)) != batch_len)
+			fatal(0, "%s(): write() to \"%s\" failed, errno=%d (%s)", function, PPRD_JOURNAL, errno, gu_strerror(errno));
+		#ifdef HAVE_FDATASYNC
+		fdatasync(journal_fd);
+		#else
+		fsync(journal_fd);
+		#endif
+
+		journal_size += batch_len;
+		batch_len = 0;
+		}
+
+	if(pending_count > 0)
+		{
+		for(x=0; x < JOURNAL_BUCKETS; x++)
+			{
+			for(f = files[x]; f; f = f->next)
+				{
+				if(f->data)
+					{
+					journal_apply(f->mode, f->path, f->data, FALSE);
+					free(f->data);
+					f->data = NULL;
+					}
+				}
+			}
+		pending_count = 0;
+		}
+	} /* end of journal_flush() */
+
+/*
+** Commit the batch and bring the files up to date.  This must be called
+** before pprd itself reads or renames any of the files.  If the journal
+** has grown too large or final is TRUE, fsync() the files and empty the
+** journal.
+*/
+void journal_checkpoint(gu_boolean final)
+	{
+	const char function[] = "journal_checkpoint";
+	struct JOURNAL_FILE *f;
+	int x;
+
+	if(journal_fd == -1)
+		return;
+
+	journal_flush();
+
+	if(final || journal_size > JOURNAL_MAX_SIZE)
+		{
+		/* The files must reach the disk before the journal which
+		   describes the changes to them is emptied. */
+		for(x=0; x < JOURNAL_BUCKETS; x++)
+			{
+			while((f = files[x]))
+				{
+				int fd;
+				if((fd = open(f->path, O_RDONLY)) != -1)
+					{
+					fsync(fd);
+					close(fd);
+					}
+				files[x] = f->next;
+				free(f);
+				}
+			}
+
+		if(ftruncate(journal_fd, 0) == -1)
+			error("%s(): can't empty \"%s\", errno=%d (%s)", function, PPRD_JOURNAL, errno, gu_strerror(errno));
+		journal_size = 0;
+		}
+	} /* end of journal_checkpoint() */
+
+/* end of file */
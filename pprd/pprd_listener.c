@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 30 March 2007.
+** Last modified 19 October 2026.
 */
 
 /*! \file
@@ -151,10 +151,9 @@ int listener_fd_set(int lastfd, fd_set *fdset)
 	}
 
 /*
-** This function is called by the daemon.  It never returns to main()
-** in the daemon, but every time a connexion is received it forks a child,
-** connects stdin, stdout, and stderr to the connexion, and returns to main()
-** in the child.
+** This function is called by the daemon.  Every time a connexion is
+** received it starts the listener's program with stdin, stdout, and stderr
+** connected to the connexion.
 */
 gu_boolean listener_hook(int selret, fd_set *fdset)
 	{
@@ -185,39 +184,21 @@ gu_boolean listener_hook(int selret, fd_set *fdset)
 		DODEBUG_LISTENER(("%s(): connection to %s from %s", function, listeners[iii].program, inet_ntoa(cli_addr.sin_addr)));
 		}
 	
+		/* Connect the connexion to stdin, stdout, and stderr. */
 		{
+		const char *args[] = {listeners[iii].program, NULL};
+		const int fds[CHILD_FDS] = {conn_fd, conn_fd, conn_fd, CHILD_INHERIT};
 		pid_t pid;
-		if((pid = fork()) == -1)		/* error, */
+		if((pid = child_spawn(listeners[iii].program, args, fds)) == -1)
 			{
-			DODEBUG_LISTENER(("%s(): fork() failed, errno=%d (%s)", function, errno, gu_strerror(errno)));
+			DODEBUG_LISTENER(("%s(): can't start %s, errno=%d (%s)", function, listeners[iii].program, errno, gu_strerror(errno)));
 			}
-		else if(pid == 0)				/* child */
-			{
-			/* Why do we have to do this? */
-			/* On Linux it produces the message "Can't ignore signal CHLD, forcing to default." */
-			/*signal_restarting(SIGCHLD, SIG_IGN);*/
-
-			/* Connect connexion to stdin if it isn't already.
-			 * We really on our caller to connect it to stdout too.
-			 */
-			if(conn_fd != 0)
-				{
-				dup2(conn_fd, 0);
-				close(conn_fd);
-				}
-			dup2(0, 1);		/* stdout */
-			dup2(0, 2);		/* stderr */
-
-			execl(listeners[iii].program, listeners[iii].program, NULL);
-			_exit(242);
-			}
-		else							/* parent */
+		else
 			{
 			DODEBUG_LISTENER(("%s(): inet child %ld launched", function, (long)pid));
 			}
 		}
 
-		/* parent or fork() failed */	
 		close(conn_fd);
 		}
 
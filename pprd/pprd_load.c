@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 20 July 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -22,6 +22,7 @@
 #include <errno.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <sys/time.h>
 #include <ctype.h>
 #include <stdlib.h>
 #ifdef INTERNATIONAL
@@ -32,6 +33,54 @@
 #include "global_structs.h"
 #include "pprd.h"
 #include "./pprd.auto_h"
+#include "group_dispatch.h"
+
+#define PRINTERS_GROWBY 64		/* printer array slots to add at a time */
+#define GROUPS_GROWBY 16		/* group array slots to add at a time */
+#define MEMBERS_GROWBY 8		/* group member slots to add at a time */
+
+static int printers_space = 0;	/* number of slots in printers[] */
+static int groups_space = 0;	/* number of slots in groups[] */
+
+/*
+** Make sure there is a slot for printer number prnid.  New slots are zeroed.
+** Returns -1 if prnid is too large to be a printer destination id.
+*/
+static int printers_grow(int prnid)
+	{
+	if(prnid >= MAX_PRINTERS)
+		return -1;
+	if(prnid >= printers_space)
+		{
+		int new_space = printers_space + PRINTERS_GROWBY;
+		if(new_space > MAX_PRINTERS)
+			new_space = MAX_PRINTERS;
+		printers = (struct Printer*)gu_realloc(printers, new_space, sizeof(struct Printer));
+		memset(&printers[printers_space], 0, (new_space - printers_space) * sizeof(struct Printer));
+		printers_space = new_space;
+		}
+	return 0;
+	}
+
+/*
+** Make sure there is a slot for group number gindex.  New slots are zeroed.
+** Returns -1 if gindex is too large to be encoded in a destination id.
+*/
+static int groups_grow(int gindex)
+	{
+	if(gindex >= MAX_GROUPS)
+		return -1;
+	if(gindex >= groups_space)
+		{
+		int new_space = groups_space + GROUPS_GROWBY;
+		if(new_space > MAX_GROUPS)
+			new_space = MAX_GROUPS;
+		groups = (struct Group*)gu_realloc(groups, new_space, sizeof(struct Group));
+		memset(&groups[groups_space], 0, (new_space - groups_space) * sizeof(struct Group));
+		groups_space = new_space;
+		}
+	return 0;
+	}
 
 /*
 ** Load the data on a single printer into the array.
@@ -45,6 +94,8 @@ static void load_printer(struct Printer *printer, const char prnname[])
 	char *line = NULL;
 	int line_space = 128;
 	int count; float x1, x2;
+	char *interface = NULL, *address = NULL, *options = NULL;
+	char *p;
 
 	{
 	char fname[MAX_PPR_PATH];
@@ -65,6 +116,12 @@ static void load_printer(struct Printer *printer, const char prnname[])
 	printer->nbins = 0;					/* start with zero bins */
 	printer->AutoSelect_exists = FALSE;	/* start with no "AutoSelect" bin */
 
+	printer->caps.grayok = TRUE;		/* most printers allow non-colour jobs */
+	printer->caps.limit_pages_lower = printer->caps.limit_pages_upper = 0;
+	printer->caps.limit_kilobytes_lower = printer->caps.limit_kilobytes_upper = 0;
+
+	printer->no_rip = FALSE;			/* until pprdrv --prerip says otherwise */
+
 	printer->ppop_pid = (pid_t)0;		/* nobody waiting for stop */
 	printer->cancel_job = FALSE;		/* don't cancel a job on next pprdrv exit */
 	printer->hold_job = FALSE;			/* don't hold job on next pprdrv exit */
@@ -109,6 +166,45 @@ static void load_printer(struct Printer *printer, const char prnname[])
 		if(*line==';' || *line=='#')
 			continue;
 
+		/* The SNMP poller needs to know where the printer is.  As in ppad,
+		   an "Interface:" line cancels the lines which preceed it. */
+		else if(lmatch(line, "Interface:"))
+			{
+			gu_free_if(interface);
+			gu_free_if(address);
+			gu_free_if(options);
+			interface = address = options = NULL;
+			gu_sscanf(line, "Interface: %S", &interface);
+			}
+		else if(lmatch(line, "Address:"))
+			{
+			gu_free_if(address);
+			address = NULL;
+			gu_sscanf(line, "Address: %A", &address);
+			}
+		else if(lmatch(line, "Options:"))
+			{
+			gu_free_if(options);
+			options = NULL;
+			gu_sscanf(line, "Options: %T", &options);
+			}
+
+		/* These limit the jobs which the printer will accept.  See
+		   pprd_capable.c. */
+		else if((p = lmatchp(line, "GrayOK:")))
+			{
+			if(gu_torf_setBOOL(&printer->caps.grayok, p) == -1)
+				error("Printer \"%s\" has an invalid \"%s\" line.", printer->name, "GrayOK:");
+			}
+		else if(lmatch(line, "LimitPages:"))
+			{
+			gu_sscanf(line, "LimitPages: %d %d", &printer->caps.limit_pages_lower, &printer->caps.limit_pages_upper);
+			}
+		else if(lmatch(line, "LimitKilobytes:"))
+			{
+			gu_sscanf(line, "LimitKilobytes: %d %d", &printer->caps.limit_kilobytes_lower, &printer->caps.limit_kilobytes_upper);
+			}
+
 		/* For "Alert:" lines, read the interval, method, and address. */
 		else if(lmatch(line, "Alert:"))
 			{
@@ -171,6 +267,12 @@ static void load_printer(struct Printer *printer, const char prnname[])
 	/* Close that configuration file! */
 	fclose(prncf);
 
+	snmp_poller_printer_config(printer, interface, address, options);
+	capable_printer_load(printer);
+	gu_free_if(interface);
+	gu_free_if(address);
+	gu_free_if(options);
+
 	/* Create the directories which will hold this printer's dynamic 
 	   state information. */
 	{
@@ -196,8 +298,6 @@ void load_printers(void)
 	int x;
 	int len;
 
-	printers = (struct Printer*)gu_alloc(MAX_PRINTERS, sizeof(struct Printer));
-
 	if(!(dir = opendir(PRCONF)))
 		fatal(0, "%s(): can't open directory \"%s\", errno=%d (%s)", function, PRCONF, errno, gu_strerror(errno));
 
@@ -213,7 +313,7 @@ void load_printers(void)
 		if(len > 0 && direntp->d_name[len-1] == '~')
 			continue;
 
-		if(x == MAX_PRINTERS)
+		if(printers_grow(x) == -1)
 			{
 			error("%s(): too many printers", function);
 			break;				/* break out of loop */
@@ -223,6 +323,7 @@ void load_printers(void)
 		printer_count++;				/* do now so destid_to_name() ok */
 		media_mounted_recover(x);		/* get those forms back */
 		media_mounted_save(x);			/* this list must be up to date for pprdrv */
+		board_printer(x);
 		x++;
 		}
 
@@ -273,6 +374,8 @@ void new_printer_config(char *printer)
 			printers[prnid].name = NULL;
 			gu_free_if(printers[prnid].alert.method);
 			gu_free_if(printers[prnid].alert.address);
+			snmp_poller_printer_free(&printers[prnid]);
+			capable_printer_free(&printers[prnid]);
 			break;
 			}
 		}
@@ -281,11 +384,14 @@ void new_printer_config(char *printer)
 		{
 		is_new = TRUE;					/* this is a new printer */
 		if(first_deleted != -1)			/* if we have an empty slot, */
+			{
 			prnid = first_deleted;		/* re-use it */
+			dispatch_printer_new(prnid);
+			}
 		}
 
-	if(prnid == MAX_PRINTERS)	/* if new printer and no more room, */
-		{						/* just say there is an error */
+	if(printers_grow(prnid) == -1)	/* if new printer and no more room, */
+		{							/* just say there is an error */
 		error("%s(): too many printers", function);
 		unlock();				/* and ignore the request */
 		return;
@@ -314,6 +420,7 @@ void new_printer_config(char *printer)
 			state_update("PRNDELETE %s", printer);
 			/* mark printer as deleted */
 			printers[prnid].spool_state.status = PRNSTATUS_DELETED;
+			board_printer(prnid);
 			}
 		}
 
@@ -326,6 +433,10 @@ void new_printer_config(char *printer)
 		saved_status = printers[prnid].spool_state.status;		/* We will use these in a moment */
 		saved_ppop_pid = printers[prnid].ppop_pid;	/* if the printer is not new. */
 	
+		/* load_printer() reads the spool_state file, so changes to it
+		   which are still in the journal must be made first. */
+		journal_checkpoint(FALSE);
+	
 		load_printer(&printers[prnid], printer);	/* load printer configuration */
 		media_mounted_recover(prnid);				/* load the list of mounted media */
 		media_mounted_save(prnid);					/* save updated (very important for pprdrv) */
@@ -343,13 +454,13 @@ void new_printer_config(char *printer)
 			   never bit for all jobs for groups to which this printer belongs.
 			   */
 			{
-			int x, prnbit;
+			int x, bitnum;
 			for(x=0; x < queue_entries; x++)
 				{
-				prnbit = 1;
-				if(queue[x].destid == prnid || (prnbit = destid_printer_bit(queue[x].destid, prnid)) )
+				if((bitnum = destid_printer_bitnum(queue[x].destid, prnid)) != -1)
 					{
-					queue[x].never &= (0xFF ^ prnbit);
+					gu_bitset_clear(&queue[x].never, bitnum);
+					capable_rescreen(&queue[x]);
 					if(queue[x].status == STATUS_STRANDED)
 						queue_p_job_new_status(&queue[x], STATUS_WAITING);
 					}
@@ -368,6 +479,8 @@ void new_printer_config(char *printer)
 			if(printers[prnid].spool_state.status == PRNSTATUS_IDLE)
 				printer_look_for_work(prnid);
 			}
+
+		board_printer(prnid);
 		} /* end if if printer still exists */
 
 	unlock();			/* ok, let things move again */
@@ -397,6 +510,9 @@ static void load_group(struct Group *cl, const char grpname[])
 	cl->last = -1;						/* initialize last used member value */
 	cl->deleted = FALSE;				/* it is not a deleted group! */
 	cl->rotate = TRUE;					/* rotate is default */
+	cl->dispatch = -1;					/* set from rotate if no "Dispatch:" */
+	cl->affinity_pages = DISPATCH_AFFINITY_PAGES;
+	cl->holding = FALSE;
 	
 	if(group_spool_state_load(&(cl->spool_state), cl->name) == -1)
 		error("saved group spool state of \"%s\" was invalid", cl->name);
@@ -419,11 +535,12 @@ static void load_group(struct Group *cl, const char grpname[])
 		/* Read the name of a group member */
 		if(gu_sscanf(line, "Printer: %S", &extract) == 1)
 			{
-			if(y >= MAX_GROUPSIZE)		/* if group has overflowed, */
-				{						/* note error and ignore member */
-				error("group \"%s\" exceeds %d member limit", cl->name, MAX_GROUPSIZE);
+			if(y == cl->members_space)	/* if the member array is full, enlarge it */
+				{
+				cl->members_space += MEMBERS_GROWBY;
+				cl->printers = (int*)gu_realloc(cl->printers, cl->members_space, sizeof(int));
 				}
-			else if((cl->printers[y] = destid_by_printer(extract)) == -1)
+			if((cl->printers[y] = destid_by_printer(extract)) == -1)
 				{
 				error("group \"%s\":  member \"%s\" does not exist", cl->name, extract);
 				}
@@ -445,10 +562,23 @@ static void load_group(struct Group *cl, const char grpname[])
 				fatal(0, "Invalid Rotate option (%s, line %d)", conf_fname, linenum);
 			continue;
 			}
+
+		/* read the dispatch policy */
+		if(gu_sscanf(line, "Dispatch: %S %d", &extract, &cl->affinity_pages) >= 1)
+			{
+			if((cl->dispatch = dispatch_policy_parse(extract)) == -1)
+				error("group \"%s\":  invalid Dispatch policy \"%s\" (%s, line %d)", cl->name, extract, conf_fname, linenum);
+			gu_free(extract);
+			continue;
+			}
 		}
 
 	fclose(f);
 
+	/* Without a "Dispatch:" line, "Rotate:" decides. */
+	if(cl->dispatch == -1)
+		cl->dispatch = cl->rotate ? DISPATCH_ROTATE : DISPATCH_ORDER;
+
 	cl->members=y;			/* set the members count */
 
 	/* Create the directory which will hold this group's dynamic 
@@ -472,9 +602,6 @@ void load_groups(void)
 	int x;
 	int len;
 
-	if((groups = (struct Group*)calloc(MAX_GROUPS, sizeof(struct Group))) == (struct Group*)NULL)
-		fatal(0, "%s(): out of memory", function);
-
 	if(!(dir = opendir(GRCONF)))
 		fatal(0, "%s(): can't open directory \"%s\", errno=%d (%s)", function, GRCONF, errno, gu_strerror(errno));
 
@@ -490,7 +617,7 @@ void load_groups(void)
 		if( len > 0 && direntp->d_name[len-1] == '~' )
 			continue;
 
-		if(x==MAX_GROUPS)
+		if(groups_grow(x) == -1)
 			{
 			error("%s(): too many groups", function);
 			break;
@@ -543,17 +670,16 @@ void new_group_config(char *group)
 		is_new = TRUE;
 		if(first_deleted != -1)
 			x = first_deleted;
+		else if(groups_grow(x) == -1)	/* if adding, make sure there is room */
+			{
+			unlock();
+			error("%s(): too many groups", function);
+			return;
+			}
 		else
 			group_count++;
 		}
 
-	if(x == MAX_GROUPS)					/* if adding, make sure there is room */
-		{
-		unlock();
-		error("%s(): too many groups", function);
-		return;
-		}
-
 	/* see if we are deleting this group */
 	ppr_fnamef(fname, "%s/%s", GRCONF, group);
 	if((testopen = fopen(fname, "r")) == (FILE*)NULL)
@@ -574,18 +700,25 @@ void new_group_config(char *group)
 	
 		state_update("GRPRELOAD %s",group); /* inform queue display programs */
 	
+		/* As for printers, above. */
+		journal_checkpoint(FALSE);
+	
 		load_group(&groups[x],group);		/* read the group file */
 	
 		/* fix all the jobs for this group */
 		destid = destid_by_gindex(x);
-		for(x = 0; x < queue_entries; x++)
+		{
+		int y;
+		for(y = 0; y < queue_entries; y++)
 			{
-			if(queue[x].destid==destid)		/* if job is for this group, */
+			if(queue[y].destid==destid)		/* if job is for this group, */
 				{							/* reset the media ready lists */
-				media_set_notnow_for_job(&queue[x], TRUE);
-				queue[x].never = 0;			/* since the membership may have changed, the never bits may be */
-				}							/* invalid, so just clear them */
-			}								/* (they will be set again if necessary). */
+				media_set_notnow_for_job(&queue[y], TRUE);
+				gu_bitset_clear_all(&queue[y].never);	/* since the membership may have changed, the never bits may be */
+				capable_rescreen(&queue[y]);			/* invalid, so just clear them */
+				}										/* (they will be set again if necessary). */
+			}
+		}
 	
 		/* look for work for any group members which are idle */
 		group_look_for_work(x);
@@ -600,33 +733,24 @@ void new_group_config(char *group)
 void initialize_queue(void)
 	{
 	const char function[] = "initialize_queue";
-	DIR *dir;					/* the open queue directory */
-	struct dirent *direntp;		/* pointer to the current queue entry */
+	struct timeval start_time, elapsed;
 	int iii;
 
 	DODEBUG_RECOVER(("%s()", function));
 
+	gettimeofday(&start_time, NULL);
+
 	/* Allocate memory to hold the queue. */
 	queue_size = QUEUE_SIZE_INITIAL;
 	queue = (struct QEntry *)gu_alloc(queue_size, sizeof(struct QEntry));
 
-	/* Open the queue directory. */
-	if(!(dir = opendir(QUEUEDIR)))
-		fatal(0, "%s(): can't open directory \"%s\", errno=%d (%s)", function, QUEUEDIR, errno, gu_strerror(errno));
-
-	/* loop to read file names */
-	while((direntp = readdir(dir)))
-		{
-		if(direntp->d_name[0] == '.')			/* ignore "." and ".." */
-			continue;
-
-		DODEBUG_RECOVER(("%s(): inheriting queue file \"%s\"", function, direntp->d_name));
+	/* Start a fresh list of the job IDs in use for ppr to consult.  If we
+	   can't, ppr will look for the queue files instead. */
+	if(!(queue_id_set = nextid_set_open(TRUE)))
+		error("%s(): can't create \"%s\", errno=%d (%s)", function, JOBID_SET_FILE, errno, gu_strerror(errno));
 
-		queue_accept_queuefile(direntp->d_name, FALSE, FALSE);
-		}
-
-	/* We are done.  Close the queue directory. */
-	closedir(dir);
+	/* Load the jobs (see pprd_recover.c). */
+	recover_queue();
 
 	/* Flush out queue job counts. */
 	for(iii=0; iii < printer_count; iii++)
@@ -634,6 +758,10 @@ void initialize_queue(void)
 	for(iii=0; iii < group_count; iii++)
 		group_spool_state_save(&(groups[iii].spool_state), groups[iii].name);
 
+	gettimeofday(&elapsed, NULL);
+	gu_timeval_sub(&elapsed, &start_time);
+	debug("%d jobs loaded in %ld.%03ld seconds", queue_entries, (long)elapsed.tv_sec, (long)(elapsed.tv_usec / 1000));
+
 	/* Give each idle printer a chance to start. */
 	for(iii=0; iii < printer_count; iii++)
 		{
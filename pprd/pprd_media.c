@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 7 April 2006.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
@@ -208,10 +208,10 @@ int get_bin_id(char *nbinname)
 =====================================================================*/
 
 static gu_boolean hasmedia(int prnid, struct QEntry *job);
-static int stoptmask(int destid);
-static void media_set_job_wait_reason(struct QEntry *job, int stopt_members_mask, int inqueue);
+static void stoptmask(int destid, struct gu_bitset *mask);
+static void media_set_job_wait_reason(struct QEntry *job, const struct gu_bitset *stopt_members_mask, int inqueue);
 static void media_startstop_update_waitreason2(int destid);
-static void media_update_notnow2(int destid, int prnbit, int prnid);
+static void media_update_notnow2(int destid, int bitnum, int prnid);
 
 /*
 ** ppop start <printer>
@@ -248,7 +248,10 @@ void media_startstop_update_waitreason(int prnid)
 static void media_startstop_update_waitreason2(int destid)
 	{
 	int x;
-	int stopt = stoptmask(destid);		/* mask of stop members */
+	struct gu_bitset stopt;				/* mask of stop members */
+
+	gu_bitset_init(&stopt);
+	stoptmask(destid, &stopt);
 
 	for(x=0; x < queue_entries; x++)	/* scan the entire queue */
 		{
@@ -256,9 +259,11 @@ static void media_startstop_update_waitreason2(int destid)
 		if(queue[x].destid == destid)
 			{
 			/* set waiting to prn or media */
-			media_set_job_wait_reason(&queue[x],stopt,TRUE);
+			media_set_job_wait_reason(&queue[x], &stopt, TRUE);
 			}
 		}
+
+	gu_bitset_free(&stopt);
 	} /* end of media_startstop_update_waitreason2() */
 
 /*
@@ -282,40 +287,45 @@ void media_update_notnow(int prnid)
 	lock();
 
 	/* Update for jobs with this printer as their dest. */
-	media_update_notnow2(prnid, 1, prnid);
+	media_update_notnow2(prnid, 0, prnid);
 
 	/* For each group if this prn is a member, update it. */
 	{
-	int g, g_destid, prnbit;
+	int g, g_destid, bitnum;
 	for(g = 0; g < group_count; g++)
 		{
 		g_destid = destid_by_gindex(g);
-		if((prnbit = destid_printer_bit(g_destid, prnid)))
-			media_update_notnow2(g_destid, prnbit, prnid);
+		if((bitnum = destid_printer_bitnum(g_destid, prnid)) != -1)
+			media_update_notnow2(g_destid, bitnum, prnid);
 		}
 	}
 
 	unlock();
 	} /* end of media_update_notnow() */
 
-static void media_update_notnow2(int destid, int prnbit, int prnid)
+static void media_update_notnow2(int destid, int bitnum, int prnid)
 	{
 	int x;
-	int stopt = stoptmask(destid);		/* mask of stop members */
+	struct gu_bitset stopt;				/* mask of stop members */
+
+	gu_bitset_init(&stopt);
+	stoptmask(destid, &stopt);
 
 	for(x = 0; x < queue_entries; x++)	/* scan the entire queue */
 		{
 		if(queue[x].destid == destid)	/* if job is for this destination */
 			{							/* then */
 			if( hasmedia(prnid, &queue[x]) )
-				queue[x].notnow &= (0xFF ^ prnbit);	 /* !!! */
+				gu_bitset_clear(&queue[x].notnow, bitnum);
 			else
-				queue[x].notnow |= prnbit;
+				gu_bitset_set(&queue[x].notnow, bitnum);
 
 			/* set waiting to prn or media */
-			media_set_job_wait_reason(&queue[x], stopt, TRUE);
+			media_set_job_wait_reason(&queue[x], &stopt, TRUE);
 			}
 		}
+
+	gu_bitset_free(&stopt);
 	} /* end of media_update_notnow2() */
 
 /*
@@ -334,37 +344,35 @@ static void media_update_notnow2(int destid, int prnbit, int prnid)
 void media_set_notnow_for_job(struct QEntry *nj, gu_boolean inqueue)
 	{
 	FUNCTION4DEBUG("set_nownow_for_job")
+	struct gu_bitset stopt;
 
 	DODEBUG_NOTNOW(("%s()", function));
 
+	gu_bitset_clear_all(&nj->notnow);	/* start with clear mask */
+
 	if(destid_is_group(nj->destid))		/* check for each printer: */
 		{
 		struct Group *gptr;				/* ptr to group array entry */
 		int x;
 		gptr = &groups[destid_to_gindex(nj->destid)];
 
-		nj->notnow = 0;					/* start with clear mask */
-
 		for(x=0;x<gptr->members;x++)	/* do for each printer */
 			if( ! hasmedia(gptr->printers[x],nj) )
 				{
-				nj->notnow |= 1<<x;		/* if hasn't media, set bit */
+				gu_bitset_set(&nj->notnow, x);	/* if hasn't media, set bit */
 				}
 		}
 
 	else								/* just one printer: */
 		{
-		if( hasmedia(nj->destid,nj) )	/* if printer has all forms */
-			{
-			nj->notnow = 0;				/* bit zero clear */
-			}
-		else							/* else */
-			{
-			nj->notnow = 1;				/* bit zero set */
-			}
+		if( ! hasmedia(nj->destid,nj) )	/* if printer lacks a form, */
+			gu_bitset_set(&nj->notnow, 0);	/* set bit zero */
 		}
 
-	media_set_job_wait_reason(nj, stoptmask(nj->destid), inqueue);
+	gu_bitset_init(&stopt);
+	stoptmask(nj->destid, &stopt);
+	media_set_job_wait_reason(nj, &stopt, inqueue);
+	gu_bitset_free(&stopt);
 	} /* end of media_set_notnow_for_newjob() */
 
 /*
@@ -408,20 +416,19 @@ static gu_boolean hasmedia(int prnid, struct QEntry *job)
 /*
 ** Get the stopt mask for a queue.  The stopt mask tells which
 ** member printers of a group are stopt.  For a printer queue
-** it is 1 if the printer is stopt, 0 if it isn't.
+** bit zero is set if the printer is stopt.  The caller must
+** pass an empty bitset and free it afterward.
 */
-static int stoptmask(int destid)
+static void stoptmask(int destid, struct gu_bitset *mask)
 	{
 	struct Group *g;
-	int mask=0;
 	int x;
 
 	if(!destid_is_group(destid))
 		{
-		if(printers[destid].spool_state.status < PRNSTATUS_DELIBERATELY_DOWN)
-			return 0;
-		else
-			return 1;
+		if(printers[destid].spool_state.status >= PRNSTATUS_DELIBERATELY_DOWN)
+			gu_bitset_set(mask, 0);
+		return;
 		}
 
 	g = &groups[destid_to_gindex(destid)];
@@ -429,10 +436,8 @@ static int stoptmask(int destid)
 	for(x=0; x<g->members; x++)
 		{
 		if(printers[g->printers[x]].spool_state.status >= PRNSTATUS_DELIBERATELY_DOWN)
-			mask |= (1 << x);
+			gu_bitset_set(mask, x);
 		}
-
-	return mask;
 	} /* end of stoptmask() */
 
 /*
@@ -447,7 +452,7 @@ static int stoptmask(int destid)
 ** The inqueue parameter is TRUE if the job is already in the queue.  If it
 ** is, we must call queue_p_job_new_status().
 */
-static void media_set_job_wait_reason(struct QEntry *job, int stopt_members_mask, int inqueue)
+static void media_set_job_wait_reason(struct QEntry *job, const struct gu_bitset *stopt_members_mask, int inqueue)
 	{
 	FUNCTION4DEBUG("media_set_job_wait_reason")
 
@@ -457,9 +462,11 @@ static void media_set_job_wait_reason(struct QEntry *job, int stopt_members_mask
 
 		if(destid_is_group(job->destid))	/* set for a group */
 			{
-			int allmask = ((1 << groups[destid_to_gindex(job->destid)].members) - 1);
+			int members = groups[destid_to_gindex(job->destid)].members;
 
-			if( ((job->notnow | stopt_members_mask) == allmask) && (stopt_members_mask != allmask) )
+			/* If every member lacks the media or is stopt, but not every
+			   member is stopt, then the job is waiting for media. */
+			if(gu_bitset_all_either(&job->notnow, stopt_members_mask, members) && !gu_bitset_all(stopt_members_mask, members))
 				new_status = STATUS_WAITING4MEDIA;
 			else
 				new_status = STATUS_WAITING;
@@ -467,7 +474,7 @@ static void media_set_job_wait_reason(struct QEntry *job, int stopt_members_mask
 
 		else							/* set for a printer */
 			{
-			if( job->notnow && (stopt_members_mask == 0) )
+			if( gu_bitset_any(&job->notnow) && !gu_bitset_any(stopt_members_mask) )
 				new_status = STATUS_WAITING4MEDIA;
 			else
 				new_status = STATUS_WAITING;
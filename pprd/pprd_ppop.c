@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 1 June 2010.
+** Last modified 19 October 2026.
 */
 
 /** \file
@@ -46,6 +46,85 @@ static FILE *reply_file;
 ** List print jobs by writing them into a file.
 ** This if for the commands "ppop list", "ppop lpq", "ppop qquery", etc.
 =======================================================================*/
+
+/*
+** Find the line which marks the end of a queue file section and return a
+** pointer to the start of it, or to the end of the text if it isn't there.
+*/
+static const char *ppop_list_find_line(const char *p, const char *end, const char line[])
+	{
+	size_t line_len = strlen(line);
+	const char *eol;
+	for( ; p < end && (eol = memchr(p, '\n', end - p)); p = eol + 1)
+		{
+		if((eol - p) == line_len && memcmp(p, line, line_len) == 0)
+			return p;
+		}
+	return end;
+	}
+
+/*
+** Copy those parts of a queue file which ppop asked for.  The sections
+** which it doesn't want are reduced to their end lines.  The IPP section
+** is always left out since ppop never looks at it.  Queue files are small,
+** so we read the whole thing and then write out the wanted sections.
+*/
+static void ppop_list_copy_parts(int qfile, int parts)
+	{
+	const char function[] = "ppop_list_copy_parts";
+	char buffer[8192];
+	char *text = buffer;
+	size_t text_available = sizeof(buffer), text_len = 0;
+	ssize_t len;
+	const char *end, *misc_end, *addon_start, *addon_end;
+
+	while((len = read(qfile, text + text_len, text_available - text_len)) > 0)
+		{
+		text_len += len;
+		if(text_len == text_available)
+			{
+			text_available *= 2;
+			if(text == buffer)
+				{
+				text = gu_alloc(text_available, sizeof(char));
+				memcpy(text, buffer, text_len);
+				}
+			else
+				{
+				text = gu_realloc(text, text_available, sizeof(char));
+				}
+			}
+		}
+
+	if(len == -1)
+		fatal(0, "%s(): read() failed, errno=%d (%s)", function, errno, gu_strerror(errno) );
+
+	end = text + text_len;
+
+	misc_end = ppop_list_find_line(text, end, "EndMisc");
+	addon_start = ppop_list_find_line(misc_end, end, "EndIPP");
+	if(addon_start < end)
+		addon_start += sizeof("EndIPP");
+	addon_end = ppop_list_find_line(addon_start, end, "EndAddon");
+
+	if(parts & QF_PART_MISC)
+		{
+		fwrite(text, sizeof(char), misc_end - text, reply_file);
+		fputs("EndMisc\nEndIPP\n", reply_file);
+		}
+	if(parts & QF_PART_ADDON)
+		fwrite(addon_start, sizeof(char), addon_end - addon_start, reply_file);
+	fputs("EndAddon\n", reply_file);
+	if((parts & QF_PART_REST) && addon_end < end)
+		{
+		addon_end += sizeof("EndAddon");
+		fwrite(addon_end, sizeof(char), end - addon_end, reply_file);
+		}
+
+	if(text != buffer)
+		gu_free(text);
+	} /* end of ppop_list_copy_parts() */
+
 static void ppop_list(const char command[])
 	{
 	const char *function = "ppop_list";
@@ -53,6 +132,7 @@ static void ppop_list(const char command[])
 	int destname_id;					/* Destination queue id to match */
 	int id;								/* Queue job id to match */
 	int subid;							/* Queue job sub id to match */
+	int parts = QF_PART_ALL;			/* parts of the queue files wanted */
 	int x;
 	char fname[MAX_PPR_PATH];
 	int qfile;
@@ -65,17 +145,18 @@ static void ppop_list(const char command[])
 	/*
 	** Pull the relevent information from the command we received.
 	*/
-	if(gu_sscanf(command, "l %S %d %d",
+	if(gu_sscanf(command, "l %S %d %d %d",
 			&destname,
 			&id,
-			&subid
-			) != 3)
+			&subid,
+			&parts
+			) < 3)
 		{
 		error("%s(): invalid list command: %s", function, command);
 		return;
 		}
 
-	DODEBUG_PPOPINT(("%s(): destname=\"%s\", id=%d, subid=%d", function, destname, id, subid));
+	DODEBUG_PPOPINT(("%s(): destname=\"%s\", id=%d, subid=%d, parts=%d", function, destname, id, subid, parts));
 
 	/*
 	** Convert the destination (printer or group) name into an id
@@ -115,7 +196,7 @@ static void ppop_list(const char command[])
 				&& (subid == WILDCARD_SUBID || queue[x].subid == subid)
 				)
 			{
-			/* Open the queue file: */
+			/* Build the name of the queue file: */
 			ppr_fnamef(fname, "%s/%s-%d.%d", QUEUEDIR,
 				destid_to_name(queue[x].destid),
 				queue[x].id,
@@ -129,8 +210,14 @@ static void ppop_list(const char command[])
 			   queue file we will assume it has been stomped
 			   on and just skip it. 
 			   (This bug is probably fixed already.)
+			   If ppop wants nothing from the queue file,
+			   we don't open it.
 			   */
-			if((qfile = open(fname, O_RDONLY)) < 0)
+			if(parts == 0)
+				{
+				qfile = -1;
+				}
+			else if((qfile = open(fname, O_RDONLY)) < 0)
 				{
 				error("%s(): can't open \"%s\", errno=%d (%s)", function, fname, errno, gu_strerror(errno) );
 				continue;
@@ -141,41 +228,59 @@ static void ppop_list(const char command[])
 			** use is the date of the last inode change.  This information
 			** is used by the ppop -A option.
 			*/
-			if(queue[x].status == STATUS_ARRESTED)
-				fstat(qfile, &statbuf);
-			else
+			if(queue[x].status != STATUS_ARRESTED
+					|| (qfile != -1 ? fstat(qfile, &statbuf) : stat(fname, &statbuf)) == -1)
 				statbuf.st_ctime = 0;
 
 			/*
 			** Print a line with the information from our job array and
-			** when the job was arrested if it was.
+			** when the job was arrested if it was.  The never and notnow
+			** bitsets are in hexadecimal.
 			*/
-			fprintf(reply_file, "%s %d %d %d %d %s %d %d %d %ld\n",
+			{
+			char *never = gu_bitset_format(&queue[x].never);
+			char *notnow = gu_bitset_format(&queue[x].notnow);
+			fprintf(reply_file, "%s %d %d %d %d %s %s %s %d %ld\n",
 				destid_to_name(queue[x].destid),
 				queue[x].id,
 				queue[x].subid,
 				queue[x].priority,
 				queue[x].status,
 				queue[x].status >= 0 ? destid_to_name(queue[x].status) : "?",
-				queue[x].never,
-				queue[x].notnow,
+				never,
+				notnow,
 				queue[x].pass,
 				(long)statbuf.st_ctime);
+			gu_free(never);
+			gu_free(notnow);
+			}
 
 			/*
-			** Copy the queue file to the reply file and
-			** append a line with a single period to
-			** indicate the end of the reply file.
+			** Copy the queue file (or the requested parts of it) to
+			** the reply file and append a line with a single period
+			** to indicate the end of the reply file.
 			*/
-			while((len = read(qfile, buffer, sizeof(buffer))) > 0)
+			if(parts == QF_PART_ALL)
 				{
-				fwrite(buffer, sizeof(char), len, reply_file);
-				}
+				while((len = read(qfile, buffer, sizeof(buffer))) > 0)
+					{
+					fwrite(buffer, sizeof(char), len, reply_file);
+					}
 
-			if(len == -1)
-				fatal(0, "%s(): read() failed, errno=%d (%s)", function, errno, gu_strerror(errno) );
+				if(len == -1)
+					fatal(0, "%s(): read() failed, errno=%d (%s)", function, errno, gu_strerror(errno) );
+				}
+			else if(qfile != -1)
+				{
+				ppop_list_copy_parts(qfile, parts);
+				}
+			else
+				{
+				fputs("EndAddon\n", reply_file);
+				}
 
-			close(qfile);
+			if(qfile != -1)
+				close(qfile);
 
 			fputs(QF_ENDTAG1, reply_file);
 			fputs(QF_ENDTAG2, reply_file);
@@ -192,13 +297,15 @@ static void ppop_list(const char command[])
 static void ppop_status_do_printer(FILE *outfile, int prnid)
 	{
 	int status = printers[prnid].spool_state.status;
+	gu_boolean active = (status == PRNSTATUS_PRINTING || status == PRNSTATUS_CANCELING
+				|| status == PRNSTATUS_STOPPING || status == PRNSTATUS_HALTING
+				|| status == PRNSTATUS_SEIZING);
+	gu_boolean polled = FALSE;
 
 	/*
 	** The first line is a dump of the printers[] entry.
 	*/
-	if(status == PRNSTATUS_PRINTING || status == PRNSTATUS_CANCELING
-				|| status == PRNSTATUS_STOPPING || status == PRNSTATUS_HALTING
-				|| status == PRNSTATUS_SEIZING)
+	if(active)
 		{
 		fprintf(outfile, "%s %d %d %d %s %d %d\n",
 				destid_to_name(prnid),						/* printer name */
@@ -221,8 +328,12 @@ static void ppop_status_do_printer(FILE *outfile, int prnid)
 
 	/*
 	** The second line and subsequent lines are the auxiliary status lines.
-	** These status lines are deposited in a file by pprdrv.
+	** These status lines are deposited in a file by pprdrv.  If pprdrv
+	** isn't running, the SNMP poller's answer is newer than the SNMP-style
+	** status pprdrv left behind, so that is used instead.
 	*/
+	if(!active)
+		polled = snmp_poller_status(outfile, prnid);
 	{
 	char fname[MAX_PPR_PATH];
 	FILE *statusfile;
@@ -234,6 +345,8 @@ static void ppop_status_do_printer(FILE *outfile, int prnid)
 		char message[MAX_STATUS_MESSAGE+1];
 		while(fgets(message, sizeof(message), statusfile))
 			{
+			if(polled && (lmatch(message, "status:") || lmatch(message, "errorstate:") || lmatch(message, "snmp-status:")))
+				continue;
 			fputs(message, outfile);
 			}
 		fclose(statusfile);
@@ -1099,6 +1212,13 @@ static void ppop_move(const char command[])
 						new_destname,
 						rank2++);
 
+				/* Changes to the queue file which are still in the journal
+				   must be made before it is renamed. */
+				journal_checkpoint(FALSE);
+
+				/* Output pre-RIPed for the old printer is no good. */
+				prerip_forget(q);
+
 				/* Rename the queue file. */
 				ppr_fnamef(oldname,"%s/%s-%d.%d", QUEUEDIR,
 					destid_to_name(q->destid),q->id,q->subid);
@@ -1108,7 +1228,7 @@ static void ppop_move(const char command[])
 
 				/* Rename all of the data files. */
 				{
-				char *list[] = {"comments", "pages", "text", "log", "infile", "barbar", NULL};
+				char *list[] = {"spool", "comments", "pages", "text", "log", "infile", "barbar", "rip", NULL};
 				int x;
 				for(x=0; list[x]; x++)
 					{
@@ -1131,6 +1251,7 @@ static void ppop_move(const char command[])
 				** after the rename code or the rename code will break.
 				*/
 				q->destid = new_destid;
+				board_job(q);
 				}
 
 			/*
@@ -1161,7 +1282,8 @@ static void ppop_move(const char command[])
 			** Clear any "never" (printer unsuitable) flags, set new "notnow" 
 			** (required media not present) flags, and update the job status.
 			*/
-			q->never = 0;
+			gu_bitset_clear_all(&q->never);
+			capable_rescreen(q);
 
 			/* Reset pass number just like in queue_insert(). */
 			if(destid_is_group(q->destid))
@@ -1291,6 +1413,7 @@ static void ppop_rush(const char command[])
 					}
 				memcpy(&queue[0], &t, sizeof(struct QEntry));
 				queue[0].priority = 101;	/* highest priority */
+				board_job(&queue[0]);
 				}
 			else
 				{
@@ -1302,6 +1425,7 @@ static void ppop_rush(const char command[])
 					}
 				memcpy(&queue[x],&t,sizeof(struct QEntry));
 				queue[x].priority = 1;		/* lowest priority */
+				board_job(&queue[x]);
 				}
 			break;
 			}
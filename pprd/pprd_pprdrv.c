@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 1 June 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -15,8 +15,8 @@
 ** the result when it exits.
 */
 
-/* This is for debugging.  Every time pprdrv is launched, strace will be launched
-   to trace it and put the output in this file.  The file will be overwritten each
+/* This is for debugging.  Every time pprdrv is launched, it will be run under
+   strace which will put the output in this file.  The file will be overwritten each
    time.  This debugging code is not intended for production systems.
    */
 #if 0
@@ -42,6 +42,19 @@
 #include "interface.h"
 #include "respond.h"
 
+/*
+** Put a printer into auto-retry mode after pprdrv has failed or couldn't
+** be started.  The caller sets the printer's status.
+*/
+static void pprdrv_fault_retry(int prnid)
+	{
+	alert(printers[prnid].name, FALSE, _("Printer placed in auto-retry mode."));
+	printers[prnid].spool_state.next_error_retry++;
+	printers[prnid].spool_state.countdown = printers[prnid].spool_state.next_error_retry * RETRY_MULTIPLIER;
+	if(printers[prnid].spool_state.countdown > MIN_RETRY)
+		printers[prnid].spool_state.countdown = MIN_RETRY;
+	} /* end of pprdrv_fault_retry() */
+
 /*
 ** This routine starts pprdrv for a specific printer to print a specific job.
 ** It is called only from pprd_printer.c:printer_start().
@@ -60,6 +73,8 @@ int pprdrv_start(int prnid, struct QEntry *job)
 	{
 	const char function[] = "pprdrv_start";
 	pid_t pid;					/* process id of pprdrv */
+	char jobname[MAX_PPR_PATH];
+	char pass_str[10];
 
 	DODEBUG_PRNSTART(("%s(prnid=%d, job={%d,%d,%d})", function, prnid, job->destid, job->id, job->subid));
 
@@ -97,100 +112,89 @@ int pprdrv_start(int prnid, struct QEntry *job)
 		return -1;
 		}
 
+	/* If it is still being pre-RIPed, it is too late for that. */
+	prerip_printing(job);
+
+	/*
+	** Reconstruct the queue file name.
+	** We can not use the library routine "local_jobid()" here
+	** because it tends to ommit parts which conform
+	** to default values.
+	*/
+	snprintf(jobname, sizeof(jobname), "%s-%d.%d",
+			destid_to_name(job->destid),
+			job->id,job->subid
+			);
+
+	/*
+	** Convert the pass number to a string so that
+	** we may use it as a argument.
+	*/
+	snprintf(pass_str, sizeof(pass_str), "%d", job->pass);
+
 	/* start pprdrv */
-	if((pid = fork()) == -1)			/* if error */
+	{
+	const char *args[] = {
+		#ifdef STRACE_OUTPUT
+		"strace", "-f", "-F", "-v", "-t", "-s", "128", "-o", STRACE_OUTPUT, PPRDRV_PATH,
+		#else
+		"pprdrv",
+		#endif
+		destid_to_name(prnid),					/* printer name */
+		jobname,								/* full job id string */
+		pass_str,								/* pass number as a string */
+		NULL
+		};
+	const int fds[CHILD_FDS] = {CHILD_INHERIT, CHILD_INHERIT, CHILD_INHERIT, CHILD_INHERIT};
+	#ifdef STRACE_OUTPUT
+	pid = child_spawn("/usr/bin/strace", args, fds);
+	#else
+	pid = child_spawn(PPRDRV_PATH, args, fds);
+	#endif
+	}
+
+	if(pid == -1)
 		{
-		error("%s(): Couldn't fork, printer \"%s\" not started", function, destid_to_name(prnid));
-		printer_new_status(&printers[prnid], PRNSTATUS_STARVED);
-		starving_printers++;
+		int saved_errno = errno;
+
+		/* Out of processes or memory, try again later. */
+		if(saved_errno == EAGAIN || saved_errno == ENOMEM)
+			{
+			error("%s(): Couldn't fork, printer \"%s\" not started", function, destid_to_name(prnid));
+			printer_new_status(&printers[prnid], PRNSTATUS_STARVED);
+			starving_printers++;
+			return -1;
+			}
+
+		/* Otherwise, treat it as pprdrv would have been treated had it
+		   been started and reported a printer error. */
+		error("%s(): Can't execute pprdrv, errno = %d (%s)", function, saved_errno, gu_strerror(saved_errno));
+		alert(destid_to_name(prnid), TRUE, "Can't execute \"%s\", errno=%d (%s)", PPRDRV_PATH, saved_errno, gu_strerror(saved_errno));
+		pprdrv_fault_retry(prnid);
+		alert_printer_failed(printers[prnid].name,
+				printers[prnid].alert.interval, printers[prnid].alert.method, printers[prnid].alert.address,
+				printers[prnid].spool_state.next_error_retry);
+		printer_new_status(&printers[prnid], PRNSTATUS_FAULT);
 		return -1;
 		}
 
-	if(pid)								/* parent */
-		{
-		DODEBUG_PRNSTART(("%s(): Starting printer \"%s\", pid=%d", function, destid_to_name(prnid), (int)pid));
-		active_printers++;								/* add to count of printers printing */
-		printers[prnid].job_pid = pid;					/* remember which process is printing it */
-		printers[prnid].job_destid = job->destid;		/* remember what job is being printed */
-		printers[prnid].job_id = job->id;
-		printers[prnid].job_subid = job->subid;
-		printer_new_status(&printers[prnid], PRNSTATUS_PRINTING);
-
-		queue_job_new_status(job->destid, job->id, job->subid, prnid);
-
-		/* If is a group job, mark last printer in group that was used. */
-		if(destid_is_group(job->destid))
-			groups[destid_to_gindex(job->destid)].last = destid_get_member_offset(job->destid, prnid);
-		}
-	else								/* child */
-		{
-		char jobname[MAX_PPR_PATH];
-		char pass_str[10];
-
-		/* Unblock the signals pprd blocks. */
-		child_unblock_all();
-
-		/*
-		** Reconstruct the queue file name.
-		** We can not use the library routine "local_jobid()" here
-		** because it tends to ommit parts which conform
-		** to default values.
-		*/
-		snprintf(jobname, sizeof(jobname), "%s-%d.%d",
-				destid_to_name(job->destid),
-				job->id,job->subid
-				);
-
-		/*
-		** Convert the pass number to a string so that
-		** we may use it as a argument to execl().
-		*/
-		snprintf(pass_str, sizeof(pass_str), "%d", job->pass);
-
-		/*
-		** If we will be tracked with strace, stop ourselves until strace is ready.
-		*/
-		#ifdef STRACE_OUTPUT
-		kill(getpid(), SIGSTOP);
-		#endif
+	DODEBUG_PRNSTART(("%s(): Starting printer \"%s\", pid=%d", function, destid_to_name(prnid), (int)pid));
+	active_printers++;								/* add to count of printers printing */
+	printers[prnid].job_pid = pid;					/* remember which process is printing it */
+	printers[prnid].job_destid = job->destid;		/* remember what job is being printed */
+	printers[prnid].job_id = job->id;
+	printers[prnid].job_subid = job->subid;
+	dispatch_started(prnid, job);					/* so that we can learn how fast it prints */
+	printer_new_status(&printers[prnid], PRNSTATUS_PRINTING);
 
-		/* Overlay this child process with pprdrv. */
-		execl(PPRDRV_PATH, "pprdrv",					/* execute the driver program */
-			destid_to_name(prnid),				/* printer name */
-			jobname,									/* full job id string */
-			pass_str,									/* pass number as a string */
-			(char*)NULL);
-
-		/*
-		** Give parent time to record PID in printers[].  If we don't allow
-		** it enough time to do that, the code in reapchild() will not
-		** understand the import of the death of this process.
-		*/
-		sleep(1);
-
-		/*
-		** We mustn't call fatal() here as it would remove the
-		** pprd lock file.  I am not even sure it is ok to
-		** call error() and exit().
-		*/
-		error("%s(): Can't execute pprdrv, execl() failed, errno = %d (%s)", function, errno, gu_strerror(errno));
-		alert(destid_to_name(prnid), TRUE, "Can't execute \"%s\", errno=%d (%s)", PPRDRV_PATH, errno, gu_strerror(errno));
-		exit(EXIT_PRNERR);
-		}
+	queue_job_new_status(job->destid, job->id, job->subid, prnid);
 
-	#ifdef STRACE_OUTPUT
-	{
-	char temp[10];
-	snprintf(temp, sizeof(temp), "%ld", (long)pid);
-	if(fork() == 0)
-		{
-		execl("/usr/bin/strace", "/usr/bin/strace", "-f", "-F", "-v", "-t", "-s", "128", "-o", STRACE_OUTPUT, "-p", temp, NULL);
-		_exit(1);
-		}
-	sleep(1);
-	kill(SIGCONT, pid);
-	}
-	#endif
+	/* If is a group job, mark last printer in group that was used. */
+	if(destid_is_group(job->destid))
+		groups[destid_to_gindex(job->destid)].last = destid_get_member_offset(job->destid, prnid);
+
+	/* The jobs waiting behind this one may now be pre-RIPed. */
+	prerip_look_for_work();
 
 	return 0;
 	} /* end of pprdrv_start() */
@@ -279,6 +283,9 @@ static void pprdrv_exited(int prnid, int wstat)
 			/* If we were trying to cancel the job, it is too late now. */
 			printers[prnid].cancel_job = FALSE;
 
+			/* Take note of how long it took. */
+			dispatch_printed(prnid);
+
 			/* Tell the user that the job has been printed. */
 			respond(printers[prnid].job_destid, printers[prnid].job_id, printers[prnid].job_subid, prnid, RESP_FINISHED);
 
@@ -340,12 +347,12 @@ static void pprdrv_exited(int prnid, int wstat)
 				}
 
 			/*
-			** If a single printer, set the never mask to 1,
+			** If a single printer, set bit zero of the never mask,
 			** arrest the job, and say the printer is incapable.
 			*/
 			if( ! destid_is_group(printers[prnid].job_destid) )
 				{
-				queue[y].never |= 1;
+				gu_bitset_set(&queue[y].never, 0);
 				job_status = STATUS_STRANDED;
 				respond(printers[prnid].job_destid,
 						printers[prnid].job_id, printers[prnid].job_subid,
@@ -361,22 +368,23 @@ static void pprdrv_exited(int prnid, int wstat)
 			else
 				{
 				/*
-				** Get a number with the bit corresponding to this
-				** printer's possition in this destination group
-				** and add that bit to the bits set in the never
-				** mask.  If the printer has been removed from
-				** the group since the job was started, then
-				** media_prn_bitmask() will return 0 which will
-				** be ok.
+				** Set the bit corresponding to this printer's
+				** possition in this destination group in the
+				** never mask.  If the printer has been removed
+				** from the group since the job was started, then
+				** destid_printer_bitnum() will return -1 and
+				** we set nothing.
 				*/
-				queue[y].never |= destid_printer_bit(printers[prnid].job_destid, prnid);
+				int bitnum = destid_printer_bitnum(printers[prnid].job_destid, prnid);
+				if(bitnum != -1)
+					gu_bitset_set(&queue[y].never, bitnum);
 
 				/*
 				** If every never bit has been set, then arrest the job and
 				** inform the user.  But, if that was the 1st pass, we give
 				** the job a second chance.
 				*/
-				if(queue[y].never == ((1 << groups[destid_to_gindex(printers[prnid].job_destid)].members) - 1))
+				if(gu_bitset_all(&queue[y].never, groups[destid_to_gindex(printers[prnid].job_destid)].members))
 					{
 					if( ++(queue[y].pass) > 2 ) /* if beyond the second pass */
 						{
@@ -387,7 +395,7 @@ static void pprdrv_exited(int prnid, int wstat)
 						}
 					else
 						{
-						queue[y].never = 0;
+						gu_bitset_clear_all(&queue[y].never);
 						}
 					}
 				} /* end of else (group of printers) */
@@ -483,11 +491,7 @@ static void pprdrv_exited(int prnid, int wstat)
 
 		case EXIT_PRNERR:
 			DODEBUG_PRNSTOP(("(fault)"));
-			alert(printers[prnid].name, FALSE, _("Printer placed in auto-retry mode."));
-			printers[prnid].spool_state.next_error_retry++;
-			printers[prnid].spool_state.countdown = printers[prnid].spool_state.next_error_retry * RETRY_MULTIPLIER;
-			if(printers[prnid].spool_state.countdown > MIN_RETRY)
-				printers[prnid].spool_state.countdown = MIN_RETRY;
+			pprdrv_fault_retry(prnid);
 			prn_status = PRNSTATUS_FAULT;
 			break;
 		}
@@ -0,0 +1,356 @@
+/*
+** mouse:~ppr/src/pprd/pprd_prerip.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This module puts idle time to use for printers which have a RIP.  While
+** a printer is printing one job, we run "pprdrv --prerip" on the jobs
+** waiting for it.  That runs each one through the RIP and saves the output
+** in the jobs directory, so that when the printer gets to the job pprdrv
+** can send it right away.  See the "Pre-RIP Cache" section of
+** pprdrv_rip.c for how pprdrv decides whether the saved output is still
+** good.
+**
+** Only jobs for printers are pre-RIPed since we can't know which member
+** of a group will print a group job.  Whether a printer has a RIP may
+** depend on its PPD file, so we don't know until pprdrv --prerip tells us
+** that it hasn't one.  After that its jobs are skipped until it is
+** reloaded.  The number of pprdrv --prerip
+** processes and the space which their output may take up are limited by
+** the [prerip] section of ppr.conf.  By default, nothing is pre-RIPed.
+**
+** The state of each job is kept in its queue entry, not in the queue file,
+** so after a restart each job is tried again.  If the output saved before
+** the restart is still good, pprdrv notices and exits right away.
+*/
+
+#include "config.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "pprd.h"
+#include "./pprd.auto_h"
+#include "interface.h"
+
+/* How many processes may be launched per tick? */
+#define MAX_LAUNCHES_PER_TICK 3
+
+/* Settings from ppr.conf. */
+static int max_active = 0;				/* most pprdrv --prerip at once */
+static long int budget_kbytes;			/* most space for saved output */
+
+/* The pprdrv --prerip processes.  The array is allocated with malloc()
+   since its size is set at startup. */
+static struct {
+	pid_t pid;
+	int destid;
+	int id;
+	int subid;
+	} *active_prerip = NULL;
+
+/* How many entries in the above array are in use? */
+static int active_prerips = 0;
+
+/* How many processes launched this tick? */
+static int launches_this_tick = 0;
+
+/* Space taken up by the saved output of jobs in the queue. */
+static long int used_kbytes = 0;
+
+/*
+** Read the settings from ppr.conf and set up the slots.
+*/
+void prerip_init(void)
+	{
+	const char function[] = "prerip_init";
+	char *p;
+	int x;
+
+	budget_kbytes = 100 * 1024;
+
+	if((p = gu_ini_query(PPR_CONF, "prerip", "maxjobs", 0, NULL)))
+		{
+		max_active = atoi(p);
+		gu_free(p);
+		}
+	if((p = gu_ini_query(PPR_CONF, "prerip", "diskbudget", 0, NULL)))
+		{
+		budget_kbytes = atol(p) * 1024;
+		gu_free(p);
+		}
+
+	if(max_active <= 0 || budget_kbytes <= 0)
+		{
+		max_active = 0;
+		return;
+		}
+
+	if(!(active_prerip = malloc(max_active * sizeof(active_prerip[0]))))
+		fatal(0, "%s(): malloc() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+	for(x=0; x < max_active; x++)
+		active_prerip[x].pid = 0;
+
+	debug("Pre-RIPing up to %d jobs at a time, %ld megabytes", max_active, budget_kbytes / 1024);
+	} /* end of prerip_init() */
+
+/*
+** Reconstruct the name of a file in which pprdrv --prerip may have left
+** output.  The suffix is "rip" or "rip.tmp".
+*/
+static void prerip_fname(char fname[], int destid, int id, int subid, const char suffix[])
+	{
+	ppr_fnamef(fname, "%s/%s-%d.%d-%s", DATADIR, destid_to_name(destid), id, subid, suffix);
+	}
+
+/*
+** Launch pprdrv --prerip for the indicated job.  It may write as much
+** output as remains in the budget.
+*/
+static int prerip_launch(struct QEntry *job)
+	{
+	const char function[] = "prerip_launch";
+	int x;
+	pid_t pid;
+
+	DODEBUG_PRERIP(("%s(job={%d,%d,%d})", function, job->destid, job->id, job->subid));
+
+	/* Find the first empty slot.  We know there is one. */
+	for(x=0; x < max_active; x++)
+		{
+		if(active_prerip[x].pid == 0)
+			break;
+		}
+	if(x == max_active)
+		fatal(0, "%s(): assertion failed", function);
+
+	{
+	char jobname[MAX_PPR_PATH];
+	char kbytes_str[16];
+	const char *args[] = {"pprdrv", "--prerip", kbytes_str, destid_to_name(job->destid), jobname, "0", NULL};
+
+	/* Connect stdin to /dev/null, and stdout and stderr to the pprd log file. */
+	const int fds[CHILD_FDS] = {CHILD_DEVNULL, CHILD_LOGFILE, CHILD_LOGFILE, CHILD_INHERIT};
+
+	snprintf(jobname, sizeof(jobname), "%s-%d.%d", destid_to_name(job->destid), job->id, job->subid);
+	snprintf(kbytes_str, sizeof(kbytes_str), "%ld", budget_kbytes - used_kbytes);
+
+	if((pid = child_spawn(PPRDRV_PATH, args, fds)) == -1)
+		{
+		error("%s(): can't start pprdrv, errno=%d (%s)", function, errno, gu_strerror(errno));
+		job->prerip = PRERIP_FAILED;
+		return -1;
+		}
+	}
+
+	DODEBUG_PRERIP(("%s(): slot %d, pid %ld", function, x, (long)pid));
+
+	active_prerip[x].pid = pid;
+	active_prerip[x].destid = job->destid;
+	active_prerip[x].id = job->id;
+	active_prerip[x].subid = job->subid;
+	active_prerips++;
+	launches_this_tick++;
+
+	job->prerip = PRERIP_RUNNING;
+
+	return 0;
+	} /* end of prerip_launch() */
+
+/*
+** Look for jobs worth pre-RIPing.  These are jobs which are waiting for a
+** printer which is busy printing something else.  Since the queue is in
+** the order in which jobs will be printed, we take them in that order.
+** This is called every tick and whenever a printer starts a job or a new
+** job arrives.
+*/
+void prerip_look_for_work(void)
+	{
+	int x;
+
+	if(max_active == 0 || active_prerips >= max_active || used_kbytes >= budget_kbytes)
+		return;
+
+	lock();
+
+	for(x=0; x < queue_entries && active_prerips < max_active && launches_this_tick < MAX_LAUNCHES_PER_TICK; x++)
+		{
+		if(queue[x].prerip == PRERIP_NONE
+				&& queue[x].status == STATUS_WAITING
+				&& destid_is_printer(queue[x].destid)
+				&& !printers[queue[x].destid].no_rip
+				&& printers[queue[x].destid].spool_state.status == PRNSTATUS_PRINTING)
+			{
+			if(prerip_launch(&queue[x]) == -1)
+				break;
+			}
+		}
+
+	unlock();
+	} /* end of prerip_look_for_work() */
+
+/*
+** This is called from reapchild().  If the process is one of ours, we note
+** the outcome in the job's queue entry.  If the job is gone, has been
+** moved, or has been started on its printer since we launched pprdrv, any
+** output is removed.
+*/
+gu_boolean prerip_child_hook(pid_t pid, int wstat)
+	{
+	FUNCTION4DEBUG("prerip_child_hook")
+	char fname[MAX_PPR_PATH];
+	struct QEntry *job = NULL;
+	int x, y;
+
+	for(x=0; x < max_active; x++)
+		{
+		if(active_prerip[x].pid == pid)
+			break;
+		}
+	if(x == max_active)
+		return FALSE;
+
+	DODEBUG_PRERIP(("%s(pid=%ld, wstat=0x%04x)", function, (long)pid, wstat));
+
+	lock();
+
+	for(y=0; y < queue_entries; y++)
+		{
+		if(queue[y].destid == active_prerip[x].destid
+				&& queue[y].id == active_prerip[x].id
+				&& queue[y].subid == active_prerip[x].subid
+				&& queue[y].prerip == PRERIP_RUNNING)
+			{
+			job = &queue[y];
+			break;
+			}
+		}
+
+	/* The temporary file is left only if pprdrv failed. */
+	prerip_fname(fname, active_prerip[x].destid, active_prerip[x].id, active_prerip[x].subid, "rip.tmp");
+	unlink(fname);
+
+	/* The printer has no RIP, so none of its jobs can be pre-RIPed. */
+	if(WIFEXITED(wstat) && WEXITSTATUS(wstat) == EXIT_PRNERR_NORETRY && destid_is_printer(active_prerip[x].destid))
+		{
+		DODEBUG_PRERIP(("%s(): printer %s has no RIP", function, destid_to_name(active_prerip[x].destid)));
+		printers[active_prerip[x].destid].no_rip = TRUE;
+		}
+
+	prerip_fname(fname, active_prerip[x].destid, active_prerip[x].id, active_prerip[x].subid, "rip");
+	if(job)
+		{
+		struct stat statbuf;
+		job->prerip = PRERIP_FAILED;
+		if(WIFEXITED(wstat) && WEXITSTATUS(wstat) == EXIT_PRINTED && stat(fname, &statbuf) == 0)
+			{
+			int kbytes = (int)((statbuf.st_size + 1023) / 1024);
+
+			/* Several may have been running at once, each
+			   allowed the whole of the remaining budget. */
+			if(used_kbytes + kbytes <= budget_kbytes)
+				{
+				job->prerip = PRERIP_DONE;
+				job->prerip_kbytes = kbytes;
+				used_kbytes += kbytes;
+				}
+			else
+				{
+				unlink(fname);
+				}
+			}
+		DODEBUG_PRERIP(("%s(): job %d %s, %ld of %ld kilobytes used", function, job->id,
+			job->prerip == PRERIP_DONE ? "done" : "failed", used_kbytes, budget_kbytes));
+		}
+	else
+		{
+		unlink(fname);
+		}
+
+	active_prerip[x].pid = 0;
+	active_prerips--;
+
+	unlock();
+
+	prerip_look_for_work();
+
+	return TRUE;
+	} /* end of prerip_child_hook() */
+
+/*
+** This is called every so often so that we can look for more work.
+*/
+void prerip_tick(void)
+	{
+	/* We have a new allotment of launches. */
+	launches_this_tick = 0;
+
+	prerip_look_for_work();
+	} /* end of prerip_tick() */
+
+/*
+** Stop pprdrv --prerip if it is running on this job.  The slot is
+** freed when it exits.
+*/
+static void prerip_kill(struct QEntry *job)
+	{
+	const char function[] = "prerip_kill";
+	int x;
+	for(x=0; x < max_active; x++)
+		{
+		if(active_prerip[x].pid > 0
+				&& active_prerip[x].destid == job->destid
+				&& active_prerip[x].id == job->id
+				&& active_prerip[x].subid == job->subid)
+			{
+			DODEBUG_PRERIP(("%s(): killing pid %ld", function, (long)active_prerip[x].pid));
+			if(kill(active_prerip[x].pid, SIGTERM) == -1)
+				error("%s(): kill(%ld, SIGTERM) failed, errno=%d (%s)", function, (long)active_prerip[x].pid, errno, gu_strerror(errno));
+			}
+		}
+	} /* end of prerip_kill() */
+
+/*
+** This is called from pprdrv_start() just before the job is started on
+** its printer.  If it hasn't been pre-RIPed by now, it is too late.
+*/
+void prerip_printing(struct QEntry *job)
+	{
+	if(job->prerip == PRERIP_RUNNING)
+		{
+		prerip_kill(job);
+		job->prerip = PRERIP_FAILED;
+		}
+	} /* end of prerip_printing() */
+
+/*
+** This is called when the job is about to be removed from the queue or
+** moved to another destination.  The caller removes or renames the files.
+** Once a job is moved it may be pre-RIPed again for its new printer.
+*/
+void prerip_forget(struct QEntry *job)
+	{
+	if(job->prerip == PRERIP_RUNNING)
+		prerip_kill(job);
+	else if(job->prerip == PRERIP_DONE)
+		used_kbytes -= job->prerip_kbytes;
+	job->prerip = PRERIP_NONE;
+	job->prerip_kbytes = 0;
+	} /* end of prerip_forget() */
+
+/* end of file */
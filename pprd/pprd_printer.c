@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 27 April 2006.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -57,6 +57,17 @@ static int printer_start(int prnid, struct QEntry *job)
 		return -1;
 		}
 
+	/*
+	** Don't start it if the SNMP poller has found it jammed, out of paper,
+	** or the like.  When the condition clears the poller will call
+	** printer_look_for_work().
+	*/
+	if(snmp_poller_held(prnid))
+		{
+		DODEBUG_PRNSTART(("%s(): printer \"%s\" is held by the SNMP poller", function, destid_to_name(prnid)));
+		return -1;
+		}
+
 	/*
 	** Don't start it if the destination is a group and it is held.
 	*/
@@ -68,17 +79,19 @@ static int printer_start(int prnid, struct QEntry *job)
 
 	/*
 	** Don't start it the printer doesn't have the forms or pprdrv has already
-	** ruled that it is incapable of printing this job.
+	** ruled that it is incapable of printing this job.  If the members of the
+	** group haven't been screened for this pass, do it now.
 	*/
+	capable_prescreen(job);
 	{
-	int bitmask = destid_printer_bit(job->destid, prnid);
-	DODEBUG_PRNSTART(("%s(): bitmask=%d, job->notnow=%d, job->never=%d", function, bitmask, job->notnow, job->never));
-	if(job->notnow & bitmask)
+	int bitnum = destid_printer_bitnum(job->destid, prnid);
+	DODEBUG_PRNSTART(("%s(): bitnum=%d", function, bitnum));
+	if(gu_bitset_test(&job->notnow, bitnum))
 		{
 		DODEBUG_PRNSTART(("%s(): notnow bit set for this printer", function));
 		return -2;
 		}
-	if(job->never & bitmask)
+	if(gu_bitset_test(&job->never, bitnum))
 		{
 		DODEBUG_PRNSTART(("%s(): never bit set for this printer", function));
 		return -2;
@@ -133,6 +146,11 @@ void printer_look_for_work(int prnid)
 					|| (destid_is_group(queue[x].destid) && destid_get_member_offset(queue[x].destid, prnid) != -1) )
 				)
 			{
+			/* The group's dispatch policy may want a busy member
+			   to print it. */
+			if(queue[x].destid != prnid && dispatch_holds(&queue[x], prnid))
+				continue;
+
 			/* Try to start the printer.  If the return value is 0 (success)
 			   or -1 (failure), then stop.  If it is -2 (job unsuitable),
 			   keep looking.
@@ -165,7 +183,8 @@ void group_look_for_work(int gindex)
 ** of them in turn.  We let printer_start() determine if the printers are
 ** idle and if `notnow' or `never' bits are set.  (Which would indicate that
 ** printers either don't have the required forms or are intrinsically
-** unsuitable for the job.)
+** unsuitable for the job.)  The order in which the members of a group are
+** tried is decided by the group's dispatch policy (see pprd_dispatch.c).
 **
 ** It is quite normal for this routine to fail.
 */
@@ -183,31 +202,33 @@ void printer_try_start_suitable_4_this_job(struct QEntry *job)
 	if(destid_is_group(job->destid))		/* if group, we have many to try */
 		{
 		struct Group *cl;
-		int x, y;
+		int *order;
+		int count, x;
 
 		cl = &groups[destid_to_gindex(job->destid)];
+		capable_prescreen(job);
 
-		if(cl->rotate)			/* if we should rotate */
-			y = cl->last;		/* set just before next one */
-		else					/* otherwise, set just before */
-			y = -1;				/* first printer */
+		/* The group's dispatch policy puts the members which might
+		   print the job in the order in which they should be tried.
+		   Members whose never or notnow bits are set are left out. */
+		order = (int*)gu_alloc(cl->members + 1, sizeof(int));
+		count = dispatch_order(job, order);
 
-		for(x=0; x < cl->members; x++)
-			{
-			#ifdef DEBUG_PRNSTART_GRITTY
-			debug("last printer in group was %d", y);
-			#endif
-
-			/* rotate to next printer */
-			y = (y+1) % cl->members;
+		#ifdef DEBUG_PRNSTART_GRITTY
+		debug("%d members to try", count);
+		#endif
 
+		for(x=0; x < count; x++)
+			{
 			#ifdef DEBUG_PRNSTART_GRITTY
-			debug("trying member %d",y);
+			debug("trying member %d", order[x]);
 			#endif
 
-			if(printer_start(cl->printers[y], job) == 0)
+			if(printer_start(cl->printers[order[x]], job) == 0)
 				break;
 			}
+
+		gu_free(order);
 		}
 	else							/* if a single printer, */
 		{							/* we can try only one */
@@ -243,6 +264,7 @@ void printer_new_status(struct Printer *printer, int newstatus)
 
 	/* Write out the status for use during restarts and by ppop. */
 	printer_spool_state_save(&(printer->spool_state), printer->name);
+	board_printer(printer - printers);
 
 	/* If ppop is waiting (ppop wstop), inform it that printer has stopt. */
 	if(printer->spool_state.status == PRNSTATUS_STOPT && printer->ppop_pid)
@@ -263,55 +285,55 @@ void printer_new_status(struct Printer *printer, int newstatus)
 		{
 		case PRNSTATUS_PRINTING:
 			state_update("PST %s printing %s %d",
-				printer,
+				printer->name,
 				jobid(destid_to_name(printer->job_destid), printer->job_id, printer->job_subid),
 				printer->spool_state.next_error_retry
 				);
 			break;
 		case PRNSTATUS_IDLE:
-			state_update("PST %s idle", printer);
+			state_update("PST %s idle", printer->name);
 			break;
 		case PRNSTATUS_CANCELING:
 			state_update("PST %s canceling %s",
-				printer,
+				printer->name,
 				jobid(destid_to_name(printer->job_destid), printer->job_id, printer->job_subid)
 				);
 			break;
 		case PRNSTATUS_SEIZING:
 			state_update("PST %s seizing %s",
-				printer,
+				printer->name,
 				jobid(destid_to_name(printer->job_destid), printer->job_id, printer->job_subid)
 				);
 			break;
 		case PRNSTATUS_FAULT:
 			state_update("PST %s fault %d %d",
-				printer,
+				printer->name,
 				printer->spool_state.next_error_retry,
 				printer->spool_state.countdown
 				);
 			break;
 		case PRNSTATUS_ENGAGED:
 			state_update("PST %s engaged %d %d",
-				printer,
+				printer->name,
 				printer->spool_state.next_engaged_retry,
 				printer->spool_state.countdown
 				);
 			break;
 		case PRNSTATUS_STARVED:
-			state_update("PST %s starved", printer);
+			state_update("PST %s starved", printer->name);
 			break;
 		case PRNSTATUS_STOPT:
-			state_update("PST %s stopt", printer);
+			state_update("PST %s stopt", printer->name);
 			break;
 		case PRNSTATUS_STOPPING:
 			state_update("PST %s stopping (printing %s)",
-				printer,
+				printer->name,
 				jobid(destid_to_name(printer->job_destid), printer->job_id, printer->job_subid)
 				);
 			break;
 		case PRNSTATUS_HALTING:
 			state_update("PST %s halting (printing %s)",
-				printer,
+				printer->name,
 				jobid(destid_to_name(printer->job_destid), printer->job_id, printer->job_subid)
 				);
 			break;
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 23 September 2005.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
@@ -105,31 +105,25 @@ static int question_launch(struct QEntry *job)
 		fatal(0, "%s(): assertion failed", function);
 	DODEBUG_QUESTIONS(("%s(): slot %d is free", function, x));
 
-	if((active_question[x].pid = fork()) == -1)
-		{
-		error("%s(): fork() failed, errno=%d (%s)", function, errno, strerror(errno));
-		return -1;
-		}
-
-	/* If child, */
-	if(active_question[x].pid == 0)
-		{
-		char jobname[256];
-		char filename[MAX_PPR_PATH];
-
-		/* Parent may have signals blocked. */
-		child_unblock_all();
+	{
+	char jobname[256];
+	char filename[MAX_PPR_PATH];
+	const char *args[] = {"pprd-question", jobname, filename, NULL};
 
-		/* Connect stdin to /dev/null, and stdout and stderr to the pprd log file. */
-		child_stdin_stdout_stderr("/dev/null", PPRD_LOGFILE);
+	/* Connect stdin to /dev/null, and stdout and stderr to the pprd log file. */
+	const int fds[CHILD_FDS] = {CHILD_DEVNULL, CHILD_LOGFILE, CHILD_LOGFILE, CHILD_INHERIT};
 
-		snprintf(jobname, sizeof(jobname), "%s-%d.%d", destid_to_name(job->destid), job->id, job->subid);
-		ppr_fnamef(filename, "%s/%s", QUEUEDIR, jobname);
+	snprintf(jobname, sizeof(jobname), "%s-%d.%d", destid_to_name(job->destid), job->id, job->subid);
+	ppr_fnamef(filename, "%s/%s", QUEUEDIR, jobname);
 
-		execl("lib/pprd-question", "pprd-question", jobname, filename, NULL);
-		debug("child: %s(): execl() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
-		exit(12);
+	if((active_question[x].pid = child_spawn("lib/pprd-question", args, fds)) == -1)
+		{
+		error("%s(): can't start pprd-question, errno=%d (%s)", function, errno, gu_strerror(errno));
+		active_question[x].pid = 0;
+		job->resend_message_at = time(NULL) + 60;	/* as if it had failed */
+		return -1;
 		}
+	}
 
 	DODEBUG_QUESTIONS(("%s(): pid is %ld", function, (long)active_question[x].pid));
 
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 9 September 2010.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -17,6 +17,7 @@
 
 #include "config.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
@@ -40,15 +41,22 @@ static void delete_job_files(const char *queuename, int id, int subid)
 
 	ppr_fnamef(filename, "%s/%s-%d.%d", QUEUEDIR, queuename, id, subid);
 	unlink(filename);
+	journal_forget(filename);
 
-	ppr_fnamef(filename, "%s/%s-%d.%d-comments", DATADIR, queuename, id, subid);
-	unlink(filename);
+	/* If the job was spooled in a single container file, the
+	   -comments, -pages, and -text files don't exist. */
+	ppr_fnamef(filename, "%s/%s-%d.%d-spool", DATADIR, queuename, id, subid);
+	if(unlink(filename) == -1)
+		{
+		ppr_fnamef(filename, "%s/%s-%d.%d-comments", DATADIR, queuename, id, subid);
+		unlink(filename);
 
-	ppr_fnamef(filename, "%s/%s-%d.%d-pages", DATADIR, queuename, id, subid);
-	unlink(filename);
+		ppr_fnamef(filename, "%s/%s-%d.%d-pages", DATADIR, queuename, id, subid);
+		unlink(filename);
 
-	ppr_fnamef(filename, "%s/%s-%d.%d-text", DATADIR, queuename, id, subid);
-	unlink(filename);
+		ppr_fnamef(filename, "%s/%s-%d.%d-text", DATADIR, queuename, id, subid);
+		unlink(filename);
+		}
 
 	ppr_fnamef(filename, "%s/%s-%d.%d-log", DATADIR, queuename, id, subid);
 	unlink(filename);
@@ -61,6 +69,9 @@ static void delete_job_files(const char *queuename, int id, int subid)
 
 	ppr_fnamef(filename, "%s/%s-%d.%d-cmdline", DATADIR, queuename, id, subid);
 	unlink(filename);
+
+	ppr_fnamef(filename, "%s/%s-%d.%d-rip", DATADIR, queuename, id, subid);
+	unlink(filename);
 	} /* end of delete_job_files() */
 
 /*===========================================================================
@@ -107,9 +118,16 @@ void queue_dequeue_job(int destid, int id, int subid)
 			{
 			DODEBUG_DEQUEUE(("removing job %s at position %d from queue", full_job_id, x));
 
-			/* Remove the actual job files. */
+			/* Stop any pre-RIP and remove the actual job files. */
+			prerip_forget(&queue[x]);
+			board_job_remove(&queue[x]);
 			delete_job_files(destname, id, subid);
 
+			gu_bitset_free(&queue[x].never);
+			gu_bitset_free(&queue[x].notnow);
+			if(queue[x].caps)
+				capable_job_free(queue[x].caps);
+
 			if((queue_entries-x) > 1)			/* do a move if not last entry */
 				{
 				memmove(&queue[x], &queue[x+1],
@@ -117,6 +135,7 @@ void queue_dequeue_job(int destid, int id, int subid)
 				}
 
 			queue_entries--;					/* one less (overall) in queue */
+			nextid_set_remove(queue_id_set, id);
 			job_count_adjust(destid, -1, TRUE);	/* in lese in destionation's queue */
 			break;								/* and we needn't look farther */
 			}
@@ -127,23 +146,16 @@ void queue_dequeue_job(int destid, int id, int subid)
 
 /*=========================================================================
 ** Update the "PPRD: XX XXXX\n" line at the start of the queue file.
+** The change goes into the journal (see pprd_journal.c).
 =========================================================================*/
 void queue_write_status_and_flags(struct QEntry *job)
 	{
-	const char function[] = "queue_write_status_and_flags";
 	char filename[MAX_PPR_PATH];
-	int fd;
 	char buf[65];
-	size_t written_size;
 
 	ppr_fnamef(filename, "%s/%s-%d.%d", QUEUEDIR, destid_to_name(job->destid), job->id, job->subid);
-	if((fd = open(filename, O_RDWR)) == -1)
-		{
-		error("%s(): can't open \"%s\", errno=%d (%s)", function, filename, errno, strerror(errno));
-		return;
-		}
 
-	/* Write the new line.  If the job is printing, substitute 0 for the actual printer index. */
+	/* Format the new line.  If the job is printing, substitute 0 for the actual printer index. */
 	if(snprintf(buf, sizeof(buf), "PPRD: %02X %08X %02X %04X                                      \n",
 			job->priority,
 			job->sequence_number,
@@ -152,12 +164,8 @@ void queue_write_status_and_flags(struct QEntry *job)
 			)
 		gu_Throw("Length of PPRD line is not 64 bytes!");
 
-	if((written_size = write(fd, buf, 64)) == -1)
-		error("%s(): write() failed, errno=%d (%s)", function, errno, strerror(errno));
-	else if(written_size != 64)
-		error("%s(): tried to write %d bytes but wrote %d instead", function, 64, (int)written_size);
-
-	close(fd);
+	/* The queue file is rewritten at the next checkpoint. */
+	journal_write_head(filename, buf);
 	} /* end of queue_write_status_and_flags() */
 
 /*===========================================================================
@@ -180,6 +188,7 @@ struct QEntry *queue_p_job_new_status(struct QEntry *job, int newstat)
 	job->status = newstat;
 
 	queue_write_status_and_flags(job);
+	board_job(job);
 
 	switch(job->status)
 		{
@@ -249,6 +258,44 @@ struct QEntry *queue_job_new_status(int destid, int id, int subid, int newstat)
 	return &queue[x];			/* return a pointer to the queue entry */
 	} /* end of queue_job_new_status() */
 
+/*===========================================================================
+** Fill in the parts of a queue entry which aren't loaded from the queue
+** file.  The fields from the "PPRD:" line, the media, and the summary of
+** what a group job needs must already be filled in.
+===========================================================================*/
+static void init_loaded_entry(struct QEntry *newent)
+	{
+	/*
+	** If this is a group job, set pass number to one, otherwise, set pass 
+	** number to zero which will indicate to pprdrv that this is not
+	** a group job.
+	*/
+	if(destid_is_group(newent->destid))
+		newent->pass = 1;
+	else
+		newent->pass = 0;
+
+	/* Clear the time of next response. */
+	newent->resend_message_at = 0;
+
+	/* Clear the bitmaps of printers which it is known can't print it
+	   and of those that can't print it right now because they don't
+	   have the required media mounted. */
+	gu_bitset_init(&newent->never);
+	gu_bitset_init(&newent->notnow);
+
+	/* It hasn't been pre-RIPed, at least not by this pprd. */
+	newent->prerip = PRERIP_NONE;
+
+	/* It gets a status board slot when it goes into the queue. */
+	newent->board_slot = -1;
+	newent->prerip_kbytes = 0;
+
+	/* If the job was printing (as indicated by a status of 0), then set its status to waiting. */
+	if(newent->status == 0)
+		newent->status = STATUS_WAITING;
+	} /* end of init_loaded_entry() */
+
 /*===========================================================================
 ** Receive a new job into the queue.
 **
@@ -260,9 +307,13 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 	const char function[] = "queue_accept_queuefile";
 	char *scratch = NULL;
 	const char *destname = NULL;
-	struct QEntry newent, *newentp;
+	struct QEntry newent, *newentp = NULL;
+	struct JOB_CAPS *caps = NULL;
 
 	scratch = gu_strdup(qfname);	/* because parse_qfname() modifies the array passed to it */
+	gu_bitset_init(&newent.never);
+	gu_bitset_init(&newent.notnow);
+	newent.caps = NULL;
 
 	gu_Try
 		{
@@ -304,6 +355,7 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 		gu_boolean pprd_line_seen = FALSE;
 		char tmedia[MAX_MEDIANAME+1];
 		int media_index = 0;
+		struct JOB_SIZE size;
 
 		DODEBUG_NEWJOB(("%s(qfname=\"%s\", newentry=?)", function, qfname));
 
@@ -312,6 +364,13 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 		if((qfile = fopen(qfname_path, "r")) == (FILE*)NULL)
 			gu_Throw("can't open \"%s\", errno=%d (%s)", qfname_path, errno, gu_strerror(errno));
 
+		/* For a group job, note what the printer must be able to do so that
+		   members which can't do it won't be tried. */
+		if(destid_is_group(newent.destid))
+			caps = capable_job_new();
+
+		dispatch_size_init(&size);
+
 		while((line = gu_getline(line, &line_available, qfile)))
 			{
 			if(gu_sscanf(line, "PPRD: %hx %x %hx %hx",
@@ -331,10 +390,17 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 				newent.media[media_index++] = get_media_id(tmedia);
 				continue;
 				}
+			if(caps)
+				capable_job_line(caps, line);
+			dispatch_size_line(&size, line);
 			}
 
 		fclose(qfile);
 
+		if(caps)
+			capable_job_fonts(caps);
+		newent.pages = dispatch_size_pages(&size);
+
 		if(!pprd_line_seen)
 			gu_Throw("no PPRD line");
 		
@@ -343,28 +409,9 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 			newent.media[media_index++] = -1;
 		}
 
-		/*
-		** If this is a group job, set pass number to one, otherwise, set pass 
-		** number to zero which will indicate to pprdrv that this is not
-		** a group job.
-		*/
-		if(destid_is_group(newent.destid))
-			newent.pass = 1;
-		else
-			newent.pass = 0;
-
-		/* Clear the time of next response. */
-		newent.resend_message_at = 0;
-
-		/* Clear the bitmaps of printers which it is known can't print it
-		   and of those that can't print it right now because they don't
-		   have the required media mounted. */
-		newent.never = 0;
-		newent.notnow = 0;
-
-		/* If the job was printing (as indicated by a status of 0), then set its status to waiting. */
-		if(newent.status == 0)
-			newent.status = STATUS_WAITING;
+		init_loaded_entry(&newent);
+		newent.caps = caps;
+		caps = NULL;
 
 		lock();
 
@@ -386,8 +433,15 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 				}
 			if(!(x < queue_entries))
 				gu_Throw("can't find job %d in queue array", newent.id);
+			gu_bitset_free(&queue[x].never);
+			gu_bitset_free(&queue[x].notnow);
+			if(queue[x].caps)
+				capable_job_free(queue[x].caps);
+			prerip_forget(&queue[x]);		/* it has probably changed */
+			newent.board_slot = queue[x].board_slot;
 			memcpy(&queue[x], &newent, sizeof(struct QEntry));
 			newentp = &queue[x];
+			board_job(newentp);
 			}
 		else
 			{
@@ -453,6 +507,7 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 	
 			/* increment our count of queue entries */
 			queue_entries++;
+			nextid_set_add(queue_id_set, newent.id);
 		
 			/* increment destination's job count */
 			job_count_adjust(newent.destid, 1, job_is_new);
@@ -461,6 +516,7 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 			state_update("JOB %s %d %d",
 					jobid(destname, newent.id, newent.subid),
 					x, destmates_passed);
+			board_job_add(newentp);
 			} /* new (and not reloaded) job */
 
 		/* If there is an outstanding question, then let the question system
@@ -472,9 +528,13 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 		if(newentp->flags & JOB_FLAG_QUESTION_UNANSWERED && newentp->status != STATUS_RECEIVING)
 			question_job(newentp);
 
-		/* If pprd isn't restarting and the job is ready to print, try to start a printer. */
+		/* If pprd isn't restarting and the job is ready to print, try to start
+		   a printer.  If its printer is busy, maybe it can be pre-RIPed. */
 		if(job_is_new && newentp->status == STATUS_WAITING)
+			{
 			printer_try_start_suitable_4_this_job(newentp);
+			prerip_look_for_work();
+			}
 
 		unlock();
 		}
@@ -484,11 +544,109 @@ void queue_accept_queuefile(const char qfname[], gu_boolean job_is_new, gu_boole
 		/* If we were able to parse the name of the bad job, we can delete its files. */
 		if(destname)
 			delete_job_files(destname, newent.id, newent.subid);
+		/* If the entry never made it into the queue, it still owns its bitsets
+		   and its summary. */
+		if(!newentp)
+			{
+			gu_bitset_free(&newent.never);
+			gu_bitset_free(&newent.notnow);
+			if(newent.caps)
+				capable_job_free(newent.caps);
+			}
+		if(caps)
+			capable_job_free(caps);
 		}
 
 	gu_free_if(scratch);
 	} /* end of queue_accept_queuefile() */
 
+/*===========================================================================
+** Load a whole set of jobs into the queue array at once.  This is used
+** by initialize_queue() when pprd starts.  The entries must be filled in
+** as queue_accept_queuefile() would fill them in from the queue files.
+** Rather than inserting each job in its place, we sort them all once.
+** The array passed to us is reordered.
+===========================================================================*/
+static int bulk_compare(const void *a, const void *b)
+	{
+	const struct QEntry *qa = (const struct QEntry *)a;
+	const struct QEntry *qb = (const struct QEntry *)b;
+
+	/* Higher priority numbers first, then earlier sequence numbers. */
+	if(qa->priority != qb->priority)
+		return qb->priority - qa->priority;
+	if(qa->sequence_number != qb->sequence_number)
+		return qa->sequence_number < qb->sequence_number ? -1 : 1;
+	if(qa->id != qb->id)
+		return qa->id - qb->id;
+	return qa->subid - qb->subid;
+	}
+
+void queue_accept_bulk(struct QEntry entries[], int count)
+	{
+	const char function[] = "queue_accept_bulk";
+	int *destmates;
+	int x;
+
+	DODEBUG_RECOVER(("%s(entries=?, count=%d)", function, count));
+
+	if(queue_entries != 0)
+		fatal(1, "%s(): assertion failed: queue_entries=%d", function, queue_entries);
+
+	if(count > QUEUE_SIZE_MAX)
+		{
+		error("%s(): %d jobs exceeds limit of %d, %d not loaded", function, count, QUEUE_SIZE_MAX, count - QUEUE_SIZE_MAX);
+		for(x=QUEUE_SIZE_MAX; x < count; x++)
+			{
+			if(entries[x].caps)
+				capable_job_free(entries[x].caps);
+			}
+		count = QUEUE_SIZE_MAX;
+		}
+
+	qsort(entries, count, sizeof(struct QEntry), bulk_compare);
+
+	lock();
+
+	if(count > queue_size)
+		{
+		queue_size = count + QUEUE_SIZE_GROWBY;
+		if(queue_size > QUEUE_SIZE_MAX)
+			queue_size = QUEUE_SIZE_MAX;
+		queue = (struct QEntry *)gu_realloc(queue, queue_size, sizeof(struct QEntry));
+		}
+
+	/* Destination ids run up to MAX_PRINTERS + MAX_GROUPS, so this is too
+	   big to be an automatic variable. */
+	destmates = (int*)gu_alloc(MAX_PRINTERS + MAX_GROUPS, sizeof(int));
+	memset(destmates, 0, (MAX_PRINTERS + MAX_GROUPS) * sizeof(int));
+
+	for(x=0; x < count; x++)
+		{
+		struct QEntry *newentp = &queue[x];
+
+		memcpy(newentp, &entries[x], sizeof(struct QEntry));
+		init_loaded_entry(newentp);
+		media_set_notnow_for_job(newentp, FALSE);
+
+		queue_entries++;
+		nextid_set_add(queue_id_set, newentp->id);
+		job_count_adjust(newentp->destid, 1, FALSE);
+
+		state_update("JOB %s %d %d",
+				jobid(destid_to_name(newentp->destid), newentp->id, newentp->subid),
+				x, destmates[newentp->destid]++);
+		board_job_add(newentp);
+
+		if(newentp->flags & JOB_FLAG_QUESTION_UNANSWERED && newentp->status != STATUS_RECEIVING)
+			question_job(newentp);
+		}
+
+	gu_free(destmates);
+
+	unlock();
+	} /* end of queue_accept_bulk() */
+
 /*===========================================================================
 ** This handles the j command from ppr.  The j command is used to inform
 ** pprd that a new job has been placed in the queue.  It calls
@@ -516,6 +674,13 @@ void queue_reload_job(char *command)
 		error("%s(): bad J command: %s", function, command);
 		return;
 		}
+	/* ppr has rewritten the queue file, so any "PPRD:" line
+	   we have yet to write is out of date. */
+	{
+	char filename[MAX_PPR_PATH];
+	ppr_fnamef(filename, "%s/%s", QUEUEDIR, qfname);
+	journal_forget(filename);
+	}
 	queue_accept_queuefile(qfname, TRUE, TRUE);
 	} /* end of queue_reload_job() */
 
@@ -0,0 +1,542 @@
+/*
+** mouse:~ppr/src/pprd/pprd_recover.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This module loads the jobs which are already in the queue when pprd
+** starts.  Since pprd accepts no commands until they are loaded, this is
+** made as fast as possible.
+**
+** When pprd shuts down cleanly, it writes a snapshot of the queue array
+** (PPRD_QUEUE_SNAPSHOT).  If the queue directory hasn't changed since the
+** snapshot was written, the jobs are loaded from it and only the queue
+** files of group jobs are opened, since the snapshot doesn't hold the
+** summaries of what they need (pprd_capable.c).  The snapshot is removed
+** as soon as it has been read so that it can never be used once the queue
+** has changed.
+**
+** To decide whether the directory has changed, the snapshot records its
+** modification time and its inode change time (to the nanosecond where
+** the system can tell us) and the number of files in it.  The mtime alone
+** isn't enough since a job can be added and another removed within the
+** same second, and the mtime can be set back with utime() but the ctime
+** can't.
+**
+** Otherwise, the queue files are read, in parallel worker threads if the
+** system has them.  The workers only read files and fill in an array
+** allocated beforehand, since libgu's memory allocator isn't thread safe.
+** The jobs are then sorted into the queue array all at once by
+** queue_accept_bulk().
+**
+** Jobs which can't be loaded either way are handed to
+** queue_accept_queuefile() one at a time so that they get the same error
+** messages and cleanup as always.
+*/
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifdef HAVE_PTHREADS
+#include <pthread.h>
+#endif
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "pprd.h"
+#include "./pprd.auto_h"
+
+#define RECOVER_MAX_THREADS 8			/* most worker threads to read queue files */
+#define RECOVER_QFNAME_MAX 64			/* longest queue file name in a snapshot */
+#define SNAPSHOT_MAGIC "PPRDQS3"
+
+/* What is read from a queue file. */
+struct RECOVER_FIELDS {
+	INT16_T priority;
+	unsigned int sequence_number;
+	INT16_T status;						/* as in the "PPRD:" line */
+	unsigned short int flags;
+	char media[MAX_DOCMEDIA][MAX_MEDIANAME+1];
+	int pages;							/* as worked out by dispatch_size_pages() */
+	} ;
+
+/* A job as read from its queue file or from the snapshot. */
+struct RECOVER_JOB {
+	char *qfname;
+	gu_boolean ok;						/* FALSE if it couldn't be read */
+	struct RECOVER_FIELDS fields;
+	struct JOB_CAPS *caps;				/* what a group job needs, not in snapshot */
+	} ;
+
+/* The snapshot is a header followed by an array of records. */
+struct SNAPSHOT_HEADER {
+	char magic[8];
+	int record_size;					/* sizeof(struct SNAPSHOT_RECORD) */
+	int count;							/* number of records which follow */
+	struct SNAPSHOT_STAMP {
+		time_t mtime;					/* when QUEUEDIR last changed */
+		long mtime_nsec;
+		time_t ctime;					/* when its inode last changed */
+		long ctime_nsec;
+		int entries;					/* files in it */
+		} queuedir;
+	} ;
+
+struct SNAPSHOT_RECORD {
+	char qfname[RECOVER_QFNAME_MAX];
+	struct RECOVER_FIELDS fields;
+	} ;
+
+/*
+** If the job is for a group, start the summary of what it needs so that
+** recover_parse() will fill it in.  This uses the libgu memory allocator,
+** so it must be done before the worker threads are started.
+*/
+static void recover_caps_new(struct RECOVER_JOB *job)
+	{
+	char *scratch = gu_strdup(job->qfname);	/* because parse_qfname() modifies it */
+	const char *destname;
+	int id, destid;
+	short int subid;
+
+	job->caps = NULL;
+	if(parse_qfname(scratch, &destname, &id, &subid) != -1
+			&& (destid = destid_by_name(destname)) != -1
+			&& destid_is_group(destid))
+		job->caps = capable_job_new();
+	gu_free(scratch);
+	} /* end of recover_caps_new() */
+
+/*
+** Read the "PPRD:" and "Media:" lines, those which give the size of the
+** job, and, for a group job, those which capable_job_line() wants from a
+** queue file.  This is called from the worker threads, so it must not use
+** the libgu memory allocator or gu_Throw().
+*/
+static void recover_parse(struct RECOVER_JOB *job)
+	{
+	char fname[MAX_PPR_PATH];
+	char line[256];
+	FILE *qfile;
+	gu_boolean line_start = TRUE;
+	int media_index = 0;
+	struct JOB_SIZE size;
+
+	job->ok = FALSE;
+	dispatch_size_init(&size);
+
+	ppr_fnamef(fname, "%s/%s", QUEUEDIR, job->qfname);
+	if(!(qfile = fopen(fname, "r")))
+		return;
+
+	while(fgets(line, sizeof(line), qfile))
+		{
+		gu_boolean this_line_start = line_start;
+		char *p;
+		if((p = strchr(line, '\n')))
+			{
+			*p = '\0';					/* as gu_getline() leaves it */
+			line_start = TRUE;
+			}
+		else
+			{
+			line_start = FALSE;
+			}
+		if(!this_line_start)			/* continuation of an overlong line */
+			continue;
+
+		if(gu_sscanf(line, "PPRD: %hx %x %hx %hx",
+				&job->fields.priority,
+				&job->fields.sequence_number,
+				&job->fields.status,
+				&job->fields.flags
+				) == 4
+			)
+			{
+			job->ok = TRUE;
+			continue;
+			}
+		if(media_index < MAX_DOCMEDIA && gu_sscanf(line, "Media: %@s", sizeof(job->fields.media[0]), job->fields.media[media_index]) == 1)
+			{
+			media_index++;
+			continue;
+			}
+		if(job->caps)
+			capable_job_line(job->caps, line);
+		dispatch_size_line(&size, line);
+		}
+
+	fclose(qfile);
+
+	job->fields.pages = dispatch_size_pages(&size);
+
+	while(media_index < MAX_DOCMEDIA)
+		job->fields.media[media_index++][0] = '\0';
+	} /* end of recover_parse() */
+
+#ifdef HAVE_PTHREADS
+struct RECOVER_WORK {
+	struct RECOVER_JOB *jobs;
+	int count;
+	int start;
+	int step;
+	} ;
+
+static void *recover_worker(void *arg)
+	{
+	struct RECOVER_WORK *work = (struct RECOVER_WORK *)arg;
+	int x;
+	for(x = work->start; x < work->count; x += work->step)
+		recover_parse(&work->jobs[x]);
+	return NULL;
+	}
+#endif
+
+/*
+** Read all of the queue files.  Returns the number of jobs found.
+*/
+static int recover_scan(struct RECOVER_JOB **jobs_ptr)
+	{
+	const char function[] = "recover_scan";
+	struct RECOVER_JOB *jobs;
+	int jobs_space = QUEUE_SIZE_INITIAL;
+	int count = 0;
+	DIR *dir;
+	struct dirent *direntp;
+
+	/* Make a list of the queue files. */
+	if(!(dir = opendir(QUEUEDIR)))
+		fatal(0, "%s(): can't open directory \"%s\", errno=%d (%s)", function, QUEUEDIR, errno, gu_strerror(errno));
+
+	jobs = gu_alloc(jobs_space, sizeof(struct RECOVER_JOB));
+	while((direntp = readdir(dir)))
+		{
+		if(direntp->d_name[0] == '.')			/* ignore "." and ".." */
+			continue;
+
+		DODEBUG_RECOVER(("%s(): inheriting queue file \"%s\"", function, direntp->d_name));
+
+		if(count == jobs_space)
+			{
+			jobs_space *= 2;
+			jobs = gu_realloc(jobs, jobs_space, sizeof(struct RECOVER_JOB));
+			}
+
+		jobs[count].qfname = gu_strdup(direntp->d_name);
+		recover_caps_new(&jobs[count]);
+		count++;
+		}
+
+	closedir(dir);
+
+	/* Read them. */
+	#ifdef HAVE_PTHREADS
+	{
+	pthread_t threads[RECOVER_MAX_THREADS];
+	struct RECOVER_WORK work[RECOVER_MAX_THREADS];
+	sigset_t all_signals, old_signals;
+	long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	int x, started;
+
+	if(nthreads > RECOVER_MAX_THREADS)
+		nthreads = RECOVER_MAX_THREADS;
+	if(nthreads > count / 100)			/* not worth it for small queues */
+		nthreads = count / 100;
+
+	/* The workers must not receive the signals meant for pprd. */
+	sigfillset(&all_signals);
+	pthread_sigmask(SIG_BLOCK, &all_signals, &old_signals);
+
+	for(started = 0; started < nthreads; started++)
+		{
+		work[started].jobs = jobs;
+		work[started].count = count;
+		work[started].start = started;
+		work[started].step = nthreads;
+		if(pthread_create(&threads[started], NULL, recover_worker, &work[started]) != 0)
+			break;
+		}
+
+	pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+
+	DODEBUG_RECOVER(("%s(): reading %d queue files with %d threads", function, count, started));
+
+	for(x=0; x < started; x++)
+		pthread_join(threads[x], NULL);
+
+	/* If there weren't enough jobs to bother or we couldn't start all of
+	   the threads, read them all here. */
+	if(started == 0 || started < nthreads)
+		{
+		for(x=0; x < count; x++)
+			recover_parse(&jobs[x]);
+		}
+	}
+	#else
+	{
+	int x;
+	for(x=0; x < count; x++)
+		recover_parse(&jobs[x]);
+	}
+	#endif
+
+	*jobs_ptr = jobs;
+	return count;
+	} /* end of recover_scan() */
+
+/*
+** Describe the queue directory as it is now.  Returns -1 if it can't.
+*/
+static int recover_queuedir_stamp(struct SNAPSHOT_STAMP *stamp)
+	{
+	struct stat statbuf;
+	DIR *dir;
+	struct dirent *direntp;
+
+	memset(stamp, 0, sizeof(*stamp));
+
+	if(stat(QUEUEDIR, &statbuf) == -1)
+		return -1;
+	stamp->mtime = statbuf.st_mtime;
+	stamp->ctime = statbuf.st_ctime;
+	#ifdef HAVE_STAT_NSEC
+	stamp->mtime_nsec = statbuf.st_mtim.tv_nsec;
+	stamp->ctime_nsec = statbuf.st_ctim.tv_nsec;
+	#endif
+
+	if(!(dir = opendir(QUEUEDIR)))
+		return -1;
+	while((direntp = readdir(dir)))
+		{
+		if(direntp->d_name[0] != '.')
+			stamp->entries++;
+		}
+	closedir(dir);
+
+	return 0;
+	} /* end of recover_queuedir_stamp() */
+
+/*
+** Load the snapshot if there is one and it is still good.  It is removed
+** in any case.  Returns the number of jobs or -1 if it can't be used.
+*/
+static int recover_snapshot_load(struct RECOVER_JOB **jobs_ptr)
+	{
+	const char function[] = "recover_snapshot_load";
+	int fd;
+	struct SNAPSHOT_HEADER header;
+	struct SNAPSHOT_STAMP now;
+	struct SNAPSHOT_RECORD *records;
+	size_t len;
+	int count = -1;
+
+	if((fd = open(PPRD_QUEUE_SNAPSHOT, O_RDONLY)) == -1)
+		return -1;
+	unlink(PPRD_QUEUE_SNAPSHOT);
+
+	do	{
+		if(read(fd, &header, sizeof(header)) != sizeof(header)
+				|| strcmp(header.magic, SNAPSHOT_MAGIC) != 0
+				|| header.record_size != sizeof(struct SNAPSHOT_RECORD)
+				|| header.count < 0)
+			{
+			error("%s(): \"%s\" is not a valid snapshot", function, PPRD_QUEUE_SNAPSHOT);
+			break;
+			}
+
+		/* If any job has been added or removed since pprd shut down, the
+		   directory will have been modified. */
+		if(recover_queuedir_stamp(&now) == -1
+				|| now.mtime != header.queuedir.mtime
+				|| now.mtime_nsec != header.queuedir.mtime_nsec
+				|| now.ctime != header.queuedir.ctime
+				|| now.ctime_nsec != header.queuedir.ctime_nsec
+				|| now.entries != header.queuedir.entries)
+			{
+			debug("%s(): \"%s\" has changed, not using snapshot", function, QUEUEDIR);
+			break;
+			}
+
+		len = header.count * sizeof(struct SNAPSHOT_RECORD);
+		records = gu_alloc(header.count + 1, sizeof(struct SNAPSHOT_RECORD));
+		if(read(fd, records, len) != len)
+			{
+			error("%s(): \"%s\" is truncated", function, PPRD_QUEUE_SNAPSHOT);
+			gu_free(records);
+			break;
+			}
+
+		{
+		struct RECOVER_JOB *jobs = gu_alloc(header.count + 1, sizeof(struct RECOVER_JOB));
+		int x;
+		for(x=0; x < header.count; x++)
+			{
+			records[x].qfname[sizeof(records[x].qfname) - 1] = '\0';
+			jobs[x].qfname = gu_strdup(records[x].qfname);
+			jobs[x].ok = TRUE;
+			memcpy(&jobs[x].fields, &records[x].fields, sizeof(struct RECOVER_FIELDS));
+
+			/* What a group job needs isn't in the snapshot, so read it
+			   from the queue file. */
+			recover_caps_new(&jobs[x]);
+			if(jobs[x].caps)
+				recover_parse(&jobs[x]);
+			}
+		*jobs_ptr = jobs;
+		}
+
+		gu_free(records);
+		count = header.count;
+		} while(FALSE);
+
+	close(fd);
+	return count;
+	} /* end of recover_snapshot_load() */
+
+/*
+** Write a snapshot of the queue array for the next run of pprd.  This is
+** called when pprd shuts down, after all state changes have been written
+** to the queue files.  The snapshot is only worth writing for a queue
+** of some size.
+*/
+void recover_snapshot_save(void)
+	{
+	const char function[] = "recover_snapshot_save";
+	char tempname[MAX_PPR_PATH];
+	struct SNAPSHOT_HEADER header;
+	struct SNAPSHOT_RECORD *records;
+	int fd, x, y;
+	size_t len;
+
+	if(queue_entries < 100)
+		return;
+
+	records = gu_alloc(queue_entries, sizeof(struct SNAPSHOT_RECORD));
+	memset(records, 0, queue_entries * sizeof(struct SNAPSHOT_RECORD));
+	for(x=0; x < queue_entries; x++)
+		{
+		struct QEntry *q = &queue[x];
+		struct SNAPSHOT_RECORD *record = &records[x];
+		if(snprintf(record->qfname, sizeof(record->qfname), "%s-%d.%d", destid_to_name(q->destid), q->id, q->subid) >= sizeof(record->qfname))
+			{
+			gu_free(records);
+			return;
+			}
+		record->fields.priority = q->priority;
+		record->fields.sequence_number = q->sequence_number;
+		record->fields.status = q->status >= 0 ? 0 : (q->status * -1);	/* as queue_write_status_and_flags() */
+		record->fields.flags = q->flags;
+		for(y=0; y < MAX_DOCMEDIA; y++)
+			gu_strlcpy(record->fields.media[y], get_media_name(q->media[y]), sizeof(record->fields.media[y]));
+		record->fields.pages = q->pages;
+		}
+
+	memset(&header, 0, sizeof(header));
+	strcpy(header.magic, SNAPSHOT_MAGIC);
+	header.record_size = sizeof(struct SNAPSHOT_RECORD);
+	header.count = queue_entries;
+	if(recover_queuedir_stamp(&header.queuedir) == -1)
+		{
+		gu_free(records);
+		return;
+		}
+
+	ppr_fnamef(tempname, "%s.new", PPRD_QUEUE_SNAPSHOT);
+	len = queue_entries * sizeof(struct SNAPSHOT_RECORD);
+	if((fd = open(tempname, O_WRONLY | O_CREAT | O_TRUNC, UNIX_644)) == -1
+			|| write(fd, &header, sizeof(header)) != sizeof(header)
+			|| write(fd, records, len) != len
+			|| fsync(fd) == -1
+			|| close(fd) == -1
+			|| rename(tempname, PPRD_QUEUE_SNAPSHOT) == -1)
+		{
+		error("%s(): can't write \"%s\", errno=%d (%s)", function, tempname, errno, gu_strerror(errno));
+		unlink(tempname);
+		}
+
+	gu_free(records);
+	} /* end of recover_snapshot_save() */
+
+/*
+** Load the jobs which are already in the queue.  Returns the number loaded.
+*/
+int recover_queue(void)
+	{
+	FUNCTION4DEBUG("recover_queue")
+	struct RECOVER_JOB *jobs;
+	struct QEntry *entries;
+	int count, loaded = 0, x, y;
+
+	if((count = recover_snapshot_load(&jobs)) == -1)
+		count = recover_scan(&jobs);
+	else
+		DODEBUG_RECOVER(("%s(): %d jobs in snapshot", function, count));
+
+	/* Convert what was read into queue entries. */
+	entries = gu_alloc(count > 0 ? count : 1, sizeof(struct QEntry));
+	for(x=0; x < count; x++)
+		{
+		struct RECOVER_JOB *job = &jobs[x];
+		struct QEntry *newent = &entries[loaded];
+		char *scratch;
+		const char *destname;
+
+		if(!job->ok)
+			continue;
+
+		scratch = gu_strdup(job->qfname);	/* because parse_qfname() modifies it */
+		if(parse_qfname(scratch, &destname, &newent->id, &newent->subid) == -1
+				|| (newent->destid = destid_by_name(destname)) == -1)
+			job->ok = FALSE;
+		gu_free(scratch);
+		if(!job->ok)
+			continue;
+
+		if(job->caps)
+			capable_job_fonts(job->caps);
+		newent->caps = job->caps;
+		job->caps = NULL;
+		newent->priority = job->fields.priority;
+		newent->sequence_number = job->fields.sequence_number;
+		newent->status = job->fields.status * -1;
+		newent->flags = job->fields.flags;
+		for(y=0; y < MAX_DOCMEDIA; y++)
+			newent->media[y] = job->fields.media[y][0] ? get_media_id(job->fields.media[y]) : -1;
+		newent->pages = job->fields.pages;
+
+		loaded++;
+		}
+
+	queue_accept_bulk(entries, loaded);
+	gu_free(entries);
+
+	/* Let the usual code report and remove the ones which couldn't be loaded. */
+	for(x=0; x < count; x++)
+		{
+		if(!jobs[x].ok)
+			queue_accept_queuefile(jobs[x].qfname, FALSE, FALSE);
+		if(jobs[x].caps)
+			capable_job_free(jobs[x].caps);
+		gu_free(jobs[x].qfname);
+		}
+
+	gu_free(jobs);
+	return queue_entries;
+	} /* end of recover_queue() */
+
+/* end of file */
@@ -7,16 +7,21 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 13 June 2008.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "gu.h"
 #include "global_defines.h"
 #include "global_structs.h"
@@ -24,12 +29,147 @@
 #include "./pprd.auto_h"
 
 /*
-** This is called whenever a responder exits.
+** Messages go to a single long-running "ppr-respond --dispatcher" which
+** runs the responders from a bounded pool and combines messages for the
+** same recipient (see responders/ppr-respond.c).  Each message is one
+** datagram on a SOCK_SEQPACKET socket.  The queue file and the job's log
+** file, if it has one, go with it as open file descriptors since they may
+** be deleted as soon as we return.  If
+** the dispatcher isn't running or its socket is full, we fall back to
+** running ppr-respond for the message alone.  If the dispatcher dies, it
+** is restarted no more often than every DISPATCHER_RESTART_INTERVAL
+** seconds.
+*/
+#define DISPATCHER_RESTART_INTERVAL 60
+
+static int dispatcher_fd = -1;			/* our end of the socket */
+static pid_t dispatcher_pid = 0;
+static time_t dispatcher_started = 0;
+
+/*
+** Start the responder dispatcher.
+*/
+static void dispatcher_start(void)
+	{
+	const char function[] = "dispatcher_start";
+	int sockets[2];
+	pid_t pid;
+
+	dispatcher_started = time(NULL);
+
+	if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets) == -1)
+		{
+		error("%s(): socketpair() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+		return;
+		}
+
+	/* Neither end may be left open in the dispatcher beyond its stdin,
+	   else it would never see end of file when we exit. */
+	gu_set_cloexec(sockets[0]);
+	gu_set_cloexec(sockets[1]);
+
+	/* Connect stdin to our socket, and stdout and stderr to the pprd log file. */
+	{
+	const char *args[] = {"ppr-respond", "--dispatcher", NULL};
+	const int fds[CHILD_FDS] = {sockets[1], CHILD_LOGFILE, CHILD_LOGFILE, CHILD_INHERIT};
+	if((pid = child_spawn(LIBDIR"/ppr-respond", args, fds)) == -1)
+		{
+		error("%s(): can't start ppr-respond, errno=%d (%s)", function, errno, gu_strerror(errno));
+		close(sockets[0]);
+		close(sockets[1]);
+		return;
+		}
+	}
+
+	close(sockets[1]);
+	gu_nonblock(sockets[0], TRUE);
+	dispatcher_fd = sockets[0];
+	dispatcher_pid = pid;
+	DODEBUG_RESPOND(("%s(): pid=%ld", function, (long)pid));
+	} /* end of dispatcher_start() */
+
+/*
+** Pass a message to the dispatcher.  The parameters are the name=value
+** pairs in params[].  If log_fd isn't -1, it is passed after the queue
+** file.  Returns -1 if the dispatcher couldn't take it.
+*/
+static int dispatcher_send(int qfile_fd, int log_fd, const char *params[])
+	{
+	const char function[] = "dispatcher_send";
+	char buffer[1024];
+	size_t len = 0;
+	union {
+		struct cmsghdr align;
+		char space[CMSG_SPACE(2 * sizeof(int))];
+		} control;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	int fds[2];
+	int nfds = 0;
+	int x;
+
+	/* The pairs are separated by NULs. */
+	for(x=0; params[x]; x += 2)
+		{
+		size_t needed = strlen(params[x]) + strlen(params[x+1]) + 2;
+		if((len + needed) > sizeof(buffer))
+			return -1;
+		len += snprintf(buffer + len, sizeof(buffer) - len, "%s=%s", params[x], params[x+1]) + 1;
+		}
+
+	iov.iov_base = buffer;
+	iov.iov_len = len;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	fds[nfds++] = qfile_fd;
+	if(log_fd != -1)
+		fds[nfds++] = log_fd;
+	msg.msg_control = control.space;
+	msg.msg_controllen = CMSG_SPACE(nfds * sizeof(int));
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(nfds * sizeof(int));
+	memcpy(CMSG_DATA(cmsg), fds, nfds * sizeof(int));
+
+	if(sendmsg(dispatcher_fd, &msg, MSG_DONTWAIT) == -1)
+		{
+		if(errno == EAGAIN)
+			DODEBUG_RESPOND(("%s(): dispatcher is backlogged", function));
+		else
+			error("%s(): sendmsg() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+		return -1;
+		}
+
+	return 0;
+	} /* end of dispatcher_send() */
+
+/*
+** Start the dispatcher when pprd starts.
+*/
+void responder_init(void)
+	{
+	dispatcher_start();
+	} /* end of responder_init() */
+
+/*
+** This is called whenever a child exits.  Only the dispatcher is claimed.
+** Those run by respond2() when it isn't available aren't acknowledged.
 */
 gu_boolean responder_child_hook(pid_t pid, int wstat)
 	{
-	/* For now we don't acknowledge our children. */
-	return FALSE;
+	if(dispatcher_pid == 0 || pid != dispatcher_pid)
+		return FALSE;
+
+	if(WIFEXITED(wstat) && WEXITSTATUS(wstat) != 0)
+		error("Responder dispatcher exited with code %d", WEXITSTATUS(wstat));
+
+	close(dispatcher_fd);
+	dispatcher_fd = -1;
+	dispatcher_pid = 0;
+	return TRUE;
 	} /* responder_child_hook() */
 
 /*
@@ -43,67 +183,93 @@ void respond2(const char *destname, int id, int subid, int prnid, const char *pr
 	const char function[] = "respond2";
 	char job[256];
 	char filename[MAX_PPR_PATH];
+	char response_code_str[8];
+	char per_duplex_str[8];
+	char per_simplex_str[8];
 	int qfile_fd;
+	int log_fd;
 	pid_t pid;							/* Process id of ppr-respond */
 
     /* Format the job name is verbose format.  This will be used to build queue file names. */
 	snprintf(job, sizeof(job), "%s-%d.%d", destname, id, subid);
 
-	/* Open the queue file before the fork since it may be deleted when we return. */
+	/* Open the queue file now since it may be deleted when we return. */
 	ppr_fnamef(filename, "%s/%s", QUEUEDIR, job);
 	if((qfile_fd = open(filename, O_RDONLY)) == -1)
 		{
 		fprintf(stderr, "Can't open \"%s\", errno=%d (%s)\n", filename, errno, gu_strerror(errno));
 		return;
 		}
+	gu_set_cloexec(qfile_fd);			/* dispatcher_start() may be called below */
+
+	/* The responder gets the job log file, if there is one, on stdin. */
+	ppr_fnamef(filename, "%s/%s-log", DATADIR, job);
+	if((log_fd = open(filename, O_RDONLY)) != -1)
+		gu_set_cloexec(log_fd);
 
-	if((pid = fork()) == -1)					/* if error, */
+	/* The response code and the printer charge rates */
+	snprintf(response_code_str, sizeof(response_code_str), "%d", response_code);
+	per_duplex_str[0] = '\0';
+	per_simplex_str[0] = '\0';
+	if(prnid > -1)
 		{
-		error("%s(): can't fork(), errno=%d (%s)", function, errno, gu_strerror(errno));
+		snprintf(per_duplex_str, sizeof(per_duplex_str), "%d", printers[prnid].charge_per_duplex);
+		snprintf(per_simplex_str, sizeof(per_simplex_str), "%d", printers[prnid].charge_per_simplex);
 		}
-	else if(pid == 0)							/* if child, */
-		{
-		char per_duplex_str[8];
-		char per_simplex_str[8];
 
-		/* Parent may have signals blocked. */
-		child_unblock_all();
+	if(dispatcher_pid == 0 && (time(NULL) - dispatcher_started) >= DISPATCHER_RESTART_INTERVAL)
+		dispatcher_start();
 
-		/* Move the queue file to file descriptor 3 if it isn't there already. */
-		if(qfile_fd != 3)
+	if(dispatcher_fd != -1)
+		{
+		const char *params[] = {
+			"job", job,
+			"response_code", response_code_str,
+			"destination", destname,
+			"printer", prnname ? prnname : "",
+			"charge_per_duplex", per_duplex_str,
+			"charge_per_simplex", per_simplex_str,
+			NULL
+			};
+		if(dispatcher_send(qfile_fd, log_fd, params) == 0)
 			{
-			dup2(qfile_fd, 3);
+			if(log_fd != -1)
+				close(log_fd);
 			close(qfile_fd);
+			return;
 			}
+		}
 
-		/* Connect stdin to the job log file, and stdout and stderr to the pprd log file. */
-		ppr_fnamef(filename, "%s/%s-log", DATADIR, job);
-		child_stdin_stdout_stderr(filename, PPRD_LOGFILE);
+	{
+	const char *args[] = {
+		"ppr-respond",
+		"qfile_fd3",
+		gu_name_str_value("job", job),
+		gu_name_int_value("response_code", response_code),
+		gu_name_str_value("destination", destname),
+		gu_name_str_value("printer", prnname),	/* NULL is handled */
+		gu_name_str_value("charge_per_duplex", per_duplex_str),
+		gu_name_str_value("charge_per_simplex", per_simplex_str),
+		NULL
+		};
+	int fds[CHILD_FDS] = {CHILD_DEVNULL, CHILD_LOGFILE, CHILD_LOGFILE, qfile_fd};
+	int x;
 
-		/* 4th and 5th are the printer charge rates */
-		per_duplex_str[0] = '\0';
-		per_simplex_str[0] = '\0';
-		if(prnid > -1)
-			{
-			snprintf(per_duplex_str, sizeof(per_duplex_str), "%d", printers[prnid].charge_per_duplex);
-			snprintf(per_simplex_str, sizeof(per_simplex_str), "%d", printers[prnid].charge_per_simplex);
-			}
+	if(log_fd != -1)
+		fds[0] = log_fd;
+
+	if((pid = child_spawn(LIBDIR"/ppr-respond", args, fds)) == -1)
+		error("%s(): can't start ppr-respond, errno=%d (%s)", function, errno, gu_strerror(errno));
+
+	/* The name=value arguments were allocated by gu_name_*_value().  They
+	   are counted rather than freed up to the first NULL so that none can
+	   be missed. */
+	for(x=2; x < (int)(sizeof(args) / sizeof(args[0])) - 1; x++)
+		gu_free((char*)args[x]);
+	}
 
-		/* Here we go! */
-		execl(LIBDIR"/ppr-respond", "ppr-respond",
-			"qfile_fd3",
-			gu_name_str_value("job", job),
-			gu_name_int_value("response_code", response_code),
-			gu_name_str_value("destination", destname),
-			gu_name_str_value("printer", prnname),	/* NULL is handled */
-			gu_name_str_value("charge_per_duplex", per_duplex_str),
-			gu_name_str_value("charge_per_simplex", per_simplex_str),
-			NULL);
-		debug("child: %s(): execl() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
-		exit(12);
-		} /* end of child clause */
-
-	/* parent drops through */
+	if(log_fd != -1)
+		close(log_fd);
 	DODEBUG_RESPOND(("%s(): pid=%ld", function, (long)pid));
 	close(qfile_fd);
 	} /* end of respond2() */
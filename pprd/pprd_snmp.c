@@ -0,0 +1,667 @@
+/*
+** mouse:~ppr/src/pprd/pprd_snmp.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This module polls network printers for their status using SNMP.
+**
+** The interface programs only query a printer while they are printing on
+** it, so without this pprd knows nothing of an idle printer's condition
+** and will happily send a job to a printer which is jammed or out of paper.
+** Here we keep a single unconnected UDP socket.  At each timer tick a GET
+** for hrDeviceStatus, hrPrinterStatus, and hrPrinterDetectedErrorState is
+** sent to each printer whose last query is at least "poll interval" seconds
+** old.  The answers arrive through the main select() loop and are matched
+** to printers by source address and request id, much as in ip_scan_snmp.
+**
+** A printer is held when its status is of at least "hold severity" (see
+** translate_snmp_error() and translate_snmp_status()).  printer_start()
+** will not start a held printer.  When the condition clears, we look for
+** work for the printer.  An answer more than three poll intervals old no
+** longer holds the printer, so a printer that stops answering is treated
+** as if it were never polled.
+**
+** The printers polled are those which use the tcpip, jetdirect, or
+** appsocket interface unless the interface option "snmp_status_interval=0"
+** is set.  The interface option "snmp_community" is honoured.
+**
+** A printer whose address is a name rather than a number isn't polled until
+** the name has been looked up.  So that neither loading the printers nor
+** the main loop waits for DNS, the lookups are done by a child process
+** which writes the answers to a pipe which we add to the select() list.
+*/
+
+#include "config.h"
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#ifndef INADDR_NONE
+#define INADDR_NONE -1
+#endif
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "pprd.h"
+#include "pprd.auto_h"
+
+#define SNMP_POLLER_INTERVAL 60			/* default seconds between queries */
+#define SNMP_POLLER_SEVERITY 7			/* default severity which holds a printer */
+#define SNMP_POLLER_BATCH 64			/* most queries sent in one tick */
+#define SNMP_POLLER_STALE 3				/* poll intervals after which an answer is stale */
+
+static struct gu_snmp *snmp = NULL;		/* NULL if the poller is off */
+static int poll_interval = SNMP_POLLER_INTERVAL;
+static int hold_severity = SNMP_POLLER_SEVERITY;
+static int snmp_port = 161;
+
+/* The name lookup child and the pipe from it */
+static pid_t resolver_pid = 0;
+static int resolver_fd = -1;
+static char *resolver_buf = NULL;
+static int resolver_len = 0;
+static int resolver_space = 0;
+
+/* The three objects we ask for */
+static const char *snmp_oids[] = {
+	"1.3.6.1.2.1.25.3.2.1.5.1",			/* hrDeviceStatus */
+	"1.3.6.1.2.1.25.3.5.1.1.1",			/* hrPrinterStatus */
+	"1.3.6.1.2.1.25.3.5.1.2.1"			/* hrPrinterDetectedErrorState */
+	};
+
+/*
+** Read the settings from ppr.conf and open the socket.  This must be
+** called before the printers are loaded.
+*/
+void snmp_poller_init(void)
+	{
+	char *p;
+
+	if((p = gu_ini_query(PPR_CONF, "snmppoller", "pollinterval", 0, NULL)))
+		{
+		poll_interval = atoi(p);
+		gu_free(p);
+		}
+	if((p = gu_ini_query(PPR_CONF, "snmppoller", "holdseverity", 0, NULL)))
+		{
+		hold_severity = atoi(p);
+		gu_free(p);
+		}
+	if((p = gu_ini_query(PPR_CONF, "snmppoller", "port", 0, NULL)))
+		{
+		snmp_port = atoi(p);
+		gu_free(p);
+		}
+
+	if(poll_interval <= 0)
+		{
+		debug("SNMP poller disabled");
+		return;
+		}
+
+	gu_Try
+		{
+		snmp = gu_snmp_open(INADDR_NONE, NULL);
+		gu_set_cloexec(gu_snmp_fd(snmp));
+		}
+	gu_Catch
+		{
+		error("can't start SNMP poller: %s", gu_exception);
+		snmp = NULL;
+		}
+	} /* end of snmp_poller_init() */
+
+/*
+** This is called by load_printer() with the printer's "Interface:",
+** "Address:", and "Options:" lines.  If the printer is one we should poll,
+** it allocates printer->snmp.  If the address is a name, it is left for
+** snmp_poller_resolve() to look up.
+*/
+void snmp_poller_printer_config(struct Printer *printer, const char interface[], const char address[], const char options[])
+	{
+	char *host, *p;
+	unsigned long int ip_address;
+	char *community = NULL;
+
+	printer->snmp = NULL;
+
+	if(!snmp || !interface || !address)
+		return;
+	if(strcmp(interface, "tcpip") != 0 && strcmp(interface, "jetdirect") != 0 && strcmp(interface, "appsocket") != 0)
+		return;
+
+	if(options)
+		{
+		struct OPTIONS_STATE o;
+		char name[32], value[64];
+		int retval;
+
+		options_start(options, &o);
+		while((retval = options_get_one(&o, name, sizeof(name), value, sizeof(value))) > 0)
+			{
+			if(strcmp(name, "snmp_status_interval") == 0 && atoi(value) == 0)
+				{
+				gu_free_if(community);
+				return;
+				}
+			if(strcmp(name, "snmp_community") == 0)
+				{
+				gu_free_if(community);
+				community = gu_strdup(value);
+				}
+			}
+		}
+
+	/* The host is the part before the port number. */
+	host = gu_strdup(address);
+	if((p = strchr(host, ':')))
+		*p = '\0';
+	ip_address = inet_addr(host);
+
+	printer->snmp = gu_alloc(1, sizeof(struct PRINTER_SNMP));
+	memset(printer->snmp, 0, sizeof(struct PRINTER_SNMP));
+	printer->snmp->ip_address = ip_address;
+	printer->snmp->community = community;
+	printer->snmp->hrDeviceStatus = -1;
+	printer->snmp->hrPrinterStatus = -1;
+
+	if(ip_address == INADDR_NONE)
+		{
+		printer->snmp->host = host;
+		DODEBUG_SNMP(("will poll \"%s\" once \"%s\" is looked up", printer->name, host));
+		}
+	else
+		{
+		gu_free(host);
+		DODEBUG_SNMP(("will poll \"%s\" at %s", printer->name, inet_ntoa(*(struct in_addr*)&ip_address)));
+		}
+	} /* end of snmp_poller_printer_config() */
+
+/*
+** Forget about a printer.  This is called when its configuration is
+** about to be reloaded or it is deleted.
+*/
+void snmp_poller_printer_free(struct Printer *printer)
+	{
+	if(printer->snmp)
+		{
+		gu_free_if(printer->snmp->community);
+		gu_free_if(printer->snmp->host);
+		gu_free(printer->snmp);
+		printer->snmp = NULL;
+		}
+	} /* end of snmp_poller_printer_free() */
+
+/*
+** Return TRUE if the poller has an answer from the printer which isn't stale.
+*/
+static gu_boolean snmp_poller_fresh(struct PRINTER_SNMP *ps, time_t time_now)
+	{
+	return ps->last_response > 0 && (time_now - ps->last_response) <= (poll_interval * SNMP_POLLER_STALE);
+	}
+
+/*
+** Decide whether the status in ps should keep jobs off the printer.
+*/
+static gu_boolean snmp_poller_assess(struct PRINTER_SNMP *ps)
+	{
+	int x, severity;
+
+	if(hold_severity <= 0)
+		return FALSE;
+
+	/* Only "down" is trusted here since many printers never leave "unknown". */
+	if(ps->hrDeviceStatus == 5)
+		{
+		translate_snmp_status(ps->hrDeviceStatus, ps->hrPrinterStatus, NULL, NULL, &severity);
+		if(severity >= hold_severity)
+			return TRUE;
+		}
+
+	for(x=0; x < SNMP_POLLER_BITS; x++)
+		{
+		if(ps->hrPrinterDetectedErrorState & (1U << x))
+			{
+			translate_snmp_error(x, NULL, NULL, &severity);
+			if(severity >= hold_severity)
+				return TRUE;
+			}
+		}
+
+	return FALSE;
+	} /* end of snmp_poller_assess() */
+
+/*
+** Hold or release a printer.  If it is released and idle, look for work
+** for it.
+*/
+static void snmp_poller_set_held(int prnid, gu_boolean held)
+	{
+	struct Printer *printer = &printers[prnid];
+
+	if(held == printer->snmp->held)
+		return;
+
+	printer->snmp->held = held;
+	debug("SNMP poller %s printer \"%s\"", held ? "holds" : "releases", printer->name);
+
+	if(!held && printer->spool_state.status == PRNSTATUS_IDLE)
+		printer_look_for_work(prnid);
+	} /* end of snmp_poller_set_held() */
+
+/*
+** Record an answer from a printer.
+*/
+static void snmp_poller_update(int prnid, int device_status, int printer_status, unsigned int errorstate)
+	{
+	struct PRINTER_SNMP *ps = printers[prnid].snmp;
+	time_t time_now = time(NULL);
+	int x;
+
+	DODEBUG_SNMP(("\"%s\": %d %d %08x", printers[prnid].name, device_status, printer_status, errorstate));
+
+	if(device_status != ps->hrDeviceStatus || printer_status != ps->hrPrinterStatus || ps->status_since == 0)
+		ps->status_since = time_now;
+	for(x=0; x < SNMP_POLLER_BITS; x++)
+		{
+		if(!(errorstate & (1U << x)))
+			ps->error_since[x] = 0;
+		else if(ps->error_since[x] == 0)
+			ps->error_since[x] = time_now;
+		}
+
+	ps->hrDeviceStatus = device_status;
+	ps->hrPrinterStatus = printer_status;
+	ps->hrPrinterDetectedErrorState = errorstate;
+	ps->last_response = time_now;
+	ps->request_id = 0;
+
+	snmp_poller_set_held(prnid, snmp_poller_assess(ps));
+	} /* end of snmp_poller_update() */
+
+/*
+** If any printer's name is due to be looked up and the child which does
+** it isn't already running, start it.  Since it is a copy of us, it simply
+** goes through printers[] and looks up each name which is still waiting.
+** For each it writes a line with the address, or "-" if the lookup
+** failed, and the name.  A name which can't be found is tried again every
+** poll interval.
+*/
+static void snmp_poller_resolve(time_t time_now)
+	{
+	int fds[2];
+	pid_t pid;
+	int prnid, due;
+
+	if(resolver_pid != 0 || resolver_fd != -1)
+		return;
+
+	for(prnid=due=0; prnid < printer_count; prnid++)
+		{
+		struct PRINTER_SNMP *ps = printers[prnid].snmp;
+		if(ps && ps->host && printers[prnid].spool_state.status != PRNSTATUS_DELETED && (time_now - ps->last_query) >= poll_interval)
+			due++;
+		}
+	if(due == 0)
+		return;
+
+	if(pipe(fds) == -1)
+		{
+		error("SNMP poller: pipe() failed, errno=%d (%s)", errno, gu_strerror(errno));
+		return;
+		}
+
+	if((pid = fork()) == -1)
+		{
+		error("SNMP poller: fork() failed, errno=%d (%s)", errno, gu_strerror(errno));
+		close(fds[0]);
+		close(fds[1]);
+		return;
+		}
+
+	if(pid == 0)			/* child */
+		{
+		FILE *f;
+		child_unblock_all();
+		close(fds[0]);
+		if(!(f = fdopen(fds[1], "w")))
+			_exit(1);
+		for(prnid=0; prnid < printer_count; prnid++)
+			{
+			struct PRINTER_SNMP *ps = printers[prnid].snmp;
+			struct hostent *hostinfo;
+			if(!ps || !ps->host || printers[prnid].spool_state.status == PRNSTATUS_DELETED)
+				continue;
+			if((hostinfo = gethostbyname(ps->host)) && hostinfo->h_addrtype == AF_INET)
+				fprintf(f, "%s %s\n", inet_ntoa(*(struct in_addr*)hostinfo->h_addr_list[0]), ps->host);
+			else
+				fprintf(f, "- %s\n", ps->host);
+			}
+		fclose(f);
+		_exit(0);
+		}
+
+	close(fds[1]);
+	gu_set_cloexec(fds[0]);
+	resolver_pid = pid;
+	resolver_fd = fds[0];
+	resolver_len = 0;
+
+	for(prnid=0; prnid < printer_count; prnid++)
+		{
+		struct PRINTER_SNMP *ps = printers[prnid].snmp;
+		if(ps && ps->host)
+			ps->last_query = time_now;
+		}
+	} /* end of snmp_poller_resolve() */
+
+/*
+** Read what the name lookup child has written.  Once it closes the pipe,
+** give each printer still waiting for a name we now have its address.
+** Printers may have been reloaded in the meantime, which is why the
+** answers are matched by name.
+*/
+static void snmp_poller_resolved(void)
+	{
+	char *line, *next, *name;
+	int len, prnid;
+
+	if(resolver_space - resolver_len < 256)
+		{
+		resolver_space += 1024;
+		resolver_buf = gu_realloc(resolver_buf, resolver_space, sizeof(char));
+		}
+
+	while((len = read(resolver_fd, resolver_buf + resolver_len, resolver_space - resolver_len - 1)) == -1 && errno == EINTR)
+		;
+	if(len > 0)
+		{
+		resolver_len += len;
+		return;
+		}
+	if(len == -1)
+		error("SNMP poller: read() from name lookup process failed, errno=%d (%s)", errno, gu_strerror(errno));
+
+	close(resolver_fd);
+	resolver_fd = -1;
+	resolver_buf[resolver_len] = '\0';
+
+	for(line = resolver_buf; (next = strchr(line, '\n')); line = next + 1)
+		{
+		*next = '\0';
+		if(!(name = strchr(line, ' ')))
+			continue;
+		*(name++) = '\0';
+
+		for(prnid=0; prnid < printer_count; prnid++)
+			{
+			struct PRINTER_SNMP *ps = printers[prnid].snmp;
+
+			if(!ps || !ps->host || strcmp(ps->host, name) != 0)
+				continue;
+
+			if(strcmp(line, "-") == 0)
+				{
+				if(!ps->lookup_failed)
+					{
+					error("SNMP poller can't determine IP address of printer \"%s\" (\"%s\")", printers[prnid].name, name);
+					ps->lookup_failed = TRUE;
+					}
+				continue;
+				}
+
+			ps->ip_address = inet_addr(line);
+			gu_free(ps->host);
+			ps->host = NULL;
+			ps->last_query = 0;			/* poll at the next tick */
+			DODEBUG_SNMP(("will poll \"%s\" at %s", printers[prnid].name, line));
+			}
+		}
+	} /* end of snmp_poller_resolved() */
+
+/*
+** This is called from tick().  It sends queries to the printers that are
+** due and lets go of printers whose answers have gone stale.
+*/
+void snmp_poller_tick(void)
+	{
+	static int next_prnid = 0;			/* where the last batch left off */
+	char packet[512];
+	struct sockaddr_in printer_addr;
+	time_t time_now;
+	int x, sent;
+
+	if(!snmp)
+		return;
+
+	time(&time_now);
+
+	snmp_poller_resolve(time_now);
+
+	memset(&printer_addr, 0, sizeof(printer_addr));
+	printer_addr.sin_family = AF_INET;
+	printer_addr.sin_port = htons(snmp_port);
+
+	for(x=sent=0; x < printer_count; x++)
+		{
+		int prnid = (next_prnid + x) % printer_count;
+		struct PRINTER_SNMP *ps = printers[prnid].snmp;
+		struct gu_snmp_items items[3];
+		int i, len;
+
+		if(!ps || ps->host || ps->unsupported || printers[prnid].spool_state.status == PRNSTATUS_DELETED)
+			continue;
+
+		if(ps->held && !snmp_poller_fresh(ps, time_now))
+			snmp_poller_set_held(prnid, FALSE);
+
+		if((time_now - ps->last_query) < poll_interval)
+			continue;
+
+		if(sent == SNMP_POLLER_BATCH)
+			{
+			next_prnid = prnid;
+			return;
+			}
+
+		for(i=0; i < 3; i++)
+			{
+			items[i].oid = snmp_oids[i];
+			items[i].type = i < 2 ? GU_SNMP_INT : GU_SNMP_BIT;
+			items[i].ptr = NULL;
+			}
+		snmp->community = ps->community ? ps->community : "public";
+		len = gu_snmp_create_packet(snmp, packet, &ps->request_id, items, 3);
+
+		memcpy(&printer_addr.sin_addr, &ps->ip_address, sizeof(printer_addr.sin_addr));
+		if(sendto(gu_snmp_fd(snmp), packet, len, 0, (struct sockaddr *)&printer_addr, sizeof(printer_addr)) == -1)
+			DODEBUG_SNMP(("sendto() for \"%s\" failed, errno=%d (%s)", printers[prnid].name, errno, gu_strerror(errno)));
+
+		ps->last_query = time_now;
+		sent++;
+		}
+
+	next_prnid = 0;
+	} /* end of snmp_poller_tick() */
+
+/*
+** Add the poller's socket and the pipe from the name lookup process, if
+** it is running, to the select() list.
+*/
+int snmp_poller_fd_set(int lastfd, fd_set *fdset)
+	{
+	int fd;
+	if(!snmp)
+		return lastfd;
+	fd = gu_snmp_fd(snmp);
+	FD_SET(fd, fdset);
+	if(fd > lastfd)
+		lastfd = fd;
+	if(resolver_fd != -1)
+		{
+		FD_SET(resolver_fd, fdset);
+		if(resolver_fd > lastfd)
+			lastfd = resolver_fd;
+		}
+	return lastfd;
+	} /* end of snmp_poller_fd_set() */
+
+/*
+** If select() says the socket is ready, read all of the answers waiting
+** and return TRUE.  Likewise if the pipe from the name lookup process is
+** ready.
+*/
+gu_boolean snmp_poller_hook(int selret, fd_set *fdset)
+	{
+	char *buffer;
+	int buffer_len;
+
+	if(!snmp || selret < 1)
+		return FALSE;
+
+	if(resolver_fd != -1 && FD_ISSET(resolver_fd, fdset))
+		{
+		snmp_poller_resolved();
+		return TRUE;
+		}
+
+	if(!FD_ISSET(gu_snmp_fd(snmp), fdset))
+		return FALSE;
+
+	buffer = gu_snmp_recv_buf(snmp, &buffer_len);
+
+	for( ; ; )
+		{
+		struct sockaddr_in from;
+		socklen_t fromlen = sizeof(from);
+		int len, prnid;
+
+		if((len = recvfrom(gu_snmp_fd(snmp), buffer, buffer_len, MSG_DONTWAIT, (struct sockaddr *)&from, &fromlen)) == -1)
+			{
+			if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNREFUSED)
+				error("SNMP poller: recvfrom() failed, errno=%d (%s)", errno, gu_strerror(errno));
+			if(errno == EINTR || errno == ECONNREFUSED)
+				continue;
+			break;
+			}
+
+		/* Several printers may share an address, so try the request id
+		   of each. */
+		for(prnid=0; prnid < printer_count; prnid++)
+			{
+			struct PRINTER_SNMP *ps = printers[prnid].snmp;
+			int device_status, printer_status;
+			unsigned int errorstate;
+			struct gu_snmp_items items[3];
+			int ret = -1;
+
+			if(!ps || ps->request_id == 0 || memcmp(&from.sin_addr, &ps->ip_address, sizeof(from.sin_addr)) != 0)
+				continue;
+
+			items[0].oid = snmp_oids[0];
+			items[0].type = GU_SNMP_INT;
+			items[0].ptr = &device_status;
+			items[1].oid = snmp_oids[1];
+			items[1].type = GU_SNMP_INT;
+			items[1].ptr = &printer_status;
+			items[2].oid = snmp_oids[2];
+			items[2].type = GU_SNMP_BIT;
+			items[2].ptr = &errorstate;
+
+			gu_snmp_set_result_len(snmp, len);
+			gu_Try
+				{
+				ret = gu_snmp_parse_response(snmp, ps->request_id, items, 3);
+				}
+			gu_Catch
+				{
+				ps->request_id = 0;
+				if(strstr(gu_exception, "(noSuchName)"))
+					{
+					debug("SNMP poller: printer \"%s\" doesn't support the Printer MIB, won't poll it again", printers[prnid].name);
+					ps->unsupported = TRUE;
+					snmp_poller_set_held(prnid, FALSE);
+					}
+				else
+					{
+					DODEBUG_SNMP(("bad answer from \"%s\": %s", printers[prnid].name, gu_exception));
+					}
+				break;
+				}
+
+			if(ret == -1)
+				continue;
+
+			snmp_poller_update(prnid, device_status, printer_status, errorstate);
+			break;
+			}
+		}
+
+	return TRUE;
+	} /* end of snmp_poller_hook() */
+
+/*
+** This is called from reapchild().  We claim the name lookup process.
+*/
+gu_boolean snmp_poller_child_hook(pid_t pid, int wstat)
+	{
+	if(resolver_pid == 0 || pid != resolver_pid)
+		return FALSE;
+	resolver_pid = 0;
+	return TRUE;
+	} /* end of snmp_poller_child_hook() */
+
+/*
+** Return TRUE if the poller says the printer can't print right now.
+*/
+gu_boolean snmp_poller_held(int prnid)
+	{
+	return printers[prnid].snmp && printers[prnid].snmp->held;
+	} /* end of snmp_poller_held() */
+
+/*
+** Write the poller's last answer from the printer in the form of the
+** auxiliary status lines which pprdrv leaves in the device_status file.
+** Returns FALSE if there is no fresh answer.
+*/
+gu_boolean snmp_poller_status(FILE *outfile, int prnid)
+	{
+	struct PRINTER_SNMP *ps = printers[prnid].snmp;
+	int x;
+
+	if(!ps || !snmp_poller_fresh(ps, time(NULL)))
+		return FALSE;
+
+	fprintf(outfile, "status: %d %d %ld %ld 0\n", ps->hrDeviceStatus, ps->hrPrinterStatus, (long)ps->status_since, (long)ps->last_response);
+	for(x=0; x < SNMP_POLLER_BITS; x++)
+		{
+		if(ps->error_since[x])
+			fprintf(outfile, "errorstate: %02d %ld %ld 0\n", x, (long)ps->error_since[x], (long)ps->last_response);
+		}
+	fprintf(outfile, "snmp-status: %d %d %d", ps->held ? 1 : 0, ps->hrDeviceStatus, ps->hrPrinterStatus);
+	for(x=0; x < SNMP_POLLER_BITS; x++)
+		{
+		if(ps->error_since[x])
+			fprintf(outfile, " %d", x);
+		}
+	fputc('\n', outfile);
+
+	return TRUE;
+	} /* end of snmp_poller_status() */
+
+/* end of file */
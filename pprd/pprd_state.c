@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 3 April 2006.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
@@ -40,6 +40,17 @@
 #include "global_structs.h"
 #include "pprd.h"
 #include "pprd.auto_h"
+#include "status_board.h"
+
+/* The status board, NULL if it couldn't be created. */
+static struct STATUS_BOARD *board = NULL;
+
+/* A stack of the job slots which aren't in use. */
+static int *free_job_slots = NULL;
+static int free_job_slots_count = 0;
+
+/* Should state_update() write to STATE_UPDATE_FILE? */
+static gu_boolean text_feed = TRUE;
 
 /*
 ** Send a line to the file which is read by programs which display
@@ -57,6 +68,9 @@ void state_update(const char *string, ... )
 	va_list va;
 	char line[128];
 
+	if(!text_feed)
+		return;
+
 	while(handle == -1 || countdown <= 0)
 		{
 		if(handle == -1)
@@ -94,5 +108,164 @@ void state_update(const char *string, ... )
 	countdown--;
 	} /* end of state_update() */
 
+/*
+** Create the status board (see libppr/status_board.c).  If we can't, the
+** text feed is kept going even if ppr.conf says it isn't wanted.  This
+** must be called before the first call to state_update().
+*/
+void board_init(void)
+	{
+	const char function[] = "board_init";
+	char *p;
+	int x;
+
+	if((p = gu_ini_query(PPR_CONF, "status", "textfeed", 0, NULL)))
+		{
+		if(gu_torf_setBOOL(&text_feed, p) == -1)
+			error("%s(): text feed in [status] section of ppr.conf should be yes or no", function);
+		gu_free(p);
+		}
+
+	if(!(board = status_board_create()))
+		{
+		error("%s(): can't create \"%s\", errno=%d (%s)", function, STATUS_BOARD_FILE, errno, gu_strerror(errno));
+		text_feed = TRUE;
+		return;
+		}
+
+	/* The lowest numbered slots are handed out first so that
+	   readers have less to scan. */
+	free_job_slots = gu_alloc(STATUS_BOARD_JOBS, sizeof(int));
+	for(x=0; x < STATUS_BOARD_JOBS; x++)
+		free_job_slots[x] = STATUS_BOARD_JOBS - 1 - x;
+	free_job_slots_count = STATUS_BOARD_JOBS;
+	} /* end of board_init() */
+
+/*
+** Copy the state of a printer to its slot on the status board.  This is
+** called whenever the printer's status changes and when it is loaded,
+** reloaded, or deleted.  The second half of the slot belongs to pprdrv.
+*/
+void board_printer(int prnid)
+	{
+	struct Printer *printer = &printers[prnid];
+	struct STATUS_BOARD_PRINTER *slot;
+
+	if(!board || prnid >= STATUS_BOARD_PRINTERS)
+		return;
+
+	slot = &board->printers[prnid];
+	if(prnid >= board->header->printers_used)
+		board->header->printers_used = prnid + 1;
+
+	status_board_write_begin(&slot->seq);
+
+	if(printer->spool_state.status == PRNSTATUS_DELETED)
+		slot->name[0] = '\0';
+	else
+		gu_strlcpy(slot->name, printer->name, sizeof(slot->name));
+	slot->status = printer->spool_state.status;
+	slot->countdown = printer->spool_state.countdown;
+	slot->retry = 0;
+	slot->job_destname[0] = '\0';
+	slot->job_id = slot->job_subid = 0;
+
+	switch(printer->spool_state.status)
+		{
+		case PRNSTATUS_FAULT:
+			slot->retry = printer->spool_state.next_error_retry;
+			break;
+		case PRNSTATUS_ENGAGED:
+			slot->retry = printer->spool_state.next_engaged_retry;
+			break;
+		case PRNSTATUS_PRINTING:
+		case PRNSTATUS_CANCELING:
+		case PRNSTATUS_SEIZING:
+		case PRNSTATUS_STOPPING:
+		case PRNSTATUS_HALTING:
+			gu_strlcpy(slot->job_destname, destid_to_name(printer->job_destid), sizeof(slot->job_destname));
+			slot->job_id = printer->job_id;
+			slot->job_subid = printer->job_subid;
+			break;
+		}
+
+	status_board_write_end(board, &slot->seq, &slot->changed);
+	} /* end of board_printer() */
+
+/*
+** Give a job which has just entered the queue a slot on the status board.
+*/
+void board_job_add(struct QEntry *job)
+	{
+	job->board_slot = -1;
+
+	if(!board || free_job_slots_count == 0)
+		return;
+
+	job->board_slot = free_job_slots[--free_job_slots_count];
+	if(job->board_slot >= board->header->jobs_used)
+		board->header->jobs_used = job->board_slot + 1;
+
+	board_job(job);
+	}
+
+/*
+** Copy the state of a job to its slot on the status board.  This is called
+** whenever its status, priority, or destination changes.
+*/
+void board_job(struct QEntry *job)
+	{
+	struct STATUS_BOARD_JOB *slot;
+
+	if(!board || job->board_slot < 0)
+		return;
+
+	slot = &board->jobs[job->board_slot];
+	status_board_write_begin(&slot->seq);
+	gu_strlcpy(slot->destname, destid_to_name(job->destid), sizeof(slot->destname));
+	slot->id = job->id;
+	slot->subid = job->subid;
+	slot->priority = job->priority;
+	slot->status = job->status;
+	status_board_write_end(board, &slot->seq, &slot->changed);
+	}
+
+/*
+** Clear the slot of a job which is leaving the queue and put it back
+** on the stack.
+*/
+void board_job_remove(struct QEntry *job)
+	{
+	struct STATUS_BOARD_JOB *slot;
+
+	if(!board || job->board_slot < 0)
+		return;
+
+	slot = &board->jobs[job->board_slot];
+	status_board_write_begin(&slot->seq);
+	slot->destname[0] = '\0';
+	status_board_write_end(board, &slot->seq, &slot->changed);
+
+	free_job_slots[free_job_slots_count++] = job->board_slot;
+	job->board_slot = -1;
+	}
+
+/*
+** Return the number of pages which pprdrv has reported starting on the
+** job the printer is printing, or -1 if it hasn't reported any.
+*/
+int board_printer_pages_started(int prnid)
+	{
+	struct STATUS_BOARD_PRINTER slot;
+
+	if(!board || prnid >= STATUS_BOARD_PRINTERS || status_board_read_printer(board, prnid, &slot) == -1)
+		return -1;
+
+	if(slot.drv_job_id != printers[prnid].job_id || slot.drv_job_subid != printers[prnid].job_subid)
+		return -1;
+
+	return slot.pages_started;
+	}
+
 /* end of file */
 
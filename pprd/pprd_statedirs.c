@@ -7,7 +7,12 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 27 April 2006.
+** Last modified 19 October 2026.
+*/
+
+/*
+** The spool_state files are written by way of the journal.  See
+** pprd_journal.c.
 */
 
 #include "config.h"
@@ -26,13 +31,9 @@
 void printer_spool_state_save(struct PRINTER_SPOOL_STATE *pstate, const char prnname[])
 	{
 	char fname[MAX_PPR_PATH];
-	int fd;
 	char temp[128];
-	int len;
 	ppr_fnamef(fname, "%s/%s/spool_state", PRINTERS_PERSISTENT_STATEDIR, prnname);
-	if((fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC, UNIX_644)) == -1)
-		fatal(0, "can't create \"%s\" for write, errno=%d (%s)", fname, errno, strerror(errno));
-	len = gu_snprintf(temp, sizeof(temp), "%d %d %d %d %d %d %d %d %d\n",
+	gu_snprintf(temp, sizeof(temp), "%d %d %d %d %d %d %d %d %d\n",
 		pstate->accepting,
 		pstate->previous_status,
 		pstate->status,
@@ -43,28 +44,22 @@ void printer_spool_state_save(struct PRINTER_SPOOL_STATE *pstate, const char prn
 		pstate->protected,
 		pstate->job_count
 		);
-	write(fd, temp, len);
-	close(fd);
+	journal_write_file(fname, temp);
 	} /* printer_spool_state_save() */
 
 void group_spool_state_save(struct GROUP_SPOOL_STATE *gstate, const char grpname[])
 	{
 	char fname[MAX_PPR_PATH];
-	int fd;
 	char temp[128];
-	int len;
 	ppr_fnamef(fname, "%s/%s/spool_state", GROUPS_PERSISTENT_STATEDIR, grpname);
-	if((fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC, UNIX_644)) == -1)
-		fatal(0, "can't create \"%s\" for write, errno=%d (%s)", fname, errno, strerror(errno));
-	len = gu_snprintf(temp, sizeof(temp), "%d %d %d %d %d\n",
+	gu_snprintf(temp, sizeof(temp), "%d %d %d %d %d\n",
 		gstate->accepting,
 		gstate->held,
 		gstate->printer_state_change_time,
 		gstate->protected,
 		gstate->job_count
 		);
-	write(fd, temp, len);
-	close(fd);
+	journal_write_file(fname, temp);
 	} /* group_spool_state_save() */
 
 /* end of file */
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 7 April 2006.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -72,6 +72,10 @@ volatile gu_boolean sigalrm_caught;
 /* Are we running with the --test switch? */
 int test_mode = FALSE;
 
+/* Are we running with the --prerip switch?  If so, test_mode is set too. */
+gu_boolean prerip_mode = FALSE;
+static long int prerip_kbytes;					/* most RIP output to save */
+
 /* Queue entry variables. */
 const char *QueueFile;							/* name of queue file of job to print */
 FILE *qstream;									/* queue file "handle" */
@@ -904,6 +908,7 @@ static void copy_a_page(int newnumber)
 	   */
 	dgetline(text);
 	tokenize();
+	rip_page_boundary(FALSE);
 	printer_printf("%%%%Page: %s %d\n", tokens[1] ? tokens[1] : "?", newnumber);
 	progress_page_start_comment_sent();			/* tell routines in pprdrv_progress.c */
 
@@ -1114,6 +1119,7 @@ static void copy_pages(void)
 						|| job.N_Up.sigsheets
 							|| ((sheetnumber+print_direction) != sheetlimit) )
 						{
+						rip_page_boundary(FALSE);
 						printer_printf("%%%%Page: dummy %d\n", pagenumber + 1);
 						printer_puts("showpage\n\n");	/* note extra newline */
 						}
@@ -1155,6 +1161,8 @@ static void copy_trailer(void)
 	if(fseek(text, temp_offset, SEEK_SET))
 		fatal(EXIT_JOBERR, "%s(): can't seek to trailer in -text", function);
 
+	rip_page_boundary(TRUE);
+
 	/* Copy -text to printer until EOF or unenclosed %%EOF comment. */
 	while(dgetline(text))
 		{
@@ -1211,6 +1219,8 @@ static void pprdrv_read_printer_conf(void)
 	printer.RIP.name = NULL;
 	printer.RIP.output_language = NULL;
 	printer.RIP.options_storage = NULL;
+	printer.RIP.parallel_workers = 0;			/* one RIP for the whole job */
+	printer.RIP.parallel_pages = 0;
 	printer.do_banner = BANNER_DISCOURAGED;		/* default flag */
 	printer.do_trailer = BANNER_DISCOURAGED;	/* page settings */
 	printer.OutputOrder = 0;					/* unknown */
@@ -1307,6 +1317,11 @@ static void pprdrv_read_printer_conf(void)
 			if((count = gu_sscanf(tptr, "%S %S %T", &printer.RIP.name, &printer.RIP.output_language, &printer.RIP.options_storage)) < 2)
 				fatal(EXIT_PRNERR_NORETRY, "Invalid \"%s\" (%s line %d).", "RIP:", cfname, linenum);
 			}
+		else if((count = gu_sscanf(confline, "RIPParallel: %d %d", &printer.RIP.parallel_workers, &printer.RIP.parallel_pages)) > 0)
+			{
+			if(count != 2 || printer.RIP.parallel_workers < 0 || printer.RIP.parallel_pages < 1)
+				fatal(EXIT_PRNERR_NORETRY, _("Invalid \"%s\" (%s line %d)."), "RIPParallel:", cfname, linenum);
+			}
 
 		/*
 		** Read amount to charge the poor user.
@@ -1569,6 +1584,25 @@ static void select_copies_method(void)
 	copies_pages_countdown = job.opts.copies;
 	} /* end of select_copies_method() */
 
+/*
+** Return TRUE if the pages which copy_pages() sends can be divided into
+** ranges which can be rendered separately, each preceded by everything
+** which comes before the first page.  This is called from rip_start() to
+** decide whether a parallel RIP may be used.  It is not so if the pages
+** depend on one another, if we are doing N-Up or signature printing
+** (since pages would have to be kept together on sheets), or if the
+** printer is collating copies itself.
+*/
+gu_boolean pages_independent(void)
+	{
+	return job.attr.script
+		&& job.attr.pages > 0
+		&& job.attr.pageorder != PAGEORDER_SPECIAL
+		&& job.N_Up.N == 1
+		&& job.N_Up.sigsheets == 0
+		&& copies_auto_collate != 1;
+	} /* end of pages_independent() */
+
 /*
 ** Compute things about pages.  This is called once from main().
 ** This routine will only exit if there is an internal error.
@@ -1645,17 +1679,6 @@ static void printer_use_log(struct timeval *start_time, int pagecount_start, int
 	int printlogfd;
 	FILE *printlog;
 
-	if((printlogfd = open(PRINTLOG_PATH, O_WRONLY | O_APPEND)) < 0)
-		return;
-
-
-	if(!(printlog = fdopen(printlogfd, "a")))
-		{
-		error("%s(): fdopen() failed", function);
-		close(printlogfd);
-		return;
-		}
-
 	{
 	int sidecount;
 	int total_printed_sheets;
@@ -1732,7 +1755,42 @@ static void printer_use_log(struct timeval *start_time, int pagecount_start, int
 				job.opts.copies);
 		}
 
-	/* Print it all as a line. */
+	/* Append a record to the structured log if it is enabled. */
+	{
+	struct PRINTLOG_RECORD record;
+	memset(&record, 0, sizeof(record));
+	record.magic = PRINTLOG_MAGIC;
+	record.pages = pages;
+	record.sheets = total_printed_sheets;
+	record.sides = total_printed_sides;
+	record.charge = charge.total;
+	record.pjl_pages = feedback_pjl_chargable_pagecount();
+	record.pagecount_start = pagecount_start;
+	record.pagecount_change = pagecount_change;
+	record.run_time = time_elapsed.tv_sec * 100 + time_elapsed.tv_usec / 10000;
+	record.submitted = job.time;
+	record.printed = seconds_now;
+	record.postscript_bytes = job.attr.postscript_bytes;
+	record.bytes_sent = progress_bytes_sent_get();
+	gu_strlcpy(record.jobid, QueueFile, sizeof(record.jobid));
+	gu_strlcpy(record.printer, printer.Name, sizeof(record.printer));
+	gu_strlcpy(record.username, job.user, sizeof(record.username));
+	gu_strlcpy(record.for_name, job.For ? job.For : "???", sizeof(record.for_name));
+	gu_strlcpy(record.title, job.Title ? job.Title : job.lpqFileName ? job.lpqFileName : "", sizeof(record.title));
+	printlog_append(&record);
+	}
+
+	/* If the text log exists, print it all there as a line. */
+	if((printlogfd = open(PRINTLOG_PATH, O_WRONLY | O_APPEND)) < 0)
+		return;
+
+	if(!(printlog = fdopen(printlogfd, "a")))
+		{
+		error("%s(): fdopen() failed", function);
+		close(printlogfd);
+		return;
+		}
+
 	fprintf(printlog, "%s,%s,%s,\"%s\",%s,\"%s\",%d,%d,%d,%ld,%ld.%02d,%d.%02d,%d,%d,%d,%ld,%ld,\"%s\"\n",
 				time_str,
 				QueueFile,
@@ -1963,13 +2021,21 @@ int real_main(int argc, char *argv[])
 		test_mode = TRUE;
 		}
 
+	/* Should we save the RIP output for pprd?  (See pprdrv_rip.c.) */
+	else if((argc - argi) >= 2 && strcmp(argv[argi], "--prerip") == 0)
+		{
+		prerip_kbytes = atol(argv[argi+1]);
+		argi += 2;
+		test_mode = prerip_mode = TRUE;
+		}
+
 	/*
 	** If fewer than 3 remaining arguments,
 	** (We mustn't call fatal() or hooked_exit() here because printer.Name is not yet set.)
 	*/
 	if((argc - argi) < 3)
 		{
-		fputs("Usage: pprdrv [--test] <printer> <queuefile> <pass>\n", stderr);
+		fputs("Usage: pprdrv [--test | --prerip <kilobytes>] <printer> <queuefile> <pass>\n", stderr);
 		exit(EXIT_PRNERR_NORETRY);
 		}
 
@@ -1990,7 +2056,7 @@ int real_main(int argc, char *argv[])
 	debug("real_main(): printer.Name=\"%s\", QueueFile=\"%s\", group_pass=%d", printer.Name, QueueFile, group_pass);
 	#endif
 
-	if(test_mode)
+	if(test_mode && !prerip_mode)
 		fprintf(stderr, "Test mode, formatting job %s for printer %s.\n", QueueFile, printer.Name);
 
 	/*
@@ -2020,8 +2086,14 @@ int real_main(int argc, char *argv[])
 	if(printer.OutputOrder == 0)
 		printer.OutputOrder = 1;
 
+	/* If the RIP's output might have been saved, describe what went into
+	   it before test mode changes things. */
+	if(printer.RIP.name)
+		rip_cache_key();
+
 	/*
-	** If we are running in test mode, change some things.
+	** If we are running in test mode, change some things.  Pre-RIPing must
+	** produce the pages in the order in which the printer will get them.
 	*/
 	if(test_mode)
 		{
@@ -2030,7 +2102,8 @@ int real_main(int argc, char *argv[])
 		printer.charge.per_simplex = 0;
 		printer.Feedback = FALSE;
 		printer.Jobbreak = JOBBREAK_NONE;
-		printer.OutputOrder = 1;
+		if(!prerip_mode)
+			printer.OutputOrder = 1;
 		printer.do_banner = BANNER_FORBIDDEN;
 		printer.do_trailer = BANNER_FORBIDDEN;
 		}
@@ -2147,13 +2220,22 @@ int real_main(int argc, char *argv[])
 	*/
 	page_computations();
 
+	/* Only PostScript jobs which we pass through a RIP can be pre-RIPed.
+	   If the printer has no RIP, pprd stops trying its jobs. */
+	if(prerip_mode && !printer.RIP.name)
+		hooked_exit(EXIT_PRNERR_NORETRY, "printer has no RIP");
+	if(prerip_mode && ((job.opts.hacks & HACK_TRANSPARENT) || job.PassThruPDL))
+		hooked_exit(EXIT_INCAPABLE, "job can't be pre-RIPed");
+
 	/* Print banner or trailer page. */
 	DODEBUG_MAIN(("real_main(): calling print_flag_page(%d, 0)", printer.OutputOrder));
 	flag_page_skiplines = print_flag_page(printer.OutputOrder, 0, 0);
 
-	/* Download any patchfile if it is not already downloaded. */
+	/* Download any patchfile if it is not already downloaded.  It
+	   mustn't end up in the saved RIP output. */
 	DODEBUG_MAIN(("real_main(): patchfile()"));
-	patchfile();
+	if(!prerip_mode)
+		patchfile();
 
 	/*
 	** Possibly get the starting page count.
@@ -2178,27 +2260,16 @@ int real_main(int argc, char *argv[])
 		}
 
 	/*
-	** Open the job files.
+	** Open the job files.  If the job is in a single container file,
+	** these are read from a memory mapping of it.
 	*/
 	DODEBUG_MAIN(("real_main(): opening job files"));
-	{
-	char fname[MAX_PPR_PATH];
-
-	ppr_fnamef(fname, "%s/%s-comments", DATADIR, QueueFile);
-	if((comments = fopen(fname, "rb")) == (FILE*)NULL)
-		fatal(EXIT_JOBERR, "can't open \"%s\", errno=%d (%s)", fname, errno, gu_strerror(errno));
-	gu_set_cloexec(fileno(comments));
-
-	ppr_fnamef(fname, "%s/%s-pages", DATADIR, QueueFile);
-	if((page_comments = fopen(fname, "rb")) == (FILE*)NULL)
-		fatal(EXIT_JOBERR, "can't open \"%s\", errno=%d (%s)", fname, errno, gu_strerror(errno));
-	gu_set_cloexec(fileno(page_comments));
-
-	ppr_fnamef(fname, "%s/%s-text", DATADIR, QueueFile);
-	if((text = fopen(fname, "rb")) == (FILE*)NULL)
-		fatal(EXIT_JOBERR, "can't open \"%s\", errno=%d (%s)", fname, errno, gu_strerror(errno));
-	gu_set_cloexec(fileno(text));
-	}
+	if((comments = spoolfile_open_section(QueueFile, "comments")) == (FILE*)NULL)
+		fatal(EXIT_JOBERR, "can't open \"%s\" section of job, errno=%d (%s)", "comments", errno, gu_strerror(errno));
+	if((page_comments = spoolfile_open_section(QueueFile, "pages")) == (FILE*)NULL)
+		fatal(EXIT_JOBERR, "can't open \"%s\" section of job, errno=%d (%s)", "pages", errno, gu_strerror(errno));
+	if((text = spoolfile_open_section(QueueFile, "text")) == (FILE*)NULL)
+		fatal(EXIT_JOBERR, "can't open \"%s\" section of job, errno=%d (%s)", "text", errno, gu_strerror(errno));
 
 	/* Download any persistent fonts or other resources. */
 	DODEBUG_MAIN(("real_main(): persistent_download_now()"));
@@ -2209,6 +2280,18 @@ int real_main(int argc, char *argv[])
 	*/
 	select_copies_method();
 
+	/*
+	** If we are pre-RIPing, send the RIP output to a file.  If the whole
+	** job must be sent more than once, each copy would go through the RIP
+	** separately, so we don't try.
+	*/
+	if(prerip_mode)
+		{
+		if(copies_doc_countdown != 1)
+			hooked_exit(EXIT_INCAPABLE, "job can't be pre-RIPed");
+		rip_cache_create(prerip_kbytes);
+		}
+
 	/*
 	** Start of the loop we used the print multiple copies by sending
 	** the whole job multiple times in stead of repeating the script section.
@@ -2306,6 +2389,10 @@ int real_main(int argc, char *argv[])
 	if(feedback_posterror())
 		result = EXIT_JOBERR;
 
+	/* If we were pre-RIPing, the saved output is now ready for use. */
+	if(prerip_mode && result == EXIT_PRINTED)
+		rip_cache_commit();
+
 	/*
 	** If we charge for the use of this printer and the job printed normally,
 	** then charge now.	 (But don't bother posting charges of zero.)
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 21 March 2006.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -130,6 +130,7 @@ struct	Media_Xlate {
 extern volatile gu_boolean sigterm_caught;
 extern volatile gu_boolean sigalrm_caught;
 extern int test_mode;
+extern gu_boolean prerip_mode;
 extern char line[];
 extern int line_len;
 extern int line_overflow;
@@ -150,6 +151,7 @@ extern int drvreq_count;
 extern int strip_binselects;	/* for pprdrv_ppd.c */
 extern int strip_signature;		/* for pprdrv_ppd.c */
 void fault_check(void);
+gu_boolean pages_independent(void);
 int real_main(int argc, char *argv[]);
 
 /* pprdrv_fault_debug.c: */
@@ -193,9 +195,13 @@ int job_nomore(void);
 
 /* pprdrv_rip.c: */
 void rip_fault_check(void);
-int rip_start(int printdata_handle, int stdout_handle);
+int rip_start(int printdata_handle, int stdout_handle, gu_boolean thejob);
+void rip_page_boundary(gu_boolean trailer);
 int rip_stop(int printdata_handle2, gu_boolean flushit);
 void rip_cancel(void);
+void rip_cache_key(void);
+void rip_cache_create(long int kbytes);
+void rip_cache_commit(void);
 gu_boolean rip_sigchld_hook(pid_t pid, int wait_status);
 
 /* pprdrv_flag.c: */
@@ -247,6 +253,7 @@ extern int media_count;
 extern int control_d_count;
 void printer_bufinit(void);
 int printer_flush(void);
+long int printer_tell(void);
 extern void (*ptr_printer_putc)(int c);
 extern void (*ptr_printer_puts)(const char *str);
 extern void (*ptr_printer_write)(const char *buf, size_t size);
@@ -394,6 +401,8 @@ struct PPRDRV {
 			char *options_storage;
 			const char **options;
 			int options_count;
+			int parallel_workers;			/* RIP processes to run at once */
+			int parallel_pages;				/* pages to give each one */
 			} RIP;
 
 		gu_boolean do_banner;
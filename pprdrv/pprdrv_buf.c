@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 8 September 2005.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -56,6 +56,7 @@ extern int intstdin;
 static char wbuf[BUFSIZE];				/* write buffer */
 static char *bptr;						/* buffer pointer */
 static int wbuf_space;					/* buffer space left */
+static long int wbuf_flushed;			/* bytes written since printer_bufinit() */
 
 /* The number of CTRL-D characters sent minus the number received: */
 int control_d_count;
@@ -74,6 +75,7 @@ void printer_bufinit(void)
 	{
 	bptr = wbuf;
 	wbuf_space = BUFSIZE;
+	wbuf_flushed = 0;
 
 	control_d_count = 0;
 
@@ -217,6 +219,7 @@ int printer_flush(void)
 
 		remain -= rval; /* reduce length left to write */
 		wptr += rval;	/* move pointer forward */
+		wbuf_flushed += rval;
 
 		/* If this isn't a banner page, update the "Progress:"
 		   line in the queue file. */
@@ -241,6 +244,17 @@ int printer_flush(void)
 	return total;
 	} /* end of printer_flush() */
 
+/*
+** Return the number of bytes which have been put into the buffer since
+** printer_bufinit() was called, whether or not they have been written
+** out yet.  This is used to tell the parallel RIP dispatcher where
+** each page begins.
+*/
+long int printer_tell(void)
+	{
+	return wbuf_flushed + (BUFSIZE - wbuf_space);
+	} /* end of printer_tell() */
+
 /*
 ** Add a single character to the output buffer.
 **
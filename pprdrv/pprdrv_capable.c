@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 23 September 2005.
+** Last modified 19 October 2026.
 */
 
 /*===========================================================================
@@ -189,7 +189,7 @@ int check_if_capable(FILE *qfile, int group_pass)
 	char *qline = NULL;					/* for reading lines from the queue file */
 	int qline_available = 80;
 
-	char *f1, *f2, *f3, *f4, *f5, *f6;
+	char *f1, *f2, *f3, *f4, *f5, *f6, *f7;
 
 	DODEBUG_RESOURCES(("%s()", function));
 
@@ -223,6 +223,7 @@ int check_if_capable(FILE *qfile, int group_pass)
 				|| !(f5 = gu_strsep(&p, " "))
 				|| !(f6 = gu_strsep(&p, " ")))
 			fatal(EXIT_JOBERR, "Queue file line has too few arguments: %s", qline);
+		f7 = gu_strsep(&p, " ");			/* body in automatic cache, optional */
 		}
 
 		/* Make a new DRVRES record. */
@@ -270,6 +271,18 @@ int check_if_capable(FILE *qfile, int group_pass)
 			continue;
 		}
 
+		/*
+		** If ppr's automatic resource cache removed it from the job, use
+		** the body which it removed, provided that it is still intact.
+		*/
+		if(f7 && (fnptr = find_cached_body(f7, TRUE)))
+			{
+			DODEBUG_RESOURCES(("resource %s %s is in automatic cache file \"%s\"", d->type, d->name, fnptr));
+			d->filename = fnptr;
+			d->needed = FALSE;
+			continue;
+			}
+
 		/*
 		** See if the resource in question is in the cache.
 		*/
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 29 March 2005.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
@@ -118,8 +118,9 @@ void commentary(int category, const char cooked[], const char raw1[], const char
 	*/
 	if(test_mode)
 		{
-		fprintf(stderr, "commentary: category=%d, cooked=\"%s\", raw1=\"%s\", raw2=\"%s\", duration=%d, severity=%d\n",
-				category, cooked, raw1 ? raw1 : "", raw2 ? raw2 : "", duration, severity);
+		if(!prerip_mode)
+			fprintf(stderr, "commentary: category=%d, cooked=\"%s\", raw1=\"%s\", raw2=\"%s\", duration=%d, severity=%d\n",
+					category, cooked, raw1 ? raw1 : "", raw2 ? raw2 : "", duration, severity);
 		return;
 		}
 
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 17 August 2005.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -290,6 +290,20 @@ static void start_interface(const char *PDL)
 		intstdin = 1;
 		intstdout = 0;
 		intstdout_write_end = 1;
+
+		/* When pre-RIPing, stdout is the file which receives the RIP
+		   output, so the RIP's messages must come back over a pipe
+		   just as they would from a real interface. */
+		if(prerip_mode)
+			{
+			if(pipe(_stdout) == -1)
+				fatal(EXIT_PRNERR, "%s(): pipe() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+			intstdout = _stdout[0];
+			intstdout_write_end = _stdout[1];
+			gu_set_cloexec(intstdout);
+			gu_nonblock(intstdout, TRUE);
+			}
+
 		feedback_setup(intstdout);
 		return;
 		}
@@ -550,14 +564,15 @@ void kill_interface(void)
 	FUNCTION4DEBUG("kill_interface")
 	DODEBUG_INTERFACE(("%s()", function));
 
+	/* Kill the Raster Image Processor (Ghostscript) if it is running.  In
+	   test mode it may be running without an interface. */
+	rip_cancel();
+
 	/* If the interface is running, kill it. */
 	if(intpid > 0)		/* 0 means not running, -1 means fork() failed */
 		{
 		DODEBUG_INTERFACE(("%s(): killing interface, intpid=%d", function, intpid));
 
-		/* Kill the Raster Image Processor (Ghostscript) if it is running. */
-		rip_cancel();
-
 		/* Kill the interface (actually its whole process group). */
 		kill((intpid*(-1)), SIGTERM);
 		}
@@ -872,8 +887,9 @@ void job_start(enum JOBTYPE jobtype)
 			/* Turn O_NONBLOCK back off since the RIP may not expect it to be on. */
 			gu_nonblock(intstdin, FALSE);
 
-			/* Interpose the RIP. */
-			intstdin = rip_start(intstdin, intstdout_write_end);
+			/* Interpose the RIP.  The job proper may have been pre-RIPed
+			   or its pages may be divided among several RIPs. */
+			intstdin = rip_start(intstdin, intstdout_write_end, jobtype == JOBTYPE_THEJOB);
 			}
 		}
 
@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified: 31 October 2012
+** Last modified: 19 October 2026
 */
 
 /*
@@ -15,6 +15,12 @@
 ** information from it.  The code is still a bit awkward because it used to
 ** use a Lex lexer.  The lexer has been replaced, but the code hasn't been
 ** fully simplified yet.
+**
+** What we find in the PPD file is compiled into a PPD image (see
+** libppr/ppdimage.c) which is saved in the printer's purgable state
+** directory.  Later jobs simply map the image into memory.  A new image
+** is compiled whenever the PPD file or any file which it includes
+** changes.
 */
 
 #include "config.h"
@@ -23,6 +29,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <sys/types.h>
 #ifdef INTERNATIONAL
 #include <libintl.h>
 #endif
@@ -34,7 +41,9 @@
 #include "util_exits.h"
 
 static struct PPDSTR **ppdstr;			/* PPD strings hash table */
+static int ppdstr_count;
 static struct PPDFONT **ppdfont;		/* PPD fontlist hash table */
+static int ppdfont_count;
 
 /* We use these when receiving feature code from the lexer. */
 static char *ppdname;					/* name of next PPD string */
@@ -56,6 +65,56 @@ static char *cups_raster_filter = NULL;
 /* Program CUPS would run to convert PostScript to the printer's language. */
 static char *cups_postscript_filter = NULL;
 
+/* These are things from the PPD file which the printer configuration
+   can override, so we don't apply them until we use the image. */
+static int ppd_OutputOrder = 0;
+static char *ppd_pprRIP = NULL;
+
+/*
+** The compiled image begins with this header.  The feature code strings
+** and the font names are stored in open hash tables with linear probing
+** so that find_feature() and ppd_font_present() are not slowed down by
+** PPD files with hundreds of options or fonts.
+*/
+#define PPD_CODE_MAGIC 0x50504443		/* "PPDC" */
+#define PPD_CODE_VERSION 1
+
+struct PPD_CODE_HEADER {
+	struct PPDIMAGE_HEADER common;
+	struct FEATURES Features;
+	int TBCP;
+	int PJL;
+	int OutputOrder;			/* 0 if no "*DefaultOutputOrder:" */
+	int pprRIP;					/* offset of value of first "*pprRIP:" */
+	int cups_raster_filter;
+	int cups_postscript_filter;
+	int papersize_count;
+	int papersizes;				/* offset of struct PPD_CODE_PAPERSIZE array */
+	int feature_slots;
+	int features;				/* offset of struct PPD_CODE_STRING hash table */
+	int font_slots;
+	int fonts;					/* offset of hash table of string offsets */
+	} ;
+
+struct PPD_CODE_PAPERSIZE {
+	int name;
+	double width;
+	double height;
+	double lm;
+	double tm;
+	double rm;
+	double bm;
+	} ;
+
+struct PPD_CODE_STRING {
+	int name;					/* zero for empty slot */
+	int value;
+	} ;
+
+/* The image in use */
+static const char *ppd_image = NULL;
+#define PPD_CODE ((const struct PPD_CODE_HEADER *)ppd_image)
+
 /*=========================================================
 ** Hash Functions
 =========================================================*/
@@ -74,31 +133,6 @@ static int hash(const char *s, int tabsize)
 	return n % tabsize;		/* wrap value and return it */
 	} /* end of hash() */
 
-/*
-** Hash two strings as though they were one.  They are hashed as if they
-** were concatentated with a space between them.
-**
-** If s2 is a NULL pointer, then this function does the same thing as
-** hash().
-*/
-static int hash2(const char *s1, const char *s2, int tabsize)
-	{
-	unsigned n=0;			/* initialize the work value */
-
-	while(*s1)				/* hash the 1st part */
-		n = 32 * n + *s1++;
-
-	if(s2)
-		{
-		if(*s2)					/* if second part is not empty, */
-			n = 32 * n + ' ';	/* hash in a space */
-		while(*s2)				/* if 2nd part not empty, hash it too */
-			n = 32 * n + *s2++;
-		}
-
-	return n % tabsize;		/* return wraped result */
-	} /* end of hash2() */
-
 /*=========================================================
 ** Callback Functions for the Lexer
 =========================================================*/
@@ -188,6 +222,7 @@ static void ppd_callback_end_string(void)
 		p = &((*p)->next);
 	*p = s;										/* set it to point to new entry */
 	s->next = (struct PPDSTR *)NULL;			/* and nullify its next pointer */
+	ppdstr_count++;
 	
 	instring = FALSE;
 	} /* end of ppd_callback_end_string() */
@@ -227,19 +262,121 @@ static void ppd_callback_papersize_moveto(char *nameline)
 ** Read the Adobe PostScript Printer Description file.
 ==========================================================*/
 
-void read_PPD_file(const char *ppd_file_name)
+/*
+** Return the number of slots to use in a hash table which will hold count
+** entries.  We keep it at most half full so that probe sequences are short.
+*/
+static int ppd_slots(int count)
 	{
-	const char function[] = "read_PPD_file";
+	int slots = 16;
+	while(slots < (count * 2))
+		slots *= 2;
+	return slots;
+	}
 
-	/* Set the default values. */
-	Features.ColorDevice = FALSE;
-	Features.Extensions = 0;
-	Features.FaxSupport = FAXSUPPORT_NONE;
-	Features.FileSystem = FALSE;
-	Features.LanguageLevel = 1;
-	Features.TTRasterizer = TT_UNKNOWN;
-	printer.prot.TBCP = FALSE;
-	printer.prot.PJL = FALSE;
+/*
+** Compile what ppd_parse() found into an image.  The files list contains
+** the names of the PPD file and any files it included.
+*/
+static char *ppd_compile(const char ppd_file_name[], void *files)
+	{
+	struct PPDIMAGE b;
+	int offset, x, slot;
+
+	ppdimage_begin(&b, sizeof(struct PPD_CODE_HEADER), PPD_CODE_MAGIC, PPD_CODE_VERSION, ppd_file_name, files);
+
+	/* The header pointer must be recomputed after each call which can move
+	 * the image, so we fill it in one field at a time. */
+	#define HDR ((struct PPD_CODE_HEADER *)b.image)
+	HDR->Features = Features;
+	HDR->TBCP = printer.prot.TBCP;
+	HDR->PJL = printer.prot.PJL;
+	HDR->OutputOrder = ppd_OutputOrder;
+	offset = ppdimage_string(&b, ppd_pprRIP); HDR->pprRIP = offset;
+	offset = ppdimage_string(&b, cups_raster_filter); HDR->cups_raster_filter = offset;
+	offset = ppdimage_string(&b, cups_postscript_filter); HDR->cups_postscript_filter = offset;
+
+	HDR->papersize_count = num_papersizes;
+	offset = ppdimage_reserve(&b, num_papersizes * sizeof(struct PPD_CODE_PAPERSIZE)); HDR->papersizes = offset;
+	for(x=0; x < num_papersizes; x++)
+		{
+		struct PPD_CODE_PAPERSIZE *ps;
+		offset = ppdimage_string(&b, papersize[x].name);
+		ps = (struct PPD_CODE_PAPERSIZE *)(b.image + HDR->papersizes) + x;
+		ps->name = offset;
+		ps->width = papersize[x].width;
+		ps->height = papersize[x].height;
+		ps->lm = papersize[x].lm;
+		ps->tm = papersize[x].tm;
+		ps->rm = papersize[x].rm;
+		ps->bm = papersize[x].bm;
+		}
+
+	/*
+	** Move the code strings into the image's hash table.  Where the PPD file
+	** has more than one string with the same name, the first one wins, as
+	** it always has.  Since entries with the same name are in the same chain
+	** in the order in which they were read, we simply skip any name which
+	** is already present.
+	*/
+	HDR->feature_slots = ppd_slots(ppdstr_count);
+	offset = ppdimage_reserve(&b, HDR->feature_slots * sizeof(struct PPD_CODE_STRING)); HDR->features = offset;
+	for(x=0; x < PPD_TABSIZE; x++)
+		{
+		struct PPDSTR *s;
+		for(s = ppdstr[x]; s; s = s->next)
+			{
+			struct PPD_CODE_STRING *entry;
+			int name_offset, value_offset;
+			for(slot = ppdimage_hash(s->name, NULL, HDR->feature_slots); TRUE; slot = (slot + 1) % HDR->feature_slots)
+				{
+				entry = (struct PPD_CODE_STRING *)(b.image + HDR->features) + slot;
+				if(!entry->name || strcmp(b.image + entry->name, s->name) == 0)
+					break;
+				}
+			if(entry->name)
+				continue;
+			name_offset = ppdimage_string(&b, s->name);
+			value_offset = ppdimage_string(&b, s->value);
+			entry = (struct PPD_CODE_STRING *)(b.image + HDR->features) + slot;
+			entry->name = name_offset;
+			entry->value = value_offset;
+			}
+		}
+
+	HDR->font_slots = ppd_slots(ppdfont_count);
+	offset = ppdimage_reserve(&b, HDR->font_slots * sizeof(int)); HDR->fonts = offset;
+	for(x=0; x < FONT_TABSIZE; x++)
+		{
+		struct PPDFONT *f;
+		for(f = ppdfont[x]; f; f = f->next)
+			{
+			int *entry;
+			for(slot = ppdimage_hash(f->name, NULL, HDR->font_slots); TRUE; slot = (slot + 1) % HDR->font_slots)
+				{
+				entry = (int*)(b.image + HDR->fonts) + slot;
+				if(!*entry || strcmp(b.image + *entry, f->name) == 0)
+					break;
+				}
+			if(*entry)
+				continue;
+			offset = ppdimage_string(&b, f->name);
+			((int*)(b.image + HDR->fonts))[slot] = offset;
+			}
+		}
+	#undef HDR
+
+	return ppdimage_finish(&b);
+	} /* end of ppd_compile() */
+
+/*
+** Parse the PPD file and return the information we found compiled into
+** an image in allocated memory.
+*/
+static char *ppd_parse(const char *ppd_file_name)
+	{
+	const char function[] = "ppd_parse";
+	char *image;
 
 	/* Create hash tables for code strings and fonts. */
 	{
@@ -247,23 +384,14 @@ void read_PPD_file(const char *ppd_file_name)
 	ppdstr = (struct PPDSTR**)gu_alloc(PPD_TABSIZE, sizeof(struct PPDSTR*));
 	for(x=0; x < PPD_TABSIZE; x++)
 		ppdstr[x] = (struct PPDSTR *)NULL;
+	ppdstr_count = 0;
 
 	ppdfont = (struct PPDFONT**)gu_alloc(FONT_TABSIZE, sizeof(struct PPDFONT*));
 	for(x=0; x < FONT_TABSIZE; x++)
 		ppdfont[x] = (struct PPDFONT *)NULL;
+	ppdfont_count = 0;
 	}
 	
-	/*
-	** If the printer configuration does not specify a PPD file, bail out.  A
-	** printer configuration file is not absolutely required to specify a PPD
-	** file.  (Though the ppad command makes it pretty difficult not to.  You
-	** have to hand create or edit the printer configuration file.  Obviously,
-	** this code was inserted in the early days of PPR.)  If printer has no PPD file, then stop things right here before we
-	** get to fopen(), which might cause a core dump.
-	*/
-	if(!ppd_file_name)
-		return;
-
 	/*
 	** Allocate temporary storage for the current name
 	** and the current code string.
@@ -343,9 +471,9 @@ void read_PPD_file(const char *ppd_file_name)
 						{
 						DODEBUG_PPD_DETAILED(("%s(): *DefaultOutputOrder: %s", function, p));
 						if(strcmp(p, "Normal") == 0)
-							printer.OutputOrder = 1;
+							ppd_OutputOrder = 1;
 						else if(strcmp(p, "Reverse") == 0)
-							printer.OutputOrder = -1;
+							ppd_OutputOrder = -1;
 						else
 							error("Unrecognized \"*DefaultOutputOrder:\" in PPD file: \"%s\"", p);
 						continue;
@@ -407,6 +535,7 @@ void read_PPD_file(const char *ppd_file_name)
 						h = hash(font->name, FONT_TABSIZE);
 						font->next = ppdfont[h];
 						ppdfont[h] = font;
+						ppdfont_count++;
 						continue;
 						}
 					break;
@@ -513,21 +642,8 @@ void read_PPD_file(const char *ppd_file_name)
 				case 'p':
 					if((p = lmatchp(line, "*pprRIP:")))
 						{
-						if(!printer.RIP.name)		/* if first in PPD file and not set in printer config file */
-							{
-							/* Parse it using gu_strsep(), keeping pointers and inserting nulls. */
-							if(!(printer.RIP.name = gu_strsep(&p, " \t")) || !(printer.RIP.output_language = gu_strsep(&p, " \t")))
-								fatal(EXIT_PRNERR_NORETRY, _("Can't parse RIP information in PPD file."));
-							printer.RIP.options_storage = gu_strsep(&p, "");
-					
-							if(strchr(printer.RIP.name, '/'))
-								fatal(EXIT_PRNERR_NORETRY, _("Slashes are not allowed in RIP names in \"*pprRIP:\" lines in PPD files."));
-
-							printer.RIP.name = gu_strdup(printer.RIP.name);
-							printer.RIP.output_language = gu_strdup(printer.RIP.output_language);
-							if(printer.RIP.options_storage)
-								printer.RIP.options_storage = gu_strdup(printer.RIP.options_storage);
-							}
+						if(!ppd_pprRIP)				/* if first in PPD file */
+							ppd_pprRIP = gu_strdup(p);
 						continue;
 						}
 					break;
@@ -582,6 +698,7 @@ void read_PPD_file(const char *ppd_file_name)
 
 			}
 		}
+	image = ppd_compile(ppd_file_name, ppdobj_files(ppdobj));
 	ppdobj_free(ppdobj);
 	}
 
@@ -589,24 +706,165 @@ void read_PPD_file(const char *ppd_file_name)
 	gu_free(ppdname);
 	gu_free(ppdtext);
 
+	/* Free the hash tables, the image has everything. */
+	{
+	int x;
+	for(x=0; x < PPD_TABSIZE; x++)
+		{
+		struct PPDSTR *s, *next;
+		for(s = ppdstr[x]; s; s = next)
+			{
+			next = s->next;
+			gu_free(s->name);
+			gu_free(s->value);
+			gu_free(s);
+			}
+		}
+	gu_free(ppdstr);
+	for(x=0; x < FONT_TABSIZE; x++)
+		{
+		struct PPDFONT *f, *next;
+		for(f = ppdfont[x]; f; f = next)
+			{
+			next = f->next;
+			gu_free(f->name);
+			gu_free(f);
+			}
+		}
+	gu_free(ppdfont);
+	for(x=0; x < num_papersizes; x++)
+		gu_free(papersize[x].name);
+	}
+
+	if(cups_raster_filter)
+		{
+		gu_free(cups_raster_filter);
+		cups_raster_filter = NULL;
+		}
+	if(cups_postscript_filter)
+		{
+		gu_free(cups_postscript_filter);
+		cups_postscript_filter = NULL;
+		}
+	if(ppd_pprRIP)
+		{
+		gu_free(ppd_pprRIP);
+		ppd_pprRIP = NULL;
+		}
+
+	return image;
+	} /* end of ppd_parse() */
+
+/*
+** Return TRUE if every offset and count in a cached image is in range and
+** the hash tables have the empty slots which end each search.
+*/
+static gu_boolean ppd_check_image(const char *image)
+	{
+	const struct PPD_CODE_HEADER *hdr = (const struct PPD_CODE_HEADER *)image;
+	const struct PPD_CODE_PAPERSIZE *papersizes;
+	const struct PPD_CODE_STRING *features;
+	const int *fonts;
+	gu_boolean empty;
+	int x;
+
+	if(hdr->common.image_size < (int)sizeof(struct PPD_CODE_HEADER))
+		return FALSE;
+
+	if(!ppdimage_string_ok(image, hdr->pprRIP)
+			|| !ppdimage_string_ok(image, hdr->cups_raster_filter)
+			|| !ppdimage_string_ok(image, hdr->cups_postscript_filter))
+		return FALSE;
+
+	if(hdr->papersize_count > MAX_PAPERSIZES
+			|| !ppdimage_table_ok(image, hdr->papersizes, hdr->papersize_count, sizeof(struct PPD_CODE_PAPERSIZE)))
+		return FALSE;
+	papersizes = (const struct PPD_CODE_PAPERSIZE *)(image + hdr->papersizes);
+	for(x=0; x < hdr->papersize_count; x++)
+		{
+		if(papersizes[x].name == 0 || !ppdimage_string_ok(image, papersizes[x].name))
+			return FALSE;
+		}
+
+	if(hdr->feature_slots < 1
+			|| !ppdimage_table_ok(image, hdr->features, hdr->feature_slots, sizeof(struct PPD_CODE_STRING)))
+		return FALSE;
+	features = (const struct PPD_CODE_STRING *)(image + hdr->features);
+	for(x=0, empty=FALSE; x < hdr->feature_slots; x++)
+		{
+		if(features[x].name == 0)
+			empty = TRUE;
+		else if(!ppdimage_string_ok(image, features[x].name) || !ppdimage_string_ok(image, features[x].value))
+			return FALSE;
+		}
+	if(!empty)
+		return FALSE;
+
+	if(hdr->font_slots < 1
+			|| !ppdimage_table_ok(image, hdr->fonts, hdr->font_slots, sizeof(int)))
+		return FALSE;
+	fonts = (const int *)(image + hdr->fonts);
+	for(x=0, empty=FALSE; x < hdr->font_slots; x++)
+		{
+		if(fonts[x] == 0)
+			empty = TRUE;
+		else if(!ppdimage_string_ok(image, fonts[x]))
+			return FALSE;
+		}
+	if(!empty)
+		return FALSE;
+
+	return TRUE;
+	} /* end of ppd_check_image() */
+
+/*
+** Take the information from a compiled image and put it where the rest
+** of pprdrv will look for it.  Things which can be set in the printer
+** configuration file are only applied if they were not.
+*/
+static void ppd_use_image(const char *image)
+	{
+	const struct PPD_CODE_HEADER *hdr = (const struct PPD_CODE_HEADER *)image;
+	int x;
+
+	ppd_image = image;
+
+	Features = hdr->Features;
+	printer.prot.TBCP = hdr->TBCP;
+	printer.prot.PJL = hdr->PJL;
+	if(hdr->OutputOrder)
+		printer.OutputOrder = hdr->OutputOrder;
+
+	if(!printer.RIP.name && hdr->pprRIP)		/* if not set in printer config file */
+		{
+		/* Parse it using gu_strsep(), keeping pointers and inserting nulls. */
+		char *p = gu_strdup(image + hdr->pprRIP);
+		if(!(printer.RIP.name = gu_strsep(&p, " \t")) || !(printer.RIP.output_language = gu_strsep(&p, " \t")))
+			fatal(EXIT_PRNERR_NORETRY, _("Can't parse RIP information in PPD file."));
+		printer.RIP.options_storage = gu_strsep(&p, "");
+
+		if(strchr(printer.RIP.name, '/'))
+			fatal(EXIT_PRNERR_NORETRY, _("Slashes are not allowed in RIP names in \"*pprRIP:\" lines in PPD files."));
+		}
+
 	/* 
 	** If we still haven't been told to use a RIP, see if we saw a
 	** "*cupsFilter:" line that can help us.
 	*/
-	DODEBUG_PPD(("read_PPD_file(): printer.RIP.name=\"%s\", cups_raster_filter=\"%s\", cups_postscript_filter=\"%s\"",
+	DODEBUG_PPD(("ppd_use_image(): printer.RIP.name=\"%s\", cups_raster_filter=\"%s\", cups_postscript_filter=\"%s\"",
 		printer.RIP.name ? printer.RIP.name : "",
-		cups_raster_filter ? cups_raster_filter : "",
-		cups_postscript_filter ? cups_postscript_filter : "",
+		hdr->cups_raster_filter ? image + hdr->cups_raster_filter : "",
+		hdr->cups_postscript_filter ? image + hdr->cups_postscript_filter : ""
 		));
 	if(!printer.RIP.name)
 		{
-		if(cups_raster_filter)
+		if(hdr->cups_raster_filter)
 			{
 			printer.RIP.name = "ppr-gs";
 			printer.RIP.output_language = "PCL";	/* !!! a wild guess !!! */
-			gu_asprintf(&printer.RIP.options_storage, "cups=%s", cups_raster_filter);
+			gu_asprintf(&printer.RIP.options_storage, "cups=%s", image + hdr->cups_raster_filter);
 			}
-		else if(cups_postscript_filter && strcmp(cups_postscript_filter, "pstopxl") == 0)
+		else if(hdr->cups_postscript_filter && strcmp(image + hdr->cups_postscript_filter, "pstopxl") == 0)
 			{
 			printer.RIP.name = "ppr-gs";
 			printer.RIP.output_language = "PCLXL";
@@ -617,11 +875,59 @@ void read_PPD_file(const char *ppd_file_name)
 			}
 		}
 
-	if(cups_raster_filter)
-		gu_free(cups_raster_filter);
-	if(cups_postscript_filter)
-		gu_free(cups_postscript_filter);
-		
+	/* The paper sizes go in the array that pprdrv_flag.c searches. */
+	for(x=0; x < hdr->papersize_count; x++)
+		{
+		const struct PPD_CODE_PAPERSIZE *ps = (const struct PPD_CODE_PAPERSIZE *)(image + hdr->papersizes) + x;
+		papersize[x].name = (char*)(image + ps->name);
+		papersize[x].width = ps->width;
+		papersize[x].height = ps->height;
+		papersize[x].lm = ps->lm;
+		papersize[x].tm = ps->tm;
+		papersize[x].rm = ps->rm;
+		papersize[x].bm = ps->bm;
+		}
+	num_papersizes = hdr->papersize_count;
+	} /* end of ppd_use_image() */
+
+/*
+** Read the PPD file (or its compiled image).
+*/
+void read_PPD_file(const char *ppd_file_name)
+	{
+	char fname[MAX_PPR_PATH];
+	const char *image;
+
+	/* Set the default values. */
+	Features.ColorDevice = FALSE;
+	Features.Extensions = 0;
+	Features.FaxSupport = FAXSUPPORT_NONE;
+	Features.FileSystem = FALSE;
+	Features.LanguageLevel = 1;
+	Features.TTRasterizer = TT_UNKNOWN;
+	printer.prot.TBCP = FALSE;
+	printer.prot.PJL = FALSE;
+
+	/*
+	** If the printer configuration does not specify a PPD file, bail out.  A
+	** printer configuration file is not absolutely required to specify a PPD
+	** file.  (Though the ppad command makes it pretty difficult not to.  You
+	** have to hand create or edit the printer configuration file.  Obviously,
+	** this code was inserted in the early days of PPR.)  If printer has no PPD file, then stop things right here before we
+	** get to fopen(), which might cause a core dump.
+	*/
+	if(!ppd_file_name)
+		return;
+
+	ppr_fnamef(fname, "%s/%s/ppdcode", PRINTERS_PURGABLE_STATEDIR, printer.Name);
+	if(!(image = ppdimage_load(fname, PPD_CODE_MAGIC, PPD_CODE_VERSION, ppd_file_name, ppd_check_image)))
+		{
+		DODEBUG_PPD(("read_PPD_file(): compiling \"%s\"", ppd_file_name));
+		image = ppd_parse(ppd_file_name);
+		ppdimage_save(fname, image);
+		}
+
+	ppd_use_image(image);
 	} /* read_PPD_file() */
 
 /*=========================================================================
@@ -660,31 +966,29 @@ static void feature_warning(const char *format, ...)
 */
 const char *find_feature(const char *featuretype, const char *option)
 	{
-	struct PPDSTR *s;					/* pointer to PPD database entry */
-	int len;							/* used in comparison */
-	char *string = (char*)NULL;			/* value to return */
+	const struct PPD_CODE_STRING *table;
+	int slot;
+	int len = strlen(featuretype);
 
 	DODEBUG_PPD(("find_feature(\"%s\", \"%s\")", featuretype, option ? option : ""));
 
-	s = ppdstr[hash2(featuretype, option, PPD_TABSIZE)];
+	if(!ppd_image)
+		return NULL;
 
-	while(s)
+	table = (const struct PPD_CODE_STRING *)(ppd_image + PPD_CODE->features);
+	for(slot = ppdimage_hash(featuretype, option, PPD_CODE->feature_slots); table[slot].name; slot = (slot + 1) % PPD_CODE->feature_slots)
 		{
-		if( (strncmp(s->name,featuretype,len=strlen(featuretype))==0)
-			&& ( ( option==(char*)NULL && s->name[len]=='\0' )
-				|| ( s->name[len]==' ' && strcmp(&s->name[len+1],option)==0 ) )
+		const char *name = ppd_image + table[slot].name;
+		if( (strncmp(name,featuretype,len)==0)
+			&& ( ( option==(char*)NULL && name[len]=='\0' )
+				|| ( option && name[len]==' ' && strcmp(&name[len+1],option)==0 ) )
 			) /* <-- notice parenthesis */
 			{
-			string = s->value;					/* use the value */
-			break;
-			}
-		else									/* if no match */
-			{									/* if chain continues, */
-			s = s->next;						/* jump to next link */
+			return ppd_image + table[slot].value;
 			}
 		}
 
-	return string;
+	return NULL;
 	} /* end of find_feature() */
 
 /*
@@ -1100,17 +1404,17 @@ void insert_features(FILE *qstream, int set)
 
 gu_boolean ppd_font_present(const char fontname[])
 	{
-	int h;
-	struct PPDFONT *p;				/* pointer to font structure */
+	const int *table;
+	int slot;
 
-	h = hash(fontname, FONT_TABSIZE);
-	p = ppdfont[h];
+	if(!ppd_image)
+		return FALSE;
 
-	while(p != (struct PPDFONT *)NULL)
+	table = (const int *)(ppd_image + PPD_CODE->fonts);
+	for(slot = ppdimage_hash(fontname, NULL, PPD_CODE->font_slots); table[slot]; slot = (slot + 1) % PPD_CODE->font_slots)
 		{
-		if(strcmp(fontname, p->name) == 0)
+		if(strcmp(fontname, ppd_image + table[slot]) == 0)
 			return TRUE;
-		p = p->next;
 		}
 
 	return FALSE;
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 14 April 2006.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
@@ -436,7 +436,8 @@ static void ppop_status_write(void)
 
 	if(test_mode)
 		{
-		write(2, buffer, strlen(buffer));
+		if(!prerip_mode)
+			write(2, buffer, strlen(buffer));
 		}
 	else
 		{
@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 1 April 2005.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -53,6 +53,7 @@
 #include "global_structs.h"
 #include "pprdrv.h"
 #include "interface.h"
+#include "status_board.h"
 
 /* These are the figures which others tell us to update: */
 static int total_pages_started = 0;
@@ -62,6 +63,11 @@ static long total_bytes = 0;
 /* Don't report progress until at least this many bytes sent. */
 #define SLACK_BYTES_COUNT 5120
 
+/* The status board and our printer's slot on it, once found. */
+static struct STATUS_BOARD *board = NULL;
+static struct STATUS_BOARD_PRINTER *board_slot = NULL;
+static gu_boolean board_searched = FALSE;
+
 /*
 ** This routine writes a line to the $VAR_SPOOL_PPR/run/state_update_pprdrv 
 ** file which is read by programs which present an automatically updated
@@ -78,6 +84,8 @@ void state_update_pprdrv_puts(const char line[])
 	const char function[] = "state_update_pprdrv_puts";
 	const char filename[] = STATE_UPDATE_PPRDRV_FILE;
 	static int handle = -1;
+	static gu_boolean text_feed = TRUE;
+	static gu_boolean text_feed_checked = FALSE;
 	int retry;
 	struct stat statbuf;
 
@@ -87,6 +95,23 @@ void state_update_pprdrv_puts(const char line[])
 	if(test_mode)
 		return;
 
+	/*
+	** The file may have been turned off in ppr.conf in favour of the
+	** status board.
+	*/
+	if(!text_feed_checked)
+		{
+		char *p;
+		if((p = gu_ini_query(PPR_CONF, "status", "textfeed", 0, NULL)))
+			{
+			gu_torf_setBOOL(&text_feed, p);
+			gu_free(p);
+			}
+		text_feed_checked = TRUE;
+		}
+	if(!text_feed)
+		return;
+
 	/*
 	** We will break out of this loop as soon as we have
 	** a satisfactory progress file to write to.
@@ -167,6 +192,57 @@ void state_update_pprdrv_puts(const char line[])
 		fatal(EXIT_PRNERR_NORETRY, "%s(): write() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
 	} /* end of state_update_pprdrv_puts() */
 
+/*
+** Copy the current figures to the pprdrv half of our printer's slot on the
+** status board (see libppr/status_board.c).  If message is not NULL, it
+** replaces the last status message from the printer.  If pprd has started
+** a new board since we found our slot, we look for it again.
+*/
+static void board_update(const char message[])
+	{
+	if(test_mode)
+		return;
+
+	if(board && status_board_is_stale(board))
+		{
+		status_board_close(board);
+		board = NULL;
+		board_slot = NULL;
+		board_searched = FALSE;
+		}
+
+	if(!board_searched)
+		{
+		int x;
+		board_searched = TRUE;
+		if((board = status_board_open(TRUE)))
+			{
+			for(x=0; x < board->header->printers_used; x++)
+				{
+				if(strcmp(board->printers[x].name, printer.Name) == 0)
+					{
+					board_slot = &board->printers[x];
+					break;
+					}
+				}
+			}
+		}
+
+	if(!board_slot)
+		return;
+
+	status_board_write_begin(&board_slot->drv_seq);
+	board_slot->drv_job_id = job.jobname.id;
+	board_slot->drv_job_subid = job.jobname.subid;
+	board_slot->pages_started = total_pages_started;
+	board_slot->pages_printed = total_pages_printed;
+	board_slot->bytes_sent = (total_bytes > SLACK_BYTES_COUNT) ? total_bytes : 0;
+	board_slot->bytes_total = job.attr.postscript_bytes;
+	if(message)
+		gu_strlcpy(board_slot->message, message, sizeof(board_slot->message));
+	status_board_write_end(board, &board_slot->drv_seq, &board_slot->drv_changed);
+	} /* end of board_update() */
+
 /*
 
 This routine writes the current values to the end of the queue file.
@@ -195,11 +271,13 @@ static void queuefile_progress_write(void)
 	/*
 	** If we are running in test mode, we have no
 	** business writing to the queue file, so we
-	** will write to stderr.
+	** will write to stderr.  (Unless we are pre-RIPing for pprd, in
+	** which case stderr is its log file.)
 	*/
 	if(test_mode)
 		{
-		fprintf(stderr, "Progress: %010ld %04d %04d\n", total_bytes, total_pages_started, total_pages_printed);
+		if(!prerip_mode)
+			fprintf(stderr, "Progress: %010ld %04d %04d\n", total_bytes, total_pages_started, total_pages_printed);
 		return;
 		}
 
@@ -270,6 +348,7 @@ void progress_page_start_comment_sent(void)
 
 	snprintf(buffer, sizeof(buffer), "PGSTA %s %d\n", printer.Name, total_pages_started);
 	state_update_pprdrv_puts(buffer);
+	board_update(NULL);
 	}
 
 /*
@@ -287,6 +366,7 @@ void progress_pages_truly_printed(int n)
 
 	snprintf(buffer, sizeof(buffer), "PGFIN %s %d\n", printer.Name, total_pages_printed);
 	state_update_pprdrv_puts(buffer);
+	board_update(NULL);
 	}
 
 /*
@@ -304,6 +384,7 @@ void progress_bytes_sent(int n)
 		char buffer[80];
 		snprintf(buffer, sizeof(buffer), "BYTES %s %ld %ld\n", printer.Name, total_bytes, job.attr.postscript_bytes);
 		state_update_pprdrv_puts(buffer);
+		board_update(NULL);
 		}
 	}
 
@@ -318,6 +399,7 @@ void progress_new_status(const char text[])
 	char buffer[80];
 	snprintf(buffer, sizeof(buffer), "STATUS %s %s\n", printer.Name, text);
 	state_update_pprdrv_puts(buffer);
+	board_update(text);
 	}
 
 /*
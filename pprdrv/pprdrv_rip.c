@@ -25,16 +25,22 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 24 February 2005.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
+#include <stdio.h>
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
 #include <signal.h>
+#include <stdarg.h>
 #include <sys/types.h>
+#include <sys/time.h>
 #include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #ifdef INTERNATIONAL
 #include <libintl.h>
@@ -50,6 +56,9 @@ static volatile pid_t rip_pid = 0;
 static gu_boolean rip_died = FALSE;
 static volatile int rip_wait_status;
 static gu_boolean rip_fault_check_disable;
+static int boundary_fd = -1;			/* pipe to parallel RIP dispatcher */
+static long int boundary_base;			/* printer_tell() when it started */
+static int rip_exit_code;				/* what rip_stop() saw */
 
 /*
 ** This is called from pprdrv.c:sigchld_handler() whenever a child exits.
@@ -163,6 +172,677 @@ void rip_fault_check(void)
 	DODEBUG_INTERFACE(("%s(): done, no fault", function));
 	} /* end of rip_fault_check() */
 
+/*============================================================================
+** Parallel RIP
+**
+** If the printer configuration file has a "RIPParallel:" line and the pages
+** of the job can be rendered separately (see pages_independent() in
+** pprdrv.c), rip_start() runs a dispatcher in place of the RIP.  As
+** pprdrv sends the PostScript, it also sends the dispatcher the offset
+** within it of the start of each page and of the trailer over a second pipe.
+**
+** The dispatcher saves everything which comes before the first page (the
+** header comments, prolog, and document setup) and begins a new chunk every
+** so many pages.  Each chunk gets a copy of the saved beginning followed by
+** its pages.  Whatever follows the trailer offset goes into the last chunk.
+** A RIP is started for each chunk as soon as it is complete, up to the
+** indicated number at a time.  The first chunk's RIP writes directly to the
+** printer.  The output of the others is held in temporary files and copied
+** to the printer in order as soon as the RIPs for the chunks before them
+** have exited.
+**
+** If any of the RIPs fails, the dispatcher kills the others and exits as the
+** failed RIP did, so rip_exit_screen() and rip_fault_check() can't tell the
+** difference.
+============================================================================*/
+
+#define PARALLEL_BOUNDARY_FD 4			/* dispatcher reads page offsets here */
+
+struct RIP_CHUNK
+	{
+	int input;							/* temporary file with the PostScript */
+	int output;							/* temporary file for RIP output, -1 for first */
+	int pages;							/* "%%Page:" sections in it */
+	pid_t pid;							/* its RIP, 0 if not yet started */
+	gu_boolean done;					/* has its RIP exited? */
+	};
+
+struct RIP_BOUNDARY
+	{
+	long int offset;
+	gu_boolean trailer;
+	};
+
+static int head_fd;						/* everything before the first page */
+static struct RIP_CHUNK *chunks = NULL;
+static int chunk_count = 0;				/* chunks begun */
+static int chunks_ready = 0;			/* chunks with all of their PostScript */
+static int chunks_started = 0;			/* chunks for which RIPs have been started */
+static int chunks_emitted = 0;			/* chunks whose output has been sent */
+static int workers_running = 0;
+static struct RIP_BOUNDARY *boundaries = NULL;
+static int boundary_count = 0;
+static int boundary_next = 0;
+static int boundary_space = 0;
+static long int input_offset = 0;		/* bytes of PostScript read so far */
+static gu_boolean input_trailer = FALSE;	/* have we passed the trailer offset? */
+static int sigchld_pipe[2];
+
+/*
+** Kill any RIPs which are still running.
+*/
+static void parallel_kill(void)
+	{
+	int x;
+	for(x=0; x < chunk_count; x++)
+		{
+		if(chunks[x].pid > 0 && !chunks[x].done)
+			kill(chunks[x].pid, SIGTERM);
+		}
+	} /* end of parallel_kill() */
+
+/*
+** The dispatcher can't call fatal() since it is not pprdrv.  Instead it
+** writes the message to stderr (which pprdrv is reading) and exits as
+** a RIP which couldn't be started would.
+*/
+static void parallel_fatal(const char message[], ...)
+#ifdef __GNUC__
+__attribute__ (( noreturn, format (printf, 1, 2) ))
+#endif
+;
+static void parallel_fatal(const char message[], ...)
+	{
+	va_list va;
+	fputs("RIP dispatcher: ", stderr);
+	va_start(va, message);
+	vfprintf(stderr, message, va);
+	va_end(va);
+	fputc('\n', stderr);
+	parallel_kill();
+	_exit(1);
+	} /* end of parallel_fatal() */
+
+/*
+** Write a whole block, restarting if interupted.
+*/
+static void parallel_write(int fd, const char *buf, size_t len)
+	{
+	ssize_t written;
+	while(len > 0)
+		{
+		if((written = write(fd, buf, len)) == -1)
+			{
+			if(errno == EINTR)
+				continue;
+			parallel_fatal("write() failed, errno=%d (%s)", errno, gu_strerror(errno));
+			}
+		buf += written;
+		len -= written;
+		}
+	} /* end of parallel_write() */
+
+/*
+** Copy the whole of a temporary file to another file descriptor.  We use
+** pread() so as not to disturb the file pointer of the source.
+*/
+static void parallel_copy(int from, int to)
+	{
+	char buf[8192];
+	off_t offset = 0;
+	ssize_t len;
+	while((len = pread(from, buf, sizeof(buf), offset)) != 0)
+		{
+		if(len == -1)
+			{
+			if(errno == EINTR)
+				continue;
+			parallel_fatal("pread() failed, errno=%d (%s)", errno, gu_strerror(errno));
+			}
+		parallel_write(to, buf, len);
+		offset += len;
+		}
+	} /* end of parallel_copy() */
+
+/*
+** Create an anonymous temporary file.
+*/
+static int parallel_tempfile(void)
+	{
+	char fname[MAX_PPR_PATH];
+	int fd;
+	ppr_fnamef(fname, "%s/ppr-rip-%ld-XXXXXX", TEMPDIR, (long)getpid());
+	if((fd = mkstemp(fname)) == -1)
+		parallel_fatal("mkstemp(\"%s\") failed, errno=%d (%s)", fname, errno, gu_strerror(errno));
+	unlink(fname);
+	gu_set_cloexec(fd);
+	return fd;
+	} /* end of parallel_tempfile() */
+
+/*
+** Wake up the select() loop when a RIP exits.
+*/
+static void parallel_sigchld(int sig)
+	{
+	int saved_errno = errno;
+	write(sigchld_pipe[1], "", 1);
+	errno = saved_errno;
+	} /* end of parallel_sigchld() */
+
+/*
+** Read whatever page offsets pprdrv has sent.  Return FALSE when pprdrv has
+** closed its end of the pipe.
+*/
+static gu_boolean parallel_read_boundaries(void)
+	{
+	static char buf[256];
+	static int buf_len = 0;
+	ssize_t len;
+	char *p, *nl;
+
+	while((len = read(PARALLEL_BOUNDARY_FD, buf + buf_len, sizeof(buf) - buf_len)) != 0)
+		{
+		if(len == -1)
+			{
+			if(errno == EINTR)
+				continue;
+			if(errno == EAGAIN)
+				return TRUE;
+			parallel_fatal("read() failed, errno=%d (%s)", errno, gu_strerror(errno));
+			}
+
+		buf_len += len;
+
+		for(p = buf; (nl = memchr(p, '\n', buf_len - (p - buf))); p = nl + 1)
+			{
+			*nl = '\0';
+			if(boundary_count == boundary_space)
+				{
+				boundary_space += 64;
+				boundaries = gu_realloc(boundaries, boundary_space, sizeof(struct RIP_BOUNDARY));
+				}
+			boundaries[boundary_count].trailer = (*p == 'T');
+			boundaries[boundary_count].offset = atol(p + 1);
+			boundary_count++;
+			}
+
+		buf_len -= (p - buf);
+		memmove(buf, p, buf_len);
+		}
+
+	return FALSE;
+	} /* end of parallel_read_boundaries() */
+
+/*
+** Begin a new chunk, finishing the previous one.
+*/
+static void parallel_new_chunk(void)
+	{
+	struct RIP_CHUNK *chunk;
+
+	chunks_ready = chunk_count;
+	chunks = gu_realloc(chunks, chunk_count + 1, sizeof(struct RIP_CHUNK));
+	chunk = &chunks[chunk_count];
+	chunk->input = parallel_tempfile();
+	parallel_copy(head_fd, chunk->input);
+	chunk->output = chunk_count == 0 ? -1 : parallel_tempfile();
+	chunk->pages = 0;
+	chunk->pid = 0;
+	chunk->done = FALSE;
+	chunk_count++;
+	} /* end of parallel_new_chunk() */
+
+/*
+** Add a block of PostScript to the chunk to which it belongs, starting
+** new chunks at page offsets as needed.
+*/
+static void parallel_input(const char *data, size_t len, int pages_per_chunk)
+	{
+	while(len > 0)
+		{
+		size_t take = len;
+
+		/* Act on offsets which we have reached. */
+		for( ; boundary_next < boundary_count && boundaries[boundary_next].offset <= input_offset; boundary_next++)
+			{
+			if(boundaries[boundary_next].trailer)
+				{
+				input_trailer = TRUE;
+				}
+			else if(!input_trailer)
+				{
+				if(chunk_count == 0 || chunks[chunk_count - 1].pages >= pages_per_chunk)
+					parallel_new_chunk();
+				chunks[chunk_count - 1].pages++;
+				}
+			}
+		if(boundary_next == boundary_count)
+			boundary_next = boundary_count = 0;
+
+		/* Don't go past the next one. */
+		if(boundary_next < boundary_count && boundaries[boundary_next].offset - input_offset < (long int)take)
+			take = boundaries[boundary_next].offset - input_offset;
+
+		parallel_write(chunk_count == 0 ? head_fd : chunks[chunk_count - 1].input, data, take);
+		data += take;
+		len -= take;
+		input_offset += take;
+		}
+	} /* end of parallel_input() */
+
+/*
+** One of the RIPs failed.  Kill the others and exit as it did.
+*/
+static void parallel_failed(int wait_status)
+	{
+	parallel_kill();
+	if(WIFSIGNALED(wait_status))
+		{
+		signal(WTERMSIG(wait_status), SIG_DFL);
+		kill(getpid(), WTERMSIG(wait_status));
+		}
+	_exit(WIFEXITED(wait_status) ? WEXITSTATUS(wait_status) : 1);
+	} /* end of parallel_failed() */
+
+/*
+** Collect the exit status of RIPs which have finished.
+*/
+static void parallel_reap(void)
+	{
+	pid_t pid;
+	int wait_status, x;
+	while((pid = waitpid((pid_t)-1, &wait_status, WNOHANG)) > 0)
+		{
+		for(x=0; x < chunk_count && chunks[x].pid != pid; x++)
+			;
+		if(x == chunk_count)
+			continue;
+		chunks[x].done = TRUE;
+		workers_running--;
+		if(!WIFEXITED(wait_status) || WEXITSTATUS(wait_status) != 0)
+			parallel_failed(wait_status);
+		}
+	} /* end of parallel_reap() */
+
+/*
+** Start RIPs for complete chunks while there are free slots.
+*/
+static void parallel_schedule(const char rip_exe[], const char **rip_args, int workers)
+	{
+	while(workers_running < workers && chunks_started < chunks_ready)
+		{
+		struct RIP_CHUNK *chunk = &chunks[chunks_started];
+		pid_t pid;
+
+		if((pid = fork()) == -1)
+			parallel_fatal("fork() failed, errno=%d (%s)", errno, gu_strerror(errno));
+
+		if(pid == 0)
+			{
+			lseek(chunk->input, (off_t)0, SEEK_SET);
+			dup2(chunk->input, 0);
+			if(chunk->output != -1)
+				dup2(chunk->output, 3);
+			signal(SIGCHLD, SIG_DFL);
+			execv(rip_exe, (char**)rip_args);
+			_exit(1);
+			}
+
+		close(chunk->input);
+		chunk->pid = pid;
+		chunks_started++;
+		workers_running++;
+		}
+	} /* end of parallel_schedule() */
+
+/*
+** Send the output of finished chunks to the printer in order.
+*/
+static void parallel_emit(void)
+	{
+	while(chunks_emitted < chunks_started && chunks[chunks_emitted].done)
+		{
+		struct RIP_CHUNK *chunk = &chunks[chunks_emitted++];
+		if(chunk->output != -1)
+			{
+			parallel_copy(chunk->output, 3);
+			close(chunk->output);
+			}
+		}
+	} /* end of parallel_emit() */
+
+/*
+** This is the dispatcher.  It runs in the child which rip_start() forks,
+** after the file descriptors and environment have been set up for the RIP.
+*/
+static void rip_parallel(const char rip_exe[], const char **rip_args, int workers, int pages_per_chunk)
+#ifdef __GNUC__
+__attribute__ (( noreturn ))
+#endif
+;
+static void rip_parallel(const char rip_exe[], const char **rip_args, int workers, int pages_per_chunk)
+	{
+	char buf[8192];
+	gu_boolean input_eof = FALSE, boundaries_eof = FALSE;
+	fd_set rfds;
+	ssize_t len;
+
+	/* We inherited pprdrv's signal handlers. */
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGHUP, SIG_DFL);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGALRM, SIG_DFL);
+	signal(SIGPIPE, SIG_DFL);
+	signal(SIGUSR1, SIG_DFL);
+
+	if(pipe(sigchld_pipe) == -1)
+		parallel_fatal("pipe() failed, errno=%d (%s)", errno, gu_strerror(errno));
+	gu_set_cloexec(sigchld_pipe[0]);
+	gu_set_cloexec(sigchld_pipe[1]);
+	gu_nonblock(sigchld_pipe[0], TRUE);
+	gu_nonblock(sigchld_pipe[1], TRUE);
+	signal_restarting(SIGCHLD, parallel_sigchld);
+
+	gu_set_cloexec(PARALLEL_BOUNDARY_FD);
+	gu_nonblock(PARALLEL_BOUNDARY_FD, TRUE);
+
+	head_fd = parallel_tempfile();
+
+	while(!input_eof || chunks_emitted < chunk_count)
+		{
+		FD_ZERO(&rfds);
+		FD_SET(sigchld_pipe[0], &rfds);
+		if(!input_eof)
+			FD_SET(0, &rfds);
+		if(!boundaries_eof)
+			FD_SET(PARALLEL_BOUNDARY_FD, &rfds);
+
+		if(select((sigchld_pipe[0] > PARALLEL_BOUNDARY_FD ? sigchld_pipe[0] : PARALLEL_BOUNDARY_FD) + 1, &rfds, NULL, NULL, NULL) == -1)
+			{
+			if(errno != EINTR)
+				parallel_fatal("select() failed, errno=%d (%s)", errno, gu_strerror(errno));
+			FD_ZERO(&rfds);
+			}
+
+		if(FD_ISSET(sigchld_pipe[0], &rfds))
+			{
+			while(read(sigchld_pipe[0], buf, sizeof(buf)) > 0)
+				;
+			}
+
+		if(!boundaries_eof && FD_ISSET(PARALLEL_BOUNDARY_FD, &rfds))
+			boundaries_eof = !parallel_read_boundaries();
+
+		if(!input_eof && FD_ISSET(0, &rfds))
+			{
+			if((len = read(0, buf, sizeof(buf))) == -1)
+				{
+				if(errno != EINTR)
+					parallel_fatal("read() failed, errno=%d (%s)", errno, gu_strerror(errno));
+				}
+			else if(len == 0)
+				{
+				input_eof = TRUE;
+
+				/* If there were no pages, the beginning is the whole job. */
+				if(chunk_count == 0)
+					{
+					chunks = gu_alloc(1, sizeof(struct RIP_CHUNK));
+					chunks[0].input = head_fd;
+					chunks[0].output = -1;
+					chunks[0].pages = 0;
+					chunks[0].pid = 0;
+					chunks[0].done = FALSE;
+					chunk_count = 1;
+					}
+				else
+					{
+					close(head_fd);
+					}
+
+				chunks_ready = chunk_count;
+				}
+			else
+				{
+				/* The offset of any page which begins in this block was
+				   sent before the block was, so we have it now. */
+				if(!boundaries_eof)
+					boundaries_eof = !parallel_read_boundaries();
+				parallel_input(buf, len, pages_per_chunk);
+				}
+			}
+
+		parallel_reap();
+		parallel_schedule(rip_exe, rip_args, workers);
+		parallel_emit();
+		}
+
+	_exit(0);
+	} /* end of rip_parallel() */
+
+/*
+** This is called from copy_a_page() and copy_trailer() in pprdrv.c just
+** before each page and the trailer are sent.  If a parallel RIP is in use,
+** tell its dispatcher where the page or trailer begins.
+*/
+void rip_page_boundary(gu_boolean trailer)
+	{
+	const char function[] = "rip_page_boundary";
+	char record[32];
+	int len;
+
+	if(boundary_fd == -1)
+		return;
+
+	len = snprintf(record, sizeof(record), "%c%ld\n", trailer ? 'T' : 'P', printer_tell() - boundary_base);
+
+	while(write(boundary_fd, record, len) == -1)
+		{
+		if(errno == EINTR)
+			continue;
+
+		/* If the dispatcher has died, fault_check() will soon say why. */
+		if(errno == EPIPE)
+			break;
+
+		fatal(EXIT_PRNERR, "%s(): write() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+		}
+	} /* end of rip_page_boundary() */
+
+/*============================================================================
+** Pre-RIP Cache
+**
+** When a job is waiting for a busy printer, pprd may run "pprdrv --prerip"
+** on it (see pprd_prerip.c).  That runs the job proper through the RIP in
+** test mode with the RIP's output going to a file in the jobs directory.
+** When the job is later printed, rip_start() runs a child in place of the
+** RIP which discards the PostScript and sends the saved output instead.
+**
+** The first line of the file is a key which describes what went into the
+** output: the printer name, a hash of the queue file (less the "PPRD:" line,
+** which pprd rewrites as the job's status changes), and the inode numbers,
+** modification times, and sizes of the printer configuration file and the
+** PPD file.  (Since ppad replaces the configuration file, its inode number
+** changes even if it is changed twice in the same second.)  If any of these
+** has changed by the time the job is printed, the file is ignored and the
+** job is RIPed in the usual way.
+============================================================================*/
+
+static char *cache_key = NULL;			/* first line of the file */
+static long int cache_limit = 0;		/* largest file a pre-RIP may write */
+
+/*
+** Build the key which describes the current job and printer.  This is
+** called from real_main() before test mode changes the printer name.
+*/
+void rip_cache_key(void)
+	{
+	char fname[MAX_PPR_PATH];
+	FILE *f;
+	int c;
+	unsigned long int hash = 5381;
+	gu_boolean first_line = TRUE;
+	struct stat conf_stat, ppd_stat;
+
+	ppr_fnamef(fname, "%s/%s", QUEUEDIR, QueueFile);
+	if(!(f = fopen(fname, "r")))
+		return;
+	while((c = getc(f)) != EOF)
+		{
+		if(first_line)
+			first_line = (c != '\n');
+		else
+			hash = (hash * 33 + c) & 0xFFFFFFFF;
+		}
+	fclose(f);
+
+	ppr_fnamef(fname, "%s/%s", PRCONF, printer.Name);
+	if(stat(fname, &conf_stat) == -1)
+		return;
+
+	if(!printer.PPDFile || stat(printer.PPDFile, &ppd_stat) == -1)
+		ppd_stat.st_ino = ppd_stat.st_mtime = ppd_stat.st_size = 0;
+
+	gu_asprintf(&cache_key, "PPR-RIP-Cache: %s %08lx %lu %ld %ld %lu %ld %ld\n",
+		printer.Name, hash,
+		(unsigned long)conf_stat.st_ino, (long)conf_stat.st_mtime, (long)conf_stat.st_size,
+		(unsigned long)ppd_stat.st_ino, (long)ppd_stat.st_mtime, (long)ppd_stat.st_size);
+	} /* end of rip_cache_key() */
+
+/*
+** If there is saved RIP output which matches the key, open it and return
+** a file descriptor positioned just after the key, otherwise return -1.
+*/
+static int rip_cache_open(void)
+	{
+	char fname[MAX_PPR_PATH];
+	char buf[MAX_PPR_PATH + 100];
+	size_t len;
+	int fd;
+
+	if(!cache_key || (len = strlen(cache_key)) > sizeof(buf))
+		return -1;
+
+	ppr_fnamef(fname, "%s/%s-rip", DATADIR, QueueFile);
+	if((fd = open(fname, O_RDONLY)) == -1)
+		return -1;
+	gu_set_cloexec(fd);
+
+	if(read(fd, buf, len) != (ssize_t)len || memcmp(buf, cache_key, len) != 0)
+		{
+		DODEBUG_INTERFACE(("rip_cache_open(): \"%s\" is stale", fname));
+		close(fd);
+		return -1;
+		}
+
+	return fd;
+	} /* end of rip_cache_open() */
+
+/*
+** This is called from real_main() in --prerip mode.  It connects stdout,
+** which start_interface() will give to the RIP as its output, to a new
+** file and arranges for the RIP to be stopped if it writes more than the
+** indicated number of kilobytes to it.  If a previous run left output
+** which is still good, we have nothing to do.
+*/
+void rip_cache_create(long int kbytes)
+	{
+	const char function[] = "rip_cache_create";
+	char fname[MAX_PPR_PATH];
+	int fd;
+
+	if(!cache_key)
+		hooked_exit(EXIT_INCAPABLE, "job can't be pre-RIPed");
+
+	if((fd = rip_cache_open()) != -1)
+		{
+		close(fd);
+		hooked_exit(EXIT_PRINTED, NULL);
+		}
+
+	ppr_fnamef(fname, "%s/%s-rip.tmp", DATADIR, QueueFile);
+	if((fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC, UNIX_644)) == -1)
+		fatal(EXIT_PRNERR, "%s(): can't create \"%s\", errno=%d (%s)", function, fname, errno, gu_strerror(errno));
+	if(write(fd, cache_key, strlen(cache_key)) == -1)
+		fatal(EXIT_PRNERR, "%s(): write() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+	dup2(fd, 1);
+	close(fd);
+
+	cache_limit = strlen(cache_key) + kbytes * 1024;
+	} /* end of rip_cache_create() */
+
+/*
+** This is called from real_main() in --prerip mode after the RIP has
+** finished.  If it succeeded, the output is put where rip_cache_open()
+** will find it.
+*/
+void rip_cache_commit(void)
+	{
+	const char function[] = "rip_cache_commit";
+	char tname[MAX_PPR_PATH], fname[MAX_PPR_PATH];
+
+	if(rip_exit_code != 0)
+		fatal(EXIT_JOBERR, "RIP exited with code %d", rip_exit_code);
+
+	ppr_fnamef(tname, "%s/%s-rip.tmp", DATADIR, QueueFile);
+	ppr_fnamef(fname, "%s/%s-rip", DATADIR, QueueFile);
+	if(rename(tname, fname) == -1)
+		fatal(EXIT_PRNERR, "%s(): rename(\"%s\", \"%s\") failed, errno=%d (%s)", function, tname, fname, errno, gu_strerror(errno));
+	} /* end of rip_cache_commit() */
+
+/*
+** This runs in the child which rip_start() launches in place of the RIP.
+** Having no use for the PostScript, we read it to the end so that pprdrv
+** can finish sending it, then send the saved output to the interface.
+*/
+static void rip_cache_play(int fd)
+#ifdef __GNUC__
+__attribute__ (( noreturn ))
+#endif
+;
+static void rip_cache_play(int fd)
+	{
+	char buf[8192];
+	ssize_t len, written;
+	char *p;
+
+	signal(SIGTERM, SIG_DFL);
+	signal(SIGHUP, SIG_DFL);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGALRM, SIG_DFL);
+	signal(SIGPIPE, SIG_DFL);
+	signal(SIGUSR1, SIG_DFL);
+	signal(SIGCHLD, SIG_DFL);
+
+	while((len = read(0, buf, sizeof(buf))) != 0)
+		{
+		if(len == -1 && errno != EINTR)
+			break;
+		}
+
+	while((len = read(fd, buf, sizeof(buf))) != 0)
+		{
+		if(len == -1)
+			{
+			if(errno == EINTR)
+				continue;
+			fprintf(stderr, "Can't read pre-RIPed output, errno=%d (%s)\n", errno, gu_strerror(errno));
+			_exit(1);
+			}
+		for(p = buf; len > 0; p += written, len -= written)
+			{
+			if((written = write(3, p, len)) == -1)
+				{
+				if(errno != EINTR)
+					_exit(1);
+				written = 0;
+				}
+			}
+		}
+
+	_exit(0);
+	} /* end of rip_cache_play() */
+
 /*
 ** This is called from job_start().  It interposes a Raster Image Processor
 ** such as Ghostscript between pprdrv and the interface program.  It also
@@ -173,14 +853,20 @@ void rip_fault_check(void)
 **		the printer control language data to.
 ** stdout_handle is the file descriptor to which the RIP should write
 **		the stdout and stderr of the PostScript program.
+** thejob is TRUE if this is the job proper rather than a banner page or
+**		such.  Its saved output may be used or its pages may be divided
+**		among several RIPs.
 */
-int rip_start(int printdata_handle, int stdout_handle)
+int rip_start(int printdata_handle, int stdout_handle, gu_boolean thejob)
 	{
 	const char function[] = "rip_start";
 	static const char *rip_exe = NULL;
 	static gu_boolean rip_is_unwrapped_ghostscript = FALSE;
 	const char **rip_args;
 	int rip_pipe[2];
+	int boundary_pipe[2];
+	int pages_per_chunk = 0;
+	int cache_fd = -1;
 
 	DODEBUG_INTERFACE(("%s()", function));
 
@@ -205,6 +891,13 @@ int rip_start(int printdata_handle, int stdout_handle)
 			rip_is_unwrapped_ghostscript = TRUE;
 			}
 
+		/* If it is some other absolute path, such as that of a test RIP,
+		   take it as it is. */
+		else if(printer.RIP.name[0] == '/')
+			{
+			rip_exe = printer.RIP.name;
+			}
+
 		/* Since the program isn't named "gs", assume that it is some
 		   sort of Ghostscript wrapper in $LIBDIR, probably
 		   our own ppr-gs.
@@ -254,6 +947,18 @@ int rip_start(int printdata_handle, int stdout_handle)
 	if(pipe(rip_pipe) == -1)
 		fatal(EXIT_PRNERR, "%s(): pipe() failed, errno=%d (%s)", function, errno, strerror(errno));
 
+	/* If the job proper was pre-RIPed, the output can be used instead. */
+	if(thejob && !test_mode)
+		cache_fd = rip_cache_open();
+
+	/* Each RIP must get whole sheets. */
+	if(cache_fd == -1 && thejob && pages_independent() && printer.RIP.parallel_workers > 1)
+		{
+		pages_per_chunk = (printer.RIP.parallel_pages + job.attr.pagefactor - 1) / job.attr.pagefactor * job.attr.pagefactor;
+		if(pipe(boundary_pipe) == -1)
+			fatal(EXIT_PRNERR, "%s(): pipe() failed, errno=%d (%s)", function, errno, strerror(errno));
+		}
+
 	if((rip_pid = fork()) == -1)
 		fatal(EXIT_PRNERR, "%s(): fork() failed, errno=%d (%s)", function, errno, strerror(errno));
 
@@ -261,12 +966,23 @@ int rip_start(int printdata_handle, int stdout_handle)
 	if(rip_pid == 0)
 		{
 		/* See pprdrv_interface.c:start_interface() for comments on this paranoid code. */
-		int new_stdin, new_stdout, new_printdata;
+		int new_stdin, new_stdout, new_printdata, new_boundary = -1, new_cache = -1;
 		umask(PPR_INTERFACE_UMASK);
 		setpgid(0, 0);
+		if(cache_fd != -1)		/* above the descriptors we are about to assign */
+			{
+			new_cache = fcntl(cache_fd, F_DUPFD, PARALLEL_BOUNDARY_FD + 1);
+			close(cache_fd);
+			}
 		new_stdin=dup(rip_pipe[0]);
 		new_stdout=dup(stdout_handle);
 		new_printdata=dup(printdata_handle);
+		if(pages_per_chunk)
+			{
+			new_boundary=dup(boundary_pipe[0]);
+			close(boundary_pipe[0]);
+			close(boundary_pipe[1]);
+			}
 		close(rip_pipe[0]);
 		close(rip_pipe[1]);
 		close(stdout_handle);
@@ -278,6 +994,11 @@ int rip_start(int printdata_handle, int stdout_handle)
 		close(new_stdin);
 		close(new_stdout);
 		close(new_printdata);
+		if(new_boundary != -1)
+			{
+			dup2(new_boundary, PARALLEL_BOUNDARY_FD);
+			close(new_boundary);
+			}
 
 		/* Some RIPs need the PPD file to set themselves up. */
 		{
@@ -298,6 +1019,22 @@ int rip_start(int printdata_handle, int stdout_handle)
 			putenv("PPR_RIPOPTS=");
 			}
 
+		/* Send the saved output rather than RIPing again. */
+		if(new_cache != -1)
+			rip_cache_play(new_cache);
+
+		/* When pre-RIPing, a RIP mustn't write more than pprd allows. */
+		if(cache_limit > 0)
+			{
+			struct rlimit limit;
+			limit.rlim_cur = limit.rlim_max = cache_limit;
+			setrlimit(RLIMIT_FSIZE, &limit);
+			}
+
+		/* Divide the pages among several copies of Ghostscript. */
+		if(pages_per_chunk)
+			rip_parallel(rip_exe, rip_args, printer.RIP.parallel_workers, pages_per_chunk);
+
 		/* Launch Ghostscript. */
 		execv(rip_exe, (char**)rip_args);
 		_exit(1);
@@ -307,6 +1044,20 @@ int rip_start(int printdata_handle, int stdout_handle)
 
 	close(rip_pipe[0]);			/* read end */
 
+	if(cache_fd != -1)
+		{
+		close(cache_fd);
+		DODEBUG_INTERFACE(("%s(): sending pre-RIPed output", function));
+		}
+
+	if(pages_per_chunk)
+		{
+		close(boundary_pipe[0]);
+		boundary_fd = boundary_pipe[1];
+		boundary_base = printer_tell();
+		DODEBUG_INTERFACE(("%s(): dispatching %d pages at a time to %d RIPs", function, pages_per_chunk, printer.RIP.parallel_workers));
+		}
+
 	gu_free(rip_args);
 
 	/* We will stash this away so that rip_stop() can return it.  Before then,
@@ -339,6 +1090,13 @@ int rip_stop(int printdata_handle2, gu_boolean flushit)
 	/* We can handle it from here. */
 	rip_fault_check_disable = TRUE;
 
+	/* A parallel RIP dispatcher learns of the last page offset first. */
+	if(boundary_fd != -1)
+		{
+		close(boundary_fd);
+		boundary_fd = -1;
+		}
+
 	/* Let the RIP know that that is EOF. */
 	close(printdata_handle2);
 
@@ -361,7 +1119,7 @@ int rip_stop(int printdata_handle2, gu_boolean flushit)
 	fault_check();
 
 	/* Check to see if the RIP core dumped or something like that. */
-	rip_exit_screen();
+	rip_exit_code = rip_exit_screen();
 
 	DODEBUG_INTERFACE(("%s(): done", function));
 	return saved_printdata_handle;
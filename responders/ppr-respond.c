@@ -7,7 +7,7 @@
 ** terms of the revised BSD licence (without the advertising clause) as
 ** described in the accompanying file LICENSE.txt.
 **
-** Last modified 8 May 2006.
+** Last modified 19 October 2026.
 */
 
 /*
@@ -19,8 +19,10 @@
 ** unmodified.  The principal task of this program is to create the additional
 ** localized parameters subject=, short_message=, and long_message=.
 **
-** Since the program does its job and then exits, it blithely allocates
-** memory without freeing it.
+** When it is run for a single message, the program does its job and then
+** exits, so it blithely allocates memory without freeing it.  When pprd
+** runs it as its long-running responder dispatcher (see below), each
+** message is prepared in its own memory pool.
 */
 
 #include "config.h"
@@ -28,6 +30,9 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -646,15 +651,75 @@ static struct RESPONDER *followme(struct RESPONDER *responder)
 	}
 
 /*
-** The command line interface of this program is not documented.  It will
-** quite likely change with each version of PPR.  Different parameters
-** are expected based upon which program invokes it (as indicated by
-** argv[1]).
+** A message ready to be handed to a responder program.  Everything it
+** points to (and the structure itself) is allocated in the pool.
 */
-int main(int argc, char *argv[])
+struct RESPONSE_MESSAGE
+	{
+	void *pool;
+	char *path;					/* responder program */
+	void *command;				/* its name=value parameters */
+	struct RESPONDER responder;
+	const char *lc_messages;
+	char *subject;				/* "subject=..." */
+	char *short_message;		/* "short_message=..." */
+	char *long_message;			/* "long_message=..." */
+	int log_fd;					/* job's log file, -1 if none */
+	struct RESPONSE_MESSAGE *next;
+	} ;
+
+#ifdef INTERNATIONAL
+static char locale_saved[256] = "";		/* locale to go back to, if changed */
+
+/*
+** Switch to the locale in which a message should be written.  The
+** dispatcher writes messages for many jobs one after another, so once
+** the message is written, message_locale_end() must be called to go
+** back.  Nothing is done if the locale is already right.
+*/
+static void message_locale_begin(const char lc_messages[])
+	{
+	static gu_boolean bound = FALSE;
+	const char *current;
+
+	if(!lc_messages || locale_saved[0])
+		return;
+	if(!(current = setlocale(LC_ALL, NULL)) || strlen(current) >= sizeof(locale_saved))
+		current = "C";
+	if(strcmp(current, lc_messages) == 0)
+		return;
+
+	strcpy(locale_saved, current);
+	setlocale(LC_ALL, lc_messages);
+	if(!bound)
+		{
+		bindtextdomain(PACKAGE, LOCALEDIR);
+		textdomain(PACKAGE);
+		bound = TRUE;
+		}
+	} /* end of message_locale_begin() */
+
+static void message_locale_end(void)
+	{
+	if(locale_saved[0])
+		{
+		setlocale(LC_ALL, locale_saved);
+		locale_saved[0] = '\0';
+		}
+	} /* end of message_locale_end() */
+#endif
+
+/*
+** Gather the information about the message described by the name=value
+** parameters in argv[] and by the queue file open on qfile_fd (if it is
+** not -1).  Return the message to be sent or NULL if none should be.
+** The queue file is closed.
+*/
+static struct RESPONSE_MESSAGE *build_response(int argc, char *argv[], int qfile_fd)
 	{
 	struct RESPONSE_INFO rinfo;
 	struct RESPONDER *actual_responder;
+	struct RESPONSE_MESSAGE *m;
 	int iii;
 	void *command;
 	char *p;
@@ -680,14 +745,18 @@ int main(int argc, char *argv[])
 	rinfo.commentary_severity_threshold = 5;
 	rinfo.job_age_threshold = 300;
 
-	for(iii=1; iii < argc; iii++)
+	if(qfile_fd != -1)
 		{
-		if(strcmp(argv[iii], "qfile_fd3") == 0)
+		FILE *f;
+		if(!(f = fdopen(qfile_fd, "r")))
+			{
+			close(qfile_fd);
+			gu_Throw("fdopen() failed, errno=%d (%s)", errno, gu_strerror(errno));
+			}
+		gu_Try
 			{
-			FILE *f = fdopen(3, "r");
 			char *line = NULL;
 			int line_len = 80;
-			char *p;
 			qentryfile_load(&rinfo.qentry, f);
 			while((line = gu_getline(line, &line_len, f)))
 				{
@@ -697,8 +766,23 @@ int main(int argc, char *argv[])
 					continue;
 					}
 				}
+			}
+		gu_Final
+			{
 			fclose(f);
 			}
+		gu_Catch
+			{
+			gu_ReThrow();
+			}
+		}
+
+	for(iii=0; iii < argc; iii++)
+		{
+		if(strcmp(argv[iii], "qfile_fd3") == 0)
+			{
+			/* already read */
+			}
 		else if((p = gu_name_matchp(argv[iii], "responder_name")))
 			{
 			rinfo.qentry.responder.name = p;
@@ -804,7 +888,7 @@ int main(int argc, char *argv[])
 	
 	/* If no response is possible, then we are done. */
 	if(!(actual_responder = followme(&rinfo.qentry.responder)))
-		return 0;
+		return NULL;
 
 	/* Parse the responder options and deteremine if this message should actually be sent. */
 	if(actual_responder->options && strlen(actual_responder->options) > 0)
@@ -817,12 +901,12 @@ int main(int argc, char *argv[])
 			if((value = gu_name_matchp(item, "printed")))
 				{
 				if(gu_torf_setBOOL(&yes, value) != -1 && !yes && rinfo.response_code==RESP_FINISHED)
-					return 0;
+					return NULL;
 				}
 			else if((value = gu_name_matchp(item, "canceled")))
 				{
 				if(gu_torf_setBOOL(&yes, value) != -1 && !yes && (rinfo.response_code==RESP_CANCELED || rinfo.response_code==RESP_CANCELED_PRINTING))
-					return 0;
+					return NULL;
 				}
 			else if((value = gu_name_matchp(item, "commentary_severity_threshold")))
 				{
@@ -841,18 +925,13 @@ int main(int argc, char *argv[])
 		}
 
 	if(rinfo.commentary_severity >= 0 && rinfo.commentary_severity < rinfo.commentary_severity_threshold)
-		return 0;
+		return NULL;
 	if(rinfo.commentary_duration >= 0 && rinfo.commentary_duration < rinfo.commentary_duration_threshold)
-		return 0;
+		return NULL;
 	
-	/* Initialize international messages library. */
+	/* Write the message in the submitter's language. */
 	#ifdef INTERNATIONAL
-	if(rinfo.qentry.lc_messages)
-		{
-		setlocale(LC_ALL, rinfo.qentry.lc_messages);
-		bindtextdomain(PACKAGE, LOCALEDIR);
-		textdomain(PACKAGE);
-		}
+	message_locale_begin(rinfo.qentry.lc_messages);
 	#endif
 
 	/* Add job information from queue file */
@@ -899,22 +978,519 @@ int main(int argc, char *argv[])
 			}
 		}
 
-	/* Add suggested messages */
-	gu_pca_push(command, build_subject(&rinfo));
-	gu_pca_push(command, build_message(&rinfo, FALSE));		/* short_message */
-	gu_pca_push(command, build_message(&rinfo, TRUE));		/* long_message */
+	m = gu_alloc(1, sizeof(struct RESPONSE_MESSAGE));
+	m->pool = NULL;
+	gu_asprintf(&m->path, "%s/%s", RESPONDERDIR, actual_responder->name);
+	m->command = command;
+	m->responder = *actual_responder;
+	m->lc_messages = rinfo.qentry.lc_messages;
+
+	/* Suggested messages */
+	m->subject = build_subject(&rinfo);
+	m->short_message = build_message(&rinfo, FALSE);
+	m->long_message = build_message(&rinfo, TRUE);
+	m->log_fd = -1;
+
+	#ifdef INTERNATIONAL
+	message_locale_end();
+	#endif
+
+	m->next = NULL;
+	return m;
+	} /* end of build_response() */
+
+/*
+** Finish the responder's argument vector.
+*/
+static char **response_argv(struct RESPONSE_MESSAGE *m)
+	{
+	gu_pca_push(m->command, m->subject);
+	gu_pca_push(m->command, m->short_message);
+	gu_pca_push(m->command, m->long_message);
 
 	/* Add the (possibly modified) responder options to the command line. */
-	gu_pca_push(command, gu_name_str_value("responder_name", actual_responder->name));
-	gu_pca_push(command, gu_name_str_value("responder_address", actual_responder->address));
-	gu_pca_push(command, gu_name_str_value("responder_options", actual_responder->options));
+	gu_pca_push(m->command, gu_name_str_value("responder_name", m->responder.name));
+	gu_pca_push(m->command, gu_name_str_value("responder_address", m->responder.address));
+	gu_pca_push(m->command, gu_name_str_value("responder_options", m->responder.options));
+
+	gu_pca_unshift(m->command, m->path);		/* argv[0] */
+	gu_pca_push(m->command, NULL);				/* terminates argv[] */
+	return gu_pca_ptr(m->command);
+	} /* end of response_argv() */
+
+/*============================================================================
+** The dispatcher
+**
+** When run with the single argument --dispatcher, this program stays
+** running and receives messages from pprd over the socket on its stdin.
+** Each is a datagram containing the name=value parameters separated by
+** NULs and carrying the open queue file as SCM_RIGHTS ancillary data.
+**
+** Messages for the same responder and address which arrive within the
+** "coalesce window" (in seconds) of the first are sent as one.  No more
+** than "workers" responders run at once.  While they are all busy,
+** messages keep piling up in the batches, so a printer group which
+** finishes a thousand jobs in a few minutes produces at most a few dozen
+** responder processes.  Both settings are in the [responders] section of
+** ppr.conf.  When pprd closes the socket or SIGTERM is received, the
+** batches are sent at once and the dispatcher exits once the responders
+** have finished.
+============================================================================*/
+
+#define DISPATCHER_WORKERS 4		/* default maximum running responders */
+#define DISPATCHER_COALESCE 2		/* default coalesce window in seconds */
+#define DISPATCHER_BATCH_MAX 100	/* most messages combined into one */
+#define DISPATCHER_MAX_MESSAGE 4096
+#define DISPATCHER_MAX_PARAMS 32
+
+/* The messages waiting for one responder and address */
+struct RESPONSE_BATCH
+	{
+	char *key;					/* responder name and address */
+	time_t started;				/* arrival time of first message */
+	int count;
+	struct RESPONSE_MESSAGE *first;
+	struct RESPONSE_MESSAGE *last;
+	struct RESPONSE_BATCH *next;
+	} ;
+
+static struct RESPONSE_BATCH *batches_head = NULL;		/* oldest first */
+static struct RESPONSE_BATCH *batches_tail = NULL;
+static void *batches_index = NULL;						/* by key */
+static int workers_running = 0;
+
+static volatile gu_boolean sigterm_received = FALSE;
+
+/* The only purpose of this handler is to interrupt select(). */
+static void dispatcher_sigchld(int sig)
+	{
+	} /* end of dispatcher_sigchld() */
+
+/* When told to stop, we send what we have first. */
+static void dispatcher_sigterm(int sig)
+	{
+	sigterm_received = TRUE;
+	} /* end of dispatcher_sigterm() */
+
+/*
+** Add a message to the batch for its recipient, starting a new one if
+** there is none.
+*/
+static void queue_message(struct RESPONSE_MESSAGE *m)
+	{
+	struct RESPONSE_BATCH *b;
+	char *key;
+
+	gu_asprintf(&key, "%s %s", m->responder.name, m->responder.address);
+	if((b = gu_pch_get(batches_index, key)))
+		{
+		gu_free(key);
+		b->last->next = m;
+		b->last = m;
+		b->count++;
+		}
+	else
+		{
+		b = gu_alloc(1, sizeof(struct RESPONSE_BATCH));
+		b->key = key;
+		b->started = time(NULL);
+		b->count = 1;
+		b->first = b->last = m;
+		b->next = NULL;
+		if(batches_tail)
+			batches_tail->next = b;
+		else
+			batches_head = b;
+		batches_tail = b;
+		gu_pch_set(batches_index, b->key, b);
+		}
+	} /* end of queue_message() */
+
+/*
+** Remove a batch from the list and free it and its messages.
+*/
+static void free_batch(struct RESPONSE_BATCH *b)
+	{
+	struct RESPONSE_BATCH **bpp, *prev = NULL;
+	struct RESPONSE_MESSAGE *m, *next;
+
+	for(bpp = &batches_head; *bpp != b; bpp = &(*bpp)->next)
+		prev = *bpp;
+	*bpp = b->next;
+	if(batches_tail == b)
+		batches_tail = prev;
+	gu_pch_delete(batches_index, b->key);
+
+	for(m = b->first; m; m = next)
+		{
+		void *pool = m->pool;
+		next = m->next;
+		if(m->log_fd != -1)
+			close(m->log_fd);
+		gu_pool_free(pool);			/* frees m too */
+		}
+	gu_free(b->key);
+	gu_free(b);
+	} /* end of free_batch() */
+
+/*
+** Fold the messages of a batch into its last one.  The short messages are
+** put one per line, the long messages one per paragraph.
+*/
+static void combine_batch(struct RESPONSE_BATCH *b)
+	{
+	struct RESPONSE_MESSAGE *m, *last = b->last;
+	void *short_message = gu_pcs_new_cstr("short_message=");
+	void *long_message = gu_pcs_new_cstr("long_message=");
+	char *subject;
+
+	#ifdef INTERNATIONAL
+	message_locale_begin(last->lc_messages);
+	#endif
+
+	for(m = b->first; m; m = m->next)
+		{
+		if(m != b->first)
+			{
+			gu_pcs_append_char(&short_message, '\n');
+			gu_pcs_append_cstr(&long_message, "\n\n");
+			}
+		gu_pcs_append_cstr(&short_message, m->short_message + sizeof("short_message=") - 1);
+		gu_pcs_append_cstr(&long_message, m->long_message + sizeof("long_message=") - 1);
+		}
+
+	/* The subject still begins with "subject=". */
+	gu_asprintf(&subject,
+		ngettext("%s (and %d other message)", "%s (and %d other messages)", b->count - 1),
+		last->subject, b->count - 1);
+
+	last->subject = subject;
+	last->short_message = gu_pcs_free_keep_cstr(&short_message);
+	last->long_message = gu_pcs_free_keep_cstr(&long_message);
+	gu_pca_push(last->command, gu_name_int_value("message_count", b->count));
+
+	#ifdef INTERNATIONAL
+	message_locale_end();
+	#endif
+	} /* end of combine_batch() */
+
+/*
+** Return a descriptor from which the responder for a batch can read the
+** log files of its jobs, one after another, or -1 if none has one.  This
+** is called in the child.
+*/
+static int batch_log(struct RESPONSE_BATCH *b)
+	{
+	struct RESPONSE_MESSAGE *m;
+	char fname[MAX_PPR_PATH];
+	char buffer[4096];
+	int fd, len;
+
+	if(b->count == 1)
+		return b->first->log_fd;
+
+	for(m = b->first; m && m->log_fd == -1; m = m->next)
+		;
+	if(!m)
+		return -1;
+
+	ppr_fnamef(fname, "%s/ppr-respond-XXXXXX", TEMPDIR);
+	if((fd = gu_mkstemp(fname)) == -1)
+		return -1;
+	unlink(fname);
+
+	for(m = b->first; m; m = m->next)
+		{
+		if(m->log_fd == -1)
+			continue;
+		while((len = read(m->log_fd, buffer, sizeof(buffer))) > 0)
+			{
+			if(write(fd, buffer, len) != len)
+				break;
+			}
+		}
+
+	lseek(fd, (off_t)0, SEEK_SET);
+	return fd;
+	} /* end of batch_log() */
+
+/*
+** Launch the responder for a batch and free it.
+*/
+static void run_batch(struct RESPONSE_BATCH *b)
+	{
+	const char function[] = "run_batch";
+	char **command;
+	pid_t pid;
+
+	gu_pool_push(b->last->pool);
+	if(b->count > 1)
+		combine_batch(b);
+	command = response_argv(b->last);
+	gu_pool_pop(b->last->pool);
+
+	if((pid = fork()) == -1)
+		{
+		error("%s(): can't fork(), errno=%d (%s)", function, errno, gu_strerror(errno));
+		}
+	else if(pid == 0)
+		{
+		int fd;
+		if((fd = batch_log(b)) == -1)
+			fd = open("/dev/null", O_RDONLY);
+		if(fd != -1 && fd != 0)
+			{
+			dup2(fd, 0);
+			close(fd);
+			}
+		execv(command[0], command);
+		fprintf(stderr, "%s(): execv(\"%s\", ...) failed, errno=%d (%s)\n", function, command[0], errno, gu_strerror(errno));
+		_exit(242);
+		}
+	else
+		{
+		workers_running++;
+		}
+
+	free_batch(b);
+	} /* end of run_batch() */
+
+/*
+** Collect the exit status of responders which have finished.
+*/
+static void reap_workers(void)
+	{
+	pid_t pid;
+	int wstat;
+
+	while((pid = waitpid((pid_t)-1, &wstat, WNOHANG)) > (pid_t)0)
+		{
+		workers_running--;
+		if(WIFSIGNALED(wstat))
+			{
+			error("responder process %ld was killed by signal %d (%s)%s",
+				(long)pid,
+				WTERMSIG(wstat),
+				gu_strsignal(WTERMSIG(wstat)),
+				WCOREDUMP(wstat) ? ", (core dumped)" : "");
+			}
+		}
+	} /* end of reap_workers() */
+
+/*
+** Receive one message from pprd, prepare it, and add it to the batch for
+** its recipient.  Returns FALSE once pprd has closed its end.
+*/
+static gu_boolean receive_message(void)
+	{
+	const char function[] = "receive_message";
+	char buffer[DISPATCHER_MAX_MESSAGE + 1];
+	char *params[DISPATCHER_MAX_PARAMS];
+	union {
+		struct cmsghdr align;
+		char space[CMSG_SPACE(2 * sizeof(int))];
+		} control;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	ssize_t len;
+	int qfile_fd = -1;
+	int log_fd = -1;
+	int count, x;
+	char *p;
+	void *pool;
+	struct RESPONSE_MESSAGE *m = NULL;
+
+	iov.iov_base = buffer;
+	iov.iov_len = DISPATCHER_MAX_MESSAGE;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.space;
+	msg.msg_controllen = sizeof(control.space);
+
+	if((len = recvmsg(0, &msg, 0)) == -1)
+		{
+		if(errno == EINTR || errno == EAGAIN)
+			return TRUE;
+		error("%s(): recvmsg() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+		return FALSE;
+		}
+	if(len == 0)
+		return FALSE;
+
+	for(cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+		{
+		if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+			{
+			/* The queue file and perhaps the job's log file */
+			int nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			if(nfds > 0)
+				memcpy(&qfile_fd, CMSG_DATA(cmsg), sizeof(int));
+			if(nfds > 1)
+				{
+				memcpy(&log_fd, CMSG_DATA(cmsg) + sizeof(int), sizeof(int));
+				gu_set_cloexec(log_fd);
+				}
+			}
+		}
+
+	/* The parameters are separated by NULs. */
+	buffer[len] = '\0';
+	for(count = 0, p = buffer; p < (buffer + len) && count < DISPATCHER_MAX_PARAMS; p += (strlen(p) + 1))
+		params[count++] = p;
+
+	pool = gu_pool_new();
+	gu_pool_push(pool);
+	gu_Try
+		{
+		for(x=0; x < count; x++)
+			params[x] = gu_strdup(params[x]);
+		m = build_response(count, params, qfile_fd);
+		}
+	gu_Final
+		{
+		gu_pool_pop(pool);
+		}
+	gu_Catch
+		{
+		error("%s", gu_exception);
+		}
+
+	/* In case build_response() threw an exception */
+	#ifdef INTERNATIONAL
+	message_locale_end();
+	#endif
+
+	if(m)
+		{
+		m->pool = pool;
+		m->log_fd = log_fd;
+		queue_message(m);
+		}
+	else
+		{
+		if(log_fd != -1)
+			close(log_fd);
+		gu_pool_free(pool);
+		}
+
+	return TRUE;
+	} /* end of receive_message() */
+
+static int dispatcher(void)
+	{
+	const char function[] = "dispatcher";
+	int workers = DISPATCHER_WORKERS;
+	int window = DISPATCHER_COALESCE;
+	gu_boolean eof = FALSE;
+	char *p;
+
+	if((p = gu_ini_query(PPR_CONF, "responders", "workers", 0, NULL)))
+		{
+		if((workers = atoi(p)) < 1)
+			workers = 1;
+		gu_free(p);
+		}
+	if((p = gu_ini_query(PPR_CONF, "responders", "coalescewindow", 0, NULL)))
+		{
+		if((window = atoi(p)) < 0)
+			window = 0;
+		gu_free(p);
+		}
+
+	batches_index = gu_pch_new(64);
+	signal_interupting(SIGCHLD, dispatcher_sigchld);
+	signal_interupting(SIGTERM, dispatcher_sigterm);
+
+	for(;;)
+		{
+		struct RESPONSE_BATCH *b, *next;
+		time_t now;
+		struct timeval tv, *timeout = NULL;
+		fd_set rfds;
+
+		reap_workers();
+
+		if(sigterm_received)
+			eof = TRUE;
+
+		/* Launch the batches which are ready, oldest first. */
+		now = time(NULL);
+		for(b = batches_head; b && workers_running < workers; b = next)
+			{
+			next = b->next;
+			if(eof || b->count >= DISPATCHER_BATCH_MAX || (now - b->started) >= window)
+				run_batch(b);
+			}
+
+		if(eof && !batches_head && workers_running == 0)
+			break;
+
+		/* Wait for a message, for the oldest batch to ripen, or for a
+		   responder to exit.  Since SIGCHLD can arrive just before
+		   select() is called, we never wait for it more than a second. */
+		if(batches_head || (eof && workers_running > 0))
+			{
+			tv.tv_usec = 0;
+			if(eof || workers_running >= workers)
+				tv.tv_sec = 1;
+			else
+				tv.tv_sec = window - (now - batches_head->started);
+			timeout = &tv;
+			}
+
+		FD_ZERO(&rfds);
+		if(!eof)
+			FD_SET(0, &rfds);
+
+		if(select(eof ? 0 : 1, &rfds, NULL, NULL, timeout) == -1)
+			{
+			if(errno != EINTR)
+				{
+				error("%s(): select() failed, errno=%d (%s)", function, errno, gu_strerror(errno));
+				sleep(1);
+				}
+			continue;
+			}
+
+		if(!eof && FD_ISSET(0, &rfds) && !receive_message())
+			eof = TRUE;
+		}
+
+	return 0;
+	} /* end of dispatcher() */
+
+/*
+** The command line interface of this program is not documented.  It will
+** quite likely change with each version of PPR.  Different parameters
+** are expected based upon which program invokes it.
+*/
+int main(int argc, char *argv[])
+	{
+	struct RESPONSE_MESSAGE *m;
+	char **command;
+	int qfile_fd = -1;
+	int iii;
+
+	if(argc == 2 && strcmp(argv[1], "--dispatcher") == 0)
+		return dispatcher();
+
+	for(iii=1; iii < argc; iii++)
+		{
+		if(strcmp(argv[iii], "qfile_fd3") == 0)
+			qfile_fd = 3;
+		}
+
+	/* If no message should be sent, we are done. */
+	if(!(m = build_response(argc - 1, argv + 1, qfile_fd)))
+		return 0;
 
-	gu_asprintf(&p, "%s/%s", RESPONDERDIR, actual_responder->name);
-	gu_pca_unshift(command, p);		/* argv[0] */
+	command = response_argv(m);
 	fflush(stdout);
-	execv(p, gu_pca_ptr(command));
+	execv(command[0], command);
 
-	gu_Throw(_("%s: execv(\"%s\", ...) failed, errno=%d (%s)"), argv[0], p, errno, gu_strerror(errno));
+	gu_Throw(_("%s: execv(\"%s\", ...) failed, errno=%d (%s)"), argv[0], command[0], errno, gu_strerror(errno));
 	}
 
 /* end of file */
@@ -0,0 +1,843 @@
+/*
+** mouse:~ppr/src/www/ppr-push-events.c
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/*
+** This is the /push/events part of ppr-push-httpd.  It sends a stream of
+** Server-Sent Events (Content-Type "text/event-stream") which tells the
+** browser about each change in the state of the printers and jobs as it
+** appears on the status board which pprd and pprdrv keep (see
+** libppr/status_board.c).  Pages such as show_queues.cgi use it (through
+** push_events.js) to update themselves in place rather than reloading.
+**
+** A browser holds its event stream open for as long as the page is up, so
+** we don't want a process for each one.  The ppr-push-httpd which receives
+** the request sends the HTTP response header, hands the connection over to
+** the events server, and exits.  The events server is another
+** ppr-push-httpd, started by the first one which needs it.  It looks at the
+** status board POLL_INTERVAL times a second and writes the changes to all of
+** its clients.  It exits once it has had no clients for IDLE_EXIT seconds.
+**
+** A connection is handed over as a datagram on the Unix-domain socket
+** PUSH_EVENTS_SOCKET with the connection attached as SCM_RIGHTS.  The
+** datagram holds the browser's Last-Event-ID (which may be empty) and then
+** the names of the queues it wants to hear about, all separated by NULs.
+** If there are no names, it hears about all of them.
+**
+** These are the events:
+**
+** reset	forget all printers and jobs, a full list follows
+** printer	the data is a JSON object describing a printer slot
+** job		the data is a JSON object describing a job slot
+** sync		the end of a batch of changes
+**
+** An object with only a "slot" member means that the slot is now empty or
+** holds something the client didn't ask about.  Each sync carries an event
+** ID from which a browser which reconnects can pick up where it left off.
+*/
+
+#include "config.h"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include "gu.h"
+#include "global_defines.h"
+#include "global_structs.h"
+#include "status_board.h"
+#include "ppr-push-httpd.h"
+
+/* How often do we look at the status board (in milliseconds)? */
+#define POLL_INTERVAL 250
+
+/* How often do we send a comment so that idle connections aren't
+   dropped by proxies (in seconds)? */
+#define KEEPALIVE_INTERVAL 30
+
+/* How long do we wait for a new client before exiting (in seconds)? */
+#define IDLE_EXIT 300
+
+/* How much unsent output may a client build up before we hang up on it?
+   Its browser will reconnect and catch up using Last-Event-ID. */
+#define MAX_BACKLOG (256 * 1024)
+
+/* The largest handover message. */
+#define MAX_HANDOVER 8192
+
+/* How long should a browser wait before reconnecting (in milliseconds)? */
+#define RETRY_INTERVAL 3000
+
+/* Output waiting to be sent. */
+struct BUFFER {
+	char *data;
+	size_t start;				/* first byte not yet sent */
+	size_t len;					/* end of the data */
+	size_t space;
+	};
+
+struct CLIENT {
+	int fd;
+	char **queues;				/* queues it wants to hear about */
+	int queues_count;			/* 0 means all */
+	char *last_event_id;		/* from the browser, until it is caught up */
+	gu_boolean caught_up;		/* has it been sent everything up to board_events? */
+	struct BUFFER out;
+	};
+
+/* A slot which has changed since the last poll. */
+struct CHANGE {
+	char name[STATUS_BOARD_NAME_MAX];	/* queue to which it belongs, empty if none */
+	const char *kind;					/* "printer" or "job" */
+	int slot;
+	struct BUFFER text;					/* event for interested clients */
+	};
+
+static struct STATUS_BOARD *board = NULL;
+static unsigned int board_events;			/* last event we have sent out */
+
+static struct CLIENT *clients = NULL;
+static int clients_count = 0;
+static int clients_space = 0;
+
+static struct CHANGE *changes = NULL;
+static int changes_count = 0;
+static int changes_space = 0;
+
+/*===========================================================================
+** Output buffers
+===========================================================================*/
+
+static void buffer_append(struct BUFFER *b, const char text[], size_t len)
+	{
+	if((b->len + len) > b->space)
+		{
+		/* If the data has moved up a long way, move it back down. */
+		if(b->start > 0 && b->start >= (b->len - b->start))
+			{
+			memmove(b->data, b->data + b->start, b->len - b->start);
+			b->len -= b->start;
+			b->start = 0;
+			}
+		if((b->len + len) > b->space)
+			{
+			b->space = (b->len + len) * 2;
+			b->data = gu_realloc(b->data, b->space, sizeof(char));
+			}
+		}
+	memcpy(b->data + b->len, text, len);
+	b->len += len;
+	}
+
+static void buffer_puts(struct BUFFER *b, const char text[])
+	{
+	buffer_append(b, text, strlen(text));
+	}
+
+static void buffer_printf(struct BUFFER *b, const char format[], ...)
+	{
+	char temp[256];
+	va_list va;
+	int len;
+	va_start(va, format);
+	len = vsnprintf(temp, sizeof(temp), format, va);
+	va_end(va);
+	if(len >= (int)sizeof(temp))
+		len = sizeof(temp) - 1;
+	if(len > 0)
+		buffer_append(b, temp, len);
+	}
+
+static size_t buffer_unsent(const struct BUFFER *b)
+	{
+	return b->len - b->start;
+	}
+
+/*
+** Add a JSON member whose value is a string.  Names and messages come
+** from printers and users, so anything odd is escaped.
+*/
+static void buffer_json_string(struct BUFFER *b, const char name[], const char value[])
+	{
+	const unsigned char *p;
+	buffer_printf(b, ",\"%s\":\"", name);
+	for(p = (const unsigned char *)value; *p; p++)
+		{
+		if(*p == '"' || *p == '\\')
+			buffer_printf(b, "\\%c", *p);
+		else if(*p < ' ' || *p == 0x7F)
+			buffer_printf(b, "\\u%04x", *p);
+		else
+			buffer_append(b, (const char *)p, 1);
+		}
+	buffer_puts(b, "\"");
+	}
+
+/*===========================================================================
+** Formatting events
+===========================================================================*/
+
+static void format_empty(struct BUFFER *b, const char kind[], int slot)
+	{
+	buffer_printf(b, "event: %s\ndata: {\"slot\":%d}\n\n", kind, slot);
+	}
+
+/*
+** Append an event describing a printer slot.  The page and byte counts
+** are only good if pprdrv wrote them for the job now printing.
+*/
+static void format_printer(struct BUFFER *b, int slot, const struct STATUS_BOARD_PRINTER *p)
+	{
+	buffer_printf(b, "event: printer\ndata: {\"slot\":%d", slot);
+	buffer_json_string(b, "name", p->name);
+	buffer_json_string(b, "status", status_board_printer_status_word(p->status));
+	buffer_printf(b, ",\"retry\":%d,\"countdown\":%d", p->retry, p->countdown);
+	if(p->job_destname[0])
+		{
+		buffer_json_string(b, "job", jobid(p->job_destname, p->job_id, p->job_subid));
+		if(p->drv_job_id == p->job_id && p->drv_job_subid == p->job_subid)
+			buffer_printf(b, ",\"pages_started\":%d,\"pages_printed\":%d,\"bytes_sent\":%ld,\"bytes_total\":%ld",
+				p->pages_started, p->pages_printed, p->bytes_sent, p->bytes_total);
+		}
+	buffer_json_string(b, "message", p->message);
+	buffer_puts(b, "}\n\n");
+	}
+
+static void format_job(struct BUFFER *b, int slot, const struct STATUS_BOARD_JOB *j)
+	{
+	buffer_printf(b, "event: job\ndata: {\"slot\":%d", slot);
+	buffer_json_string(b, "job", jobid(j->destname, j->id, j->subid));
+	buffer_json_string(b, "queue", j->destname);
+	buffer_printf(b, ",\"priority\":%d", j->priority);
+	buffer_json_string(b, "status", status_board_job_status_word(j->status));
+	if(j->status >= 0 && j->status < STATUS_BOARD_PRINTERS)
+		buffer_json_string(b, "printer", board->printers[j->status].name);
+	buffer_puts(b, "}\n\n");
+	}
+
+/* The ID is the time at which pprd started the board and the event number. */
+static void format_sync(struct BUFFER *b)
+	{
+	buffer_printf(b, "id: %ld-%u\nevent: sync\ndata: {\"events\":%u}\n\n",
+		board->header->started, board_events, board_events);
+	}
+
+/*===========================================================================
+** Clients
+===========================================================================*/
+
+static gu_boolean client_wants(const struct CLIENT *c, const char name[])
+	{
+	int x;
+	if(c->queues_count == 0)
+		return TRUE;
+	for(x=0; x < c->queues_count; x++)
+		{
+		if(strcmp(c->queues[x], name) == 0)
+			return TRUE;
+		}
+	return FALSE;
+	}
+
+/*
+** Add a client from a handover message.  The caller has already sent the
+** response header.
+*/
+static void client_new(int fd, char *params[], int count)
+	{
+	struct CLIENT *c;
+	int x;
+
+	if(clients_count == clients_space)
+		{
+		clients_space = clients_space ? clients_space * 2 : 16;
+		clients = gu_realloc(clients, clients_space, sizeof(struct CLIENT));
+		}
+	c = &clients[clients_count++];
+
+	gu_nonblock(fd, TRUE);
+	gu_set_cloexec(fd);
+	c->fd = fd;
+	c->last_event_id = count > 0 && params[0][0] ? gu_strdup(params[0]) : NULL;
+	c->queues_count = count > 1 ? count - 1 : 0;
+	c->queues = c->queues_count ? gu_alloc(c->queues_count, sizeof(char*)) : NULL;
+	for(x=0; x < c->queues_count; x++)
+		c->queues[x] = gu_strdup(params[x + 1]);
+	c->caught_up = FALSE;
+	memset(&c->out, 0, sizeof(c->out));
+
+	buffer_printf(&c->out, "retry: %d\n\n", RETRY_INTERVAL);
+	}
+
+static void client_free(struct CLIENT *c)
+	{
+	int x;
+	close(c->fd);
+	for(x=0; x < c->queues_count; x++)
+		gu_free(c->queues[x]);
+	if(c->queues)
+		gu_free(c->queues);
+	if(c->last_event_id)
+		gu_free(c->last_event_id);
+	if(c->out.data)
+		gu_free(c->out.data);
+	}
+
+/* Drop clients whose fd has been set to -1. */
+static void clients_sweep(void)
+	{
+	int x, y;
+	for(x=y=0; x < clients_count; x++)
+		{
+		if(clients[x].fd == -1)
+			continue;
+		if(y != x)
+			clients[y] = clients[x];
+		y++;
+		}
+	clients_count = y;
+	}
+
+static void client_drop(struct CLIENT *c)
+	{
+	client_free(c);
+	c->fd = -1;
+	}
+
+/* Write as much of the client's output as it will take now. */
+static void client_flush(struct CLIENT *c)
+	{
+	ssize_t len;
+	while(c->fd != -1 && buffer_unsent(&c->out) > 0)
+		{
+		if((len = write(c->fd, c->out.data + c->out.start, buffer_unsent(&c->out))) == -1)
+			{
+			if(errno == EINTR)
+				continue;
+			if(errno != EAGAIN)
+				client_drop(c);
+			return;
+			}
+		c->out.start += len;
+		}
+	c->out.start = c->out.len = 0;
+	}
+
+/*
+** Bring a new client up to date.  If it has been connected to us before and
+** this board is still current, send the slots which have changed since then.
+** Otherwise, send a reset and all of the slots.
+*/
+static void client_catch_up(struct CLIENT *c)
+	{
+	struct STATUS_BOARD_PRINTER p;
+	struct STATUS_BOARD_JOB j;
+	unsigned int since = 0;
+	gu_boolean all = TRUE;
+	int x, used;
+
+	if(c->last_event_id)
+		{
+		long started;
+		if(gu_sscanf(c->last_event_id, "%ld-%u", &started, &since) == 2 && started == board->header->started)
+			all = FALSE;
+		gu_free(c->last_event_id);
+		c->last_event_id = NULL;
+		}
+
+	if(all)
+		buffer_puts(&c->out, "event: reset\ndata: {}\n\n");
+
+	used = board->header->printers_used;
+	for(x=0; x < used; x++)
+		{
+		if(!all && !status_board_printer_changed(board, x, since))
+			continue;
+		if(status_board_read_printer(board, x, &p) == -1)
+			continue;
+		if(p.name[0] && client_wants(c, p.name))
+			format_printer(&c->out, x, &p);
+		else if(!all)
+			format_empty(&c->out, "printer", x);
+		}
+
+	used = board->header->jobs_used;
+	for(x=0; x < used; x++)
+		{
+		if(!all && !status_board_job_changed(board, x, since))
+			continue;
+		if(status_board_read_job(board, x, &j) == -1)
+			continue;
+		if(j.destname[0] && client_wants(c, j.destname))
+			format_job(&c->out, x, &j);
+		else if(!all)
+			format_empty(&c->out, "job", x);
+		}
+
+	format_sync(&c->out);
+	c->caught_up = TRUE;
+	}
+
+/*===========================================================================
+** Following the status board
+===========================================================================*/
+
+static struct CHANGE *change_new(const char kind[], int slot)
+	{
+	struct CHANGE *ch;
+	if(changes_count == changes_space)
+		{
+		changes_space = changes_space ? changes_space * 2 : 64;
+		changes = gu_realloc(changes, changes_space, sizeof(struct CHANGE));
+		memset(&changes[changes_count], 0, (changes_space - changes_count) * sizeof(struct CHANGE));
+		}
+	ch = &changes[changes_count++];
+	ch->kind = kind;
+	ch->slot = slot;
+	ch->name[0] = '\0';
+	ch->text.start = ch->text.len = 0;
+	return ch;
+	}
+
+/*
+** Collect the slots which have changed since the last time and format an
+** event for each.  This is done once no matter how many clients there are.
+*/
+static void collect_changes(unsigned int since)
+	{
+	struct STATUS_BOARD_PRINTER p;
+	struct STATUS_BOARD_JOB j;
+	struct CHANGE *ch;
+	int x, used;
+
+	changes_count = 0;
+
+	used = board->header->printers_used;
+	for(x=0; x < used; x++)
+		{
+		if(!status_board_printer_changed(board, x, since) || status_board_read_printer(board, x, &p) == -1)
+			continue;
+		ch = change_new("printer", x);
+		if(p.name[0])
+			{
+			gu_strlcpy(ch->name, p.name, sizeof(ch->name));
+			format_printer(&ch->text, x, &p);
+			}
+		}
+
+	used = board->header->jobs_used;
+	for(x=0; x < used; x++)
+		{
+		if(!status_board_job_changed(board, x, since) || status_board_read_job(board, x, &j) == -1)
+			continue;
+		ch = change_new("job", x);
+		if(j.destname[0])
+			{
+			gu_strlcpy(ch->name, j.destname, sizeof(ch->name));
+			format_job(&ch->text, x, &j);
+			}
+		}
+	}
+
+/*
+** Open the board if we don't have it, or if pprd has started a new one.
+** If it is a new one, every client will need a reset.
+*/
+static gu_boolean board_check(void)
+	{
+	int x;
+
+	if(board && status_board_is_stale(board))
+		{
+		status_board_close(board);
+		board = NULL;
+		}
+
+	if(!board)
+		{
+		if(!(board = status_board_open(FALSE)))
+			return FALSE;
+		board_events = status_board_events(board);
+		for(x=0; x < clients_count; x++)
+			{
+			if(clients[x].last_event_id)
+				{
+				gu_free(clients[x].last_event_id);
+				clients[x].last_event_id = NULL;
+				}
+			clients[x].caught_up = FALSE;
+			}
+		}
+
+	return TRUE;
+	}
+
+/*
+** Look for changes on the board and queue them up for the clients.
+*/
+static void board_poll(void)
+	{
+	unsigned int events;
+	int x, y;
+
+	if(!board_check())
+		return;
+
+	events = status_board_events(board);
+	if(events != board_events)
+		{
+		collect_changes(board_events);
+		board_events = events;
+
+		for(x=0; x < clients_count; x++)
+			{
+			struct CLIENT *c = &clients[x];
+			if(!c->caught_up)
+				continue;
+			for(y=0; y < changes_count; y++)
+				{
+				struct CHANGE *ch = &changes[y];
+				if(ch->name[0] && client_wants(c, ch->name))
+					buffer_append(&c->out, ch->text.data, ch->text.len);
+				else
+					format_empty(&c->out, ch->kind, ch->slot);
+				}
+			format_sync(&c->out);
+
+			/* A client which can't keep up is cut off.  It will
+			   reconnect and get only what it has missed. */
+			if(buffer_unsent(&c->out) > MAX_BACKLOG)
+				client_drop(c);
+			}
+		}
+
+	/* New clients get a list of their own. */
+	for(x=0; x < clients_count; x++)
+		{
+		if(clients[x].fd != -1 && !clients[x].caught_up)
+			client_catch_up(&clients[x]);
+		}
+	}
+
+/*===========================================================================
+** The events server
+===========================================================================*/
+
+/*
+** Receive the connections waiting to be handed over to us.
+*/
+static void receive_handovers(int sockfd)
+	{
+	const char function[] = "receive_handovers";
+	char buffer[MAX_HANDOVER + 1];
+	char *params[MAX_HANDOVER + 1];		/* one per byte if all are empty */
+	union {
+		struct cmsghdr align;
+		char space[CMSG_SPACE(sizeof(int))];
+		} control;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	ssize_t len;
+	int fd, count;
+	char *p;
+
+	for(;;)
+		{
+		iov.iov_base = buffer;
+		iov.iov_len = MAX_HANDOVER;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control.space;
+		msg.msg_controllen = sizeof(control.space);
+
+		if((len = recvmsg(sockfd, &msg, MSG_DONTWAIT)) == -1)
+			{
+			if(errno != EINTR && errno != EAGAIN)
+				fprintf(stderr, "%s(): recvmsg() failed, errno=%d (%s)\n", function, errno, gu_strerror(errno));
+			return;
+			}
+
+		fd = -1;
+		for(cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+			{
+			if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+				memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+			}
+		if(fd == -1)
+			continue;
+
+		/* The parameters are separated by NULs. */
+		buffer[len] = '\0';
+		for(count = 0, p = buffer; p < (buffer + len) && count < (sizeof(params) / sizeof(params[0])); p += (strlen(p) + 1))
+			params[count++] = p;
+
+		client_new(fd, params, count);
+		}
+	} /* end of receive_handovers() */
+
+/*
+** The events server's main loop.  It doesn't return.
+*/
+static void events_server(int sockfd)
+	{
+	struct pollfd *fds = NULL;
+	int fds_space = 0;
+	time_t time_now, last_keepalive, last_client;
+	int x;
+
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGHUP, SIG_IGN);
+
+	last_keepalive = last_client = time(NULL);
+
+	for(;;)
+		{
+		if(fds_space < (clients_count + 1))
+			{
+			fds_space = (clients_count + 1) * 2;
+			fds = gu_realloc(fds, fds_space, sizeof(struct pollfd));
+			}
+		fds[0].fd = sockfd;
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
+		for(x=0; x < clients_count; x++)
+			{
+			fds[x+1].fd = clients[x].fd;
+			fds[x+1].events = POLLIN | (buffer_unsent(&clients[x].out) > 0 ? POLLOUT : 0);
+			fds[x+1].revents = 0;
+			}
+
+		if(poll(fds, clients_count + 1, POLL_INTERVAL) == -1 && errno != EINTR)
+			{
+			fprintf(stderr, "events_server(): poll() failed, errno=%d (%s)\n", errno, gu_strerror(errno));
+			exit(1);
+			}
+
+		/* Browsers don't send anything after the request, so anything
+		   readable is probably end of file. */
+		for(x=0; x < clients_count; x++)
+			{
+			if(fds[x+1].revents & (POLLIN | POLLHUP | POLLERR))
+				{
+				char junk[512];
+				ssize_t len = read(clients[x].fd, junk, sizeof(junk));
+				if(len == 0 || (len == -1 && errno != EAGAIN && errno != EINTR))
+					client_drop(&clients[x]);
+				}
+			}
+		clients_sweep();
+
+		if(fds[0].revents & POLLIN)
+			receive_handovers(sockfd);
+
+		board_poll();
+
+		time_now = time(NULL);
+		if((time_now - last_keepalive) >= KEEPALIVE_INTERVAL)
+			{
+			for(x=0; x < clients_count; x++)
+				{
+				if(clients[x].fd != -1)
+					buffer_puts(&clients[x].out, ":\n\n");
+				}
+			last_keepalive = time_now;
+			}
+
+		for(x=0; x < clients_count; x++)
+			client_flush(&clients[x]);
+		clients_sweep();
+
+		if(clients_count > 0)
+			{
+			last_client = time_now;
+			}
+		else if((time_now - last_client) >= IDLE_EXIT)
+			{
+			/* Clients which arrive after this will start a new server. */
+			unlink(PUSH_EVENTS_SOCKET);
+			exit(0);
+			}
+		}
+	} /* end of events_server() */
+
+/*
+** Start the events server.  Return 0 if it is (or another is) ready.
+** The server is a child of ours which becomes a session leader so that it
+** outlives us.  It holds a lock on a file so that only one server at a
+** time can own the socket.
+*/
+static int events_server_start(void)
+	{
+	int ready[2];
+	pid_t pid;
+	char c;
+
+	if(pipe(ready) == -1)
+		return -1;
+
+	if((pid = fork()) == -1)
+		{
+		close(ready[0]);
+		close(ready[1]);
+		return -1;
+		}
+
+	if(pid == 0)				/* child */
+		{
+		char lockname[MAX_PPR_PATH];
+		struct sockaddr_un addr;
+		int lockfd, sockfd, devnull;
+
+		close(ready[0]);
+		setsid();
+
+		/* Our stdout is the browser's connection.  We mustn't hold
+		   onto it or it won't close when it should. */
+		if((devnull = open("/dev/null", O_RDWR)) != -1)
+			{
+			dup2(devnull, 0);
+			dup2(devnull, 1);
+			if(devnull > 2)
+				close(devnull);
+			}
+
+		ppr_fnamef(lockname, "%s.lock", PUSH_EVENTS_SOCKET);
+		if((lockfd = open(lockname, O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR)) == -1
+				|| gu_lock_exclusive(lockfd, FALSE) == -1)
+			_exit(0);			/* another is starting */
+		gu_set_cloexec(lockfd);
+
+		unlink(PUSH_EVENTS_SOCKET);
+		if((sockfd = socket(AF_UNIX, SOCK_DGRAM, 0)) == -1)
+			_exit(1);
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		gu_strlcpy(addr.sun_path, PUSH_EVENTS_SOCKET, sizeof(addr.sun_path));
+		if(bind(sockfd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+			_exit(1);
+		gu_set_cloexec(sockfd);
+
+		write(ready[1], "", 1);
+		close(ready[1]);
+
+		events_server(sockfd);
+		}
+
+	/* Wait until the child is ready or has given up. */
+	close(ready[1]);
+	while(read(ready[0], &c, 1) == -1 && errno == EINTR)
+		;
+	close(ready[0]);
+
+	return 0;
+	} /* end of events_server_start() */
+
+/*
+** Send a connection to the events server.
+*/
+static int handover(int fd, const char buffer[], size_t len)
+	{
+	union {
+		struct cmsghdr align;
+		char space[CMSG_SPACE(sizeof(int))];
+		} control;
+	struct sockaddr_un addr;
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	int sockfd, retval;
+
+	if((sockfd = socket(AF_UNIX, SOCK_DGRAM, 0)) == -1)
+		return -1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	gu_strlcpy(addr.sun_path, PUSH_EVENTS_SOCKET, sizeof(addr.sun_path));
+
+	iov.iov_base = (void *)buffer;
+	iov.iov_len = len;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &addr;
+	msg.msg_namelen = sizeof(addr);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.space;
+	msg.msg_controllen = sizeof(control.space);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+	retval = sendmsg(sockfd, &msg, 0) == -1 ? -1 : 0;
+	close(sockfd);
+	return retval;
+	} /* end of handover() */
+
+/*
+** This is called by main() for /push/events.  The parameters "queue=" name
+** the queues the client wants to hear about.
+*/
+void do_events(const char request_method[], char *content[], int content_count, const char last_event_id[])
+	{
+	char buffer[MAX_HANDOVER];
+	size_t len = 0;
+	int x, tries;
+
+	/* snprintf() returns the length it would have liked to use. */
+	len += snprintf(buffer, sizeof(buffer), "%s", last_event_id ? last_event_id : "") + 1;
+	if(len > sizeof(buffer))
+		len = sizeof(buffer);
+	for(x=0; x < content_count; x++)
+		{
+		if(strncmp(content[x], "queue=", 6) == 0)
+			{
+			size_t needed = strlen(content[x] + 6) + 1;
+			if((len + needed) > sizeof(buffer))
+				{
+				http_error(413, "Request Entity Too Large", "Too many queues.");
+				return;
+				}
+			strcpy(buffer + len, content[x] + 6);
+			len += needed;
+			}
+		}
+
+	send_header("text/event-stream");
+	fflush(stdout);
+
+	/* If there is no server, start one and try again.  If another is
+	   just starting or just exiting, it may take a few tries. */
+	for(tries=0; tries < 10; tries++)
+		{
+		if(tries > 1)
+			usleep(100000);
+		if(handover(1, buffer, len) == 0)
+			return;
+		if(events_server_start() == -1)
+			break;
+		}
+
+	printf(": no events server, errno=%d (%s)\n\n", errno, gu_strerror(errno));
+	} /* end of do_events() */
+
+/* end of file */
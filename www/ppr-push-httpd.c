@@ -25,7 +25,7 @@
 ** ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 ** POSSIBILITY OF SUCH DAMAGE.
 **
-** Last modified 9 September 2005.
+** Last modified 19 October 2026.
 */
 
 #include "config.h"
@@ -36,14 +36,14 @@
 #include "gu.h"
 #include "global_defines.h"
 #include "respond.h"
+#include "ppr-push-httpd.h"
 
-#define MAX_PRINTERS_TRACKED 100
 struct SETTINGS
 	{
 	int categories;								/* which category bits? */
 	int severity;								/* how server must event be to be played? (1 -- 10) */
 	int printers_count;							/* number of printers to monitor */
-	char *printers[MAX_PRINTERS_TRACKED];		/* printers to monitor */
+	char **printers;							/* printers to monitor */
 	int silly_sounds;							/* play silly sounds? */
 	char *voice;								/* which sound file set? */
 	int method;									/* Browser sound playing method */
@@ -51,7 +51,7 @@ struct SETTINGS
 	char *images;								/* URL of images directory */
 	};
 
-static void send_header(const char content_type[])
+void send_header(const char content_type[])
 	{
 	printf("HTTP/1.1 200 OK\r\n"
 		"Connection: close\r\n"
@@ -178,6 +178,7 @@ static void do_audio1(const char request_method[], char *content[], int content_
 	settings.voice = "male1";
 	settings.severity = 1;
 	settings.printers_count = 0;
+	settings.printers = gu_alloc(content_count + 1, sizeof(char*));
 	settings.method = 0;
 	settings.player = "/cgi-bin/commentary_speach.cgi";
 	settings.images = "/images/";
@@ -190,10 +191,7 @@ static void do_audio1(const char request_method[], char *content[], int content_
 		{
 		if(strncmp(content[x], "printer=", 8) == 0)
 			{
-			if(settings.printers_count < MAX_PRINTERS_TRACKED)
-				{
-				settings.printers[settings.printers_count++] = &content[x][8];
-				}
+			settings.printers[settings.printers_count++] = &content[x][8];
 			continue;
 			}
 		if(gu_sscanf(content[x], "categories=%d", &tempint) == 1)
@@ -350,7 +348,7 @@ static void do_tail_status(const char request_method[], char *content[], int con
 ** Server support routines and main() follow.
 ==========================================================================*/
 
-static void http_error(int code, const char message[], const char explain[], ...)
+void http_error(int code, const char message[], const char explain[], ...)
 	{
 	va_list va;
 
@@ -420,6 +418,8 @@ int main(int argc, char *argv[])
 	char *request_method = NULL;
 	char *url = NULL;
 	char *host = NULL;
+	char *query = NULL;
+	char *last_event_id = NULL;
 	int content_length = -1;
 	char *entity_body = NULL;
 	#define MAX_PAIRS 100
@@ -451,6 +451,10 @@ int main(int argc, char *argv[])
 			url += hostlen;
 			}
 
+		/* A GET request has its form variables in the query string. */
+		if((query = strchr(url, '?')))
+			*(query++) = '\0';
+
 		/* Now we must decode the URL. */
 		{
 		char *si, *di;
@@ -485,6 +489,22 @@ int main(int argc, char *argv[])
 			gu_sscanf(line, " %S", &host);
 			}
 
+		/* A browser reconnecting to /push/events says what it last got.
+		   It must be an ID which we sent, else it is ignored. */
+		else if(gu_strncasecmp(line, "Last-Event-ID:", 14) == 0 && !last_event_id)
+			{
+			long int started;
+			unsigned int since;
+			char junk;
+			if(gu_sscanf(line + 14, " %S", &last_event_id) == 1
+					&& (strlen(last_event_id) > MAX_EVENT_ID
+						|| sscanf(last_event_id, "%ld-%u%c", &started, &since, &junk) != 2))
+				{
+				gu_free(last_event_id);
+				last_event_id = NULL;
+				}
+			}
+
 		/* A blank line signals the end of the header. */
 		if(strspn(line, " \t") == strlen(line))
 			break;
@@ -509,30 +529,38 @@ int main(int argc, char *argv[])
 		http_error(400, "Bad Request", "There is no \"Host:\" line in the request header.");
 		return 0;
 		}
-	if(strcmp(request_method, "POST"))
+	if(strcmp(request_method, "GET") == 0)
 		{
-		http_error(501, "Not Implemented", "The only request method this server supports is POST.  (You sent a %s request.)", request_method);
-		return 0;
+		/* Browsers' EventSource objects can only use GET. */
+		entity_body = gu_strdup(query ? query : "");
 		}
-	if(content_length < 0)
+	else if(strcmp(request_method, "POST") == 0)
 		{
-		http_error(411, "Length Required", "There is no \"Content-Length:\" line in the request header.");
-		return 0;
-		}
-	if(content_length > 100000)
-		{
-		http_error(413, "Request Entity Too Large", "The content length (%d) is unreasonably large.", content_length);
-		return 0;
-		}
+		if(content_length < 0)
+			{
+			http_error(411, "Length Required", "There is no \"Content-Length:\" line in the request header.");
+			return 0;
+			}
+		if(content_length > 100000)
+			{
+			http_error(413, "Request Entity Too Large", "The content length (%d) is unreasonably large.", content_length);
+			return 0;
+			}
 
-	/* Read the POST data. */
-	entity_body = (char*)gu_alloc(content_length + 1, 1);
-	if(fread(entity_body, 1, content_length, stdin) != content_length)
+		/* Read the POST data. */
+		entity_body = (char*)gu_alloc(content_length + 1, 1);
+		if(fread(entity_body, 1, content_length, stdin) != content_length)
+			{
+			http_error(400, "Bad Request", "Read error.");
+			return 0;
+			}
+		entity_body[content_length] = '\0';
+		}
+	else
 		{
-		http_error(400, "Bad Request", "Read error.");
+		http_error(501, "Not Implemented", "The only request methods this server supports are GET and POST.  (You sent a %s request.)", request_method);
 		return 0;
 		}
-	entity_body[content_length] = '\0';
 
 	/* Reverse the CGI encoding and make an array of pointer to the
 	   name=value pairs. */
@@ -587,6 +615,10 @@ int main(int argc, char *argv[])
 		{
 		do_tail_status(request_method, content, content_count);
 		}
+	else if(strcmp(url, "/push/events") == 0)
+		{
+		do_events(request_method, content, content_count, last_event_id);
+		}
 	else
 		{
 		http_error(404, "Not Found", "The file \"%s\" does not exist.", url);
@@ -0,0 +1,21 @@
+/*
+** mouse:~ppr/src/www/ppr-push-httpd.h
+** Copyright 1995--2026, Trinity College Computing Center.
+** Written by David Chappell.
+**
+** This file is part of PPR.  You can redistribute it and modify it under the
+** terms of the revised BSD licence (without the advertising clause) as
+** described in the accompanying file LICENSE.txt.
+**
+** Last modified 19 October 2026.
+*/
+
+/* ppr-push-httpd.c */
+void send_header(const char content_type[]);
+void http_error(int code, const char message[], const char explain[], ...);
+
+/* ppr-push-events.c */
+#define MAX_EVENT_ID 32			/* longest Last-Event-ID accepted, "%ld-%u" */
+void do_events(const char request_method[], char *content[], int content_count, const char last_event_id[]);
+
+/* end of file */
@@ -0,0 +1,107 @@
+//
+// mouse:~ppr/src/www/push_events.js
+// Copyright 1995--2026, Trinity College Computing Center.
+// Written by David Chappell.
+// Last modified 19 October 2026.
+//
+
+//
+// This follows the event stream which ppr-push-httpd sends for /push/events
+// and keeps a copy of the printer and job slots which it describes.  The
+// slots are indexed by slot number.  A printer slot has the members name,
+// status, retry, countdown, job, pages_started, pages_printed, bytes_sent,
+// bytes_total, and message.  A job slot has job, queue, priority, status,
+// and (if it is printing) printer.
+//
+var push_printers = new Object();
+var push_jobs = new Object();
+
+//
+// Start following the events.  The queues argument is an array of the
+// names of the queues to hear about (an empty array for all of them).  The
+// function on_sync is called at the end of each batch of changes with an
+// argument which is true if the batch was a complete list.  If the
+// browser can't do this or gives up on the server, on_lost is called so
+// that the page can go back to reloading itself.
+//
+function push_events_start(queues, on_sync, on_lost)
+	{
+	if(!window.EventSource || !window.JSON)
+		{
+		on_lost();
+		return false;
+		}
+
+	var url = '/push/events';
+	for(var i=0; i < queues.length; i++)
+		url += (i == 0 ? '?' : ';') + 'queue=' + encodeURIComponent(queues[i]);
+
+	var source = new EventSource(url);
+	var reset = false;
+
+	source.addEventListener('reset', function(event)
+		{
+		push_printers = new Object();
+		push_jobs = new Object();
+		reset = true;
+		}, false);
+
+	// An object with nothing but a slot number means the slot is empty.
+	source.addEventListener('printer', function(event)
+		{
+		var p = JSON.parse(event.data);
+		if(p.name)
+			push_printers[p.slot] = p;
+		else
+			delete push_printers[p.slot];
+		}, false);
+
+	source.addEventListener('job', function(event)
+		{
+		var j = JSON.parse(event.data);
+		if(j.job)
+			push_jobs[j.slot] = j;
+		else
+			delete push_jobs[j.slot];
+		}, false);
+
+	source.addEventListener('sync', function(event)
+		{
+		on_sync(reset);
+		reset = false;
+		}, false);
+
+	// The browser reconnects by itself unless the server refused us.
+	source.onerror = function(event)
+		{
+		if(source.readyState == 2)
+			on_lost();
+		};
+
+	return true;
+	}
+
+// Return an object which maps queue names to the number of jobs in each.
+function push_job_counts()
+	{
+	var counts = new Object();
+	for(var slot in push_jobs)
+		{
+		var queue = push_jobs[slot].queue;
+		counts[queue] = (counts[queue] ? counts[queue] : 0) + 1;
+		}
+	return counts;
+	}
+
+// Find the printer with the indicated name, or return null.
+function push_printer(name)
+	{
+	for(var slot in push_printers)
+		{
+		if(push_printers[slot].name == name)
+			return push_printers[slot];
+		}
+	return null;
+	}
+
+// end of file
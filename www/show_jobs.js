@@ -2,7 +2,7 @@
 // mouse:~ppr/src/www/show_jobs.js
 // Copyright 1995--2001, Trinity College Computing Center.
 // Written by David Chappell.
-// Last modified 17 December 2003.
+// Last modified 19 October 2026.
 //
 
 // Open a Modify window.
@@ -61,4 +61,36 @@ function do_log()
     return false;
     }
 
+//
+// The rows of the table come from ppop, so when a job comes, goes, or
+// changes status we reload rather than work out the new rows here.  The
+// functions which this uses are in show_queues.js and push_events.js.
+//
+var jobs_seen = null;
+
+function jobs_start(seconds, queue)
+	{
+	reload_interval = seconds;
+	reload_later();
+	push_events_start(queue == "all" ? new Array() : new Array(queue), jobs_update, reload_later);
+	}
+
+function jobs_update(reset)
+	{
+	reload_cancel();
+
+	var list = new Array();
+	for(var slot in push_jobs)
+		{
+		var j = push_jobs[slot];
+		list.push(j.job + " " + j.status + " " + j.priority);
+		}
+	list.sort();
+
+	var seen = list.join("\n");
+	if(jobs_seen != null && seen != jobs_seen)
+		gentle_reload();
+	jobs_seen = seen;
+	}
+
 // end of file
@@ -2,7 +2,7 @@
 // mouse:~ppr/src/www/show_queues.js
 // Copyright 1995--2004, Trinity College Computing Center.
 // Written by David Chappell.
-// Last revised 8 October 2004.
+// Last revised 19 October 2026.
 //
 
 // Width in pixels of invisible border round the table.
@@ -204,4 +204,117 @@ function wopen(event, url)
 	return false;
 	}
 
+//
+// These functions keep the icons up to date using the events from
+// push_events.js so that the page needn't be reloaded.  The icon file names
+// are made of five characters (see show_queues.cgi) of which the fourth
+// says whether there are jobs and the fifth (for printers) gives the
+// printer status.
+//
+var reload_timer = null;
+var reload_interval;
+
+// This is called when the page has loaded.  Until the first batch of
+// events arrives (or if they stop) we reload every so often as before.
+function queues_start(seconds)
+	{
+	reload_interval = seconds;
+	reload_later();
+	push_events_start(new Array(), queues_update, reload_later);
+	}
+
+function reload_later()
+	{
+	if(reload_timer == null)
+		reload_timer = window.setTimeout("gentle_reload()", reload_interval * 1000);
+	}
+
+function reload_cancel()
+	{
+	if(reload_timer != null)
+		{
+		window.clearTimeout(reload_timer);
+		reload_timer = null;
+		}
+	}
+
+// Change one character of an icon's file name.
+function set_icon_char(img, position, c)
+	{
+	var src = img.src;
+	var start = src.lastIndexOf('/') + 1;
+	if(src.charAt(start + position) != c)
+		img.src = src.substr(0, start + position) + c + src.substr(start + position + 1);
+	}
+
+// This is the same as pstatus_char() in show_queues.cgi.
+function pstatus_char(message, default_char, offline_char, error_char)
+	{
+	if(/PrinterError: off ?line/.test(message) || /^OFFLINE/.test(message))
+		return offline_char;
+	if(/PrinterError:/.test(message))
+		return error_char;
+	return default_char;
+	}
+
+function printer_status_char(p)
+	{
+	switch(p.status)
+		{
+		case "idle":		return pstatus_char(p.message, '0', '8', '9');
+		case "printing":	return pstatus_char(p.message, '1', 'a', 'b');
+		case "stopping":
+		case "halting":		return '2';
+		case "canceling":
+		case "seizing":		return '3';
+		case "stopt":		return '4';
+		case "fault":		return p.retry > 0 ? '5' : '6';
+		case "starved":		return '5';
+		case "engaged":		return pstatus_char(p.message, '7', '8', '9');
+		default:			return 'x';
+		}
+	}
+
+// This is called by push_events.js after each batch of changes.  If a
+// printer has been added or removed, we reload since we would need a new
+// icon and a new menu.
+function queues_update(reset)
+	{
+	reload_cancel();
+
+	var counts = push_job_counts();
+	var printers = new Object();
+	for(var slot in push_printers)
+		{
+		var p = push_printers[slot];
+		var img = document.getElementById('icon_' + p.name);
+		if(!img)
+			{
+			gentle_reload();
+			return;
+			}
+		set_icon_char(img, 4, printer_status_char(p));
+		printers[p.name] = true;
+		}
+
+	var images = document.getElementsByTagName('img');
+	for(var i=0; i < images.length; i++)
+		{
+		var img = images.item(i);
+		if(img.id.substr(0, 5) != 'icon_')
+			continue;
+		var name = img.id.substr(5);
+		if(img.alt == '[printer]' && !printers[name])
+			{
+			gentle_reload();
+			return;
+			}
+		var count = counts[name] ? counts[name] : 0;
+		set_icon_char(img, 3, count > 0 ? '1' : '0');
+		var span = document.getElementById('jobs_' + name);
+		if(span)
+			span.innerHTML = count > 0 ? '(' + count + ')' : '';
+		}
+	}
+
 // end of file
@@ -26,7 +26,7 @@
 # ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
 # POSSIBILITY OF SUCH DAMAGE.
 #
-# Last modified 3 April 2006.
+# Last modified 19 October 2026.
 #
 
 #=============================================================================
@@ -111,6 +111,9 @@ directory $RESOURCEDIR/procset 755
 directory $RESOURCEDIR/file 755
 directory $RESOURCEDIR/encoding 755
 
+# The automatic resource cache.  Ppr creates the subdirectories as needed.
+directory $RESOURCE_AUTOCACHE 755
+
 # Make the miscelaineous directories in /usr/lib/ppr.
 directory $BINDIR 755
 directory $FILTDIR 755
@@ -8,7 +8,7 @@
 # terms of the revised BSD licence (without the advertising clause) as
 # described in the accompanying file LICENSE.txt.
 #
-# Last modified: 31 October 2012
+# Last modified: 19 October 2026
 #
 
 #
@@ -215,6 +215,114 @@ if_dir_print "/usr/share/ppd"
 
 echo >&5
 
+cat - >&5 <<===EndHere93===
+#
+# The largest job ID number.  After it is used, numbering starts again at 1.
+# The default is 9999.  It may be as large as 99999999.
+#
+# The spool format may be "separate", in which case the body of each job is
+# stored in three files, or "container", in which case it is stored in one.
+# Use ppr-spoolconv to convert jobs already in the queue.
+#
+# The journal window is the number of milliseconds for which pprd collects
+# changes to job and destination state before writing them to its journal
+# all at once.  Set it to 0 to write each change as soon as it is made.
+#
+[spooler]
+  #max job id = 9999
+  #spool format = separate
+  #journal window = 50
+
+===EndHere93===
+
+cat - >&5 <<===EndHere95===
+#
+# The automatic resource cache.  Resources which are embedded in incoming
+# jobs are stored here so that later jobs which embed the same resources can
+# be spooled without them.  Resources which have not been used for longer
+# than the number of days given are removed when the cache grows beyond the
+# given size (in megabytes), unless a job in the queue still needs them.
+# Set the size to 0 to turn the cache off.
+#
+[resource cache]
+  #max size = 64
+  #keep days = 7
+
+===EndHere95===
+
+cat - >&5 <<===EndHere96===
+#
+# The structured print log.  If the directory
+# $LOGDIR/printlog.d
+# exists, a record of each job printed is appended to it.  When the file
+# being appended to reaches the given size (in kilobytes), it is indexed
+# and a new one is started.  Use ppr-printlog to read it.
+#
+[printlog]
+  #segment size = 16384
+
+===EndHere96===
+
+cat - >&5 <<===EndHere97===
+#
+# The SNMP status poller in pprd.  Every network printer which uses the
+# tcpip, jetdirect, or appsocket interface is asked for its status every
+# poll interval (in seconds) whether it is printing or not.  A printer whose
+# status is at least as severe as the hold severity (7 means jammed, out of
+# paper, or the like) is not given new jobs until the condition clears.
+# Set the poll interval to 0 to turn the poller off or the hold severity
+# to 0 to only show the status in "ppop status".  The port is the printers'
+# SNMP port.  It is changed only for testing.
+#
+[snmp poller]
+  #poll interval = 60
+  #hold severity = 7
+  #port = 161
+
+===EndHere97===
+
+cat - >&5 <<===EndHere98===
+#
+# The responder dispatcher which pprd uses to send messages to users.  No
+# more than the given number of workers (responder programs) run at once.
+# Messages for the same user which arrive within coalesce window seconds
+# of the first are sent together as one.  Set it to 0 to send each message
+# as soon as a worker is free.
+#
+[responders]
+  #workers = 4
+  #coalesce window = 2
+
+===EndHere98===
+
+cat - >&5 <<===EndHere101===
+#
+# Pre-RIPing in pprd.  While a printer which has a RIP is printing, pprd
+# may run the jobs waiting for it through the RIP and save the output so
+# that it is ready when their turn comes.  No more than max jobs are done
+# at once and the saved output may take up no more than disk budget
+# megabytes.  The default of 0 jobs turns pre-RIPing off.
+#
+[prerip]
+  #max jobs = 0
+  #disk budget = 100
+
+===EndHere101===
+
+cat - >&5 <<===EndHere102===
+#
+# How pprd and pprdrv tell queue display programs what is going on.  They
+# always keep the status board (a file which such programs map into memory
+# to see the current state of each printer and job) up to date.  Setting
+# text feed to no turns off the older state_update files which such programs
+# read with tail_status.  Those programs which haven't been converted to use
+# the status board, such as the audio feature of ppr-push-httpd, need them.
+#
+[status]
+  #text feed = yes
+
+===EndHere102===
+
 cat - >&5 <<===EndHere100===
 # Configuration of the new AppleTalk Printer Access Protocol server
 [papd]